@@ -57,10 +57,30 @@ if command -v sshpass &> /dev/null && ! ssh -o BatchMode=yes root@"$DEVICE_IP" "
     echo "使用密码认证复制文件..."
     sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no rg34xx-sdl2-arm root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
     sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no NotoSansCJK-Regular.ttc root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    if [ -f "ui-glyphs.pack" ]; then
+        sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no ui-glyphs.pack root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
+    sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no gamecontrollerdb.txt root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    if [ -f "metrics-tool" ]; then
+        sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no metrics-tool root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
+    if [ -f "jitter-bench" ]; then
+        sshpass -p "$SSH_PASSWORD" scp -o StrictHostKeyChecking=no jitter-bench root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
 else
     echo "使用密钥认证复制文件..."
     scp rg34xx-sdl2-arm root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
     scp NotoSansCJK-Regular.ttc root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    if [ -f "ui-glyphs.pack" ]; then
+        scp ui-glyphs.pack root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
+    scp gamecontrollerdb.txt root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    if [ -f "metrics-tool" ]; then
+        scp metrics-tool root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
+    if [ -f "jitter-bench" ]; then
+        scp jitter-bench root@"$DEVICE_IP":/mnt/mmc/Roms/APPS/
+    fi
 fi
 
 # 设置权限
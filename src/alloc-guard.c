@@ -0,0 +1,104 @@
+#include "alloc-guard.h"
+
+#include <stdlib.h>
+
+#if defined(DEBUG) && defined(__GLIBC__)
+#include <errno.h>
+
+// glibc的内部分配函数，替换后的入口转发给它们
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+static __thread int guard_armed;
+static unsigned long guard_count;
+static size_t guard_first_size;
+
+static void record(size_t size) {
+    if (guard_armed) {
+        if (__atomic_fetch_add(&guard_count, 1, __ATOMIC_RELAXED) == 0) {
+            guard_first_size = size;
+        }
+    }
+}
+
+void* malloc(size_t size) {
+    record(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    record(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    record(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    record(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    record(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    record(size);
+    void* p = __libc_memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *ptr = p;
+    return 0;
+}
+
+int alloc_guard_enabled(void) {
+    return 1;
+}
+
+void alloc_guard_arm(void) {
+    __atomic_store_n(&guard_count, 0, __ATOMIC_RELAXED);
+    guard_first_size = 0;
+    guard_armed = 1;
+}
+
+void alloc_guard_disarm(void) {
+    guard_armed = 0;
+}
+
+unsigned long alloc_guard_count(void) {
+    return __atomic_load_n(&guard_count, __ATOMIC_RELAXED);
+}
+
+size_t alloc_guard_first_size(void) {
+    return guard_first_size;
+}
+
+#else
+
+int alloc_guard_enabled(void) {
+    return 0;
+}
+
+void alloc_guard_arm(void) {
+}
+
+void alloc_guard_disarm(void) {
+}
+
+unsigned long alloc_guard_count(void) {
+    return 0;
+}
+
+size_t alloc_guard_first_size(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ALLOC_GUARD_H
+#define ALLOC_GUARD_H
+
+#include <stddef.h>
+
+// 堆分配检查 (调试版本): 替换malloc/calloc/realloc等入口，
+// 在调用 alloc_guard_arm 的线程上统计之后发生的分配次数，用来确认主循环预热后不再分配。
+// 只在定义了DEBUG且动态链接glibc时生效 (静态链接时与libc.a的malloc重复定义)，
+// 其它情况下计数始终为0。
+
+// 返回检查是否可用
+int alloc_guard_enabled(void);
+
+// 在当前线程开始统计 (计数清零)
+void alloc_guard_arm(void);
+void alloc_guard_disarm(void);
+
+// 开始统计后的分配次数和第一次分配的大小
+unsigned long alloc_guard_count(void);
+size_t alloc_guard_first_size(void);
+
+#endif
@@ -0,0 +1,455 @@
+#include "audio-mixer.h"
+#include "fixmath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// 音量 (0..256) 和声像 (-256..256) 转为左右声道的Q16增益: 居中时两边都是原音量，偏向一边时另一边减小
+static void volume_gains(int volume, int pan, int32_t* left, int32_t* right) {
+    if (volume < 0) volume = 0;
+    if (volume > AUDIO_VOLUME_MAX) volume = AUDIO_VOLUME_MAX;
+    if (pan < -AUDIO_VOLUME_MAX) pan = -AUDIO_VOLUME_MAX;
+    if (pan > AUDIO_VOLUME_MAX) pan = AUDIO_VOLUME_MAX;
+    int32_t gain = volume * (FX_ONE / AUDIO_VOLUME_MAX);
+    *left = pan > 0 ? gain / AUDIO_VOLUME_MAX * (AUDIO_VOLUME_MAX - pan) : gain;
+    *right = pan < 0 ? gain / AUDIO_VOLUME_MAX * (AUDIO_VOLUME_MAX + pan) : gain;
+}
+
+// ---------- 命令环 (写者) ----------
+
+static int push_command(audio_mixer_t* mixer, const audio_command_t* command) {
+    unsigned head = atomic_load_explicit(&mixer->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&mixer->tail, memory_order_acquire);
+    if (head - tail >= AUDIO_MIXER_QUEUE_SIZE) {
+        atomic_fetch_add_explicit(&mixer->dropped, 1, memory_order_relaxed);
+        return -1;
+    }
+    mixer->queue[head & (AUDIO_MIXER_QUEUE_SIZE - 1)] = *command;
+    atomic_store_explicit(&mixer->head, head + 1, memory_order_release);
+    return 0;
+}
+
+uint32_t audio_mixer_play(audio_mixer_t* mixer, const audio_sound_t* sound, int volume, int pan, int loop) {
+    if (!sound || !sound->samples || sound->frames <= 0) {
+        return 0;
+    }
+    audio_command_t command = {AUDIO_CMD_PLAY, 0, sound, 0, 0, loop};
+    if (++mixer->next_voice == 0) mixer->next_voice = 1;
+    command.voice = mixer->next_voice;
+    volume_gains(volume, pan, &command.gain_left, &command.gain_right);
+    return push_command(mixer, &command) == 0 ? command.voice : 0;
+}
+
+int audio_mixer_stop(audio_mixer_t* mixer, uint32_t voice) {
+    audio_command_t command = {AUDIO_CMD_STOP, voice, NULL, 0, 0, 0};
+    return push_command(mixer, &command);
+}
+
+int audio_mixer_set_volume(audio_mixer_t* mixer, uint32_t voice, int volume, int pan) {
+    audio_command_t command = {AUDIO_CMD_VOLUME, voice, NULL, 0, 0, 0};
+    volume_gains(volume, pan, &command.gain_left, &command.gain_right);
+    return push_command(mixer, &command);
+}
+
+int audio_mixer_stop_all(audio_mixer_t* mixer) {
+    audio_command_t command = {AUDIO_CMD_STOP_ALL, 0, NULL, 0, 0, 0};
+    return push_command(mixer, &command);
+}
+
+int audio_mixer_set_master(audio_mixer_t* mixer, int volume) {
+    audio_command_t command = {AUDIO_CMD_MASTER, 0, NULL, 0, 0, 0};
+    volume_gains(volume, 0, &command.gain_left, &command.gain_right);
+    return push_command(mixer, &command);
+}
+
+// ---------- 回调 ----------
+
+static audio_voice_t* find_voice(audio_mixer_t* mixer, uint32_t id) {
+    for (int i = 0; i < mixer->voice_count; i++) {
+        if (mixer->voices[i].sound && mixer->voices[i].id == id) return &mixer->voices[i];
+    }
+    return NULL;
+}
+
+static void ramp_to(audio_voice_t* voice, int32_t left, int32_t right) {
+    voice->target_left = left;
+    voice->target_right = right;
+    voice->step_left = (left - voice->gain_left) / AUDIO_MIXER_RAMP_FRAMES;
+    voice->step_right = (right - voice->gain_right) / AUDIO_MIXER_RAMP_FRAMES;
+    voice->ramp = AUDIO_MIXER_RAMP_FRAMES;
+}
+
+// 被替换的声音移到淡出槽位继续过渡到0，直接截断会产生爆音
+static void fade_out(audio_mixer_t* mixer, const audio_voice_t* voice) {
+    audio_voice_t* slot = &mixer->fading[0];
+    for (int i = 0; i < AUDIO_MIXER_FADE_VOICES; i++) {
+        audio_voice_t* fade = &mixer->fading[i];
+        if (!fade->sound) {
+            slot = fade;
+            break;
+        }
+        if (fade->ramp < slot->ramp) slot = fade;
+    }
+    *slot = *voice;
+    if (!slot->stopping) {
+        slot->stopping = 1;
+        ramp_to(slot, 0, 0);
+    }
+}
+
+// 空闲的声部，没有时替换最早开始的非循环声部 (都在循环时替换最早的)
+static audio_voice_t* allocate_voice(audio_mixer_t* mixer) {
+    audio_voice_t* oldest = NULL;
+    audio_voice_t* oldest_loop = NULL;
+    for (int i = 0; i < mixer->voice_count; i++) {
+        audio_voice_t* voice = &mixer->voices[i];
+        if (!voice->sound) return voice;
+        audio_voice_t** slot = voice->loop ? &oldest_loop : &oldest;
+        if (!*slot || (int32_t)(voice->started - (*slot)->started) < 0) *slot = voice;
+    }
+    atomic_fetch_add_explicit(&mixer->stolen, 1, memory_order_relaxed);
+    audio_voice_t* voice = oldest ? oldest : oldest_loop;
+    fade_out(mixer, voice);
+    return voice;
+}
+
+static void run_command(audio_mixer_t* mixer, const audio_command_t* command) {
+    audio_voice_t* voice;
+    switch (command->type) {
+        case AUDIO_CMD_PLAY:
+            voice = allocate_voice(mixer);
+            memset(voice, 0, sizeof(*voice));
+            voice->sound = command->sound;
+            voice->id = command->voice;
+            voice->loop = command->loop;
+            voice->gain_left = voice->target_left = command->gain_left;
+            voice->gain_right = voice->target_right = command->gain_right;
+            voice->started = mixer->sequence;
+            break;
+        case AUDIO_CMD_STOP:
+            voice = find_voice(mixer, command->voice);
+            if (voice) {
+                voice->stopping = 1;
+                ramp_to(voice, 0, 0);
+            }
+            break;
+        case AUDIO_CMD_VOLUME:
+            voice = find_voice(mixer, command->voice);
+            if (voice && !voice->stopping) {
+                ramp_to(voice, command->gain_left, command->gain_right);
+            }
+            break;
+        case AUDIO_CMD_STOP_ALL:
+            for (int i = 0; i < mixer->voice_count; i++) {
+                if (mixer->voices[i].sound) {
+                    mixer->voices[i].stopping = 1;
+                    ramp_to(&mixer->voices[i], 0, 0);
+                }
+            }
+            break;
+        case AUDIO_CMD_MASTER:
+            mixer->master = command->gain_left;
+            break;
+    }
+}
+
+// 把一个声部累加到acc，声音结束 (或停止的过渡完成) 时返回0
+static int mix_voice(audio_voice_t* voice, int32_t* acc, int frames) {
+    const audio_sound_t* sound = voice->sound;
+    int done = 0;
+    while (done < frames) {
+        int remaining = sound->frames - voice->position;
+        if (remaining <= 0) {
+            if (!voice->loop) return 0;
+            voice->position = 0;
+            continue;
+        }
+        int n = frames - done < remaining ? frames - done : remaining;
+        const int16_t* src = sound->samples + (size_t)voice->position * 2;
+        int32_t* dst = acc + (size_t)done * 2;
+        int i = 0;
+
+        // 过渡中逐帧改变增益，结束时对齐到目标值
+        for (; i < n && voice->ramp > 0; i++) {
+            voice->gain_left += voice->step_left;
+            voice->gain_right += voice->step_right;
+            dst[i * 2] += (src[i * 2] * voice->gain_left) >> FX_SHIFT;
+            dst[i * 2 + 1] += (src[i * 2 + 1] * voice->gain_right) >> FX_SHIFT;
+            if (--voice->ramp == 0) {
+                voice->gain_left = voice->target_left;
+                voice->gain_right = voice->target_right;
+                if (voice->stopping) return 0;
+            }
+        }
+
+        int32_t left = voice->gain_left, right = voice->gain_right;
+        if (left == FX_ONE && right == FX_ONE) {
+            for (; i < n; i++) {
+                dst[i * 2] += src[i * 2];
+                dst[i * 2 + 1] += src[i * 2 + 1];
+            }
+        } else {
+            for (; i < n; i++) {
+                dst[i * 2] += (src[i * 2] * left) >> FX_SHIFT;
+                dst[i * 2 + 1] += (src[i * 2 + 1] * right) >> FX_SHIFT;
+            }
+        }
+        voice->position += n;
+        done += n;
+    }
+    return 1;
+}
+
+static void mix_chunk(audio_mixer_t* mixer, int16_t* out, int frames) {
+    int32_t* acc = mixer->mix;
+    memset(acc, 0, (size_t)frames * 2 * sizeof(int32_t));
+    int active = 0;
+    for (int i = 0; i < mixer->voice_count; i++) {
+        audio_voice_t* voice = &mixer->voices[i];
+        if (!voice->sound) continue;
+        if (mix_voice(voice, acc, frames)) {
+            active++;
+        } else {
+            voice->sound = NULL;
+        }
+    }
+    for (int i = 0; i < AUDIO_MIXER_FADE_VOICES; i++) {
+        audio_voice_t* fade = &mixer->fading[i];
+        if (fade->sound && !mix_voice(fade, acc, frames)) {
+            fade->sound = NULL;
+        }
+    }
+
+    unsigned long clipped = 0;
+    int32_t master = mixer->master;
+    for (int i = 0; i < frames * 2; i++) {
+        int32_t v = master == FX_ONE ? acc[i] : (int32_t)(((int64_t)acc[i] * master) >> FX_SHIFT);
+        if (v > 32767) {
+            v = 32767;
+            clipped++;
+        } else if (v < -32768) {
+            v = -32768;
+            clipped++;
+        }
+        out[i] = (int16_t)v;
+    }
+    if (clipped) atomic_fetch_add_explicit(&mixer->clipped, clipped, memory_order_relaxed);
+    atomic_store_explicit(&mixer->active, active, memory_order_relaxed);
+    if (active > atomic_load_explicit(&mixer->peak, memory_order_relaxed)) {
+        atomic_store_explicit(&mixer->peak, active, memory_order_relaxed);
+    }
+}
+
+void audio_mixer_render(audio_mixer_t* mixer, int16_t* out, int frames) {
+    uint64_t start = now_ns();
+    uint64_t period = (uint64_t)frames * 1000000000ull / mixer->rate;
+    if (mixer->last_callback_ns && start - mixer->last_callback_ns > period + period / 2) {
+        atomic_fetch_add_explicit(&mixer->underruns, 1, memory_order_relaxed);
+    }
+    mixer->last_callback_ns = start;
+    mixer->sequence++;
+
+    // 取走写者已经发布的所有命令
+    unsigned tail = atomic_load_explicit(&mixer->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&mixer->head, memory_order_acquire);
+    if (head != tail) {
+        atomic_fetch_add_explicit(&mixer->commands, head - tail, memory_order_relaxed);
+        for (; tail != head; tail++) {
+            run_command(mixer, &mixer->queue[tail & (AUDIO_MIXER_QUEUE_SIZE - 1)]);
+        }
+        atomic_store_explicit(&mixer->tail, tail, memory_order_release);
+    }
+
+    for (int done = 0; done < frames; done += mixer->max_frames) {
+        int n = frames - done < mixer->max_frames ? frames - done : mixer->max_frames;
+        mix_chunk(mixer, out + (size_t)done * 2, n);
+    }
+
+    uint64_t elapsed = now_ns() - start;
+    unsigned long us = (unsigned long)(elapsed / 1000);
+    if (elapsed > period) atomic_fetch_add_explicit(&mixer->late, 1, memory_order_relaxed);
+    if (us > atomic_load_explicit(&mixer->max_mix_us, memory_order_relaxed)) {
+        atomic_store_explicit(&mixer->max_mix_us, us, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&mixer->mix_us, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mixer->frames, frames, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mixer->callbacks, 1, memory_order_relaxed);
+}
+
+// ---------- 初始化和统计 ----------
+
+int audio_mixer_init(audio_mixer_t* mixer, int rate, int voices, int max_frames) {
+    memset(mixer, 0, sizeof(*mixer));
+    if (rate <= 0 || voices <= 0 || voices > AUDIO_MIXER_MAX_VOICES || max_frames <= 0) {
+        return -1;
+    }
+    mixer->mix = malloc((size_t)max_frames * 2 * sizeof(int32_t));
+    if (!mixer->mix) {
+        return -1;
+    }
+    mixer->rate = rate;
+    mixer->voice_count = voices;
+    mixer->max_frames = max_frames;
+    mixer->master = FX_ONE;
+    atomic_init(&mixer->head, 0);
+    atomic_init(&mixer->tail, 0);
+    return 0;
+}
+
+void audio_mixer_destroy(audio_mixer_t* mixer) {
+    free(mixer->mix);
+    memset(mixer, 0, sizeof(*mixer));
+}
+
+void audio_mixer_get_stats(audio_mixer_t* mixer, audio_mixer_stats_t* stats) {
+    stats->callbacks = atomic_load_explicit(&mixer->callbacks, memory_order_relaxed);
+    stats->frames = atomic_load_explicit(&mixer->frames, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&mixer->underruns, memory_order_relaxed);
+    stats->late = atomic_load_explicit(&mixer->late, memory_order_relaxed);
+    stats->commands = atomic_load_explicit(&mixer->commands, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&mixer->dropped, memory_order_relaxed);
+    stats->stolen = atomic_load_explicit(&mixer->stolen, memory_order_relaxed);
+    stats->clipped = atomic_load_explicit(&mixer->clipped, memory_order_relaxed);
+    stats->mix_us = atomic_load_explicit(&mixer->mix_us, memory_order_relaxed);
+    stats->max_mix_us = atomic_load_explicit(&mixer->max_mix_us, memory_order_relaxed);
+    stats->active = atomic_load_explicit(&mixer->active, memory_order_relaxed);
+    stats->peak = atomic_load_explicit(&mixer->peak, memory_order_relaxed);
+}
+
+// ---------- 音效 (启动时准备) ----------
+
+static uint32_t read_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return read_u16(p) | (read_u16(p + 2) << 16);
+}
+
+int audio_sound_load_wav(audio_sound_t* sound, const char* path, int rate) {
+    memset(sound, 0, sizeof(*sound));
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    uint8_t* data = NULL;
+    long size = 0;
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 44 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc(size);
+        if (data && fread(data, 1, size, file) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data) {
+        return -1;
+    }
+
+    int rc = -1;
+    int channels = 0, src_rate = 0, bits = 0;
+    const uint8_t* pcm = NULL;
+    uint32_t pcm_size = 0;
+    if (memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+        goto done;
+    }
+    // 逐个读块，只需要fmt和data
+    for (long offset = 12; offset + 8 <= size;) {
+        uint32_t chunk = read_u32(data + offset + 4);
+        const uint8_t* body = data + offset + 8;
+        if (chunk > (uint32_t)(size - offset - 8)) chunk = (uint32_t)(size - offset - 8);
+        if (memcmp(data + offset, "fmt ", 4) == 0 && chunk >= 16) {
+            uint32_t tag = read_u16(body);
+            channels = read_u16(body + 2);
+            src_rate = (int)read_u32(body + 4);
+            bits = read_u16(body + 14);
+            if (tag != 1 && tag != 0xFFFE) goto done;   // 只支持PCM (包括扩展格式头)
+        } else if (memcmp(data + offset, "data", 4) == 0) {
+            pcm = body;
+            pcm_size = chunk;
+        }
+        offset += 8 + chunk + (chunk & 1);
+    }
+    if (!pcm || (channels != 1 && channels != 2) || (bits != 8 && bits != 16) || src_rate <= 0) {
+        goto done;
+    }
+
+    int bytes = bits / 8 * channels;
+    int src_frames = (int)(pcm_size / bytes);
+    int frames = (int)((int64_t)src_frames * rate / src_rate);
+    if (src_frames <= 0 || frames <= 0) {
+        goto done;
+    }
+    sound->samples = malloc((size_t)frames * 2 * sizeof(int16_t));
+    if (!sound->samples) {
+        goto done;
+    }
+
+    // 源位置为32.32定点，在相邻两帧之间线性插值
+    uint64_t step = ((uint64_t)src_rate << 32) / rate;
+    uint64_t position = 0;
+    for (int i = 0; i < frames; i++, position += step) {
+        int index = (int)(position >> 32);
+        int next = index + 1 < src_frames ? index + 1 : index;
+        int32_t frac = (int32_t)((position >> 16) & 0xFFFF);
+        for (int c = 0; c < 2; c++) {
+            int channel = channels == 2 ? c : 0;
+            int32_t a, b;
+            if (bits == 16) {
+                a = (int16_t)read_u16(pcm + (size_t)index * bytes + channel * 2);
+                b = (int16_t)read_u16(pcm + (size_t)next * bytes + channel * 2);
+            } else {
+                a = (pcm[(size_t)index * bytes + channel] - 128) * 256;
+                b = (pcm[(size_t)next * bytes + channel] - 128) * 256;
+            }
+            sound->samples[i * 2 + c] = (int16_t)(a + (((b - a) * frac) >> 16));
+        }
+    }
+    sound->frames = frames;
+    rc = 0;
+
+done:
+    free(data);
+    return rc;
+}
+
+int audio_sound_tone(audio_sound_t* sound, int rate, int freq, int freq_end, int ms, int volume) {
+    memset(sound, 0, sizeof(*sound));
+    int frames = (int)((int64_t)rate * ms / 1000);
+    if (frames <= 0 || freq <= 0 || freq_end <= 0) {
+        return -1;
+    }
+    sound->samples = malloc((size_t)frames * 2 * sizeof(int16_t));
+    if (!sound->samples) {
+        return -1;
+    }
+
+    // 相位为32位二进制角度 (高16位给fx_sin)；2ms淡入，之后线性衰减到0
+    int attack = rate / 500 > 0 ? rate / 500 : 1;
+    int32_t amplitude = 32767 * (volume < AUDIO_VOLUME_MAX ? volume : AUDIO_VOLUME_MAX) / AUDIO_VOLUME_MAX;
+    uint32_t phase = 0;
+    for (int i = 0; i < frames; i++) {
+        int64_t f = freq + (int64_t)(freq_end - freq) * i / frames;
+        phase += (uint32_t)((f << 32) / rate);
+        int32_t envelope = i < attack ? (int32_t)((int64_t)amplitude * i / attack)
+                                      : (int32_t)((int64_t)amplitude * (frames - i) / (frames - attack));
+        int16_t v = (int16_t)(((int64_t)fx_sin(phase >> 16) * envelope) >> FX_SHIFT);
+        sound->samples[i * 2] = v;
+        sound->samples[i * 2 + 1] = v;
+    }
+    sound->frames = frames;
+    return 0;
+}
+
+void audio_sound_free(audio_sound_t* sound) {
+    free(sound->samples);
+    memset(sound, 0, sizeof(*sound));
+}
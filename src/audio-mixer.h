@@ -0,0 +1,136 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 音频混音 (不依赖SDL): 输出为交错的16位立体声，音频回调中调用 audio_mixer_render。
+//
+// 音效在启动时预先转换为输出的采样率和格式 (audio_sound_t)，混音时不再解码或重采样。
+// 每个声部的音量为Q16定点增益，所有声部累加到32位缓冲 (初始化时分配) 后乘主音量并饱和为16位。
+// 音量变化和停止在64帧内线性过渡，不会产生爆音。
+//
+// 界面线程 (唯一的写者) 通过无锁单写单读的命令环发送播放、停止和音量命令，回调在每次混音开始时
+// 取走所有命令；回调中不加锁、不分配内存、不调用可能阻塞的函数。声部都在使用中时替换
+// 最早开始的非循环声部: 被替换的声音移到淡出槽位，同样在64帧内过渡到0，新的声音不用等待。
+//
+// 回调间隔超过缓冲区时长的1.5倍时记为一次欠载 (设备缓冲已经放空)。
+
+#define AUDIO_MIXER_MAX_VOICES 32
+#define AUDIO_MIXER_QUEUE_SIZE 64        // 命令环容量 (2的幂)
+#define AUDIO_MIXER_RAMP_FRAMES 64       // 音量过渡的帧数
+#define AUDIO_MIXER_FADE_VOICES 4        // 被替换的声部淡出的槽位 (都在使用时放弃剩余最少的淡出)
+#define AUDIO_VOLUME_MAX 256             // 音量 0..256，声像 -256 (左) .. 256 (右)
+
+// 预转换的音效: 交错的16位立体声，采样率与混音输出相同
+typedef struct {
+    int16_t* samples;
+    int frames;
+} audio_sound_t;
+
+typedef enum {
+    AUDIO_CMD_PLAY,
+    AUDIO_CMD_STOP,
+    AUDIO_CMD_VOLUME,
+    AUDIO_CMD_STOP_ALL,
+    AUDIO_CMD_MASTER,
+} audio_command_type_t;
+
+typedef struct {
+    audio_command_type_t type;
+    uint32_t voice;              // 声部编号 (写者分配，0为无效)
+    const audio_sound_t* sound;
+    int32_t gain_left, gain_right;   // Q16
+    int loop;
+} audio_command_t;
+
+typedef struct {
+    const audio_sound_t* sound;  // NULL为空闲
+    uint32_t id;
+    int position;                // 下一帧的位置
+    int loop;
+    int stopping;                // 过渡到0后释放
+    int32_t gain_left, gain_right;   // 当前增益 (Q16)
+    int32_t step_left, step_right;   // 过渡中每帧的增量
+    int32_t target_left, target_right;
+    int ramp;                    // 剩余的过渡帧数
+    uint32_t started;            // 开始时的回调序号 (替换最早的)
+} audio_voice_t;
+
+typedef struct {
+    unsigned long callbacks;
+    unsigned long frames;
+    unsigned long underruns;     // 回调来得太晚
+    unsigned long late;          // 混音耗时超过缓冲区时长
+    unsigned long commands;      // 回调处理的命令数
+    unsigned long dropped;       // 命令环满时丢掉的命令 (写者)
+    unsigned long stolen;        // 被替换的声部
+    unsigned long clipped;       // 饱和的采样数
+    unsigned long mix_us;        // 混音累计耗时 (微秒)
+    unsigned long max_mix_us;
+    int active;                  // 当前发声的声部数
+    int peak;                    // 同时发声的最多声部数
+} audio_mixer_stats_t;
+
+typedef struct {
+    int rate;
+    int voice_count;
+    int max_frames;              // 一次混音的最大帧数，超过时分段
+    int32_t* mix;                // 累加缓冲 (max_frames * 2)
+    audio_voice_t voices[AUDIO_MIXER_MAX_VOICES];
+    audio_voice_t fading[AUDIO_MIXER_FADE_VOICES];   // 被替换后正在淡出的声音
+    int32_t master;              // Q16，只由回调访问
+    uint32_t sequence;
+
+    // 命令环: head只由写者推进，tail只由回调推进
+    audio_command_t queue[AUDIO_MIXER_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+    uint32_t next_voice;         // 只由写者访问
+
+    // 只由回调访问
+    uint64_t last_callback_ns;
+
+    // 回调写入、任意线程读取的统计
+    atomic_ulong callbacks;
+    atomic_ulong frames;
+    atomic_ulong underruns;
+    atomic_ulong late;
+    atomic_ulong commands;
+    atomic_ulong stolen;
+    atomic_ulong clipped;
+    atomic_ulong mix_us;
+    atomic_ulong max_mix_us;
+    atomic_int active;
+    atomic_int peak;
+    // 写者写入
+    atomic_ulong dropped;
+} audio_mixer_t;
+
+// rate为输出采样率 (设备实际打开的)，voices为声部数，max_frames为回调一次最多要求的帧数。失败返回-1
+int audio_mixer_init(audio_mixer_t* mixer, int rate, int voices, int max_frames);
+void audio_mixer_destroy(audio_mixer_t* mixer);
+
+// 音频回调: 处理命令后混出frames帧 (交错立体声)
+void audio_mixer_render(audio_mixer_t* mixer, int16_t* out, int frames);
+
+// 以下只由一个线程 (界面线程) 调用。命令环满时丢掉命令并返回0或-1
+uint32_t audio_mixer_play(audio_mixer_t* mixer, const audio_sound_t* sound, int volume, int pan, int loop);
+int audio_mixer_stop(audio_mixer_t* mixer, uint32_t voice);
+int audio_mixer_set_volume(audio_mixer_t* mixer, uint32_t voice, int volume, int pan);
+int audio_mixer_stop_all(audio_mixer_t* mixer);
+int audio_mixer_set_master(audio_mixer_t* mixer, int volume);
+
+// 统计 (任意线程，各计数分别读取)
+void audio_mixer_get_stats(audio_mixer_t* mixer, audio_mixer_stats_t* stats);
+
+// 读取WAV (8/16位PCM，单声道或立体声)，线性插值重采样到rate并转换为立体声。失败返回-1
+int audio_sound_load_wav(audio_sound_t* sound, const char* path, int rate);
+
+// 合成一个短音 (正弦，起止有淡入淡出)，用作界面音效。freq_end与freq不同时频率线性滑动
+int audio_sound_tone(audio_sound_t* sound, int rate, int freq, int freq_end, int ms, int volume);
+
+void audio_sound_free(audio_sound_t* sound);
+
+#endif
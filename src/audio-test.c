@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "audio-mixer.h"
+
+// 混音测试工具 (不需要声卡): 先直接调用混音检查结果，再用一个按缓冲区时长定时的线程模拟音频回调，
+// 界面线程同时不断发送命令，统计每次混音的耗时、欠载和命令数。
+//   1. 满音量居中时输出与音效逐位相同；声像偏右时左声道为0
+//   2. 两个声部相加后饱和
+//   3. 停止后在过渡帧数内降到0，并且逐帧减小 (没有爆音)
+//   4. 声部不够时替换最早的，被替换的声音逐帧淡出
+//   5. 命令环满时丢掉命令
+//   6. WAV读取和重采样
+//   7. 模拟回调
+// 例如:  ./audio-test -b 256 -v 16 -t 3 -o /tmp/mix.raw   (输出为48kHz 16位立体声的原始数据)
+// 所有检查通过返回0。
+
+typedef struct {
+    audio_mixer_t* mixer;
+    int frames;
+    FILE* out;
+    atomic_int quit;
+} device_t;
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-r 采样率] [-b 缓冲帧数] [-v 声部数] [-t 秒数] [-o 输出.raw]\n"
+            "  默认 48000Hz，256帧 (5.3ms)，16个声部，模拟回调3秒\n",
+            prog);
+}
+
+static int check(int ok, const char* message) {
+    if (!ok) {
+        printf("  检查失败: %s\n", message);
+    }
+    return ok ? 0 : 1;
+}
+
+static int constant_sound(audio_sound_t* sound, int frames, int16_t value) {
+    sound->samples = malloc((size_t)frames * 2 * sizeof(int16_t));
+    if (!sound->samples) return -1;
+    for (int i = 0; i < frames * 2; i++) sound->samples[i] = value;
+    sound->frames = frames;
+    return 0;
+}
+
+// 单声道16位WAV，采样值为 i * 100
+static int write_wav(const char* path, int rate, int frames) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return -1;
+    uint32_t data_size = frames * 2;
+    uint8_t header[44];
+    memcpy(header, "RIFF", 4);
+    uint32_t riff_size = 36 + data_size;
+    memcpy(header + 4, &riff_size, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    uint32_t fmt[] = {16, 1 | (1 << 16), (uint32_t)rate, (uint32_t)rate * 2, 2 | (16 << 16)};
+    memcpy(header + 16, fmt, sizeof(fmt));
+    memcpy(header + 36, "data", 4);
+    memcpy(header + 40, &data_size, 4);
+    fwrite(header, 1, sizeof(header), file);
+    for (int i = 0; i < frames; i++) {
+        int16_t v = (int16_t)(i * 100);
+        fwrite(&v, 2, 1, file);
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+static void* device_main(void* data) {
+    device_t* device = (device_t*)data;
+    int16_t* buffer = malloc((size_t)device->frames * 2 * sizeof(int16_t));
+    if (!buffer) return NULL;
+    long period = (long)device->frames * 1000000000L / device->mixer->rate;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!atomic_load(&device->quit)) {
+        audio_mixer_render(device->mixer, buffer, device->frames);
+        if (device->out) fwrite(buffer, sizeof(int16_t), (size_t)device->frames * 2, device->out);
+        next.tv_nsec += period;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    free(buffer);
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    int rate = 48000, frames = 256, voices = 16, seconds = 3;
+    const char* out_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:b:v:t:o:h")) != -1) {
+        switch (opt) {
+            case 'r': rate = atoi(optarg); break;
+            case 'b': frames = atoi(optarg); break;
+            case 'v': voices = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            case 'o': out_path = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc || rate < 8000 || frames < 16 || voices < 4 || voices > AUDIO_MIXER_MAX_VOICES || seconds < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int failures = 0;
+    static audio_mixer_t mixer;
+    audio_mixer_stats_t stats;
+    int16_t* out = malloc((size_t)rate * 2 * sizeof(int16_t));
+    audio_sound_t tone, loud, quiet, silence;
+    if (!out || audio_sound_tone(&tone, rate, 880, 440, 120, 200) < 0 || constant_sound(&loud, rate, 30000) < 0 ||
+        constant_sound(&quiet, rate, 10000) < 0 || constant_sound(&silence, rate, 0) < 0) {
+        fprintf(stderr, "错误: 内存不足\n");
+        return 1;
+    }
+
+    // 1. 满音量居中、声像偏右
+    audio_mixer_init(&mixer, rate, voices, 128);   // 小于一次的帧数，同时检查分段混音
+    audio_mixer_play(&mixer, &tone, AUDIO_VOLUME_MAX, 0, 0);
+    audio_mixer_render(&mixer, out, tone.frames);
+    failures += check(memcmp(out, tone.samples, (size_t)tone.frames * 4) == 0, "满音量输出与音效不同");
+    audio_mixer_play(&mixer, &tone, AUDIO_VOLUME_MAX, AUDIO_VOLUME_MAX, 0);
+    audio_mixer_render(&mixer, out, tone.frames);
+    int left_zero = 1, right_same = 1;
+    for (int i = 0; i < tone.frames; i++) {
+        if (out[i * 2] != 0) left_zero = 0;
+        if (out[i * 2 + 1] != tone.samples[i * 2 + 1]) right_same = 0;
+    }
+    failures += check(left_zero && right_same, "声像偏右时左声道应该为0");
+    audio_mixer_render(&mixer, out, 64);
+    audio_mixer_get_stats(&mixer, &stats);
+    failures += check(stats.active == 0, "播放完的声部没有释放");
+    printf("1.音量和声像: 音效%d帧，输出逐位相同\n", tone.frames);
+
+    // 2. 饱和
+    audio_mixer_play(&mixer, &loud, AUDIO_VOLUME_MAX, 0, 1);
+    audio_mixer_play(&mixer, &loud, AUDIO_VOLUME_MAX, 0, 1);
+    audio_mixer_render(&mixer, out, 256);
+    audio_mixer_get_stats(&mixer, &stats);
+    failures += check(out[0] == 32767 && out[511] == 32767 && stats.clipped == 512, "相加后应该饱和");
+    printf("2.饱和: 30000+30000 -> %d，饱和%lu个采样\n", out[0], stats.clipped);
+    audio_mixer_stop_all(&mixer);
+    audio_mixer_render(&mixer, out, 256);
+
+    // 3. 停止的过渡
+    uint32_t id = audio_mixer_play(&mixer, &quiet, AUDIO_VOLUME_MAX, 0, 1);
+    audio_mixer_render(&mixer, out, 100);
+    audio_mixer_stop(&mixer, id);
+    audio_mixer_render(&mixer, out, 256);
+    int monotonic = 1, silent = 1;
+    for (int i = 1; i < AUDIO_MIXER_RAMP_FRAMES; i++) {
+        if (out[i * 2] > out[(i - 1) * 2]) monotonic = 0;
+    }
+    for (int i = AUDIO_MIXER_RAMP_FRAMES; i < 256; i++) {
+        if (out[i * 2] || out[i * 2 + 1]) silent = 0;
+    }
+    failures += check(out[0] > 9000 && monotonic && silent, "停止时应该在过渡帧数内逐帧降到0");
+    printf("3.停止: %d -> %d -> %d (%d帧)\n", out[0], out[AUDIO_MIXER_RAMP_FRAMES / 2 * 2],
+           out[AUDIO_MIXER_RAMP_FRAMES * 2], AUDIO_MIXER_RAMP_FRAMES);
+
+    // 4. 替换声部
+    for (int i = 0; i < voices + 2; i++) {
+        audio_mixer_play(&mixer, &quiet, 16, 0, 0);
+        audio_mixer_render(&mixer, out, 16);
+    }
+    audio_mixer_get_stats(&mixer, &stats);
+    failures += check(stats.stolen == 2 && stats.active == voices, "声部不够时应该替换最早的");
+    audio_mixer_stop_all(&mixer);
+    audio_mixer_render(&mixer, out, 256);
+
+    // 所有声部都在循环时播放一个静音的声音: 最早的声部被替换，输出逐帧减小一个声部的音量
+    for (int i = 0; i < voices; i++) {
+        audio_mixer_play(&mixer, &quiet, 16, 0, 1);
+    }
+    audio_mixer_render(&mixer, out, 16);
+    int full = out[30];
+    audio_mixer_play(&mixer, &silence, AUDIO_VOLUME_MAX, 0, 0);
+    audio_mixer_render(&mixer, out, 256);
+    int gradual = 1;
+    for (int i = 1; i < AUDIO_MIXER_RAMP_FRAMES; i++) {
+        if (out[i * 2] > out[(i - 1) * 2] || out[(i - 1) * 2] - out[i * 2] > 100) gradual = 0;
+    }
+    int rest = out[AUDIO_MIXER_RAMP_FRAMES * 2];
+    failures += check(out[0] > full - 100 && gradual && rest == full - 625, "被替换的声音应该逐帧淡出");
+    printf("4.替换: 播放%d个，%d个声部，替换%lu个 | 替换循环声部: %d -> %d -> %d (%d帧)\n", voices + 2, voices,
+           stats.stolen, full, out[0], rest, AUDIO_MIXER_RAMP_FRAMES);
+    audio_mixer_stop_all(&mixer);
+    audio_mixer_render(&mixer, out, 256);
+    audio_mixer_get_stats(&mixer, &stats);
+
+    // 5. 命令环满
+    unsigned long before = stats.dropped;
+    for (int i = 0; i < AUDIO_MIXER_QUEUE_SIZE + 5; i++) {
+        audio_mixer_set_master(&mixer, AUDIO_VOLUME_MAX);
+    }
+    audio_mixer_render(&mixer, out, 16);
+    audio_mixer_get_stats(&mixer, &stats);
+    failures += check(stats.dropped - before == 5, "命令环满时应该丢掉多出的命令");
+    printf("5.命令环: 容量%d，丢掉%lu个\n", AUDIO_MIXER_QUEUE_SIZE, stats.dropped - before);
+    audio_mixer_destroy(&mixer);
+
+    // 6. WAV: 24kHz单声道重采样到输出采样率
+    char wav_path[] = "/tmp/audio-test-XXXXXX";
+    int fd = mkstemp(wav_path);
+    audio_sound_t wav;
+    if (fd < 0 || write_wav(wav_path, 24000, 100) < 0 || audio_sound_load_wav(&wav, wav_path, rate) < 0) {
+        failures += check(0, "无法读取WAV");
+    } else {
+        int expect = (int)((int64_t)100 * rate / 24000);
+        int ok = wav.frames == expect && wav.samples[0] == 0 && wav.samples[1] == 0;
+        if (rate == 48000) ok = ok && wav.samples[2] == 50 && wav.samples[4] == 100 && wav.samples[5] == 100;
+        failures += check(ok, "WAV重采样结果不对");
+        printf("6.WAV: 24000Hz单声道100帧 -> %dHz立体声%d帧\n", rate, wav.frames);
+        audio_sound_free(&wav);
+    }
+    if (fd >= 0) {
+        close(fd);
+        unlink(wav_path);
+    }
+
+    // 7. 模拟回调: 背景音乐循环，界面线程随机播放、调音量和停止
+    if (audio_mixer_init(&mixer, rate, voices, frames) < 0) {
+        fprintf(stderr, "错误: 混音初始化失败\n");
+        return 1;
+    }
+    device_t device = {&mixer, frames, NULL, 0};
+    atomic_init(&device.quit, 0);
+    if (out_path && !(device.out = fopen(out_path, "wb"))) {
+        fprintf(stderr, "错误: 无法写入 %s\n", out_path);
+        return 1;
+    }
+    audio_sound_t click, music;
+    audio_sound_tone(&click, rate, 1760, 1760, 30, 160);
+    audio_sound_tone(&music, rate, 220, 330, 2000, 96);
+    pthread_t thread;
+    pthread_create(&thread, NULL, device_main, &device);
+
+    unsigned long sent = 0, refused = 0;
+    uint32_t music_id = audio_mixer_play(&mixer, &music, 128, 0, 1);
+    sent++;
+    unsigned seed = 1;
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        seed = seed * 1103515245 + 12345;
+        int action = (seed >> 16) % 16;
+        int ok;
+        if (action < 10) {
+            ok = audio_mixer_play(&mixer, action & 1 ? &click : &tone, 64 + action * 16, (int)(seed % 513) - 256, 0) != 0;
+        } else if (action < 14) {
+            ok = audio_mixer_set_volume(&mixer, music_id, 32 + (seed >> 8) % 224, 0) == 0;
+        } else {
+            ok = audio_mixer_stop(&mixer, 0) == 0;   // 不存在的声部，回调直接忽略
+        }
+        sent++;
+        if (!ok) refused++;
+        struct timespec tick = {0, (long)((seed >> 20) % 8) * 1000000L};
+        nanosleep(&tick, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 < seconds * 1000L);
+
+    // 等回调取走剩下的命令
+    struct timespec drain = {0, 50000000};
+    nanosleep(&drain, NULL);
+    atomic_store(&device.quit, 1);
+    pthread_join(thread, NULL);
+    if (device.out) fclose(device.out);
+
+    audio_mixer_get_stats(&mixer, &stats);
+    double period_us = frames * 1000000.0 / rate;
+    double average = stats.callbacks ? (double)stats.mix_us / stats.callbacks : 0;
+    printf("7.模拟回调: %d帧 (%.1fms) | 回调%lu次 | 混音平均%.1fus 最长%luus (缓冲时长的%.1f%%) | 欠载%lu 超时%lu |"
+           " 命令%lu (发送%lu，丢掉%lu) | 替换%lu | 最多%d个声部 | 饱和%lu\n",
+           frames, period_us / 1000, stats.callbacks, average, stats.max_mix_us, average * 100 / period_us,
+           stats.underruns, stats.late, stats.commands, sent, stats.dropped, stats.stolen, stats.peak, stats.clipped);
+    failures += check(stats.commands + stats.dropped == sent && stats.dropped == refused, "有命令丢失");
+    failures += check(stats.callbacks >= (unsigned long)(seconds * rate / frames / 2), "回调次数太少");
+    audio_mixer_destroy(&mixer);
+
+    audio_sound_free(&click);
+    audio_sound_free(&music);
+    audio_sound_free(&tone);
+    audio_sound_free(&loud);
+    audio_sound_free(&quiet);
+    audio_sound_free(&silence);
+    free(out);
+    printf("%s\n", failures ? "失败" : "全部通过");
+    return failures ? 1 : 0;
+}
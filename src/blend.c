@@ -0,0 +1,300 @@
+#include "blend.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BLEND_HAVE_NEON 1
+#endif
+
+// t / 255 四舍五入 (t <= 255*255)，与NEON的 vraddhn(t, vrshr(t, 8)) 相同
+static inline uint32_t div255(uint32_t t) {
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline int clamp_alpha(int alpha) {
+    return alpha < 0 ? 0 : (alpha > 255 ? 255 : alpha);
+}
+
+static inline uint16_t blend_565(uint32_t d, uint32_t s, uint32_t a) {
+    uint32_t ia = 255 - a;
+    uint32_t r = div255((s >> 11) * a + (d >> 11) * ia);
+    uint32_t g = div255(((s >> 5) & 0x3F) * a + ((d >> 5) & 0x3F) * ia);
+    uint32_t b = div255((s & 0x1F) * a + (d & 0x1F) * ia);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// 4个字节分量都混合 (X分量也按同样方式计算，与NEON的vld4一致)
+static inline uint32_t blend_8888(uint32_t d, uint32_t s, uint32_t a) {
+    uint32_t ia = 255 - a;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        out |= div255(((s >> shift) & 0xFF) * a + ((d >> shift) & 0xFF) * ia) << shift;
+    }
+    return out;
+}
+
+// ===== 标量参考实现 =====
+
+void blend_fill_row_ref(pixel_format_t format, void* dst, uint32_t pixel, int count, int alpha) {
+    alpha = clamp_alpha(alpha);
+    if (alpha == 0 || count <= 0) return;
+    if (alpha == 255) {
+        pixel_fill_row(format, dst, pixel, count);
+        return;
+    }
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        for (int i = 0; i < count; i++) {
+            p[i] = blend_565(p[i], pixel, alpha);
+        }
+    } else {
+        uint32_t* p = (uint32_t*)dst;
+        for (int i = 0; i < count; i++) {
+            p[i] = blend_8888(p[i], pixel, alpha);
+        }
+    }
+}
+
+void blend_copy_row_ref(pixel_format_t format, void* dst, const void* src, int count, int alpha) {
+    alpha = clamp_alpha(alpha);
+    if (alpha == 0 || count <= 0) return;
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        const uint16_t* s = (const uint16_t*)src;
+        for (int i = 0; i < count; i++) {
+            p[i] = blend_565(p[i], s[i], alpha);
+        }
+    } else {
+        uint32_t* p = (uint32_t*)dst;
+        const uint32_t* s = (const uint32_t*)src;
+        for (int i = 0; i < count; i++) {
+            p[i] = blend_8888(p[i], s[i], alpha);
+        }
+    }
+}
+
+void blend_mask_row_ref(pixel_format_t format, void* dst, uint32_t pixel,
+                        const uint8_t* mask, int count, int opacity) {
+    opacity = clamp_alpha(opacity);
+    if (opacity == 0 || count <= 0) return;
+    int bytes = pixel_format_bytes(format);
+    for (int i = 0; i < count; i++) {
+        uint32_t a = opacity == 255 ? mask[i] : div255(mask[i] * (uint32_t)opacity);
+        // a为0或255时公式的结果就是原值或源颜色，直接跳过或写入
+        if (a == 0) continue;
+        if (bytes == 2) {
+            uint16_t* p = (uint16_t*)dst + i;
+            *p = a == 255 ? (uint16_t)pixel : blend_565(*p, pixel, a);
+        } else {
+            uint32_t* p = (uint32_t*)dst + i;
+            *p = a == 255 ? pixel : blend_8888(*p, pixel, a);
+        }
+    }
+}
+
+void blend_copy_mask_row_ref(pixel_format_t format, void* dst, const void* src,
+                             const uint8_t* mask, int count, int opacity) {
+    opacity = clamp_alpha(opacity);
+    if (opacity == 0 || count <= 0) return;
+    int bytes = pixel_format_bytes(format);
+    for (int i = 0; i < count; i++) {
+        uint32_t a = opacity == 255 ? mask[i] : div255(mask[i] * (uint32_t)opacity);
+        if (a == 0) continue;
+        if (bytes == 2) {
+            uint16_t* p = (uint16_t*)dst + i;
+            uint16_t s = ((const uint16_t*)src)[i];
+            *p = a == 255 ? s : blend_565(*p, s, a);
+        } else {
+            uint32_t* p = (uint32_t*)dst + i;
+            uint32_t s = ((const uint32_t*)src)[i];
+            *p = a == 255 ? s : blend_8888(*p, s, a);
+        }
+    }
+}
+
+// ===== NEON =====
+
+#ifdef BLEND_HAVE_NEON
+
+static inline uint16x8_t div255_u16(uint16x8_t t) {
+    t = vaddq_u16(t, vdupq_n_u16(128));
+    return vshrq_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+static inline uint8x8_t div255_narrow(uint16x8_t t) {
+    return vraddhn_u16(t, vrshrq_n_u16(t, 8));
+}
+
+// 8个565像素: 拆成5/6/5位分量分别计算
+static inline uint16x8_t blend_565_x8(uint16x8_t d, uint16x8_t s, uint16x8_t a) {
+    uint16x8_t ia = vsubq_u16(vdupq_n_u16(255), a);
+    uint16x8_t mask6 = vdupq_n_u16(0x3F);
+    uint16x8_t mask5 = vdupq_n_u16(0x1F);
+
+    uint16x8_t r = vmlaq_u16(vmulq_u16(vshrq_n_u16(s, 11), a), vshrq_n_u16(d, 11), ia);
+    uint16x8_t g = vmlaq_u16(vmulq_u16(vandq_u16(vshrq_n_u16(s, 5), mask6), a),
+                             vandq_u16(vshrq_n_u16(d, 5), mask6), ia);
+    uint16x8_t b = vmlaq_u16(vmulq_u16(vandq_u16(s, mask5), a), vandq_u16(d, mask5), ia);
+
+    return vorrq_u16(vshlq_n_u16(div255_u16(r), 11),
+                     vorrq_u16(vshlq_n_u16(div255_u16(g), 5), div255_u16(b)));
+}
+
+// 16个8888像素的一个分量
+static inline uint8x16_t blend_u8_x16(uint8x16_t d, uint8x16_t s, uint8x16_t a, uint8x16_t ia) {
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s), vget_low_u8(a)), vget_low_u8(d), vget_low_u8(ia));
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(s), vget_high_u8(a)), vget_high_u8(d), vget_high_u8(ia));
+    return vcombine_u8(div255_narrow(lo), div255_narrow(hi));
+}
+
+static inline uint8x16x4_t blend_8888_x16(uint8x16x4_t d, uint8x16x4_t s, uint8x16_t a) {
+    uint8x16_t ia = vmvnq_u8(a);
+    for (int c = 0; c < 4; c++) {
+        d.val[c] = blend_u8_x16(d.val[c], s.val[c], a, ia);
+    }
+    return d;
+}
+
+static inline uint8x16x4_t splat_8888(uint32_t pixel) {
+    uint8x16x4_t s;
+    s.val[0] = vdupq_n_u8(pixel & 0xFF);
+    s.val[1] = vdupq_n_u8((pixel >> 8) & 0xFF);
+    s.val[2] = vdupq_n_u8((pixel >> 16) & 0xFF);
+    s.val[3] = vdupq_n_u8(pixel >> 24);
+    return s;
+}
+
+// 不透明度作用到覆盖率上: m * opacity / 255
+static inline uint8x8_t scale_mask_x8(uint8x8_t m, uint8x8_t opacity) {
+    return div255_narrow(vmull_u8(m, opacity));
+}
+
+#endif
+
+// ===== 对外接口: 向量部分处理整组，剩余的像素交给参考实现 =====
+
+void blend_fill_row(pixel_format_t format, void* dst, uint32_t pixel, int count, int alpha) {
+    alpha = clamp_alpha(alpha);
+    if (alpha == 0 || count <= 0) return;
+    if (alpha == 255) {
+        pixel_fill_row(format, dst, pixel, count);
+        return;
+    }
+    int i = 0;
+#ifdef BLEND_HAVE_NEON
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        uint16x8_t s = vdupq_n_u16((uint16_t)pixel);
+        uint16x8_t a = vdupq_n_u16(alpha);
+        for (; i + 8 <= count; i += 8) {
+            vst1q_u16(p + i, blend_565_x8(vld1q_u16(p + i), s, a));
+        }
+    } else {
+        uint8_t* p = (uint8_t*)dst;
+        uint8x16x4_t s = splat_8888(pixel);
+        uint8x16_t a = vdupq_n_u8(alpha);
+        for (; i + 16 <= count; i += 16) {
+            vst4q_u8(p + i * 4, blend_8888_x16(vld4q_u8(p + i * 4), s, a));
+        }
+    }
+#endif
+    int bytes = pixel_format_bytes(format);
+    blend_fill_row_ref(format, (uint8_t*)dst + (size_t)i * bytes, pixel, count - i, alpha);
+}
+
+void blend_copy_row(pixel_format_t format, void* dst, const void* src, int count, int alpha) {
+    alpha = clamp_alpha(alpha);
+    if (alpha == 0 || count <= 0) return;
+    int i = 0;
+#ifdef BLEND_HAVE_NEON
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        const uint16_t* s = (const uint16_t*)src;
+        uint16x8_t a = vdupq_n_u16(alpha);
+        for (; i + 8 <= count; i += 8) {
+            vst1q_u16(p + i, blend_565_x8(vld1q_u16(p + i), vld1q_u16(s + i), a));
+        }
+    } else {
+        uint8_t* p = (uint8_t*)dst;
+        const uint8_t* s = (const uint8_t*)src;
+        uint8x16_t a = vdupq_n_u8(alpha);
+        for (; i + 16 <= count; i += 16) {
+            vst4q_u8(p + i * 4, blend_8888_x16(vld4q_u8(p + i * 4), vld4q_u8(s + i * 4), a));
+        }
+    }
+#endif
+    int bytes = pixel_format_bytes(format);
+    blend_copy_row_ref(format, (uint8_t*)dst + (size_t)i * bytes,
+                       (const uint8_t*)src + (size_t)i * bytes, count - i, alpha);
+}
+
+void blend_mask_row(pixel_format_t format, void* dst, uint32_t pixel,
+                    const uint8_t* mask, int count, int opacity) {
+    opacity = clamp_alpha(opacity);
+    if (opacity == 0 || count <= 0) return;
+    int i = 0;
+#ifdef BLEND_HAVE_NEON
+    uint8x8_t op = vdup_n_u8(opacity);
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        uint16x8_t s = vdupq_n_u16((uint16_t)pixel);
+        for (; i + 8 <= count; i += 8) {
+            uint8x8_t m = vld1_u8(mask + i);
+            if (opacity != 255) m = scale_mask_x8(m, op);
+            vst1q_u16(p + i, blend_565_x8(vld1q_u16(p + i), s, vmovl_u8(m)));
+        }
+    } else {
+        uint8_t* p = (uint8_t*)dst;
+        uint8x16x4_t s = splat_8888(pixel);
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t m = vld1q_u8(mask + i);
+            if (opacity != 255) {
+                m = vcombine_u8(scale_mask_x8(vget_low_u8(m), op), scale_mask_x8(vget_high_u8(m), op));
+            }
+            vst4q_u8(p + i * 4, blend_8888_x16(vld4q_u8(p + i * 4), s, m));
+        }
+    }
+#endif
+    int bytes = pixel_format_bytes(format);
+    blend_mask_row_ref(format, (uint8_t*)dst + (size_t)i * bytes, pixel, mask + i, count - i, opacity);
+}
+
+void blend_copy_mask_row(pixel_format_t format, void* dst, const void* src,
+                         const uint8_t* mask, int count, int opacity) {
+    opacity = clamp_alpha(opacity);
+    if (opacity == 0 || count <= 0) return;
+    int i = 0;
+#ifdef BLEND_HAVE_NEON
+    uint8x8_t op = vdup_n_u8(opacity);
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        const uint16_t* s = (const uint16_t*)src;
+        for (; i + 8 <= count; i += 8) {
+            uint8x8_t m = vld1_u8(mask + i);
+            if (opacity != 255) m = scale_mask_x8(m, op);
+            vst1q_u16(p + i, blend_565_x8(vld1q_u16(p + i), vld1q_u16(s + i), vmovl_u8(m)));
+        }
+    } else {
+        uint8_t* p = (uint8_t*)dst;
+        const uint8_t* s = (const uint8_t*)src;
+        for (; i + 16 <= count; i += 16) {
+            uint8x16_t m = vld1q_u8(mask + i);
+            if (opacity != 255) {
+                m = vcombine_u8(scale_mask_x8(vget_low_u8(m), op), scale_mask_x8(vget_high_u8(m), op));
+            }
+            vst4q_u8(p + i * 4, blend_8888_x16(vld4q_u8(p + i * 4), vld4q_u8(s + i * 4), m));
+        }
+    }
+#endif
+    int bytes = pixel_format_bytes(format);
+    blend_copy_mask_row_ref(format, (uint8_t*)dst + (size_t)i * bytes, (const uint8_t*)src + (size_t)i * bytes,
+                            mask + i, count - i, opacity);
+}
+
+const char* blend_backend(void) {
+#ifdef BLEND_HAVE_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef BLEND_H
+#define BLEND_H
+
+#include <stdint.h>
+#include "pixel-format.h"
+
+// 透明混合 (source-over) 内核，目标为一行原生格式像素 (RGB565/BGR565 或 XRGB8888/XBGR8888)。
+//
+// 每个分量都按 d' = (s*a + d*(255-a)) / 255 四舍五入计算，565在5/6位分量上直接计算，
+// 不展开到8位。有NEON时565每次处理8个像素、8888每次处理16个像素，
+// 结果与 *_ref 标量参考实现逐位相同 (fb-test 启动时会自检)。
+
+// 纯色以固定不透明度alpha (0-255) 覆盖一行，用于半透明面板
+void blend_fill_row(pixel_format_t format, void* dst, uint32_t pixel, int count, int alpha);
+
+// 同格式的源像素行以固定不透明度覆盖，用于叠加图层
+void blend_copy_row(pixel_format_t format, void* dst, const void* src, int count, int alpha);
+
+// 按A8覆盖率 (例如字形) 混合纯色，opacity为整体不透明度
+void blend_mask_row(pixel_format_t format, void* dst, uint32_t pixel,
+                    const uint8_t* mask, int count, int opacity);
+
+// 源像素行按各自的A8不透明度 (例如图片的alpha平面) 混合，opacity为整体不透明度
+void blend_copy_mask_row(pixel_format_t format, void* dst, const void* src,
+                         const uint8_t* mask, int count, int opacity);
+
+// 标量参考实现
+void blend_fill_row_ref(pixel_format_t format, void* dst, uint32_t pixel, int count, int alpha);
+void blend_copy_row_ref(pixel_format_t format, void* dst, const void* src, int count, int alpha);
+void blend_mask_row_ref(pixel_format_t format, void* dst, uint32_t pixel,
+                        const uint8_t* mask, int count, int opacity);
+void blend_copy_mask_row_ref(pixel_format_t format, void* dst, const void* src,
+                             const uint8_t* mask, int count, int opacity);
+
+// 当前使用的实现 ("neon" 或 "scalar")
+const char* blend_backend(void);
+
+#endif
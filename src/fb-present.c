@@ -0,0 +1,205 @@
+#include "fb-present.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+int fb_present_open(fb_present_t* fb, const char* path) {
+    memset(fb, 0, sizeof(*fb));
+    fb->fd = open(path, O_RDWR);
+    if (fb->fd < 0) {
+        fb->fd = -1;
+        return -1;
+    }
+
+    struct fb_var_screeninfo vinfo;
+    struct fb_fix_screeninfo finfo;
+    if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &vinfo) < 0) {
+        close(fb->fd);
+        fb->fd = -1;
+        return -1;
+    }
+    fb->saved_yoffset = vinfo.yoffset;
+    fb->saved_yres_virtual = vinfo.yres_virtual;
+
+    // 虚拟高度不够两页时尝试扩大，驱动不支持就退回单缓冲
+    if (vinfo.yres_virtual < vinfo.yres * 2) {
+        struct fb_var_screeninfo want = vinfo;
+        want.yres_virtual = vinfo.yres * 2;
+        want.yoffset = 0;
+        if (ioctl(fb->fd, FBIOPUT_VSCREENINFO, &want) == 0) {
+            ioctl(fb->fd, FBIOGET_VSCREENINFO, &vinfo);
+        }
+    }
+    if (ioctl(fb->fd, FBIOGET_FSCREENINFO, &finfo) < 0) {
+        fb_present_close(fb);
+        return -1;
+    }
+
+    fb->var = vinfo;
+    fb->width = vinfo.xres;
+    fb->height = vinfo.yres;
+    fb->bits_per_pixel = vinfo.bits_per_pixel;
+    fb->line_length = finfo.line_length;
+    fb->red_offset = vinfo.red.offset;
+    fb->green_offset = vinfo.green.offset;
+    fb->blue_offset = vinfo.blue.offset;
+
+    size_t page_size = (size_t)fb->line_length * fb->height;
+    fb->pages = (vinfo.yres_virtual >= vinfo.yres * 2 && finfo.smem_len >= page_size * 2) ? 2 : 1;
+    fb->memory_size = page_size * fb->pages;
+    if (page_size == 0 || finfo.smem_len < page_size ||
+        (fb->bits_per_pixel != 16 && fb->bits_per_pixel != 32)) {
+        fb_present_close(fb);
+        return -1;
+    }
+
+    void* memory = mmap(NULL, fb->memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fb->fd, 0);
+    if (memory == MAP_FAILED) {
+        fb_present_close(fb);
+        return -1;
+    }
+    fb->memory = memory;
+
+    // 从当前没有显示的那一页开始写
+    fb->back_page = (fb->pages == 2 && vinfo.yoffset < vinfo.yres) ? 1 : 0;
+    fb->vsync = 1;
+
+    // 两页原来的内容都不是我们的画面，第一次写入时整页复制
+    for (int page = 0; page < 2; page++) {
+        fb->stale_y0[page] = 0;
+        fb->stale_y1[page] = fb->height;
+    }
+    return 0;
+}
+
+void fb_present_close(fb_present_t* fb) {
+    if (fb->memory) {
+        munmap(fb->memory, fb->memory_size);
+    }
+    if (fb->fd >= 0) {
+        // 恢复控制台原来的虚拟分辨率和显示位置
+        struct fb_var_screeninfo vinfo;
+        if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &vinfo) == 0 &&
+            ((int)vinfo.yres_virtual != fb->saved_yres_virtual || (int)vinfo.yoffset != fb->saved_yoffset)) {
+            vinfo.yres_virtual = fb->saved_yres_virtual;
+            vinfo.yoffset = fb->saved_yoffset;
+            ioctl(fb->fd, FBIOPUT_VSCREENINFO, &vinfo);
+        }
+        close(fb->fd);
+    }
+    memset(fb, 0, sizeof(*fb));
+    fb->fd = -1;
+}
+
+int fb_present_frame(fb_present_t* fb, const void* pixels, int pitch, int wait_vsync) {
+    return fb_present_frame_rows(fb, pixels, pitch, 0, fb->height, wait_vsync);
+}
+
+int fb_present_frame_rows(fb_present_t* fb, const void* pixels, int pitch, int y0, int y1, int wait_vsync) {
+    if (y0 < 0) y0 = 0;
+    if (y1 > fb->height) y1 = fb->height;
+
+    // 另一页 (正在显示的) 同样缺少这一帧变化的行
+    if (fb->pages == 2 && y0 < y1) {
+        int other = fb->back_page ^ 1;
+        if (fb->stale_y0[other] >= fb->stale_y1[other]) {
+            fb->stale_y0[other] = y0;
+            fb->stale_y1[other] = y1;
+        } else {
+            if (y0 < fb->stale_y0[other]) fb->stale_y0[other] = y0;
+            if (y1 > fb->stale_y1[other]) fb->stale_y1[other] = y1;
+        }
+    }
+
+    // 本页要复制的行: 这一帧变化的行加上本页之前落下的行
+    int page = fb->back_page;
+    if (fb->stale_y0[page] < fb->stale_y1[page]) {
+        if (y0 >= y1) {
+            y0 = fb->stale_y0[page];
+            y1 = fb->stale_y1[page];
+        } else {
+            if (fb->stale_y0[page] < y0) y0 = fb->stale_y0[page];
+            if (fb->stale_y1[page] > y1) y1 = fb->stale_y1[page];
+        }
+        fb->stale_y0[page] = fb->stale_y1[page] = 0;
+    }
+
+    uint8_t* dst = fb->memory + (size_t)page * fb->line_length * fb->height;
+    const uint8_t* src = pixels;
+    int row_bytes = fb->width * (fb->bits_per_pixel / 8);
+
+    // 显存通常是写合并的: 只做顺序写入，不在显存上读写混合绘制
+    fb->copied_bytes = y0 < y1 ? (size_t)row_bytes * (y1 - y0) : 0;
+    if (y0 < y1) {
+        if (pitch == fb->line_length && row_bytes == fb->line_length) {
+            memcpy(dst + (size_t)y0 * row_bytes, src + (size_t)y0 * pitch, (size_t)row_bytes * (y1 - y0));
+        } else {
+            for (int y = y0; y < y1; y++) {
+                memcpy(dst + (size_t)y * fb->line_length, src + (size_t)y * pitch, row_bytes);
+            }
+        }
+    }
+
+    // 用打开时读到的完整参数翻页 (fb-test也是这样)，失败时重新读取一次参数再试
+    if (fb->pages == 2) {
+        struct fb_var_screeninfo pan = fb->var;
+        pan.yoffset = fb->back_page * fb->height;
+        if (ioctl(fb->fd, FBIOPAN_DISPLAY, &pan) < 0) {
+            if (ioctl(fb->fd, FBIOGET_VSCREENINFO, &fb->var) < 0) {
+                return -1;
+            }
+            pan = fb->var;
+            pan.yoffset = fb->back_page * fb->height;
+            if (ioctl(fb->fd, FBIOPAN_DISPLAY, &pan) < 0) {
+                return -1;
+            }
+        }
+    }
+
+    int synced = 0;
+    if (wait_vsync && fb->vsync) {
+        __u32 crtc = 0;
+        if (ioctl(fb->fd, FBIO_WAITFORVSYNC, &crtc) == 0) {
+            synced = 1;
+        } else {
+            fb->vsync = 0;
+        }
+    }
+
+    // 翻页后原来的前台页成为下一帧的后台页
+    if (fb->pages == 2) {
+        fb->back_page ^= 1;
+    }
+    return synced;
+}
+
+#else
+
+int fb_present_open(fb_present_t* fb, const char* path) {
+    (void)path;
+    memset(fb, 0, sizeof(*fb));
+    fb->fd = -1;
+    return -1;
+}
+
+void fb_present_close(fb_present_t* fb) {
+    memset(fb, 0, sizeof(*fb));
+    fb->fd = -1;
+}
+
+int fb_present_frame(fb_present_t* fb, const void* pixels, int pitch, int wait_vsync) {
+    (void)fb; (void)pixels; (void)pitch; (void)wait_vsync;
+    return -1;
+}
+
+int fb_present_frame_rows(fb_present_t* fb, const void* pixels, int pitch, int y0, int y1, int wait_vsync) {
+    (void)fb; (void)pixels; (void)pitch; (void)y0; (void)y1; (void)wait_vsync;
+    return -1;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FB_PRESENT_H
+#define FB_PRESENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __linux__
+#include <linux/fb.h>
+#endif
+
+// 直接输出到帧缓冲 (fbdev): 映射显存，把渲染好的画面复制到后台页再翻页。
+// 虚拟分辨率能容纳两页时用 FBIOPAN_DISPLAY 双缓冲，否则直接写前台页。
+// 非Linux平台上 fb_present_open 总是失败。
+
+typedef struct {
+    int fd;
+    uint8_t* memory;
+    size_t memory_size;
+
+    int width;
+    int height;
+    int bits_per_pixel;
+    int line_length;         // 每行字节数 (可能大于 width * 每像素字节数)
+    int red_offset;          // 颜色分量位置，用于选择匹配的像素格式
+    int green_offset;
+    int blue_offset;
+
+    int pages;               // 1 或 2
+    int back_page;           // 下一帧写入的页
+    int vsync;               // FBIO_WAITFORVSYNC 可用
+#ifdef __linux__
+    // 翻页时传给 FBIOPAN_DISPLAY 的完整参数 (只改yoffset)，有的驱动从中读取分辨率和色深
+    struct fb_var_screeninfo var;
+#endif
+
+    // 每页与最新画面不同的行范围 [y0, y1)，翻页前先补上后台页落下的行
+    int stale_y0[2];
+    int stale_y1[2];
+
+    size_t copied_bytes;     // 上一帧复制到显存的字节数
+
+    int saved_yoffset;       // 关闭时恢复控制台的显示位置
+    int saved_yres_virtual;
+} fb_present_t;
+
+// 打开并映射帧缓冲，失败返回-1
+int fb_present_open(fb_present_t* fb, const char* path);
+void fb_present_close(fb_present_t* fb);
+
+// 把一帧 (与帧缓冲相同的像素格式，宽高为 width x height) 复制到后台页并翻页。
+// wait_vsync 为真时等待垂直同步，返回1表示已同步，0表示未同步，-1表示失败
+int fb_present_frame(fb_present_t* fb, const void* pixels, int pitch, int wait_vsync);
+
+// 同上，但只有 [y0, y1) 行与上一帧不同: 后台页只复制这些行和它自己落下的行
+int fb_present_frame_rows(fb_present_t* fb, const void* pixels, int pitch, int y0, int y1, int wait_vsync);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef FIXMATH_H
+#define FIXMATH_H
+
+#include <stdint.h>
+
+// 定点数学 (Q16.16)，用于帧缓冲路径的动画
+// 不调用libm，也不使用浮点运算，同样的输入在主机和掌机上得到逐位相同的结果，
+// 便于用图像校验和对比画面。
+//
+// 角度用二进制角度表示: 65536为一整圈，加减乘法溢出后自然回绕。
+// 正弦查四分之一周期的预计算表 (257项) 后线性插值，误差不超过2/65536。
+
+typedef int32_t fx_t;
+typedef uint32_t fx_angle_t;
+
+#define FX_SHIFT 16
+#define FX_ONE   (1 << FX_SHIFT)
+
+// 编译期常量 (例如 FX_CONST(0.016))，在编译时折叠，运行时没有浮点运算
+#define FX_CONST(x) ((fx_t)((x) >= 0 ? (x) * FX_ONE + 0.5 : (x) * FX_ONE - 0.5))
+
+// 一整圈对应的二进制角度
+#define FX_ANGLE_TURN 65536
+
+// 每弧度对应的二进制角度 (65536 / 2π)，Q16.16
+#define FX_RAD_TO_ANGLE 683565276LL
+
+static inline fx_t fx_from_int(int value) {
+    return (fx_t)((uint32_t)value << FX_SHIFT);
+}
+
+// 向下取整
+static inline int fx_to_int(fx_t value) {
+    return value >> FX_SHIFT;
+}
+
+static inline fx_t fx_mul(fx_t a, fx_t b) {
+    return (fx_t)(((int64_t)a * b) >> FX_SHIFT);
+}
+
+static inline fx_t fx_div(fx_t a, fx_t b) {
+    return (fx_t)(((int64_t)a << FX_SHIFT) / b);
+}
+
+// 弧度 (Q16.16) 转为二进制角度
+static inline fx_angle_t fx_angle_from_rad(fx_t radians) {
+    return (fx_angle_t)(((int64_t)radians * FX_RAD_TO_ANGLE) >> 32);
+}
+
+// 正弦和余弦，结果为Q16.16 (-1.0 到 1.0)
+fx_t fx_sin(fx_angle_t angle);
+
+static inline fx_t fx_cos(fx_angle_t angle) {
+    return fx_sin(angle + FX_ANGLE_TURN / 4);
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "font-cache.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// TTF_GlyphMetrics32 从SDL_ttf 2.0.18开始提供
+#if defined(SDL_TTF_VERSION_ATLEAST)
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+#define HAVE_GLYPH_METRICS32 1
+#endif
+#endif
+
+static double elapsed_ms(Uint64 start) {
+    return (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// 映射字体文件，所有字号共享同一份只读内存
+static int map_font_file(font_cache_t* cache) {
+    int fd = open(cache->path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    cache->data = data;
+    cache->size = st.st_size;
+    return 0;
+}
+
+int font_cache_init(font_cache_t* cache, const char* const* paths) {
+    memset(cache, 0, sizeof(*cache));
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; paths[i]; i++) {
+        if (access(paths[i], R_OK) == 0) {
+            snprintf(cache->path, sizeof(cache->path), "%s", paths[i]);
+            break;
+        }
+    }
+    cache->resolve_ms = elapsed_ms(start);
+
+    if (!cache->path[0]) {
+        return -1;
+    }
+
+    start = SDL_GetPerformanceCounter();
+    if (map_font_file(cache) < 0) {
+        // 映射失败时退回TTF_OpenFont按路径打开
+        cache->data = NULL;
+        cache->size = 0;
+    }
+    cache->map_ms = elapsed_ms(start);
+    return 0;
+}
+
+TTF_Font* font_cache_get(font_cache_t* cache, int ptsize) {
+    // 相同字号只打开一次
+    for (int i = 0; i < cache->face_count; i++) {
+        if (cache->faces[i].ptsize == ptsize) {
+            return cache->faces[i].font;
+        }
+    }
+
+    if (!cache->path[0] || cache->face_count >= FONT_CACHE_MAX_FACES) {
+        return NULL;
+    }
+
+    font_face_t* face = &cache->faces[cache->face_count++];
+    face->ptsize = ptsize;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    // SDL_RWFromConstMem的大小是int，超过INT_MAX的映射 (不会出现在实际字体上) 按路径打开
+    if (cache->data && cache->size <= (size_t)INT_MAX) {
+        SDL_RWops* rw = SDL_RWFromConstMem(cache->data, (int)cache->size);
+        face->font = rw ? TTF_OpenFontRW(rw, 1, ptsize) : NULL;
+    } else {
+        face->font = TTF_OpenFont(cache->path, ptsize);
+    }
+    face->load_ms = elapsed_ms(start);
+    face->failed = face->font == NULL;
+
+    return face->font;
+}
+
+int font_cache_advance(font_cache_t* cache, int ptsize, uint32_t cp) {
+    TTF_Font* font = font_cache_get(cache, ptsize);
+    if (!font) {
+        return -1;
+    }
+    int advance;
+#ifdef HAVE_GLYPH_METRICS32
+    if (TTF_GlyphMetrics32(font, cp, NULL, NULL, NULL, NULL, &advance) < 0) {
+        return -1;
+    }
+    return advance;
+#else
+    // 旧版SDL_ttf只有16位的字形接口: 按单个字符的UTF-8字符串测量
+    char text[5];
+    int len;
+    if (cp < 0x80) {
+        text[0] = (char)cp; len = 1;
+    } else if (cp < 0x800) {
+        text[0] = (char)(0xC0 | (cp >> 6)); text[1] = (char)(0x80 | (cp & 0x3F)); len = 2;
+    } else if (cp < 0x10000) {
+        text[0] = (char)(0xE0 | (cp >> 12)); text[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        text[2] = (char)(0x80 | (cp & 0x3F)); len = 3;
+    } else {
+        text[0] = (char)(0xF0 | (cp >> 18)); text[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+        text[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); text[3] = (char)(0x80 | (cp & 0x3F)); len = 4;
+    }
+    text[len] = '\0';
+    int height;
+    if (TTF_SizeUTF8(font, text, &advance, &height) < 0) {
+        return -1;
+    }
+    return advance;
+#endif
+}
+
+void font_cache_log_stats(const font_cache_t* cache, void (*log)(const char* message)) {
+    char msg[384];
+
+    snprintf(msg, sizeof(msg), "Font file: %s (%s, %zu bytes) | resolve %.2f ms | map %.2f ms",
+             cache->path[0] ? cache->path : "(none)",
+             cache->data ? "mmap" : "path", cache->size,
+             cache->resolve_ms, cache->map_ms);
+    log(msg);
+
+    for (int i = 0; i < cache->face_count; i++) {
+        const font_face_t* face = &cache->faces[i];
+        snprintf(msg, sizeof(msg), "Font face %dpt: %s in %.2f ms",
+                 face->ptsize, face->failed ? "failed" : "opened", face->load_ms);
+        log(msg);
+    }
+}
+
+void font_cache_destroy(font_cache_t* cache) {
+    for (int i = 0; i < cache->face_count; i++) {
+        if (cache->faces[i].font) {
+            TTF_CloseFont(cache->faces[i].font);
+        }
+    }
+    if (cache->data) {
+        munmap((void*)cache->data, cache->size);
+    }
+    memset(cache, 0, sizeof(*cache));
+}
@@ -0,0 +1,46 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL2/SDL_ttf.h>
+
+// 字体管理: 字体文件只解析路径并映射一次，相同字号的字体共享一个TTF_Font，
+// 字体在第一次使用时才打开。
+
+#define FONT_CACHE_MAX_FACES 8
+
+// 一个已打开 (或待打开) 的字号
+typedef struct {
+    int ptsize;
+    TTF_Font* font;
+    int failed;          // 打开失败后不再重试
+    double load_ms;      // 打开耗时
+} font_face_t;
+
+typedef struct {
+    char path[256];      // 解析出的字体文件
+    const void* data;    // 映射的字体数据 (为NULL时退回按路径打开)
+    size_t size;
+    double resolve_ms;   // 路径解析耗时
+    double map_ms;       // 映射耗时
+    font_face_t faces[FONT_CACHE_MAX_FACES];
+    int face_count;
+} font_cache_t;
+
+// 在候选路径中找到第一个可读的字体文件并映射，失败返回-1
+int font_cache_init(font_cache_t* cache, const char* const* paths);
+
+// 获取指定字号的字体，第一次调用时打开，失败返回NULL
+TTF_Font* font_cache_get(font_cache_t* cache, int ptsize);
+
+// 字符在指定字号下的步进宽度 (排版用)，字体打不开时返回-1
+int font_cache_advance(font_cache_t* cache, int ptsize, uint32_t cp);
+
+// 通过log函数输出路径解析、映射和各字号的加载耗时
+void font_cache_log_stats(const font_cache_t* cache, void (*log)(const char* message));
+
+// 关闭所有字体并解除映射
+void font_cache_destroy(font_cache_t* cache);
+
+#endif
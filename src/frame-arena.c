@@ -0,0 +1,27 @@
+#include "frame-arena.h"
+
+void frame_arena_init(frame_arena_t* arena, void* buffer, size_t size) {
+    arena->base = (unsigned char*)buffer;
+    arena->size = size;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->failures = 0;
+}
+
+void* frame_arena_alloc(frame_arena_t* arena, size_t size) {
+    size_t aligned = (size + 7) & ~(size_t)7;
+    if (aligned < size || aligned > arena->size - arena->used) {
+        arena->failures++;
+        return NULL;
+    }
+    void* p = arena->base + arena->used;
+    arena->used += aligned;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return p;
+}
+
+void frame_arena_reset(frame_arena_t* arena) {
+    arena->used = 0;
+}
@@ -0,0 +1,24 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+
+// 每帧的临时内存: 在调用方提供的固定缓冲区上顺序分配，帧末整体重置，不使用堆。
+
+typedef struct {
+    unsigned char* base;
+    size_t size;
+    size_t used;
+    size_t peak;             // 历史最大用量，用于调整缓冲区大小
+    int failures;            // 空间不足的次数
+} frame_arena_t;
+
+void frame_arena_init(frame_arena_t* arena, void* buffer, size_t size);
+
+// 分配8字节对齐的内存，空间不足返回NULL
+void* frame_arena_alloc(frame_arena_t* arena, size_t size);
+
+// 释放本帧的全部分配
+void frame_arena_reset(frame_arena_t* arena);
+
+#endif
@@ -0,0 +1,243 @@
+#include "gamepad.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// 掌机按键的原始序号: 0 A、1 B、2 Y、3 X、4 L1、5 R1、6 SELECT、7 START、8 MENU、9 L2、10 R2、
+// 13 VOL-、14 VOL+ (映射中没有音量键，直接读原始按键)，十字键为方向帽 (没有方向帽时为轴0和轴1)
+#define BUILTIN_VOL_DOWN 13
+#define BUILTIN_VOL_UP   14
+#define BUILTIN_BUTTONS "a:b0,b:b1,y:b2,x:b3,leftshoulder:b4,rightshoulder:b5,back:b6,start:b7,guide:b8," \
+                        "lefttrigger:b9,righttrigger:b10,"
+#define BUILTIN_HAT     "dpup:h0.1,dpright:h0.2,dpdown:h0.4,dpleft:h0.8,"
+#define BUILTIN_AXES    "dpup:-a1,dpdown:+a1,dpleft:-a0,dpright:+a0,"
+
+static const char* const button_names[GAMEPAD_BUTTON_COUNT] = {
+    "A", "B", "X", "Y", "SELECT", "MENU", "START", "L3", "R3", "L1", "R1",
+    "UP", "DOWN", "LEFT", "RIGHT", "L2", "R2", "VOL-", "VOL+",
+};
+
+const char* gamepad_button_name(gamepad_button_t button) {
+    return button >= 0 && button < GAMEPAD_BUTTON_COUNT ? button_names[button] : "?";
+}
+
+// ---------- 实例编号查找表 (线性探测) ----------
+
+static unsigned lookup_home(SDL_JoystickID instance) {
+    return (unsigned)instance & (GAMEPAD_LOOKUP_SIZE - 1);
+}
+
+gamepad_device_t* gamepad_manager_find(gamepad_manager_t* manager, SDL_JoystickID instance) {
+    for (unsigned i = lookup_home(instance), n = 0; n < GAMEPAD_LOOKUP_SIZE; i = (i + 1) & (GAMEPAD_LOOKUP_SIZE - 1), n++) {
+        int slot = manager->lookup[i];
+        if (slot < 0) return NULL;
+        if (manager->devices[slot].instance == instance) return &manager->devices[slot];
+    }
+    return NULL;
+}
+
+static void lookup_insert(gamepad_manager_t* manager, SDL_JoystickID instance, int slot) {
+    unsigned i = lookup_home(instance);
+    while (manager->lookup[i] >= 0) {
+        i = (i + 1) & (GAMEPAD_LOOKUP_SIZE - 1);
+    }
+    manager->lookup[i] = (int8_t)slot;
+}
+
+// 删除后把后面同一串中的项往前移，查找不需要墓碑
+static void lookup_remove(gamepad_manager_t* manager, SDL_JoystickID instance) {
+    unsigned mask = GAMEPAD_LOOKUP_SIZE - 1;
+    unsigned i = lookup_home(instance);
+    while (manager->lookup[i] >= 0 && manager->devices[manager->lookup[i]].instance != instance) {
+        i = (i + 1) & mask;
+    }
+    if (manager->lookup[i] < 0) return;
+    manager->lookup[i] = -1;
+    for (unsigned j = (i + 1) & mask; manager->lookup[j] >= 0; j = (j + 1) & mask) {
+        unsigned home = lookup_home(manager->devices[manager->lookup[j]].instance);
+        // home不在 (i, j] 之间时，这一项可以移到空位i
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            manager->lookup[i] = manager->lookup[j];
+            manager->lookup[j] = -1;
+            i = j;
+        }
+    }
+}
+
+// ---------- 设备 ----------
+
+// 没有映射的设备按RG34XX的布局生成映射 (名字中的逗号会破坏映射格式，换成空格)
+static int add_builtin_mapping(int device_index) {
+    SDL_Joystick* joystick = SDL_JoystickOpen(device_index);
+    if (!joystick) {
+        return -1;
+    }
+    char guid[33];
+    SDL_JoystickGetGUIDString(SDL_JoystickGetGUID(joystick), guid, sizeof(guid));
+    char name[64];
+    snprintf(name, sizeof(name), "%s", SDL_JoystickName(joystick) ? SDL_JoystickName(joystick) : "RG34XX Gamepad");
+    for (char* p = name; *p; p++) {
+        if (*p == ',') *p = ' ';
+    }
+    char mapping[384];
+    snprintf(mapping, sizeof(mapping), "%s,%s," BUILTIN_BUTTONS "%s", guid, name,
+             SDL_JoystickNumHats(joystick) > 0 ? BUILTIN_HAT : BUILTIN_AXES);
+    int rc = SDL_GameControllerAddMapping(mapping);
+    SDL_JoystickClose(joystick);
+    return rc < 0 ? -1 : 0;
+}
+
+int gamepad_manager_init(gamepad_manager_t* manager, const char* const* paths) {
+    memset(manager, 0, sizeof(*manager));
+    memset(manager->lookup, -1, sizeof(manager->lookup));
+    for (int i = 0; i < GAMEPAD_MAX_PLAYERS; i++) {
+        manager->players[i].device = -1;
+    }
+    manager->any.device = -1;
+    for (int i = 0; paths && paths[i]; i++) {
+        int count = SDL_GameControllerAddMappingsFromFile(paths[i]);
+        if (count >= 0) {
+            manager->mappings = count;
+            manager->mappings_path = paths[i];
+            break;
+        }
+    }
+    return manager->mappings;
+}
+
+void gamepad_manager_destroy(gamepad_manager_t* manager) {
+    for (int i = 0; i < GAMEPAD_MAX_DEVICES; i++) {
+        if (manager->devices[i].controller) {
+            SDL_GameControllerClose(manager->devices[i].controller);
+        }
+    }
+    memset(manager, 0, sizeof(*manager));
+}
+
+int gamepad_manager_add(gamepad_manager_t* manager, int device_index) {
+    SDL_JoystickID instance = SDL_JoystickGetDeviceInstanceID(device_index);
+    gamepad_device_t* existing = gamepad_manager_find(manager, instance);
+    if (existing) {
+        return (int)(existing - manager->devices);
+    }
+    int slot = -1;
+    for (int i = 0; i < GAMEPAD_MAX_DEVICES && slot < 0; i++) {
+        if (!manager->devices[i].controller) slot = i;
+    }
+    if (slot < 0) {
+        return -1;
+    }
+
+    int builtin = 0;
+    if (!SDL_IsGameController(device_index)) {
+        if (add_builtin_mapping(device_index) < 0) return -1;
+        builtin = 1;
+    }
+    SDL_GameController* controller = SDL_GameControllerOpen(device_index);
+    if (!controller) {
+        return -1;
+    }
+
+    gamepad_device_t* device = &manager->devices[slot];
+    device->controller = controller;
+    device->instance = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(controller));
+    device->builtin = builtin;
+    device->player = -1;
+    const char* name = SDL_GameControllerName(controller);
+    snprintf(device->name, sizeof(device->name), "%s", name ? name : "Unknown");
+    lookup_insert(manager, device->instance, slot);
+    manager->device_count++;
+
+    // 第一个空着的玩家
+    for (int p = 0; p < GAMEPAD_MAX_PLAYERS; p++) {
+        if (manager->players[p].device < 0) {
+            device->player = p;
+            memset(&manager->players[p], 0, sizeof(manager->players[p]));
+            manager->players[p].device = (int8_t)slot;
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+            SDL_GameControllerSetPlayerIndex(controller, p);
+#endif
+            break;
+        }
+    }
+    return slot;
+}
+
+int gamepad_manager_remove(gamepad_manager_t* manager, SDL_JoystickID instance) {
+    gamepad_device_t* device = gamepad_manager_find(manager, instance);
+    if (!device) {
+        return -1;
+    }
+    int player = device->player;
+    lookup_remove(manager, instance);
+    SDL_GameControllerClose(device->controller);
+    memset(device, 0, sizeof(*device));
+    manager->device_count--;
+    if (player >= 0) {
+        // 拔掉时按住的键算作松开
+        gamepad_state_t* state = &manager->players[player];
+        state->released = state->buttons;
+        state->pressed = 0;
+        state->buttons = 0;
+        memset(state->axes, 0, sizeof(state->axes));
+        state->device = -1;
+        state->removed = 1;
+    }
+    return player;
+}
+
+// ---------- 每帧的快照 ----------
+
+static uint32_t read_buttons(const gamepad_device_t* device, int16_t* axes) {
+    SDL_GameController* controller = device->controller;
+    uint32_t buttons = 0;
+    for (int b = 0; b <= GAMEPAD_RIGHT; b++) {
+        if (SDL_GameControllerGetButton(controller, (SDL_GameControllerButton)b)) buttons |= GAMEPAD_BIT(b);
+    }
+    for (int a = 0; a < GAMEPAD_AXIS_COUNT; a++) {
+        axes[a] = SDL_GameControllerGetAxis(controller, (SDL_GameControllerAxis)a);
+    }
+    // 扳机是轴 (按键式的扳机在映射中也会变成轴)，摇杆推到底也算十字键
+    if (axes[GAMEPAD_AXIS_L2] > GAMEPAD_TRIGGER_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_L2);
+    if (axes[GAMEPAD_AXIS_R2] > GAMEPAD_TRIGGER_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_R2);
+    if (axes[GAMEPAD_AXIS_LX] < -GAMEPAD_STICK_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_LEFT);
+    if (axes[GAMEPAD_AXIS_LX] > GAMEPAD_STICK_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_RIGHT);
+    if (axes[GAMEPAD_AXIS_LY] < -GAMEPAD_STICK_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_UP);
+    if (axes[GAMEPAD_AXIS_LY] > GAMEPAD_STICK_THRESHOLD) buttons |= GAMEPAD_BIT(GAMEPAD_DOWN);
+    if (device->builtin) {
+        SDL_Joystick* joystick = SDL_GameControllerGetJoystick(controller);
+        if (SDL_JoystickGetButton(joystick, BUILTIN_VOL_DOWN)) buttons |= GAMEPAD_BIT(GAMEPAD_VOL_DOWN);
+        if (SDL_JoystickGetButton(joystick, BUILTIN_VOL_UP)) buttons |= GAMEPAD_BIT(GAMEPAD_VOL_UP);
+    }
+    return buttons;
+}
+
+void gamepad_manager_update(gamepad_manager_t* manager) {
+    gamepad_state_t* any = &manager->any;
+    uint32_t any_before = any->buttons;
+    memset(any, 0, sizeof(*any));
+    any->device = -1;
+    for (int p = 0; p < GAMEPAD_MAX_PLAYERS; p++) {
+        gamepad_state_t* state = &manager->players[p];
+        if (state->device < 0) {
+            // 拔出事件和update在同一帧中先后处理，刚拔掉的玩家这一次保留松开的按键位
+            if (state->removed) {
+                state->removed = 0;
+            } else {
+                state->released = 0;
+            }
+            continue;
+        }
+        uint32_t before = state->buttons;
+        state->buttons = read_buttons(&manager->devices[state->device], state->axes);
+        state->pressed = state->buttons & ~before;
+        state->released = before & ~state->buttons;
+        any->buttons |= state->buttons;
+        if (any->device < 0) {
+            any->device = state->device;
+            memcpy(any->axes, state->axes, sizeof(any->axes));
+        }
+    }
+    any->pressed = any->buttons & ~any_before;
+    any->released = any_before & ~any->buttons;
+}
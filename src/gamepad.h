@@ -0,0 +1,107 @@
+#ifndef GAMEPAD_H
+#define GAMEPAD_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+
+// 手柄管理: 所有手柄都以SDL_GameController打开，按键按映射的名字 (A、B、L1……) 读取，不再依赖原始按键序号。
+//
+// 映射来自SDL内置的数据库 (常见手柄)、随程序发布的 gamecontrollerdb.txt 和 SDL_GAMECONTROLLERCONFIG 环境变量；
+// 都没有映射的手柄 (包括掌机自带的按键) 按RG34XX的按键布局用它自己的GUID生成一条映射。
+//
+// 打开的设备按SDL的实例编号放在一个小的开放寻址表中，热插拔事件和按实例查找都是O(1)。
+// 每个玩家 (按连接顺序分配，拔掉后空出) 每帧有一份打包的状态快照: 按住的按键位、本帧按下和松开的按键位、
+// 各轴的值。游戏逻辑每帧调用一次 gamepad_manager_update 之后直接读快照，不需要处理按键事件。
+
+#define GAMEPAD_MAX_DEVICES 8
+#define GAMEPAD_MAX_PLAYERS 4
+#define GAMEPAD_LOOKUP_SIZE 32           // 实例编号查找表 (2的幂，至少为设备数的2倍)
+#define GAMEPAD_STICK_THRESHOLD 16000    // 摇杆超过这个值时同时算作十字键
+#define GAMEPAD_TRIGGER_THRESHOLD 8000   // 模拟扳机超过这个值时算作按下
+
+// 按键位 (前15个与SDL_GameControllerButton的顺序相同)，按掌机上印的名字
+typedef enum {
+    GAMEPAD_A,
+    GAMEPAD_B,
+    GAMEPAD_X,
+    GAMEPAD_Y,
+    GAMEPAD_SELECT,
+    GAMEPAD_MENU,
+    GAMEPAD_START,
+    GAMEPAD_L3,
+    GAMEPAD_R3,
+    GAMEPAD_L1,
+    GAMEPAD_R1,
+    GAMEPAD_UP,
+    GAMEPAD_DOWN,
+    GAMEPAD_LEFT,
+    GAMEPAD_RIGHT,
+    GAMEPAD_L2,
+    GAMEPAD_R2,
+    GAMEPAD_VOL_DOWN,            // 掌机的音量键 (GameController没有对应的按键，只有内置映射的设备读原始按键)
+    GAMEPAD_VOL_UP,
+    GAMEPAD_BUTTON_COUNT
+} gamepad_button_t;
+
+#define GAMEPAD_BIT(button) (1u << (button))
+
+typedef enum {
+    GAMEPAD_AXIS_LX,
+    GAMEPAD_AXIS_LY,
+    GAMEPAD_AXIS_RX,
+    GAMEPAD_AXIS_RY,
+    GAMEPAD_AXIS_L2,
+    GAMEPAD_AXIS_R2,
+    GAMEPAD_AXIS_COUNT
+} gamepad_axis_t;
+
+// 一个玩家的状态快照
+typedef struct {
+    uint32_t buttons;            // 按住的按键位
+    uint32_t pressed;            // 本帧按下的
+    uint32_t released;           // 本帧松开的
+    int16_t axes[GAMEPAD_AXIS_COUNT];
+    int8_t device;               // 设备槽位，-1为没有连接
+    int8_t removed;              // 刚拔掉: 下一次update保留松开的按键位，再下一次清除
+} gamepad_state_t;
+
+typedef struct {
+    SDL_GameController* controller;  // NULL为空闲
+    SDL_JoystickID instance;
+    int player;
+    int builtin;                 // 使用RG34XX布局生成的映射
+    char name[64];
+} gamepad_device_t;
+
+typedef struct {
+    gamepad_device_t devices[GAMEPAD_MAX_DEVICES];
+    int8_t lookup[GAMEPAD_LOOKUP_SIZE];      // 实例编号 -> 设备槽位，-1为空
+    gamepad_state_t players[GAMEPAD_MAX_PLAYERS];
+    gamepad_state_t any;         // 所有玩家合并 (菜单接受任意手柄)
+    int device_count;
+    int mappings;                // 从映射文件读入的条数
+    const char* mappings_path;
+} gamepad_manager_t;
+
+// 读入第一个存在的映射文件 (paths以NULL结尾)，返回读入的条数
+int gamepad_manager_init(gamepad_manager_t* manager, const char* const* paths);
+void gamepad_manager_destroy(gamepad_manager_t* manager);
+
+// 打开设备 (SDL的设备序号)，已经打开时直接返回。返回设备槽位，失败返回-1
+int gamepad_manager_add(gamepad_manager_t* manager, int device_index);
+
+// 关闭设备 (拔出事件中的实例编号)，返回它的玩家编号，不是打开的设备时返回-1
+int gamepad_manager_remove(gamepad_manager_t* manager, SDL_JoystickID instance);
+
+gamepad_device_t* gamepad_manager_find(gamepad_manager_t* manager, SDL_JoystickID instance);
+
+// 每帧一次: 读取所有设备，生成每个玩家的快照
+void gamepad_manager_update(gamepad_manager_t* manager);
+
+static inline const gamepad_state_t* gamepad_player(const gamepad_manager_t* manager, int player) {
+    return &manager->players[player];
+}
+
+const char* gamepad_button_name(gamepad_button_t button);
+
+#endif
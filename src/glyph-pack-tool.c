@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include "glyph-pack.h"
+#include "utf8.h"
+
+// 字形包生成工具 (主机上运行)
+// 从UI源码的字符串字面量和字符集文件收集字符，用FreeType按指定字号光栅化，
+// 输出可直接mmap的A8字形包。字符按码点排序且不写入时间戳，相同输入得到相同输出。
+
+#define MAX_CODEPOINT 0x110000
+#define MAX_SIZES     8
+
+#define FT_CEIL(x) ((int)(((x) + 63) & -64) / 64)
+
+static uint8_t codepoint_set[MAX_CODEPOINT / 8];
+
+static void add_codepoint(uint32_t cp) {
+    if (cp < MAX_CODEPOINT && cp != UTF8_REPLACEMENT) {
+        codepoint_set[cp >> 3] |= 1 << (cp & 7);
+    }
+}
+
+static int has_codepoint(uint32_t cp) {
+    return (codepoint_set[cp >> 3] >> (cp & 7)) & 1;
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "错误: 无法打开 %s\n", path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = malloc(size + 1);
+    if (buf && fread(buf, 1, size, f) != (size_t)size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    if (buf) buf[size] = '\0';
+    return buf;
+}
+
+// 扫描C源码，只收集字符串字面量中的字符 (跳过注释和字符常量)
+static int scan_source(const char* path) {
+    char* src = read_file(path);
+    if (!src) return -1;
+
+    const char* p = src;
+    while (*p) {
+        if (p[0] == '/' && p[1] == '/') {
+            while (*p && *p != '\n') p++;
+        } else if (p[0] == '/' && p[1] == '*') {
+            p += 2;
+            while (*p && !(p[0] == '*' && p[1] == '/')) p++;
+            if (*p) p += 2;
+        } else if (*p == '\'') {
+            p++;
+            while (*p && *p != '\'') {
+                if (*p == '\\' && p[1]) p++;
+                p++;
+            }
+            if (*p) p++;
+        } else if (*p == '"') {
+            p++;
+            while (*p && *p != '"' && *p != '\n') {
+                if (*p == '\\' && p[1]) {
+                    p += 2;
+                    continue;
+                }
+                add_codepoint(utf8_next(&p));
+            }
+            if (*p) p++;
+        } else {
+            p++;
+        }
+    }
+
+    free(src);
+    return 0;
+}
+
+// 字符集文件: 每行的所有字符都加入，'#'开头的行为注释
+static int scan_charset(const char* path) {
+    char* text = read_file(path);
+    if (!text) return -1;
+
+    const char* p = text;
+    int line_start = 1;
+    while (*p) {
+        if (line_start && *p == '#') {
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        uint32_t cp = utf8_next(&p);
+        line_start = (cp == '\n');
+        if (cp >= 0x20) {
+            add_codepoint(cp);
+        }
+    }
+
+    free(text);
+    return 0;
+}
+
+typedef struct {
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+} buffer_t;
+
+static int buffer_append(buffer_t* b, const void* data, size_t size) {
+    if (b->size + size > b->capacity) {
+        size_t cap = b->capacity ? b->capacity * 2 : 65536;
+        while (cap < b->size + size) cap *= 2;
+        uint8_t* p = realloc(b->data, cap);
+        if (!p) return -1;
+        b->data = p;
+        b->capacity = cap;
+    }
+    memcpy(b->data + b->size, data, size);
+    b->size += size;
+    return 0;
+}
+
+// 光栅化一个字号的所有字符，与SDL_ttf相同的加载和度量方式
+static int rasterize_size(FT_Face face, int ptsize, glyph_pack_size_t* size_info,
+                          buffer_t* glyphs, buffer_t* bitmaps, uint32_t* missing) {
+    if (FT_Set_Char_Size(face, 0, ptsize * 64, 0, 0) != 0) {
+        fprintf(stderr, "错误: 无法设置字号 %d\n", ptsize);
+        return -1;
+    }
+
+    FT_Fixed scale = face->size->metrics.y_scale;
+    size_info->ptsize = ptsize;
+    size_info->ascent = FT_CEIL(FT_MulFix(face->ascender, scale));
+    size_info->descent = FT_CEIL(FT_MulFix(face->descender, scale));
+    size_info->line_skip = FT_CEIL(FT_MulFix(face->height, scale));
+    size_info->first_glyph = glyphs->size / sizeof(glyph_pack_glyph_t);
+    size_info->glyph_count = 0;
+
+    for (uint32_t cp = 0; cp < MAX_CODEPOINT; cp++) {
+        if (!has_codepoint(cp)) continue;
+
+        FT_UInt index = FT_Get_Char_Index(face, cp);
+        if (index == 0) {
+            // 字体中没有的字符不写入，运行时回退
+            (*missing)++;
+            continue;
+        }
+        if (FT_Load_Glyph(face, index, FT_LOAD_DEFAULT) != 0 ||
+            FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL) != 0) {
+            (*missing)++;
+            continue;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        FT_Bitmap* bm = &slot->bitmap;
+        uint8_t row[1024];
+        if (bm->width > sizeof(row)) {
+            (*missing)++;
+            continue;
+        }
+        glyph_pack_glyph_t g;
+        memset(&g, 0, sizeof(g));
+        g.codepoint = cp;
+        g.left = slot->bitmap_left;
+        g.top = slot->bitmap_top;
+        g.width = bm->width;
+        g.height = bm->rows;
+        g.advance = FT_CEIL(slot->metrics.horiAdvance);
+        g.offset = bitmaps->size;
+
+        for (unsigned int y = 0; y < bm->rows; y++) {
+            const uint8_t* src = bm->buffer + (int)y * bm->pitch;
+            for (unsigned int x = 0; x < bm->width; x++) {
+                if (bm->pixel_mode == FT_PIXEL_MODE_MONO) {
+                    row[x] = (src[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
+                } else {
+                    row[x] = src[x];
+                }
+            }
+            if (buffer_append(bitmaps, row, bm->width) < 0) return -1;
+        }
+        if (buffer_append(glyphs, &g, sizeof(g)) < 0) return -1;
+        size_info->glyph_count++;
+    }
+    return 0;
+}
+
+static int parse_sizes(const char* arg, int* sizes) {
+    int count = 0;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", arg);
+    for (char* tok = strtok(buf, ","); tok && count < MAX_SIZES; tok = strtok(NULL, ",")) {
+        int s = atoi(tok);
+        if (s <= 0 || s > 255) return -1;
+        sizes[count++] = s;
+    }
+    // 字号升序，去重
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && sizes[j] < sizes[j - 1]; j--) {
+            int t = sizes[j]; sizes[j] = sizes[j - 1]; sizes[j - 1] = t;
+        }
+    }
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        if (n == 0 || sizes[i] != sizes[n - 1]) sizes[n++] = sizes[i];
+    }
+    return n;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr, "用法: %s -f 字体 -s 14,18 [-c 字符集文件] -o 输出.pack 源文件...\n", prog);
+}
+
+int main(int argc, char* argv[]) {
+    const char* font_path = NULL;
+    const char* charset_path = NULL;
+    const char* output = NULL;
+    int sizes[MAX_SIZES];
+    int size_count = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:c:o:h")) != -1) {
+        switch (opt) {
+            case 'f': font_path = optarg; break;
+            case 's': size_count = parse_sizes(optarg, sizes); break;
+            case 'c': charset_path = optarg; break;
+            case 'o': output = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (!font_path || !output || size_count <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // 可打印ASCII总是包含
+    for (uint32_t cp = 0x20; cp < 0x7F; cp++) {
+        add_codepoint(cp);
+    }
+    for (int i = optind; i < argc; i++) {
+        if (scan_source(argv[i]) < 0) return 1;
+    }
+    if (charset_path && scan_charset(charset_path) < 0) {
+        return 1;
+    }
+
+    uint32_t total = 0;
+    for (uint32_t cp = 0; cp < MAX_CODEPOINT; cp++) {
+        total += has_codepoint(cp);
+    }
+
+    FT_Library library;
+    FT_Face face;
+    if (FT_Init_FreeType(&library) != 0) {
+        fprintf(stderr, "错误: FreeType初始化失败\n");
+        return 1;
+    }
+    if (FT_New_Face(library, font_path, 0, &face) != 0) {
+        fprintf(stderr, "错误: 无法加载字体 %s\n", font_path);
+        FT_Done_FreeType(library);
+        return 1;
+    }
+
+    glyph_pack_size_t size_infos[MAX_SIZES];
+    buffer_t glyphs = {0};
+    buffer_t bitmaps = {0};
+    uint32_t missing = 0;
+
+    for (int i = 0; i < size_count; i++) {
+        if (rasterize_size(face, sizes[i], &size_infos[i], &glyphs, &bitmaps, &missing) < 0) {
+            return 1;
+        }
+    }
+
+    glyph_pack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GLYPH_PACK_MAGIC, 4);
+    header.version = GLYPH_PACK_VERSION;
+    header.size_count = size_count;
+    header.glyph_count = glyphs.size / sizeof(glyph_pack_glyph_t);
+    header.sizes_offset = sizeof(header);
+    header.glyphs_offset = header.sizes_offset + size_count * sizeof(glyph_pack_size_t);
+    header.bitmaps_offset = header.glyphs_offset + glyphs.size;
+    header.file_size = header.bitmaps_offset + bitmaps.size;
+
+    FILE* out = fopen(output, "wb");
+    if (!out) {
+        fprintf(stderr, "错误: 无法创建 %s\n", output);
+        return 1;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(size_infos, sizeof(glyph_pack_size_t), size_count, out);
+    fwrite(glyphs.data, 1, glyphs.size, out);
+    fwrite(bitmaps.data, 1, bitmaps.size, out);
+    fclose(out);
+
+    printf("字形包: %s | %u个字符 x %d个字号 | %u个字形 | 字体缺少%u | %u bytes\n",
+           output, total, size_count, header.glyph_count, missing, header.file_size);
+
+    free(glyphs.data);
+    free(bitmaps.data);
+    FT_Done_Face(face);
+    FT_Done_FreeType(library);
+    return 0;
+}
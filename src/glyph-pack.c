@@ -0,0 +1,131 @@
+#include "glyph-pack.h"
+#include "utf8.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 校验头部和各区段边界，防止损坏的文件导致越界访问
+static int validate(const glyph_pack_t* pack) {
+    const glyph_pack_header_t* h = pack->header;
+    size_t size = pack->size;
+
+    if (size < sizeof(*h) || memcmp(h->magic, GLYPH_PACK_MAGIC, 4) != 0 ||
+        h->version != GLYPH_PACK_VERSION || h->file_size != size) {
+        return -1;
+    }
+    if (h->sizes_offset > size || h->size_count > (size - h->sizes_offset) / sizeof(glyph_pack_size_t)) {
+        return -1;
+    }
+    if (h->glyphs_offset > size || h->glyph_count > (size - h->glyphs_offset) / sizeof(glyph_pack_glyph_t)) {
+        return -1;
+    }
+    if (h->bitmaps_offset > size) {
+        return -1;
+    }
+
+    size_t bitmap_size = size - h->bitmaps_offset;
+    for (uint32_t i = 0; i < h->size_count; i++) {
+        const glyph_pack_size_t* s = &pack->sizes[i];
+        if (s->first_glyph > h->glyph_count || s->glyph_count > h->glyph_count - s->first_glyph) {
+            return -1;
+        }
+    }
+    for (uint32_t i = 0; i < h->glyph_count; i++) {
+        const glyph_pack_glyph_t* g = &pack->glyphs[i];
+        if (g->offset > bitmap_size || (size_t)g->width * g->height > bitmap_size - g->offset) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int glyph_pack_open(glyph_pack_t* pack, const char* path) {
+    memset(pack, 0, sizeof(*pack));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(glyph_pack_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    pack->data = data;
+    pack->size = st.st_size;
+    pack->header = (const glyph_pack_header_t*)pack->data;
+    pack->sizes = (const glyph_pack_size_t*)(pack->data + pack->header->sizes_offset);
+    pack->glyphs = (const glyph_pack_glyph_t*)(pack->data + pack->header->glyphs_offset);
+    pack->bitmaps = pack->data + pack->header->bitmaps_offset;
+
+    if (validate(pack) < 0) {
+        glyph_pack_close(pack);
+        return -1;
+    }
+    return 0;
+}
+
+void glyph_pack_close(glyph_pack_t* pack) {
+    if (pack->data) {
+        munmap((void*)pack->data, pack->size);
+    }
+    memset(pack, 0, sizeof(*pack));
+}
+
+const glyph_pack_size_t* glyph_pack_find_size(const glyph_pack_t* pack, int ptsize) {
+    if (!pack->data) {
+        return NULL;
+    }
+    for (uint32_t i = 0; i < pack->header->size_count; i++) {
+        if (pack->sizes[i].ptsize == ptsize) {
+            return &pack->sizes[i];
+        }
+    }
+    return NULL;
+}
+
+const glyph_pack_glyph_t* glyph_pack_find_glyph(const glyph_pack_t* pack,
+                                                const glyph_pack_size_t* size,
+                                                uint32_t codepoint) {
+    const glyph_pack_glyph_t* glyphs = pack->glyphs + size->first_glyph;
+    uint32_t lo = 0;
+    uint32_t hi = size->glyph_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (glyphs[mid].codepoint < codepoint) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < size->glyph_count && glyphs[lo].codepoint == codepoint) {
+        return &glyphs[lo];
+    }
+    return NULL;
+}
+
+int glyph_pack_measure(const glyph_pack_t* pack, const glyph_pack_size_t* size, const char* text) {
+    int width = 0;
+    uint32_t cp;
+
+    while ((cp = utf8_next(&text)) != 0) {
+        const glyph_pack_glyph_t* g = glyph_pack_find_glyph(pack, size, cp);
+        if (!g) {
+            return -1;
+        }
+        width += g->advance;
+    }
+    return width;
+}
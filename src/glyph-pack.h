@@ -0,0 +1,79 @@
+#ifndef GLYPH_PACK_H
+#define GLYPH_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 预光栅化字形包: 构建时由 glyph-pack-tool 从UI字符串和字符集文件生成，
+// 运行时一次mmap即可使用，包中缺少的字符回退到完整字体。
+//
+// 文件布局 (小端，所有偏移相对文件开头):
+//   glyph_pack_header_t
+//   glyph_pack_size_t  [size_count]      按ptsize升序
+//   glyph_pack_glyph_t [glyph_count]     每个字号一段，段内按codepoint升序
+//   A8位图数据                            每个字形 width*height 字节，逐行紧密排列
+
+#define GLYPH_PACK_MAGIC   "RGGP"
+#define GLYPH_PACK_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t size_count;
+    uint32_t glyph_count;
+    uint32_t sizes_offset;
+    uint32_t glyphs_offset;
+    uint32_t bitmaps_offset;
+    uint32_t file_size;
+} glyph_pack_header_t;
+
+// 一个字号的字体度量 (与SDL_ttf相同的计算方式)
+typedef struct {
+    uint16_t ptsize;
+    int16_t ascent;
+    int16_t descent;
+    int16_t line_skip;
+    uint32_t first_glyph;
+    uint32_t glyph_count;
+} glyph_pack_size_t;
+
+typedef struct {
+    uint32_t codepoint;
+    int16_t left;        // 相对笔位置的水平偏移
+    int16_t top;         // 基线以上的高度
+    uint16_t width;
+    uint16_t height;
+    uint16_t advance;
+    uint16_t reserved;
+    uint32_t offset;     // 相对位图区开头
+} glyph_pack_glyph_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    const glyph_pack_header_t* header;
+    const glyph_pack_size_t* sizes;
+    const glyph_pack_glyph_t* glyphs;
+    const uint8_t* bitmaps;
+} glyph_pack_t;
+
+// 映射并校验字形包，失败返回-1
+int glyph_pack_open(glyph_pack_t* pack, const char* path);
+void glyph_pack_close(glyph_pack_t* pack);
+
+// 查找字号，没有返回NULL
+const glyph_pack_size_t* glyph_pack_find_size(const glyph_pack_t* pack, int ptsize);
+
+// 在字号内二分查找字形，没有返回NULL
+const glyph_pack_glyph_t* glyph_pack_find_glyph(const glyph_pack_t* pack,
+                                                const glyph_pack_size_t* size,
+                                                uint32_t codepoint);
+
+static inline const uint8_t* glyph_pack_bitmap(const glyph_pack_t* pack, const glyph_pack_glyph_t* glyph) {
+    return pack->bitmaps + glyph->offset;
+}
+
+// 测量UTF-8字符串宽度，有字符不在包中时返回-1
+int glyph_pack_measure(const glyph_pack_t* pack, const glyph_pack_size_t* size, const char* text);
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <png.h>
+
+#include "image-asset.h"
+
+// 图片资源生成工具 (主机上运行)
+// 用libpng读取PNG，转换为面板原生像素格式，按 IMAGE_ASSET_ALIGN 对齐每行后输出，
+// 运行时 image_asset_open 直接mmap使用。有半透明像素时另外输出A8透明度平面。
+
+static const struct {
+    const char* name;
+    pixel_format_t format;
+} formats[] = {
+    { "rgb565", PIXEL_FORMAT_RGB565 },
+    { "bgr565", PIXEL_FORMAT_BGR565 },
+    { "xrgb8888", PIXEL_FORMAT_XRGB8888 },
+    { "xbgr8888", PIXEL_FORMAT_XBGR8888 },
+};
+
+static int parse_format(const char* name, pixel_format_t* format) {
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (strcmp(name, formats[i].name) == 0) {
+            *format = formats[i].format;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-f rgb565|bgr565|xrgb8888|xbgr8888] [-a auto|on|off] -o 输出.rgi 输入.png\n"
+            "  -f  面板像素格式，默认 rgb565\n"
+            "  -a  透明度平面: auto 有半透明像素时输出 (默认)，on 总是输出，off 丢弃透明度\n",
+            prog);
+}
+
+int main(int argc, char* argv[]) {
+    pixel_format_t format = PIXEL_FORMAT_RGB565;
+    const char* alpha_mode = "auto";
+    const char* output = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:a:o:h")) != -1) {
+        switch (opt) {
+            case 'f':
+                if (parse_format(optarg, &format) < 0) {
+                    fprintf(stderr, "错误: 不支持的像素格式 %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'a': alpha_mode = optarg; break;
+            case 'o': output = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (!output || optind != argc - 1 ||
+        (strcmp(alpha_mode, "auto") != 0 && strcmp(alpha_mode, "on") != 0 && strcmp(alpha_mode, "off") != 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* input = argv[optind];
+
+    // 任何PNG (调色板、灰度、16位) 都由libpng展开为RGBA8
+    png_image png;
+    memset(&png, 0, sizeof(png));
+    png.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&png, input)) {
+        fprintf(stderr, "错误: 无法读取 %s - %s\n", input, png.message);
+        return 1;
+    }
+    png.format = PNG_FORMAT_RGBA;
+    if (png.width == 0 || png.height == 0 || png.width > 4096 || png.height > 4096) {
+        fprintf(stderr, "错误: 图片尺寸 %ux%u 超出范围 (最大4096x4096)\n", png.width, png.height);
+        png_image_free(&png);
+        return 1;
+    }
+    uint8_t* rgba = malloc(PNG_IMAGE_SIZE(png));
+    if (!rgba) {
+        fprintf(stderr, "错误: 内存不足\n");
+        png_image_free(&png);
+        return 1;
+    }
+    if (!png_image_finish_read(&png, NULL, rgba, 0, NULL)) {
+        fprintf(stderr, "错误: 无法解码 %s - %s\n", input, png.message);
+        free(rgba);
+        return 1;
+    }
+
+    uint32_t width = png.width, height = png.height;
+    int translucent = 0;
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        if (rgba[i * 4 + 3] != 255) {
+            translucent = 1;
+            break;
+        }
+    }
+    int with_alpha = strcmp(alpha_mode, "on") == 0 || (strcmp(alpha_mode, "auto") == 0 && translucent);
+
+    // 展开为0xAARRGGBB，文件布局和格式转换与运行时生成的资源 (缩略图缓存) 共用 image_asset_build
+    uint32_t* argb = malloc((size_t)width * height * sizeof(uint32_t));
+    if (!argb) {
+        fprintf(stderr, "错误: 内存不足\n");
+        free(rgba);
+        return 1;
+    }
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        const uint8_t* p = rgba + i * 4;
+        argb[i] = ((uint32_t)p[3] << 24) | ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    }
+    free(rgba);
+
+    size_t file_size;
+    uint8_t* file = image_asset_build(format, (int)width, (int)height, argb, with_alpha, &file_size);
+    free(argb);
+    if (!file) {
+        fprintf(stderr, "错误: 内存不足\n");
+        return 1;
+    }
+    const image_asset_header_t* header = (const image_asset_header_t*)file;
+
+    FILE* out = fopen(output, "wb");
+    if (!out) {
+        fprintf(stderr, "错误: 无法创建 %s\n", output);
+        free(file);
+        return 1;
+    }
+    size_t written = fwrite(file, 1, file_size, out);
+    fclose(out);
+    if (written != file_size) {
+        free(file);
+        fprintf(stderr, "错误: 写入 %s 失败\n", output);
+        return 1;
+    }
+
+    printf("图片资源: %s | %ux%u %s%s | 每行%u bytes | %u bytes\n",
+           output, width, height, formats[format].name, with_alpha ? " + A8" : "",
+           header->pitch, header->file_size);
+    free(file);
+    if (translucent && !with_alpha) {
+        printf("警告: 图片有半透明像素，但没有输出透明度平面\n");
+    }
+    return 0;
+}
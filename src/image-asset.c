@@ -0,0 +1,173 @@
+#include "image-asset.h"
+#include "blend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ALIGN_UP(x) (((x) + IMAGE_ASSET_ALIGN - 1) / IMAGE_ASSET_ALIGN * IMAGE_ASSET_ALIGN)
+
+// 平面是否完整位于文件内
+static int plane_fits(size_t size, uint32_t offset, uint32_t pitch, uint32_t height) {
+    return offset <= size && offset % IMAGE_ASSET_ALIGN == 0 && pitch % IMAGE_ASSET_ALIGN == 0 &&
+           (height == 0 || pitch <= (size - offset) / height);
+}
+
+// 校验头部和平面边界，防止损坏的文件导致越界访问
+static int validate(const image_asset_t* image) {
+    const image_asset_header_t* h = image->header;
+    size_t size = image->size;
+
+    if (size < sizeof(*h) || memcmp(h->magic, IMAGE_ASSET_MAGIC, 4) != 0 ||
+        h->version != IMAGE_ASSET_VERSION || h->file_size != size) {
+        return -1;
+    }
+    if (h->format > PIXEL_FORMAT_XBGR8888 || h->width == 0 || h->height == 0 ||
+        h->width > 4096 || h->height > 4096) {
+        return -1;
+    }
+    if (h->pitch < h->width * pixel_format_bytes((pixel_format_t)h->format) ||
+        !plane_fits(size, h->pixels_offset, h->pitch, h->height)) {
+        return -1;
+    }
+    if (h->alpha_pitch != 0 &&
+        (h->alpha_pitch < h->width || !plane_fits(size, h->alpha_offset, h->alpha_pitch, h->height))) {
+        return -1;
+    }
+    return 0;
+}
+
+int image_asset_open(image_asset_t* image, const char* path) {
+    memset(image, 0, sizeof(*image));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(image_asset_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+
+    if (image_asset_view(image, data, st.st_size) < 0) {
+        munmap(data, st.st_size);
+        return -1;
+    }
+    return 0;
+}
+
+int image_asset_view(image_asset_t* image, const void* data, size_t size) {
+    memset(image, 0, sizeof(*image));
+    image->data = data;
+    image->size = size;
+    image->header = (const image_asset_header_t*)image->data;
+
+    if (size < sizeof(image_asset_header_t) || validate(image) < 0) {
+        memset(image, 0, sizeof(*image));
+        return -1;
+    }
+
+    const image_asset_header_t* h = image->header;
+    image->format = (pixel_format_t)h->format;
+    image->width = (int)h->width;
+    image->height = (int)h->height;
+    image->pixels = image->data + h->pixels_offset;
+    image->alpha = h->alpha_pitch ? image->data + h->alpha_offset : NULL;
+    return 0;
+}
+
+uint8_t* image_asset_build(pixel_format_t format, int width, int height, const uint32_t* argb, int with_alpha,
+                           size_t* size) {
+    if (width <= 0 || height <= 0 || width > 4096 || height > 4096) {
+        return NULL;
+    }
+
+    image_asset_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, IMAGE_ASSET_MAGIC, 4);
+    header.version = IMAGE_ASSET_VERSION;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.pitch = ALIGN_UP(width * pixel_format_bytes(format));
+    header.alpha_pitch = with_alpha ? ALIGN_UP(width) : 0;
+    header.pixels_offset = ALIGN_UP(sizeof(header));
+    header.alpha_offset = with_alpha ? header.pixels_offset + header.pitch * height : 0;
+    header.file_size = header.pixels_offset + (header.pitch + header.alpha_pitch) * height;
+
+    // 补齐部分为0
+    uint8_t* file = calloc(1, header.file_size);
+    if (!file) {
+        return NULL;
+    }
+    memcpy(file, &header, sizeof(header));
+    for (int y = 0; y < height; y++) {
+        const uint32_t* src = argb + (size_t)y * width;
+        uint8_t* row = file + header.pixels_offset + (size_t)y * header.pitch;
+        uint8_t* alpha = with_alpha ? file + header.alpha_offset + (size_t)y * header.alpha_pitch : NULL;
+        for (int x = 0; x < width; x++) {
+            // 完全透明的像素颜色无意义，写0便于压缩；透明度只进透明度平面 (XRGB的X字节为0)
+            uint32_t rgb = (alpha && (src[x] >> 24) == 0) ? 0 : src[x] & 0xFFFFFF;
+            uint32_t pixel = pixel_map(format, rgb);
+            if (pixel_format_bytes(format) == 2) {
+                ((uint16_t*)row)[x] = (uint16_t)pixel;
+            } else {
+                ((uint32_t*)row)[x] = pixel;
+            }
+            if (alpha) alpha[x] = (uint8_t)(src[x] >> 24);
+        }
+    }
+    *size = header.file_size;
+    return file;
+}
+
+void image_asset_close(image_asset_t* image) {
+    if (image->data) {
+        munmap((void*)image->data, image->size);
+    }
+    memset(image, 0, sizeof(*image));
+}
+
+int image_asset_blit(const image_asset_t* image, pixel_format_t format, void* pixels, int pitch,
+                     int width, int height, int x, int y, int opacity) {
+    if (!image->data || image->format != format) {
+        return -1;
+    }
+
+    // 裁剪到目标范围
+    int sx = x < 0 ? -x : 0;
+    int sy = y < 0 ? -y : 0;
+    int x0 = x + sx, y0 = y + sy;
+    int x1 = x + image->width < width ? x + image->width : width;
+    int y1 = y + image->height < height ? y + image->height : height;
+    if (x0 >= x1 || y0 >= y1 || opacity <= 0) {
+        return 0;
+    }
+
+    int bytes = pixel_format_bytes(format);
+    int count = x1 - x0;
+    for (int row = y0; row < y1; row++) {
+        uint8_t* dst = (uint8_t*)pixels + (size_t)row * pitch + (size_t)x0 * bytes;
+        const uint8_t* src = (const uint8_t*)image_asset_row(image, row - y) + (size_t)sx * bytes;
+        const uint8_t* mask = image_asset_alpha_row(image, row - y);
+        if (mask) {
+            blend_copy_mask_row(format, dst, src, mask + sx, count, opacity);
+        } else if (opacity >= 255) {
+            memcpy(dst, src, (size_t)count * bytes);
+        } else {
+            blend_copy_row(format, dst, src, count, opacity);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef IMAGE_ASSET_H
+#define IMAGE_ASSET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pixel-format.h"
+
+// 预转换图片资源: 构建时由 image-asset-tool 从PNG生成，像素已经是面板的原生格式，
+// 运行时一次mmap即可逐行复制或混合到后缓冲，不解码、不转换。
+//
+// 文件布局 (小端，所有偏移相对文件开头，区段和每行都按 IMAGE_ASSET_ALIGN 对齐):
+//   image_asset_header_t
+//   像素平面      height 行，每行 pitch 字节 (原生格式像素 + 行尾补齐)
+//   A8透明度平面  可选，height 行，每行 alpha_pitch 字节
+
+#define IMAGE_ASSET_MAGIC   "RGIM"
+#define IMAGE_ASSET_VERSION 1
+#define IMAGE_ASSET_ALIGN   16
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;         // pixel_format_t
+    uint32_t width;
+    uint32_t height;
+    uint32_t pitch;          // 像素平面每行字节数
+    uint32_t alpha_pitch;    // 透明度平面每行字节数，0表示完全不透明
+    uint32_t pixels_offset;
+    uint32_t alpha_offset;
+    uint32_t file_size;
+    uint32_t reserved[2];
+} image_asset_header_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    const image_asset_header_t* header;
+    pixel_format_t format;
+    int width;
+    int height;
+    const uint8_t* pixels;
+    const uint8_t* alpha;    // 没有透明度平面时为NULL
+} image_asset_t;
+
+// 映射并校验图片资源，失败返回-1
+int image_asset_open(image_asset_t* image, const char* path);
+void image_asset_close(image_asset_t* image);
+
+// 校验内存中的图片资源并填写image，不复制也不接管data (data在使用期间必须有效，不要调用 image_asset_close)
+int image_asset_view(image_asset_t* image, const void* data, size_t size);
+
+// 在内存中生成图片资源文件: argb为 width x height 个0xAARRGGBB像素，转换为format，
+// with_alpha为0时不输出透明度平面 (输出时完全透明的像素写0)。返回malloc的文件内容 (大小写入size)，失败返回NULL
+uint8_t* image_asset_build(pixel_format_t format, int width, int height, const uint32_t* argb, int with_alpha,
+                           size_t* size);
+
+static inline const void* image_asset_row(const image_asset_t* image, int y) {
+    return image->pixels + (size_t)y * image->header->pitch;
+}
+
+static inline const uint8_t* image_asset_alpha_row(const image_asset_t* image, int y) {
+    return image->alpha ? image->alpha + (size_t)y * image->header->alpha_pitch : NULL;
+}
+
+// 把图片画到同格式的像素缓冲区 (x, y)，自动裁剪，opacity为整体不透明度 (0-255)。
+// 不透明且opacity为255时逐行memcpy，否则用blend内核混合。格式不同返回-1
+int image_asset_blit(const image_asset_t* image, pixel_format_t format, void* pixels, int pitch,
+                     int width, int height, int x, int y, int opacity);
+
+#endif
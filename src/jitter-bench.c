@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "rt-tune.h"
+
+// 帧抖动基准测试: 按固定帧率 (绝对时刻的 clock_nanosleep) 醒来，每帧写一遍后台缓冲，
+// 先用默认设置、再用指定的实时选项各运行一段时间，比较醒来的延迟、每帧耗时、超过帧时长的帧和缺页数。
+// 同时运行的负载线程模拟后台服务 (忙等和休眠交替，并不断分配、触碰、释放内存)。
+// 每段都重新分配后台缓冲: 默认设置下第一帧要处理缺页，-m 时预先触碰并锁定。
+// 任何Linux主机上都能运行，没有权限时实时调度被拒绝并退回nice值 (结果中注明)。例如:
+//   ./jitter-bench -t 5 -l 4 -c 1 -p fifo -m
+//   sudo ./jitter-bench -t 10 -l 8 -c 3 -p rr -P 80 -m
+
+#define BACK_BUFFER_BYTES (640 * 480 * 4)
+#define LOAD_CHURN_BYTES (1 << 20)
+
+typedef struct {
+    const char* name;
+    int frames;
+    double wake_avg_us, wake_p50_us, wake_p99_us, wake_max_us;
+    double work_avg_us, work_max_us, first_work_us;
+    int missed;                  // 本帧结束时已经过了下一帧的时刻
+    long faults;                 // 这一段的缺页 (次要+主要)
+    char tuning[192];
+    char memory[160];
+} phase_result_t;
+
+static atomic_int load_running;
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-f 帧率] [-t 每段秒数] [-l 负载线程数] [-c 核] [-p fifo|rr|other] [-P 优先级] [-n nice] [-m]\n"
+            "  默认 60帧/秒，每段5秒，负载线程数为CPU数；-c/-p/-P/-n/-m 只用于第二段 (调整后)\n"
+            "  -m 锁定内存并预先触碰后台缓冲\n",
+            prog);
+}
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static long thread_faults(void) {
+    struct rusage usage;
+#ifdef RUSAGE_THREAD
+    getrusage(RUSAGE_THREAD, &usage);
+#else
+    getrusage(RUSAGE_SELF, &usage);
+#endif
+    return usage.ru_minflt + usage.ru_majflt;
+}
+
+// 负载: 忙等约3ms、休眠约2ms交替，每轮分配并触碰1MB
+static void* load_main(void* arg) {
+    (void)arg;
+    while (atomic_load(&load_running)) {
+        double until = now_us() + 3000;
+        volatile unsigned spin = 0;
+        while (now_us() < until) spin++;
+        char* churn = malloc(LOAD_CHURN_BYTES);
+        if (churn) {
+            memset(churn, (int)spin, LOAD_CHURN_BYTES);
+            free(churn);
+        }
+        struct timespec pause = {0, 2000000};
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void timespec_add_ns(struct timespec* ts, long ns) {
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+static int run_phase(phase_result_t* result, int hz, int seconds, int lock_memory) {
+    int frames = hz * seconds;
+    long period_ns = 1000000000L / hz;
+    double* wake = malloc(frames * sizeof(double));
+    uint8_t* back = malloc(BACK_BUFFER_BYTES);
+    if (!wake || !back) {
+        free(wake);
+        free(back);
+        return -1;
+    }
+    if (lock_memory) {
+        int locked = rt_tune_lock_memory(result->memory, sizeof(result->memory));
+        int flags = RT_TUNE_PREFAULT_WRITE | (locked & RT_TUNE_LOCK_FUTURE ? 0 : RT_TUNE_PREFAULT_LOCK);
+        rt_tune_prefault(back, BACK_BUFFER_BYTES, flags);
+        rt_tune_prefault(wake, frames * sizeof(double), flags);
+    }
+
+    long faults_before = thread_faults();
+    double work_sum = 0;
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    timespec_add_ns(&deadline, period_ns);
+    for (int i = 0; i < frames; i++) {
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        double target = deadline.tv_sec * 1e6 + deadline.tv_nsec / 1e3;
+        double start = now_us();
+        wake[i] = start - target;
+
+        // 一帧的工作: 写一遍后台缓冲
+        memset(back, i & 0xFF, BACK_BUFFER_BYTES);
+
+        double end = now_us();
+        double work = end - start;
+        work_sum += work;
+        if (i == 0) result->first_work_us = work;
+        if (work > result->work_max_us) result->work_max_us = work;
+        if (end > target + period_ns / 1e3) result->missed++;
+        timespec_add_ns(&deadline, period_ns);
+    }
+    result->faults = thread_faults() - faults_before;
+
+    double wake_sum = 0;
+    for (int i = 0; i < frames; i++) {
+        wake_sum += wake[i];
+    }
+    qsort(wake, frames, sizeof(double), compare_double);
+    result->frames = frames;
+    result->wake_avg_us = wake_sum / frames;
+    result->wake_p50_us = wake[frames / 2];
+    result->wake_p99_us = wake[(int)(frames * 0.99)];
+    result->wake_max_us = wake[frames - 1];
+    result->work_avg_us = work_sum / frames;
+
+    free(wake);
+    free(back);
+    return 0;
+}
+
+static void print_result(const phase_result_t* r) {
+    printf("[%s] %s\n", r->name, r->tuning);
+    if (r->memory[0]) printf("  %s\n", r->memory);
+    printf("  醒来延迟: 平均%.1fus p50 %.1fus p99 %.1fus 最大%.1fus\n",
+           r->wake_avg_us, r->wake_p50_us, r->wake_p99_us, r->wake_max_us);
+    printf("  每帧耗时: 平均%.1fus 最大%.1fus 第一帧%.1fus | 超时%d帧/%d | 缺页%ld\n",
+           r->work_avg_us, r->work_max_us, r->first_work_us, r->missed, r->frames, r->faults);
+}
+
+int main(int argc, char* argv[]) {
+    int hz = 60;
+    int seconds = 5;
+    int loads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int lock_memory = 0;
+    rt_tune_options_t options;
+    rt_tune_defaults(&options);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:t:l:c:p:P:n:mh")) != -1) {
+        switch (opt) {
+            case 'f': hz = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            case 'l': loads = atoi(optarg); break;
+            case 'c': options.cpu = atoi(optarg); break;
+            case 'p':
+                if (rt_tune_parse_policy(optarg, &options.policy) < 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'P': options.priority = atoi(optarg); break;
+            case 'n': options.nice = atoi(optarg); break;
+            case 'm': lock_memory = 1; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc || hz <= 0 || seconds <= 0 || loads < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!rt_tune_requested(&options) && !lock_memory) {
+        // 没有指定时比较一个常用的组合: 最后一个核、SCHED_FIFO (被拒绝时nice -10)、锁定内存
+        options.cpu = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+        options.policy = RT_TUNE_FIFO;
+        options.nice = -10;
+        lock_memory = 1;
+    }
+
+    static pthread_t threads[64];
+    if (loads > 64) loads = 64;
+    atomic_store(&load_running, 1);
+    int started = 0;
+    for (int i = 0; i < loads; i++) {
+        if (pthread_create(&threads[i], NULL, load_main, NULL) == 0) started++;
+    }
+    printf("%d帧/秒，每段%d秒，%d个负载线程\n", hz, seconds, started);
+
+    phase_result_t results[2];
+    memset(results, 0, sizeof(results));
+    results[0].name = "默认";
+    snprintf(results[0].tuning, sizeof(results[0].tuning), "default");
+    results[1].name = "调整后";
+
+    int rc = run_phase(&results[0], hz, seconds, 0);
+    if (rc == 0) {
+        rt_tune_result_t tune;
+        rt_tune_apply(&options, &tune);
+        snprintf(results[1].tuning, sizeof(results[1].tuning), "%s", tune.text);
+        rc = run_phase(&results[1], hz, seconds, lock_memory);
+    }
+
+    atomic_store(&load_running, 0);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (rc < 0) {
+        fprintf(stderr, "错误: 内存不足\n");
+        return 1;
+    }
+
+    print_result(&results[0]);
+    print_result(&results[1]);
+    printf("p99醒来延迟: %.1fus -> %.1fus | 最大: %.1fus -> %.1fus | 超时帧: %d -> %d\n",
+           results[0].wake_p99_us, results[1].wake_p99_us, results[0].wake_max_us, results[1].wake_max_us,
+           results[0].missed, results[1].missed);
+    return 0;
+}
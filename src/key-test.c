@@ -1,8 +1,14 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ioctl.h>
 #include <linux/input.h>
+#include <linux/uinput.h>
 #include <errno.h>
 #include <string.h>
 
@@ -23,6 +29,21 @@
 #define RG34XX_BTN_L2     312
 #define RG34XX_BTN_R2     313
 
+// 每次read最多读取的事件数
+#define EVENT_BATCH       64
+// 直方图桶数: 按2的幂划分微秒区间 (<1us, 1-2us, ... , >=2^30us)
+#define HIST_BUCKETS      32
+// 默认去抖窗口 (毫秒)
+#define DEFAULT_DEBOUNCE_MS 5
+
+static const int rg34xx_codes[] = {
+    RG34XX_BTN_UP, RG34XX_BTN_DOWN, RG34XX_BTN_LEFT, RG34XX_BTN_RIGHT,
+    RG34XX_BTN_A, RG34XX_BTN_B, RG34XX_BTN_X, RG34XX_BTN_Y,
+    RG34XX_BTN_L, RG34XX_BTN_R, RG34XX_BTN_SELECT, RG34XX_BTN_START,
+    RG34XX_BTN_M, RG34XX_BTN_L2, RG34XX_BTN_R2,
+};
+#define RG34XX_CODE_COUNT (int)(sizeof(rg34xx_codes) / sizeof(rg34xx_codes[0]))
+
 const char* get_key_name(int code) {
     switch (code) {
         case RG34XX_BTN_UP:     return "UP";
@@ -44,12 +65,260 @@ const char* get_key_name(int code) {
     }
 }
 
-int main() {
-    printf("=== RG34XX 按键监听测试 ===\n");
-    printf("按任意按键测试，按Ctrl+C退出\n\n");
-    
-    // 尝试打开输入设备
-    int fd = -1;
+// 微秒直方图
+typedef struct {
+    uint32_t buckets[HIST_BUCKETS];
+    uint64_t count;
+    int64_t min_us, max_us;
+    int64_t sum_us;
+} histogram_t;
+
+// 单个按键码的统计
+typedef struct {
+    uint32_t presses;
+    uint32_t releases;
+    uint32_t repeats;
+    uint32_t chatter;          // 触点抖动次数 (释放后去抖窗口内又按下)
+    int64_t last_press_us;
+    int64_t last_release_us;
+    int64_t hold_min_us, hold_max_us, hold_sum_us;
+    uint32_t holds;
+} key_stats_t;
+
+// 分析器状态
+typedef struct {
+    int quiet;                 // 不逐个打印事件
+    int monotonic;             // 事件时间戳是否为CLOCK_MONOTONIC
+    int64_t debounce_us;
+    uint64_t reads;            // read() 次数 (每次一批事件)
+    uint64_t events;
+    uint64_t key_events;
+    int max_batch;
+    int64_t first_event_us, last_event_us;
+    int64_t last_key_us;
+    int64_t last_syn_us;
+    histogram_t key_interval;  // 相邻按键事件间隔
+    histogram_t report_interval; // 相邻SYN_REPORT间隔 (控制器上报周期)
+    histogram_t delivery;      // 内核时间戳到用户态读到的延迟
+    key_stats_t keys[KEY_CNT];
+} analyzer_t;
+
+static volatile sig_atomic_t running = 1;
+
+static void signal_handler(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static int64_t monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t event_us(const struct input_event* ev) {
+    return (int64_t)ev->input_event_sec * 1000000 + ev->input_event_usec;
+}
+
+static void hist_add(histogram_t* h, int64_t us) {
+    if (us < 0) us = 0;
+    int bucket = 0;
+    while (bucket < HIST_BUCKETS - 1 && (1LL << bucket) <= us) {
+        bucket++;
+    }
+    h->buckets[bucket]++;
+    if (h->count == 0 || us < h->min_us) h->min_us = us;
+    if (h->count == 0 || us > h->max_us) h->max_us = us;
+    h->sum_us += us;
+    h->count++;
+}
+
+// 近似分位数 (返回所在桶的上界)
+static int64_t hist_percentile(const histogram_t* h, double p) {
+    if (h->count == 0) return 0;
+    uint64_t target = (uint64_t)(h->count * p);
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > target) {
+            return i == 0 ? 1 : (1LL << i);
+        }
+    }
+    return h->max_us;
+}
+
+static void hist_print(const char* title, const histogram_t* h) {
+    printf("\n%s: %llu 个样本", title, (unsigned long long)h->count);
+    if (h->count == 0) {
+        printf("\n");
+        return;
+    }
+    printf(" | 最小 %lldus 平均 %lldus 最大 %lldus | p50<=%lldus p99<=%lldus\n",
+           (long long)h->min_us, (long long)(h->sum_us / (int64_t)h->count), (long long)h->max_us,
+           (long long)hist_percentile(h, 0.50), (long long)hist_percentile(h, 0.99));
+
+    uint32_t peak = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (h->buckets[i] > peak) peak = h->buckets[i];
+    }
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        if (h->buckets[i] == 0) continue;
+        long long lo = i == 0 ? 0 : (1LL << (i - 1));
+        long long hi = 1LL << i;
+        int bar = (int)((uint64_t)h->buckets[i] * 40 / peak);
+        printf("  %9lld - %9lldus %8u ", lo, hi, h->buckets[i]);
+        for (int j = 0; j < bar; j++) putchar('#');
+        putchar('\n');
+    }
+}
+
+static void analyzer_init(analyzer_t* a, int quiet, int debounce_ms) {
+    memset(a, 0, sizeof(*a));
+    a->quiet = quiet;
+    a->debounce_us = (int64_t)debounce_ms * 1000;
+    a->first_event_us = -1;
+    a->last_key_us = -1;
+    a->last_syn_us = -1;
+    for (int i = 0; i < KEY_CNT; i++) {
+        a->keys[i].last_press_us = -1;
+        a->keys[i].last_release_us = -1;
+    }
+}
+
+// 处理一个按键事件，返回1表示需要退出
+static int analyze_key(analyzer_t* a, const struct input_event* ev, int64_t t) {
+    a->key_events++;
+    if (a->last_key_us >= 0) {
+        hist_add(&a->key_interval, t - a->last_key_us);
+    }
+    a->last_key_us = t;
+
+    if (ev->code >= KEY_CNT) return 0;
+    key_stats_t* k = &a->keys[ev->code];
+
+    if (ev->value == 1) {
+        k->presses++;
+        // 释放后很快又按下视为一次抖动。只在重新按下时计数: 一次抖动同时包含很短的按住和
+        // 很快的重新按下，两边都计数会算成两次
+        if (k->last_release_us >= 0 && t - k->last_release_us < a->debounce_us) {
+            k->chatter++;
+        }
+        k->last_press_us = t;
+    } else if (ev->value == 0) {
+        k->releases++;
+        if (k->last_press_us >= 0) {
+            int64_t hold = t - k->last_press_us;
+            if (k->holds == 0 || hold < k->hold_min_us) k->hold_min_us = hold;
+            if (k->holds == 0 || hold > k->hold_max_us) k->hold_max_us = hold;
+            k->hold_sum_us += hold;
+            k->holds++;
+        }
+        k->last_release_us = t;
+    } else {
+        k->repeats++;
+    }
+
+    if (!a->quiet) {
+        const char* action = (ev->value == 1) ? "按下" :
+                             (ev->value == 0) ? "释放" : "重复";
+        printf("[%ld.%06ld] EV_KEY %d %s %s\n",
+               (long)ev->input_event_sec, (long)ev->input_event_usec,
+               ev->code, get_key_name(ev->code), action);
+    }
+
+    // 如果按下START键，退出
+    if (ev->code == RG34XX_BTN_START && ev->value == 1) {
+        if (!a->quiet) {
+            printf("\n🎯 START键按下，退出监听\n");
+        }
+        return 1;
+    }
+    return 0;
+}
+
+// 处理一批事件，返回1表示需要退出
+static int analyze_batch(analyzer_t* a, const struct input_event* evs, int count, int64_t read_us) {
+    int quit = 0;
+    a->reads++;
+    a->events += count;
+    if (count > a->max_batch) a->max_batch = count;
+
+    for (int i = 0; i < count; i++) {
+        const struct input_event* ev = &evs[i];
+        int64_t t = event_us(ev);
+        if (a->first_event_us < 0) a->first_event_us = t;
+        a->last_event_us = t;
+
+        if (ev->type == EV_SYN && ev->code == SYN_REPORT) {
+            if (a->last_syn_us >= 0) {
+                hist_add(&a->report_interval, t - a->last_syn_us);
+            }
+            a->last_syn_us = t;
+            // 时间戳已切换为CLOCK_MONOTONIC时才能与读取时刻比较
+            if (a->monotonic) {
+                hist_add(&a->delivery, read_us - t);
+            }
+        } else if (ev->type == EV_KEY) {
+            quit |= analyze_key(a, ev, t);
+        }
+    }
+    return quit;
+}
+
+static void analyzer_report(const analyzer_t* a) {
+    printf("\n=== 输入事件分析 ===\n");
+    printf("read次数: %llu | 事件: %llu | 按键事件: %llu | 平均每批 %.1f 最大每批 %d\n",
+           (unsigned long long)a->reads, (unsigned long long)a->events,
+           (unsigned long long)a->key_events,
+           a->reads ? (double)a->events / a->reads : 0.0, a->max_batch);
+    if (a->first_event_us >= 0 && a->last_event_us > a->first_event_us) {
+        double secs = (a->last_event_us - a->first_event_us) / 1000000.0;
+        printf("事件时长: %.2fs | 吞吐: %.1f 事件/秒\n", secs, a->events / secs);
+    }
+
+    // 上报周期: 控制器只在状态变化时上报，最小间隔最接近其轮询周期
+    const histogram_t* r = &a->report_interval;
+    if (r->count > 0 && r->min_us > 0) {
+        printf("控制器上报: 最小间隔 %lldus (≈%.0fHz) | 中位间隔<=%lldus\n",
+               (long long)r->min_us, 1000000.0 / r->min_us, (long long)hist_percentile(r, 0.5));
+    }
+
+    printf("\n按键统计 (去抖窗口 %lldms):\n", (long long)(a->debounce_us / 1000));
+    printf("  %-8s %6s %6s %6s %6s %10s %10s %10s\n",
+           "按键", "按下", "释放", "重复", "抖动", "最短按住", "平均按住", "最长按住");
+    for (int code = 0; code < KEY_CNT; code++) {
+        const key_stats_t* k = &a->keys[code];
+        if (k->presses == 0 && k->releases == 0 && k->repeats == 0) continue;
+        char name[16];
+        if (strcmp(get_key_name(code), "UNKNOWN") == 0) {
+            snprintf(name, sizeof(name), "%d", code);
+        } else {
+            snprintf(name, sizeof(name), "%s", get_key_name(code));
+        }
+        printf("  %-8s %6u %6u %6u %6u %8.1fms %8.1fms %8.1fms\n",
+               name, k->presses, k->releases, k->repeats, k->chatter,
+               k->holds ? k->hold_min_us / 1000.0 : 0.0,
+               k->holds ? (double)k->hold_sum_us / k->holds / 1000.0 : 0.0,
+               k->holds ? k->hold_max_us / 1000.0 : 0.0);
+    }
+
+    hist_print("按键事件间隔", &a->key_interval);
+    hist_print("控制器上报间隔", &a->report_interval);
+    hist_print("内核到用户态延迟", &a->delivery);
+}
+
+// 打开输入设备
+static int open_input_device(const char* path) {
+    if (path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            printf("❌ 无法打开 %s: %s\n", path, strerror(errno));
+            return -1;
+        }
+        printf("✅ 成功打开输入设备: %s\n", path);
+        return fd;
+    }
+
     const char* devices[] = {
         "/dev/input/event1",  // RG34XX主要输入设备
         "/dev/input/event0",
@@ -58,17 +327,20 @@ int main() {
         "/dev/input/event4",
         NULL
     };
-    
+
     for (int i = 0; devices[i] != NULL; i++) {
-        fd = open(devices[i], O_RDONLY | O_NONBLOCK);
-        if (fd > 0) {
+        int fd = open(devices[i], O_RDONLY);
+        if (fd >= 0) {
             printf("✅ 成功打开输入设备: %s\n", devices[i]);
-            break;
-        } else {
-            printf("❌ 无法打开 %s: %s\n", devices[i], strerror(errno));
+            return fd;
         }
+        printf("❌ 无法打开 %s: %s\n", devices[i], strerror(errno));
     }
-    
+    return -1;
+}
+
+static int run_analyzer(const char* device, int quiet, int debounce_ms, int timeout_s) {
+    int fd = open_input_device(device);
     if (fd < 0) {
         printf("❌ 无法打开任何输入设备\n");
         printf("请检查:\n");
@@ -76,39 +348,198 @@ int main() {
         printf("2. 输入设备: cat /proc/bus/input/devices\n");
         return 1;
     }
-    
-    printf("🎮 开始监听按键...\n");
-    printf("按键格式: [时间] 事件类型 按键码 按键名称 状态\n\n");
-    
-    struct input_event ev;
-    int running = 1;
-    
+
+    // 事件时间戳使用单调时钟，便于计算投递延迟
+    int clk = CLOCK_MONOTONIC;
+    int monotonic = ioctl(fd, EVIOCSCLOCKID, &clk) == 0;
+    if (!monotonic) {
+        printf("⚠️  无法切换事件时钟，不统计投递延迟\n");
+    }
+
+    char name[128] = "Unknown";
+    ioctl(fd, EVIOCGNAME(sizeof(name)), name);
+    printf("🎮 设备名称: %s\n", name);
+    printf("开始监听按键%s，按START或Ctrl+C结束\n\n", quiet ? " (静默模式)" : "");
+    if (!quiet) {
+        printf("按键格式: [时间] 事件类型 按键码 按键名称 状态\n\n");
+    }
+
+    static analyzer_t analyzer;
+    analyzer_init(&analyzer, quiet, debounce_ms);
+    analyzer.monotonic = monotonic;
+
+    struct input_event evs[EVENT_BATCH];
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int64_t deadline = timeout_s > 0 ? monotonic_us() + (int64_t)timeout_s * 1000000 : 0;
+
     while (running) {
-        if (read(fd, &ev, sizeof(ev)) == sizeof(ev)) {
-            if (ev.type == EV_KEY) {
-                const char* key_name = get_key_name(ev.code);
-                const char* action = (ev.value == 1) ? "按下" : 
-                                   (ev.value == 0) ? "释放" : "重复";
-                
-                printf("[%ld.%06ld] EV_KEY %d %s %s\n", 
-                       ev.time.tv_sec, ev.time.tv_usec, 
-                       ev.code, key_name, action);
-                
-                // 如果按下START键，退出
-                if (ev.code == RG34XX_BTN_START && ev.value == 1) {
-                    printf("\n🎯 START键按下，退出监听\n");
-                    running = 0;
-                }
-            }
-        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        // 阻塞等待，周期性醒来检查退出条件
+        int ret = poll(&pfd, 1, 500);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+            printf("❌ poll错误: %s\n", strerror(errno));
+            break;
+        }
+        if (deadline && monotonic_us() >= deadline) {
+            break;
+        }
+        if (ret == 0) continue;
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            printf("❌ 输入设备已断开\n");
+            break;
+        }
+
+        ssize_t n = read(fd, evs, sizeof(evs));
+        int64_t read_us = monotonic_us();
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
             printf("❌ 读取错误: %s\n", strerror(errno));
             break;
         }
-        
-        usleep(1000); // 1ms延迟
+        if (n == 0) {
+            // 读取的是录制的事件文件 (cat /dev/input/eventN > dump)，回放结束
+            break;
+        }
+        if (analyze_batch(&analyzer, evs, (int)(n / sizeof(evs[0])), read_us)) {
+            break;
+        }
     }
-    
+
     close(fd);
-    printf("\n✅ 按键监听测试完成\n");
+    analyzer_report(&analyzer);
     return 0;
 }
+
+// ===== uinput模拟设备 =====
+
+static void emit(int fd, int type, int code, int value) {
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    if (write(fd, &ev, sizeof(ev)) != sizeof(ev)) {
+        printf("❌ 写入uinput失败: %s\n", strerror(errno));
+    }
+}
+
+static void emit_key(int fd, int code, int value) {
+    emit(fd, EV_KEY, code, value);
+    emit(fd, EV_SYN, SYN_REPORT, 0);
+}
+
+// 创建模拟RG34XX手柄的uinput设备并按固定频率发送按键
+static int run_simulator(int rate_hz, int count, int chatter_pct, int hold_ms) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        printf("❌ 无法打开 /dev/uinput: %s\n", strerror(errno));
+        printf("请检查: modprobe uinput 以及设备权限\n");
+        return 1;
+    }
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    for (int i = 0; i < RG34XX_CODE_COUNT; i++) {
+        ioctl(fd, UI_SET_KEYBIT, rg34xx_codes[i]);
+    }
+
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x1234;
+    setup.id.product = 0x3400;
+    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "RG34XX key-test sim");
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+        printf("❌ 创建uinput设备失败: %s\n", strerror(errno));
+        close(fd);
+        return 1;
+    }
+
+    char sysname[64] = "";
+    if (ioctl(fd, UI_GET_SYSNAME(sizeof(sysname)), sysname) >= 0) {
+        printf("✅ 模拟设备: /sys/devices/virtual/input/%s (在其下查找eventN)\n", sysname);
+    }
+    printf("🎮 %d次按键, %dHz, 按住%dms, 抖动概率%d%%, 最后发送START\n",
+           count, rate_hz, hold_ms, chatter_pct);
+
+    // 给分析器留出打开设备的时间
+    sleep(2);
+
+    long period_us = 1000000L / (rate_hz > 0 ? rate_hz : 1);
+    long hold_us = (long)hold_ms * 1000;
+    if (hold_us >= period_us) hold_us = period_us / 2;
+    unsigned int seed = 34;
+
+    for (int i = 0; i < count && running; i++) {
+        int code = rg34xx_codes[i % (RG34XX_CODE_COUNT - 1)]; // 不含START
+        emit_key(fd, code, 1);
+        if (chatter_pct > 0 && (int)(rand_r(&seed) % 100) < chatter_pct) {
+            // 模拟触点抖动: 1ms内释放再按下
+            usleep(300);
+            emit_key(fd, code, 0);
+            usleep(700);
+            emit_key(fd, code, 1);
+        }
+        usleep(hold_us);
+        emit_key(fd, code, 0);
+        usleep(period_us - hold_us);
+    }
+
+    emit_key(fd, RG34XX_BTN_START, 1);
+    emit_key(fd, RG34XX_BTN_START, 0);
+    usleep(100000);
+
+    ioctl(fd, UI_DEV_DESTROY);
+    close(fd);
+    printf("✅ 模拟结束\n");
+    return 0;
+}
+
+static void usage(const char* prog) {
+    printf("用法:\n");
+    printf("  %s [-d 设备] [-q] [-b 去抖ms] [-t 秒]   分析输入事件\n", prog);
+    printf("  %s -s [-r 频率Hz] [-n 次数] [-j 抖动%%] [-p 按住ms]   创建uinput模拟设备\n", prog);
+    printf("  -q  静默模式: 不逐个打印事件，只在结束时输出统计\n");
+    printf("  -d  也可指定录制的事件文件离线分析 (cat /dev/input/eventN > dump)\n");
+}
+
+int main(int argc, char* argv[]) {
+    printf("=== RG34XX 按键监听测试 ===\n");
+
+    const char* device = NULL;
+    int quiet = 0;
+    int debounce_ms = DEFAULT_DEBOUNCE_MS;
+    int timeout_s = 0;
+    int simulate = 0;
+    int rate_hz = 20;
+    int count = 200;
+    int chatter_pct = 0;
+    int hold_ms = 20;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:qb:t:sr:n:j:p:h")) != -1) {
+        switch (opt) {
+            case 'd': device = optarg; break;
+            case 'q': quiet = 1; break;
+            case 'b': debounce_ms = atoi(optarg); break;
+            case 't': timeout_s = atoi(optarg); break;
+            case 's': simulate = 1; break;
+            case 'r': rate_hz = atoi(optarg); break;
+            case 'n': count = atoi(optarg); break;
+            case 'j': chatter_pct = atoi(optarg); break;
+            case 'p': hold_ms = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    int ret = simulate ? run_simulator(rate_hz, count, chatter_pct, hold_ms)
+                       : run_analyzer(device, quiet, debounce_ms, timeout_s);
+    if (ret == 0) {
+        printf("\n✅ 按键监听测试完成\n");
+    }
+    return ret;
+}
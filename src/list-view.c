@@ -0,0 +1,177 @@
+#include "list-view.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 按下后第一次重复前的延迟
+#define REPEAT_DELAY_MS 300
+
+// 按住的时间越长，重复越快，到最快 (每个逻辑步) 之后每次移动多行
+static void repeat_rate(int hold_ms, int* interval_ms, int* rows) {
+    *rows = 1;
+    if (hold_ms < 1000) {
+        *interval_ms = 100;
+    } else if (hold_ms < 2000) {
+        *interval_ms = 50;
+    } else {
+        *interval_ms = 16;
+        if (hold_ms >= 5000) *rows = 16;
+        else if (hold_ms >= 3500) *rows = 4;
+    }
+}
+
+static int max_scroll(const list_view_t* view) {
+    int max = view->count * view->row_height - view->view_height;
+    return max > 0 ? max : 0;
+}
+
+// 目标位置: 选中行完整地出现在视口内，移动得尽量少
+static void update_target(list_view_t* view) {
+    int top = view->selected * view->row_height;
+    int bottom = top + view->row_height;
+    if (top < view->target) {
+        view->target = top;
+    } else if (bottom > view->target + view->view_height) {
+        view->target = bottom - view->view_height;
+    }
+    if (view->target > max_scroll(view)) view->target = max_scroll(view);
+    if (view->target < 0) view->target = 0;
+}
+
+static void move_selection(list_view_t* view, int delta) {
+    if (view->count == 0) {
+        return;
+    }
+    int selected = view->selected + delta;
+    if (selected < 0) selected = 0;
+    if (selected >= view->count) selected = view->count - 1;
+    view->selected = selected;
+    update_target(view);
+}
+
+void list_view_init(list_view_t* view, int count, int row_height, int view_height) {
+    memset(view, 0, sizeof(*view));
+    view->count = count > 0 ? count : 0;
+    view->row_height = row_height > 0 ? row_height : 1;
+    view->view_height = view_height;
+}
+
+void list_view_set_count(list_view_t* view, int count) {
+    view->count = count > 0 ? count : 0;
+    move_selection(view, 0);
+    if (view->count == 0) {
+        view->selected = view->target = 0;
+    }
+    if (view->scroll > max_scroll(view)) view->scroll = max_scroll(view);
+}
+
+int list_view_step(list_view_t* view, int dir, int dt_ms) {
+    int selected = view->selected;
+    int scroll = view->scroll;
+
+    if (dir != view->hold) {
+        // 刚按下 (或换了方向) 立即移动一行
+        view->hold = dir;
+        view->hold_ms = 0;
+        view->repeat_ms = REPEAT_DELAY_MS;
+        move_selection(view, dir);
+    } else if (dir != 0) {
+        view->hold_ms += dt_ms;
+        view->repeat_ms -= dt_ms;
+        while (view->repeat_ms <= 0) {
+            int interval, rows;
+            repeat_rate(view->hold_ms, &interval, &rows);
+            move_selection(view, dir * rows);
+            view->repeat_ms += interval;
+        }
+    }
+
+    // 平滑滚动: 每步走剩余距离的三分之一；差得太远时先跳到只差一屏的位置
+    int diff = view->target - view->scroll;
+    if (diff > view->view_height * 2) {
+        view->scroll = view->target - view->view_height;
+    } else if (diff < -view->view_height * 2) {
+        view->scroll = view->target + view->view_height;
+    }
+    diff = view->target - view->scroll;
+    if (diff != 0) {
+        int delta = diff / 3;
+        if (delta == 0) delta = diff > 0 ? 1 : -1;
+        view->scroll += delta;
+    }
+
+    return view->selected != selected || view->scroll != scroll;
+}
+
+void list_view_page(list_view_t* view, int pages) {
+    int rows = view->view_height / view->row_height;
+    if (rows < 1) rows = 1;
+    move_selection(view, pages * rows);
+}
+
+void list_view_visible(const list_view_t* view, int* first, int* last) {
+    *first = view->scroll / view->row_height;
+    *last = (view->scroll + view->view_height - 1) / view->row_height;
+    if (*last >= view->count) *last = view->count - 1;
+}
+
+int list_rows_init(list_rows_t* rows, int visible, int overscan, list_text_fn text, void* context) {
+    memset(rows, 0, sizeof(*rows));
+    if (visible < 1 || overscan < 0) {
+        return -1;
+    }
+    // 顶端和底端各露出一部分时比完整的行数多一行
+    rows->capacity = visible + 1 + overscan * 2;
+    rows->rows = malloc((size_t)rows->capacity * sizeof(list_row_t));
+    if (!rows->rows) {
+        return -1;
+    }
+    rows->overscan = overscan;
+    rows->text = text;
+    rows->context = context;
+    list_rows_invalidate(rows);
+    return 0;
+}
+
+void list_rows_destroy(list_rows_t* rows) {
+    free(rows->rows);
+    memset(rows, 0, sizeof(*rows));
+}
+
+int list_rows_update(list_rows_t* rows, int first, int last, int count) {
+    int lo = first - rows->overscan;
+    int hi = last + rows->overscan;
+    if (lo < 0) lo = 0;
+    if (hi >= count) hi = count - 1;
+    if (hi - lo + 1 > rows->capacity) hi = lo + rows->capacity - 1;
+
+    // 窗口内的下标对容量取模互不相同，滚动后移出窗口的槽位正好被移进来的条目复用
+    int fetched = 0;
+    for (int i = lo; i <= hi; i++) {
+        list_row_t* row = &rows->rows[i % rows->capacity];
+        if (row->index == i) continue;
+        if (rows->text(rows->context, i, row->text, sizeof(row->text)) < 0) {
+            row->text[0] = '\0';
+        }
+        row->index = i;
+        fetched++;
+    }
+    rows->fetched = fetched;
+    rows->total_fetched += fetched;
+    return fetched;
+}
+
+const char* list_rows_text(const list_rows_t* rows, int index) {
+    if (index < 0) {
+        return NULL;
+    }
+    const list_row_t* row = &rows->rows[index % rows->capacity];
+    return row->index == index ? row->text : NULL;
+}
+
+void list_rows_invalidate(list_rows_t* rows) {
+    for (int i = 0; i < rows->capacity; i++) {
+        rows->rows[i].index = -1;
+        rows->rows[i].text[0] = '\0';
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef LIST_VIEW_H
+#define LIST_VIEW_H
+
+// 虚拟化的滚动列表 (不依赖SDL)，用于条目数很多的目录浏览。
+//
+// 滚动状态 (list_view_t) 由逻辑线程推进: 方向键移动选中行，按住时先延迟再重复，越按越快 (每次移动的行数也变多)；
+// 滚动位置平滑地追向让选中行可见的目标位置，跳得很远时直接跳到目标附近。
+// 行缓存 (list_rows_t) 由绘制方持有: 只保存可见行加上下各overscan行的文字，按 下标 % 容量 循环使用槽位，
+// 滚动一行只取一行新的文字。两者的开销都与条目总数无关。
+
+#define LIST_VIEW_TEXT_MAX 256
+
+typedef struct {
+    int count;                   // 条目数 (可以在扫描过程中增长)
+    int row_height;
+    int view_height;
+    int selected;
+    int scroll;                  // 视口顶端在列表中的像素位置
+    int target;                  // 让选中行可见的滚动位置
+
+    // 按住方向键的自动重复
+    int hold;                    // 按住的方向: -1上，1下，0没有
+    int hold_ms;                 // 已经按住的时间
+    int repeat_ms;               // 距下一次重复的时间
+} list_view_t;
+
+void list_view_init(list_view_t* view, int count, int row_height, int view_height);
+
+// 条目数变化 (选中行保持在范围内)
+void list_view_set_count(list_view_t* view, int count);
+
+// 逻辑一步: dir为当前按住的方向，dt_ms为步长。返回选中行或滚动位置是否变化
+int list_view_step(list_view_t* view, int dir, int dt_ms);
+
+// 翻页 (pages为负时向上)，选中行和目标位置一起移动
+void list_view_page(list_view_t* view, int pages);
+
+// 视口中 (可能只露出一部分) 的第一行和最后一行，列表为空时last < first
+void list_view_visible(const list_view_t* view, int* first, int* last);
+
+// 取第index项的文字写入text，失败返回-1
+typedef int (*list_text_fn)(void* context, int index, char* text, int size);
+
+typedef struct {
+    int index;                   // 槽位中的条目，-1为空
+    char text[LIST_VIEW_TEXT_MAX];
+} list_row_t;
+
+typedef struct {
+    list_row_t* rows;
+    int capacity;
+    int overscan;
+    list_text_fn text;
+    void* context;
+    int fetched;                 // 上一次 list_rows_update 新取文字的行数
+    long total_fetched;
+} list_rows_t;
+
+// 可见行数visible加上下各overscan行的槽位一次分配，失败返回-1
+int list_rows_init(list_rows_t* rows, int visible, int overscan, list_text_fn text, void* context);
+void list_rows_destroy(list_rows_t* rows);
+
+// 确保 [first - overscan, last + overscan] 内的条目都在缓存中，返回新取文字的行数
+int list_rows_update(list_rows_t* rows, int first, int last, int count);
+
+// 缓存中第index项的文字，不在缓存中时返回NULL
+const char* list_rows_text(const list_rows_t* rows, int index);
+
+// 条目内容变了 (例如重新扫描)，所有槽位作废
+void list_rows_invalidate(list_rows_t* rows);
+
+#endif
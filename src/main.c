@@ -9,12 +9,16 @@
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <time.h>
-#include <math.h>
 #include <signal.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <netdb.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include "pixel-format.h"
+#include "fixmath.h"
+#include "blend.h"
+#include "image-asset.h"
+#include "triple-buffer.h"
+#include "net-probe.h"
 
 // 屏幕分辨率
 #define SCREEN_WIDTH  720
@@ -46,9 +50,9 @@
 #define RG34XX_BTN_R2     313
 
 // 全局变量
-int running = 1;
-int frame_count = 0;
-float animation_time = 0.0f;
+atomic_int running = 1;       // 信号处理、逻辑线程和渲染线程共用
+int frame_count = 0;          // 渲染的帧数
+fx_t animation_time = 0;      // 动画时间 (秒，Q16.16)
 time_t last_activity_time = 0;
 FILE* log_file = NULL;
 
@@ -59,11 +63,33 @@ size_t buffer_size = 0;
 // 按键状态显示
 char last_key_info[128] = "等待按键输入...";
 
+// 逻辑线程发布给渲染线程的界面状态快照，发布后不再修改
+typedef struct {
+    int tick;
+    fx_t animation_time;
+    int remaining_time;           // 距离自动退出的秒数
+    char last_key_info[128];
+    net_probe_state_t net_state;  // 网络检测进度，结果出来后下一帧就会显示
+} ui_state_t;
+
+// 逻辑与渲染分离: 按键和动画在主线程以固定步长运行，绘制和刷新在渲染线程，
+// 通过无锁三缓冲交换快照，渲染慢时不会推迟按键处理
+triple_buffer_t ui_states;
+sem_t state_ready;                // 发布新快照时通知渲染线程
+int render_threaded = 0;
+int logic_tick = 0;
+
+// 网络检测在后台线程中进行，逻辑线程每步读取一次结果，不阻塞启动和界面
+net_probe_t net_probe;
+net_probe_result_t net_result;
+int net_reported = 0;             // 结果已经写入日志
+
 // 日志函数
 void log_message(const char* message) {
     if (log_file) {
         time_t now = time(NULL);
-        char* time_str = ctime(&now);
+        char time_str[32];
+        ctime_r(&now, time_str);   // 逻辑线程和渲染线程都会写日志，不用ctime的静态缓冲区
         time_str[strlen(time_str) - 1] = '\0'; // 移除换行符
         fprintf(log_file, "[%s] %s\n", time_str, message);
         fflush(log_file);
@@ -98,10 +124,14 @@ typedef struct {
     size_t size;
     int width, height;
     int bpp; // bits per pixel
+    pixel_format_t format;   // 面板原生像素格式，颜色绘制前转换一次
 } framebuffer_t;
 
 framebuffer_t fb;
 
+// 标题栏图标 (可选的预转换图片资源，像素已是面板格式)
+image_asset_t logo;
+
 // 初始化帧缓冲
 int init_framebuffer() {
     fb.fd = open("/dev/fb0", O_RDWR);
@@ -160,6 +190,7 @@ int init_framebuffer() {
         fb.bpp = vinfo.bits_per_pixel;
         fb.size = fb.width * fb.height * fb.bpp / 8;
     }
+    fb.format = pixel_format_from_fb(fb.bpp, vinfo.red.offset);
     
     printf("帧缓冲初始化成功: %dx%d, %dbpp\n", fb.width, fb.height, fb.bpp);
     return 0;
@@ -233,19 +264,11 @@ void set_pixel(int x, int y, unsigned int color) {
     if (fb.bpp == 32) {
         // 32位色深
         unsigned int* pixel = (unsigned int*)target_buffer + location;
-        *pixel = color;
+        *pixel = pixel_map(fb.format, color);
     } else if (fb.bpp == 16) {
         // 16位色深 (RGB565)
         unsigned short* pixel = (unsigned short*)target_buffer + location;
-        
-        // 提取RGB分量
-        unsigned int r = (color >> 16) & 0xFF;
-        unsigned int g = (color >> 8) & 0xFF;
-        unsigned int b = color & 0xFF;
-        
-        // 转换为RGB565
-        unsigned short rgb565 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-        *pixel = rgb565;
+        *pixel = (unsigned short)pixel_map(fb.format, color);
     }
 }
 
@@ -260,38 +283,89 @@ void set_pixel_fb(int x, int y, unsigned int color) {
     if (fb.bpp == 32) {
         // 32位色深
         unsigned int* pixel = (unsigned int*)fb.framebuffer + location;
-        *pixel = color;
+        *pixel = pixel_map(fb.format, color);
     } else if (fb.bpp == 16) {
         // 16位色深 (RGB565)
         unsigned short* pixel = (unsigned short*)fb.framebuffer + location;
-        
-        // 提取RGB分量
-        unsigned int r = (color >> 16) & 0xFF;
-        unsigned int g = (color >> 8) & 0xFF;
-        unsigned int b = color & 0xFF;
-        
-        // 转换为RGB565
-        unsigned short rgb565 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
-        *pixel = rgb565;
+        *pixel = (unsigned short)pixel_map(fb.format, color);
     }
 }
 
-// 绘制矩形
+// 用原生像素值填充一行中的 [x0, x1) (自动裁剪)
+static void fill_span(int y, int x0, int x1, uint32_t pixel) {
+    if (y < 0 || y >= fb.height) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 > fb.width) x1 = fb.width;
+    if (x0 >= x1) return;
+    
+    int bytes = fb.bpp / 8;
+    unsigned char* target_buffer = back_buffer ? back_buffer : fb.framebuffer;
+    unsigned char* row = target_buffer + ((size_t)y * fb.width + x0) * bytes;
+    pixel_fill_row(fb.format, row, pixel, x1 - x0);
+}
+
+// 绘制矩形 (颜色只转换一次，逐行填充原生像素)
 void draw_rect(int x, int y, int width, int height, unsigned int color) {
+    uint32_t pixel = pixel_map(fb.format, color);
     for (int i = y; i < y + height && i < fb.height; i++) {
-        for (int j = x; j < x + width && j < fb.width; j++) {
-            set_pixel(j, i, color);
+        fill_span(i, x, x + width, pixel);
+    }
+}
+
+// 半透明矩形 (alpha 0-255)，逐行与后缓冲中已有的像素混合
+void draw_rect_blend(int x, int y, int width, int height, unsigned int color, int alpha) {
+    uint32_t pixel = pixel_map(fb.format, color);
+    int x0 = x < 0 ? 0 : x;
+    int x1 = x + width > fb.width ? fb.width : x + width;
+    if (x0 >= x1) return;
+    
+    int bytes = fb.bpp / 8;
+    unsigned char* target_buffer = back_buffer ? back_buffer : fb.framebuffer;
+    for (int i = y < 0 ? 0 : y; i < y + height && i < fb.height; i++) {
+        unsigned char* row = target_buffer + ((size_t)i * fb.width + x0) * bytes;
+        blend_fill_row(fb.format, row, pixel, x1 - x0, alpha);
+    }
+}
+
+// 映射标题栏图标，格式与面板不同时不显示 (用 image-asset-tool -f 转换为面板格式)
+void load_logo() {
+    const char* paths[] = { "./ui-logo.rgi", "/mnt/mmc/Roms/APPS/ui-logo.rgi" };
+    for (int i = 0; i < 2; i++) {
+        if (image_asset_open(&logo, paths[i]) < 0) continue;
+        
+        char image_msg[320];
+        if (logo.format != fb.format) {
+            sprintf(image_msg, "警告: 图片资源 %s 的像素格式与面板不同，不显示", paths[i]);
+            image_asset_close(&logo);
+        } else {
+            sprintf(image_msg, "图片资源: %s %dx%d%s", paths[i], logo.width, logo.height,
+                    logo.alpha ? " + 透明度" : "");
         }
+        log_message(image_msg);
+        return;
     }
 }
 
-// 绘制圆形
+// 绘制图片 (逐行复制映射的像素，不解码不转换)
+void draw_image(const image_asset_t* image, int x, int y) {
+    if (!image->data) return;
+    void* target_buffer = back_buffer ? back_buffer : fb.framebuffer;
+    image_asset_blit(image, fb.format, target_buffer, fb.width * (fb.bpp / 8),
+                     fb.width, fb.height, x, y, 255);
+}
+
+// 绘制圆形 (每行一段水平填充)
 void draw_circle(int cx, int cy, int radius, unsigned int color) {
-    for (int y = -radius; y <= radius; y++) {
-        for (int x = -radius; x <= radius; x++) {
-            if (x*x + y*y <= radius*radius) {
-                set_pixel(cx + x, cy + y, color);
-            }
+    uint32_t pixel = pixel_map(fb.format, color);
+    int span = radius;
+    for (int y = 0; y <= radius; y++) {
+        // 行越远离圆心越窄，半宽只会减小
+        while (span > 0 && span * span + y * y > radius * radius) {
+            span--;
+        }
+        fill_span(cy - y, cx - span, cx + span + 1, pixel);
+        if (y > 0) {
+            fill_span(cy + y, cx - span, cx + span + 1, pixel);
         }
     }
 }
@@ -341,8 +415,8 @@ void refresh_framebuffer() {
     }
 }
 
-// 绘制界面
-void draw_ui() {
+// 绘制界面 (只读取快照)
+void draw_ui(const ui_state_t* state) {
     char debug_msg[256];
     sprintf(debug_msg, "绘制界面: %dx%d, %dbpp", fb.width, fb.height, fb.bpp);
     log_message(debug_msg);
@@ -352,6 +426,16 @@ void draw_ui() {
     
     // 绘制标题背景
     draw_rect(0, 0, fb.width, 40, COLOR_BLUE);
+    draw_image(&logo, fb.width - logo.width - 10, (40 - logo.height) / 2);
+    
+    // 网络状态指示: 黄色检测中，绿色连接成功，红色失败
+    unsigned int net_color = COLOR_YELLOW;
+    if (state->net_state == NET_PROBE_OK) {
+        net_color = COLOR_GREEN;
+    } else if (state->net_state == NET_PROBE_FAILED) {
+        net_color = COLOR_RED;
+    }
+    draw_rect(10, 10, 20, 20, net_color);
     
     // 绘制底部信息栏
     draw_rect(0, fb.height - 60, fb.width, 60, COLOR_BLUE);
@@ -362,10 +446,10 @@ void draw_ui() {
     // 在动画区域内绘制动画
     draw_rect(15, 55, fb.width - 30, fb.height - 130, COLOR_BLACK);
     
-    // 绘制动画
-    float t = animation_time;
-    int circle_x = (int)(fb.width/2 + cos(t) * 100);
-    int circle_y = (int)(fb.height/2 + sin(t * 2) * 60);
+    // 绘制动画 (定点运算，主机和掌机上逐位相同)
+    fx_angle_t t = fx_angle_from_rad(state->animation_time);
+    int circle_x = fb.width/2 + fx_to_int(fx_cos(t) * 100);
+    int circle_y = fb.height/2 + fx_to_int(fx_sin(t * 2) * 60);
     
     // 确保圆形在动画区域内
     if (circle_x > 15 && circle_x < fb.width - 15 && circle_y > 55 && circle_y < fb.height - 55) {
@@ -373,35 +457,35 @@ void draw_ui() {
     }
     
     // 绘制旋转矩形
-    float angle = t * 3;
-    int rect_x = fb.width/2 + (int)(cos(angle) * 60);
-    int rect_y = fb.height/2 + (int)(sin(angle) * 40);
+    fx_angle_t angle = t * 3;
+    int rect_x = fb.width/2 + fx_to_int(fx_cos(angle) * 60);
+    int rect_y = fb.height/2 + fx_to_int(fx_sin(angle) * 40);
     
     if (rect_x > 15 && rect_x < fb.width - 15 && rect_y > 55 && rect_y < fb.height - 55) {
         draw_rect(rect_x - 20, rect_y - 20, 40, 40, COLOR_GREEN);
     }
     
-    // 绘制按键信息 (使用简单的像素块表示文字)
-    draw_rect(20, fb.height - 50, fb.width - 40, 20, COLOR_BLACK);
+    // 绘制按键信息 (使用简单的像素块表示文字)，底板半透明，透出下面的底栏
+    draw_rect_blend(20, fb.height - 50, fb.width - 40, 20, COLOR_BLACK, 160);
     
     // 显示按键信息 (简化文字显示)
     int text_x = 30;
     int text_y = fb.height - 45;
-    for (int i = 0; i < strlen(last_key_info) && i < 30; i++) {
+    for (int i = 0; i < strlen(state->last_key_info) && i < 30; i++) {
         // 简单的字符显示 (每个字符用小方块表示)
         draw_rect(text_x + i * 15, text_y, 10, 10, COLOR_YELLOW);
     }
     
     // 绘制状态信息
-    time_t current_time = time(NULL);
-    int remaining_time = 15 - (int)(current_time - last_activity_time);
+    int remaining_time = state->remaining_time;
     
     // 在状态栏绘制像素块表示文字
     for (int i = 0; i < remaining_time && i < 15; i++) {
         draw_rect(10 + i * 20, fb.height - 20, 15, 15, COLOR_WHITE);
     }
     
-    sprintf(debug_msg, "状态更新: Frame=%d Time=%.1fs AutoExit=%ds", frame_count, animation_time, remaining_time);
+    int tenths = fx_to_int(fx_mul(state->animation_time, fx_from_int(10)));
+    sprintf(debug_msg, "状态更新: Frame=%d Time=%d.%ds AutoExit=%ds", frame_count, tenths / 10, tenths % 10, remaining_time);
     log_message(debug_msg);
     
     // 复制后缓冲到帧缓冲
@@ -409,6 +493,49 @@ void draw_ui() {
     log_message("帧缓冲刷新完成");
 }
 
+// 当前的逻辑状态写入快照
+void fill_state(ui_state_t* state) {
+    state->tick = logic_tick;
+    state->animation_time = animation_time;
+    state->remaining_time = 15 - (int)(time(NULL) - last_activity_time);
+    strcpy(state->last_key_info, last_key_info);
+    state->net_state = net_result.state;
+}
+
+// 逻辑线程: 发布快照并通知渲染线程 (不等待)；没有渲染线程时直接绘制
+void publish_state() {
+    fill_state(triple_buffer_write_slot(&ui_states));
+    triple_buffer_publish(&ui_states);
+    if (render_threaded) {
+        sem_post(&state_ready);
+    } else {
+        draw_ui(triple_buffer_read(&ui_states, NULL));
+        frame_count++;
+    }
+}
+
+// 渲染线程: 等待新快照，绘制后复制到帧缓冲
+void* render_thread_main(void* arg) {
+    (void)arg;
+    while (running) {
+        if (!triple_buffer_pending(&ui_states)) {
+            // 超时后重新检查running
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100 * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            sem_timedwait(&state_ready, &deadline);
+            continue;
+        }
+        draw_ui(triple_buffer_read(&ui_states, NULL));
+        frame_count++;
+    }
+    return NULL;
+}
+
 // 检查自动退出
 void check_auto_exit() {
     time_t current_time = time(NULL);
@@ -431,51 +558,25 @@ void update_activity() {
     last_activity_time = time(NULL);
 }
 
-// 网络测试
-int test_network() {
-    log_message("开始网络测试...");
-    
-    // 测试DNS解析
-    struct hostent* host = gethostbyname("www.baidu.com");
-    if (host == NULL) {
-        char error_msg[128];
-        sprintf(error_msg, "DNS解析失败: %s", hstrerror(h_errno));
-        log_message(error_msg);
-        return -1;
+// 网络测试: 取后台检测的最新结果，得出结果时写一次日志
+void poll_network() {
+    if (net_reported) {
+        return;
     }
-    
-    char success_msg[128];
-    sprintf(success_msg, "DNS解析成功: %s", host->h_name);
-    log_message(success_msg);
-    
-    // 测试TCP连接
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        log_message("创建socket失败");
-        return -1;
+    net_probe_get(&net_probe, &net_result);
+    if (net_result.state != NET_PROBE_OK && net_result.state != NET_PROBE_FAILED) {
+        return;
     }
-    
-    struct sockaddr_in addr;
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(80);
-    memcpy(&addr.sin_addr, host->h_addr_list[0], host->h_length);
-    
-    // 设置超时
-    struct timeval timeout;
-    timeout.tv_sec = 5;
-    timeout.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    
-    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        log_message("网络连接失败");
-        close(sock);
-        return -1;
+    char net_msg[512];
+    if (net_result.state == NET_PROBE_OK) {
+        sprintf(net_msg, "网络测试通过: %s:%s 已连接 %s (%dms，同时尝试%d个地址)",
+                net_probe.host, net_probe.port, net_result.address, net_result.elapsed_ms, net_result.attempts);
+    } else {
+        sprintf(net_msg, "网络测试失败: %s:%s %s (%dms)",
+                net_probe.host, net_probe.port, net_result.message, net_result.elapsed_ms);
     }
-    
-    log_message("网络连接成功");
-    close(sock);
-    return 0;
+    log_message(net_msg);
+    net_reported = 1;
 }
 
 // 按键测试
@@ -511,8 +612,13 @@ void test_buttons() {
     struct input_event ev;
     int button_states[16] = {0}; // 记录按键状态
     
+    // 固定16ms步长，按绝对时间睡眠，不随处理时间漂移
+    struct timespec next_tick;
+    clock_gettime(CLOCK_MONOTONIC, &next_tick);
+    
     while (running) {
-        if (read(fd, &ev, sizeof(ev)) == sizeof(ev)) {
+        // 每一步读完所有待处理的事件，逻辑总是基于最新的输入
+        while (read(fd, &ev, sizeof(ev)) == sizeof(ev)) {
             if (ev.type == EV_KEY) {
                 int button_index = -1;
                 const char* button_name = "UNKNOWN";
@@ -575,14 +681,26 @@ void test_buttons() {
         }
         
         // 更新动画
-        animation_time += 0.016f; // 假设60FPS
-        frame_count++;
-        draw_ui();
+        animation_time += FX_CONST(0.016); // 60Hz步长
+        logic_tick++;
         
         // 检查自动退出
         check_auto_exit();
+        poll_network();
+        
+        publish_state();
         
-        usleep(16000); // ~60FPS
+        next_tick.tv_nsec += 16000000L;
+        if (next_tick.tv_nsec >= 1000000000L) {
+            next_tick.tv_sec++;
+            next_tick.tv_nsec -= 1000000000L;
+        }
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next_tick.tv_sec + 1) {
+            next_tick = now;  // 落后太多 (例如被挂起) 时不追赶
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next_tick, NULL);
     }
     
     close(fd);
@@ -594,7 +712,7 @@ void signal_handler(int sig) {
     running = 0;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     printf("=== RG34XX 硬件测试应用 v1.3 ===\n");
     printf("屏幕分辨率: %dx%d\n", SCREEN_WIDTH, SCREEN_HEIGHT);
     
@@ -605,6 +723,30 @@ int main() {
     // 打开日志文件
     open_log_file();
     
+    // 网络测试: 最先开始，在后台与下面的检查和颜色测试同时进行
+    // 用法: rg34xx-test [--net 主机:端口] [--net-timeout 毫秒]
+    const char* net_target = NET_PROBE_DEFAULT_TARGET;
+    int net_timeout = NET_PROBE_DEFAULT_TIMEOUT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--net") == 0 && i + 1 < argc) {
+            net_target = argv[++i];
+        } else if (strcmp(argv[i], "--net-timeout") == 0 && i + 1 < argc) {
+            net_timeout = atoi(argv[++i]);
+        }
+    }
+    log_message("=== 网络测试 (后台) ===");
+    char net_msg[256];
+    sprintf(net_msg, "检测目标: %.200s，超时%dms", net_target, net_timeout);
+    log_message(net_msg);
+    if (net_probe_start(&net_probe, net_target, net_timeout) < 0) {
+        sprintf(net_msg, "网络测试失败: %.200s", net_probe.result.message);   // 没有后台线程，可以直接读
+        log_message(net_msg);
+        net_result.state = NET_PROBE_FAILED;
+        net_reported = 1;
+    } else {
+        net_result.state = NET_PROBE_RESOLVING;
+    }
+    
     // 检查设备权限
     log_message("=== 检查设备权限 ===");
     
@@ -655,6 +797,7 @@ int main() {
     if (init_double_buffer() < 0) {
         log_message("双缓冲初始化失败，使用单缓冲模式");
     }
+    load_logo();
     
     // 显示系统信息
     log_message("=== 系统信息 ===");
@@ -682,14 +825,8 @@ int main() {
     
     sleep(1);
     
-    // 网络测试
-    log_message("=== 网络测试 ===");
-    int network_result = test_network();
-    if (network_result == 0) {
-        log_message("网络测试通过");
-    } else {
-        log_message("网络测试失败");
-    }
+    // 网络测试还没完成时不等待，结果出来后显示在标题栏
+    poll_network();
     
     // 按键和动画测试
     log_message("=== 按键和动画测试 ===");
@@ -700,20 +837,53 @@ int main() {
     update_activity();
     
     // 先显示一个静态界面确保可见
-    draw_ui();
+    ui_state_t initial_state;
+    fill_state(&initial_state);
+    draw_ui(&initial_state);
     log_message("初始界面绘制完成");
     sleep(2);
     
+    // 启动渲染线程，失败时在主线程上逻辑和绘制交替进行
+    pthread_t render_thread;
+    if (triple_buffer_init(&ui_states, sizeof(ui_state_t)) < 0) {
+        log_message("状态缓冲分配失败");
+        cleanup_framebuffer();
+        close_log_file();
+        return 1;
+    }
+    if (sem_init(&state_ready, 0, 0) == 0 && pthread_create(&render_thread, NULL, render_thread_main, NULL) == 0) {
+        render_threaded = 1;
+        log_message("渲染线程已启动");
+    } else {
+        log_message("警告: 无法创建渲染线程，使用单线程模式");
+    }
+    
     test_buttons();
     
+    running = 0;
+    if (render_threaded) {
+        sem_post(&state_ready);
+        pthread_join(render_thread, NULL);
+    }
+    
+    // 快照交接统计: 没被绘制就被覆盖的为丢帧，重复绘制同一快照的为重复帧
+    triple_buffer_stats_t handoff;
+    triple_buffer_get_stats(&ui_states, &handoff);
+    char handoff_msg[160];
+    sprintf(handoff_msg, "快照交接: 发布%lu 绘制%lu 丢帧%lu 重复%lu",
+            handoff.published, handoff.consumed, handoff.dropped, handoff.duplicated);
+    log_message(handoff_msg);
+    triple_buffer_destroy(&ui_states);
+    
     // 清理
+    image_asset_close(&logo);
     cleanup_framebuffer();
     close_log_file();
     
     // 显示最终统计
     printf("\n=== 测试完成 ===\n");
     printf("总帧数: %d\n", frame_count);
-    printf("运行时间: %.1f秒\n", animation_time);
+    printf("运行时间: %.1f秒\n", animation_time / (double)FX_ONE);
     
     return 0;
 }
@@ -3,12 +3,12 @@
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
-#include <math.h>
 #include <signal.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
+#include "fixmath.h"
 
 // 屏幕分辨率
 #define SCREEN_WIDTH  720
@@ -25,7 +25,7 @@
 // 全局变量
 int running = 1;
 int frame_count = 0;
-float animation_time = 0.0f;
+fx_t animation_time = 0;      // 动画时间 (秒，Q16.16)
 time_t last_activity_time = 0;
 
 // 模拟帧缓冲 (本地测试用)
@@ -93,9 +93,9 @@ void draw_animation() {
     draw_rect(0, 0, fb.width, fb.height, COLOR_BLACK);
     
     // 计算动画位置
-    float t = animation_time;
-    int circle_x = (int)(fb.width/2 + cos(t) * 150);
-    int circle_y = (int)(fb.height/2 + sin(t * 2) * 100);
+    fx_angle_t t = fx_angle_from_rad(animation_time);
+    int circle_x = fb.width/2 + fx_to_int(fx_cos(t) * 150);
+    int circle_y = fb.height/2 + fx_to_int(fx_sin(t * 2) * 100);
     
     // 绘制多个圆形
     draw_circle(circle_x, circle_y, 30, COLOR_RED);
@@ -103,16 +103,17 @@ void draw_animation() {
     draw_circle(circle_x, fb.height - circle_y, 25, COLOR_BLUE);
     
     // 绘制旋转的矩形
-    float angle = t * 3;
-    int rect_x = fb.width/2 + (int)(cos(angle) * 100);
-    int rect_y = fb.height/2 + (int)(sin(angle) * 100);
+    fx_angle_t angle = t * 3;
+    int rect_x = fb.width/2 + fx_to_int(fx_cos(angle) * 100);
+    int rect_y = fb.height/2 + fx_to_int(fx_sin(angle) * 100);
     draw_rect(rect_x - 15, rect_y - 15, 30, 30, COLOR_YELLOW);
     
     // 显示帧数和倒计时
     char fps_text[64];
     time_t current_time = time(NULL);
     int remaining_time = 15 - (int)(current_time - last_activity_time);
-    sprintf(fps_text, "Frame: %d Time: %.1fs AutoExit: %ds", frame_count, animation_time, remaining_time);
+    int tenths = fx_to_int(fx_mul(animation_time, fx_from_int(10)));
+    sprintf(fps_text, "Frame: %d Time: %d.%ds AutoExit: %ds", frame_count, tenths / 10, tenths % 10, remaining_time);
     
     // 在控制台显示
     printf("\r%s", fps_text);
@@ -233,7 +234,7 @@ void test_buttons() {
         }
         
         // 更新动画
-        animation_time += 0.016f; // 假设60FPS
+        animation_time += FX_CONST(0.016); // 假设60FPS
         frame_count++;
         draw_animation();
         
@@ -293,8 +294,9 @@ int main() {
     
     printf("\n=== 测试完成 ===\n");
     printf("总帧数: %d\n", frame_count);
-    printf("运行时间: %.1f秒\n", animation_time);
-    printf("平均FPS: %.1f\n", frame_count / (animation_time > 0 ? animation_time : 1));
+    double seconds = animation_time / (double)FX_ONE;
+    printf("运行时间: %.1f秒\n", seconds);
+    printf("平均FPS: %.1f\n", frame_count / (seconds > 0 ? seconds : 1));
     
     return 0;
 }
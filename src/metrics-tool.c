@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "metrics.h"
+
+// 指标查看工具: 只读映射程序的指标表 (共享内存)，不和程序通信，也不影响程序。
+// 可以在电脑上通过SSH运行，例如:
+//   ssh root@[IP] /mnt/mmc/Roms/APPS/metrics-tool -i 1000
+// 不加 -i 时打印一次；加 -i 时按间隔重复打印，计数器显示每秒增量，直方图显示这段时间内的分布。
+// -r 输出 "名字 类型 值" 的原始格式 (直方图为次数和估计的平均值)，便于脚本处理。
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-n 共享内存名] [-i 间隔毫秒] [-c 次数] [-r]\n"
+            "  默认 %s，打印一次\n",
+            prog, METRICS_DEFAULT_NAME);
+}
+
+// 一次读取的快照 (各项分别读取)
+typedef struct {
+    int32_t pid;
+    int64_t start_time;
+    uint32_t count;
+    metrics_entry_t entries[METRICS_MAX_ENTRIES];
+} snapshot_t;
+
+static int take_snapshot(const char* name, snapshot_t* snap) {
+    metrics_t metrics;
+    if (metrics_attach(&metrics, name) < 0) {
+        return -1;
+    }
+    snap->pid = metrics.header->pid;
+    snap->start_time = metrics.header->start_time;
+    snap->count = metrics_count(&metrics);
+    if (snap->count > METRICS_MAX_ENTRIES) snap->count = METRICS_MAX_ENTRIES;
+    for (uint32_t i = 0; i < snap->count; i++) {
+        const metrics_entry_t* src = &metrics.entries[i];
+        metrics_entry_t* dst = &snap->entries[i];
+        memcpy(dst->name, src->name, sizeof(dst->name));
+        dst->name[sizeof(dst->name) - 1] = '\0';
+        memcpy(dst->unit, src->unit, sizeof(dst->unit));
+        dst->unit[sizeof(dst->unit) - 1] = '\0';
+        dst->type = src->type;
+        atomic_store_explicit(&dst->value, metrics_value(src), memory_order_relaxed);
+        for (int b = 0; b < METRICS_BUCKETS; b++) {
+            uint64_t n = atomic_load_explicit((_Atomic uint64_t*)&src->buckets[b], memory_order_relaxed);
+            atomic_store_explicit(&dst->buckets[b], n, memory_order_relaxed);
+        }
+    }
+    metrics_close(&metrics);
+    return 0;
+}
+
+static uint64_t load(const _Atomic uint64_t* value) {
+    return atomic_load_explicit((_Atomic uint64_t*)value, memory_order_relaxed);
+}
+
+// 两次快照之间的直方图 (各桶的差)
+static void histogram_delta(const metrics_entry_t* now, const metrics_entry_t* before, metrics_entry_t* delta) {
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        atomic_store_explicit(&delta->buckets[b], load(&now->buckets[b]) - load(&before->buckets[b]),
+                              memory_order_relaxed);
+    }
+}
+
+static void print_limit(uint64_t limit, const char* unit) {
+    if (limit == UINT64_MAX) {
+        printf(">=%llu%s", (unsigned long long)metrics_bucket_limit(METRICS_BUCKETS - 2), unit);
+    } else {
+        printf("<%llu%s", (unsigned long long)limit, unit);
+    }
+}
+
+static void print_histogram(const metrics_entry_t* entry) {
+    uint64_t count = metrics_histogram_count(entry);
+    if (count == 0) {
+        printf("n=0");
+        return;
+    }
+    printf("n=%llu 平均~%.1f%s p50", (unsigned long long)count, metrics_histogram_mean(entry), entry->unit);
+    print_limit(metrics_histogram_percentile(entry, 0.50), entry->unit);
+    printf(" p90");
+    print_limit(metrics_histogram_percentile(entry, 0.90), entry->unit);
+    printf(" p99");
+    print_limit(metrics_histogram_percentile(entry, 0.99), entry->unit);
+    printf(" max");
+    print_limit(metrics_histogram_percentile(entry, 1.0), entry->unit);
+}
+
+static const metrics_entry_t* find_entry(const snapshot_t* snap, const char* name) {
+    for (uint32_t i = 0; i < snap->count; i++) {
+        if (strcmp(snap->entries[i].name, name) == 0) return &snap->entries[i];
+    }
+    return NULL;
+}
+
+static void print_snapshot(const snapshot_t* snap, const snapshot_t* before, double seconds, int raw) {
+    if (raw) {
+        for (uint32_t i = 0; i < snap->count; i++) {
+            const metrics_entry_t* entry = &snap->entries[i];
+            const char* type = metrics_type_name((metrics_type_t)entry->type);
+            if (entry->type == METRICS_HISTOGRAM) {
+                printf("%s %s %llu %.1f\n", entry->name, type, (unsigned long long)metrics_histogram_count(entry),
+                       metrics_histogram_mean(entry));
+            } else if (entry->type == METRICS_GAUGE) {
+                printf("%s %s %lld\n", entry->name, type, (long long)(int64_t)load(&entry->value));
+            } else {
+                printf("%s %s %llu\n", entry->name, type, (unsigned long long)load(&entry->value));
+            }
+        }
+        fflush(stdout);
+        return;
+    }
+
+    int alive = kill(snap->pid, 0) == 0 || errno == EPERM;
+    printf("进程%d (%s)，已运行%llds，%u项\n", snap->pid, alive ? "运行中" : "已退出",
+           (long long)(time(NULL) - snap->start_time), snap->count);
+    for (uint32_t i = 0; i < snap->count; i++) {
+        const metrics_entry_t* entry = &snap->entries[i];
+        const metrics_entry_t* old = before ? find_entry(before, entry->name) : NULL;
+        printf("  %-24s ", entry->name);
+        if (entry->type == METRICS_COUNTER) {
+            uint64_t value = load(&entry->value);
+            printf("%llu%s", (unsigned long long)value, entry->unit);
+            if (old && seconds > 0) {
+                printf("  (%.1f/s)", (double)(value - load(&old->value)) / seconds);
+            }
+        } else if (entry->type == METRICS_GAUGE) {
+            printf("%lld%s", (long long)(int64_t)load(&entry->value), entry->unit);
+        } else if (entry->type == METRICS_HISTOGRAM) {
+            // 重复打印时只看这段时间内的分布
+            if (old) {
+                static metrics_entry_t delta;
+                memcpy(delta.unit, entry->unit, sizeof(delta.unit));
+                histogram_delta(entry, old, &delta);
+                print_histogram(&delta);
+            } else {
+                print_histogram(entry);
+            }
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = METRICS_DEFAULT_NAME;
+    int interval_ms = 0;
+    int samples = 0;
+    int raw = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:i:c:rh")) != -1) {
+        switch (opt) {
+            case 'n': name = optarg; break;
+            case 'i': interval_ms = atoi(optarg); break;
+            case 'c': samples = atoi(optarg); break;
+            case 'r': raw = 1; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc || interval_ms < 0 || samples < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static snapshot_t snaps[2];
+    int current = 0;
+    int have_before = 0;
+    struct timespec last = {0, 0};
+    for (int n = 0; ; n++) {
+        snapshot_t* snap = &snaps[current];
+        snapshot_t* before = &snaps[current ^ 1];
+        if (take_snapshot(name, snap) < 0) {
+            fprintf(stderr, "错误: 无法读取指标表 %s (程序没有运行或版本不同)\n", name);
+            if (interval_ms == 0) return 1;
+            have_before = 0;
+        } else {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double seconds = (now.tv_sec - last.tv_sec) + (now.tv_nsec - last.tv_nsec) / 1e9;
+            // 程序重新启动后不和旧的表比较
+            int comparable = have_before && before->pid == snap->pid && before->start_time == snap->start_time;
+            print_snapshot(snap, comparable ? before : NULL, seconds, raw);
+            last = now;
+            have_before = 1;
+            current ^= 1;
+        }
+        if (interval_ms == 0 || (samples > 0 && n + 1 >= samples)) break;
+        struct timespec pause = {interval_ms / 1000, (interval_ms % 1000) * 1000000L};
+        nanosleep(&pause, NULL);
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "metrics.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static size_t table_size(uint32_t capacity) {
+    return sizeof(metrics_header_t) + (size_t)capacity * sizeof(metrics_entry_t);
+}
+
+static void bind_table(metrics_t* metrics, void* base, size_t size) {
+    metrics->header = (metrics_header_t*)base;
+    metrics->entries = (metrics_entry_t*)((unsigned char*)base + sizeof(metrics_header_t));
+    metrics->size = size;
+}
+
+int metrics_create(metrics_t* metrics, const char* name) {
+    memset(metrics, 0, sizeof(*metrics));
+    snprintf(metrics->name, sizeof(metrics->name), "%s", name ? name : METRICS_DEFAULT_NAME);
+    size_t size = table_size(METRICS_MAX_ENTRIES);
+
+    // 删掉上次留下的表，新建的共享内存内容为0
+    void* base = MAP_FAILED;
+    shm_unlink(metrics->name);
+    int fd = shm_open(metrics->name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd >= 0) {
+        if (ftruncate(fd, (off_t)size) == 0) {
+            base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (base == MAP_FAILED) {
+            shm_unlink(metrics->name);
+        }
+    }
+    metrics->shared = base != MAP_FAILED;
+    if (base == MAP_FAILED) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            return -1;
+        }
+    }
+    bind_table(metrics, base, size);
+    metrics->writable = 1;
+
+    metrics_header_t* header = metrics->header;
+    header->magic = METRICS_MAGIC;
+    header->version = METRICS_VERSION;
+    header->header_size = sizeof(metrics_header_t);
+    header->entry_size = sizeof(metrics_entry_t);
+    header->capacity = METRICS_MAX_ENTRIES;
+    header->pid = (int32_t)getpid();
+    header->start_time = (int64_t)time(NULL);
+    atomic_store_explicit(&header->count, 0, memory_order_release);
+    return 0;
+}
+
+int metrics_attach(metrics_t* metrics, const char* name) {
+    memset(metrics, 0, sizeof(*metrics));
+    snprintf(metrics->name, sizeof(metrics->name), "%s", name ? name : METRICS_DEFAULT_NAME);
+    int fd = shm_open(metrics->name, O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(metrics_header_t)) {
+        close(fd);
+        return -1;
+    }
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    const metrics_header_t* header = (const metrics_header_t*)base;
+    if (header->magic != METRICS_MAGIC || header->version != METRICS_VERSION ||
+        header->header_size != sizeof(metrics_header_t) || header->entry_size != sizeof(metrics_entry_t) ||
+        table_size(header->capacity) > (size_t)st.st_size) {
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+    bind_table(metrics, base, (size_t)st.st_size);
+    return 0;
+}
+
+void metrics_close(metrics_t* metrics) {
+    if (metrics->header) {
+        munmap(metrics->header, metrics->size);
+        if (metrics->writable && metrics->shared) {
+            shm_unlink(metrics->name);
+        }
+    }
+    metrics->header = NULL;
+    metrics->entries = NULL;
+    metrics->size = 0;
+}
+
+metrics_entry_t* metrics_register(metrics_t* metrics, const char* name, metrics_type_t type, const char* unit) {
+    if (!metrics->header || !metrics->writable) {
+        return &metrics->spare;
+    }
+    metrics_header_t* header = metrics->header;
+    uint32_t count = atomic_load_explicit(&header->count, memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++) {
+        metrics_entry_t* entry = &metrics->entries[i];
+        if (strcmp(entry->name, name) == 0) {
+            return entry->type == (uint32_t)type ? entry : &metrics->spare;
+        }
+    }
+    if (count >= header->capacity) {
+        return &metrics->spare;
+    }
+    metrics_entry_t* entry = &metrics->entries[count];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    snprintf(entry->unit, sizeof(entry->unit), "%s", unit ? unit : "");
+    entry->type = (uint32_t)type;
+    // 名字和类型写完后才让读者看到这一项
+    atomic_store_explicit(&header->count, count + 1, memory_order_release);
+    return entry;
+}
+
+uint32_t metrics_count(const metrics_t* metrics) {
+    if (!metrics->header) {
+        return 0;
+    }
+    uint32_t count = atomic_load_explicit((_Atomic uint32_t*)&metrics->header->count, memory_order_acquire);
+    return count < metrics->header->capacity ? count : metrics->header->capacity;
+}
+
+uint64_t metrics_histogram_count(const metrics_entry_t* entry) {
+    uint64_t count = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        count += atomic_load_explicit((_Atomic uint64_t*)&entry->buckets[i], memory_order_relaxed);
+    }
+    return count;
+}
+
+double metrics_histogram_mean(const metrics_entry_t* entry) {
+    double sum = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        uint64_t n = atomic_load_explicit((_Atomic uint64_t*)&entry->buckets[i], memory_order_relaxed);
+        // 桶0只有0，桶1只有1，桶i为[2^(i-1), 2^i)
+        double middle = i <= 1 ? i : i == METRICS_BUCKETS - 1 ? (double)((uint64_t)1 << (i - 1))
+                                                               : 1.5 * (double)((uint64_t)1 << (i - 1));
+        sum += middle * (double)n;
+        total += n;
+    }
+    return total ? sum / (double)total : 0;
+}
+
+uint64_t metrics_histogram_percentile(const metrics_entry_t* entry, double quantile) {
+    uint64_t counts[METRICS_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit((_Atomic uint64_t*)&entry->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    // 第rank个值所在的桶 (rank从1开始)
+    uint64_t rank = (uint64_t)(quantile * (double)total + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+    uint64_t seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return metrics_bucket_limit(i);
+        }
+    }
+    return metrics_bucket_limit(METRICS_BUCKETS - 1);
+}
+
+uint64_t metrics_bucket_limit(int bucket) {
+    if (bucket >= METRICS_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)1 << bucket;
+}
+
+const char* metrics_type_name(metrics_type_t type) {
+    switch (type) {
+        case METRICS_COUNTER: return "counter";
+        case METRICS_GAUGE: return "gauge";
+        case METRICS_HISTOGRAM: return "histogram";
+    }
+    return "?";
+}
@@ -0,0 +1,124 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// 指标登记表: 计数器、量值和直方图放在一块共享内存 (shm_open) 中，其他进程 (metrics-tool，
+// 可以通过SSH运行) 只读映射后随时读取，不需要和程序通信，也不会影响程序。
+//
+// 布局固定，读者按下面的偏移直接读取 (整数为本机字节序，掌机和主机都是小端)。布局变化时改 METRICS_VERSION:
+//   偏移0    metrics_header_t (64字节)
+//   偏移64   capacity 个 metrics_entry_t (每个256字节)
+// 每一项的名字、单位和类型在登记时写入，然后以release写入 count；读者以acquire读 count，只读前count项。
+//
+// 更新都是relaxed原子操作，不加锁: 计数器和量值为一次原子加或一次原子存；直方图只有所在桶一次原子加，
+// 次数、分位数和平均值 (按桶中点估计) 都由读者从各桶算出。登记 (按名字查找或追加) 只在初始化时由一个线程进行，
+// 之后的更新可以在任意线程。共享内存打不开时使用私有内存，更新照常进行，只是外部读不到。
+
+#define METRICS_MAGIC 0x544d4752u        // "RGMT"
+#define METRICS_VERSION 2
+#define METRICS_DEFAULT_NAME "/rg34xx-metrics"
+#define METRICS_MAX_ENTRIES 64
+#define METRICS_NAME_SIZE 40
+#define METRICS_UNIT_SIZE 8
+#define METRICS_BUCKETS 24               // 直方图: 桶0为0，桶i为[2^(i-1), 2^i)，最后一个桶包括更大的值
+
+typedef enum {
+    METRICS_COUNTER = 1,         // 只增加的总数
+    METRICS_GAUGE = 2,           // 当前值 (有符号)
+    METRICS_HISTOGRAM = 3,       // 按2的幂分桶的分布
+} metrics_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;        // sizeof(metrics_header_t)
+    uint32_t entry_size;         // sizeof(metrics_entry_t)
+    uint32_t capacity;           // 项数上限
+    _Atomic uint32_t count;      // 已登记的项数
+    int32_t pid;                 // 写者进程
+    uint32_t reserved0;
+    int64_t start_time;          // 写者创建表的时刻 (Unix时间，秒)
+    uint8_t reserved[24];
+} metrics_header_t;
+
+typedef struct {
+    char name[METRICS_NAME_SIZE];    // 以0结尾
+    char unit[METRICS_UNIT_SIZE];    // 以0结尾，例如 "us"、"bytes"
+    uint32_t type;                   // metrics_type_t
+    uint32_t reserved0;
+    _Atomic uint64_t value;          // 计数器的总数、量值 (int64_t)，直方图不使用
+    _Atomic uint64_t buckets[METRICS_BUCKETS];   // 只有直方图使用
+} metrics_entry_t;
+
+_Static_assert(sizeof(metrics_header_t) == 64, "metrics header layout");
+_Static_assert(sizeof(metrics_entry_t) == 256, "metrics entry layout");
+
+typedef struct {
+    metrics_header_t* header;    // NULL为没有打开
+    metrics_entry_t* entries;
+    size_t size;                 // 映射的字节数
+    int shared;                  // 写者: 在共享内存中 (外部可以读到)
+    int writable;
+    char name[64];
+    metrics_entry_t spare;       // 登记失败时返回它，调用方不需要检查NULL
+} metrics_t;
+
+// 写者: 创建 (替换同名的旧表) 并映射，失败时改用私有内存。返回0；私有内存也分配失败时返回-1，
+// 此后登记的都是同一个备用项
+int metrics_create(metrics_t* metrics, const char* name);
+
+// 读者: 只读映射已有的表，检查魔数、版本和大小。失败返回-1
+int metrics_attach(metrics_t* metrics, const char* name);
+
+// 解除映射；写者同时删除共享内存名字 (已经映射的读者仍可读到最后的值)
+void metrics_close(metrics_t* metrics);
+
+// 按名字登记 (已有同名同类型的项时直接返回它)。表满、类型不同时返回备用项
+metrics_entry_t* metrics_register(metrics_t* metrics, const char* name, metrics_type_t type, const char* unit);
+
+// 读者: 已登记的项数
+uint32_t metrics_count(const metrics_t* metrics);
+
+// ---------- 更新 (任意线程) ----------
+
+static inline void metrics_add(metrics_entry_t* entry, uint64_t n) {
+    atomic_fetch_add_explicit(&entry->value, n, memory_order_relaxed);
+}
+
+static inline void metrics_set(metrics_entry_t* entry, int64_t value) {
+    atomic_store_explicit(&entry->value, (uint64_t)value, memory_order_relaxed);
+}
+
+static inline int metrics_bucket(uint64_t value) {
+    int bucket = value ? 64 - __builtin_clzll(value) : 0;
+    return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+static inline void metrics_observe(metrics_entry_t* entry, uint64_t value) {
+    atomic_fetch_add_explicit(&entry->buckets[metrics_bucket(value)], 1, memory_order_relaxed);
+}
+
+// ---------- 读取 (任意进程) ----------
+
+static inline uint64_t metrics_value(const metrics_entry_t* entry) {
+    return atomic_load_explicit((_Atomic uint64_t*)&entry->value, memory_order_relaxed);
+}
+
+// 直方图的次数 (各桶之和)
+uint64_t metrics_histogram_count(const metrics_entry_t* entry);
+
+// 直方图的平均值估计 (每个值按所在桶的中点计，最后一个桶按下界)；没有数据时返回0
+double metrics_histogram_mean(const metrics_entry_t* entry);
+
+// 直方图的分位数 (0..1)，返回所在桶的上界；没有数据时返回0
+uint64_t metrics_histogram_percentile(const metrics_entry_t* entry, double quantile);
+
+// 桶的上界 (不含)，最后一个桶返回UINT64_MAX
+uint64_t metrics_bucket_limit(int bucket);
+
+const char* metrics_type_name(metrics_type_t type);
+
+#endif
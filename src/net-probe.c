@@ -0,0 +1,234 @@
+#include "net-probe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static int elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+static void set_state(net_probe_t* probe, net_probe_state_t state) {
+    pthread_mutex_lock(&probe->lock);
+    probe->result.state = state;
+    probe->result.elapsed_ms = elapsed_ms(&probe->start);
+    pthread_mutex_unlock(&probe->lock);
+}
+
+static void finish(net_probe_t* probe, net_probe_state_t state, const char* address, const char* message) {
+    pthread_mutex_lock(&probe->lock);
+    probe->result.state = state;
+    probe->result.elapsed_ms = elapsed_ms(&probe->start);
+    snprintf(probe->result.address, sizeof(probe->result.address), "%s", address ? address : "");
+    snprintf(probe->result.message, sizeof(probe->result.message), "%s", message ? message : "");
+    pthread_mutex_unlock(&probe->lock);
+}
+
+// 对所有地址同时发起非阻塞连接，返回连上的下标，全部失败或超时返回-1
+static int connect_any(net_probe_t* probe, struct addrinfo** addrs, int count, char* error, size_t error_size) {
+    struct pollfd fds[NET_PROBE_MAX_ADDRESSES];
+    int pending = 0;
+    int winner = -1;
+
+    snprintf(error, error_size, "timeout");
+    for (int i = 0; i < count; i++) {
+        fds[i].fd = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        fds[i].fd = socket(addrs[i]->ai_family, addrs[i]->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                           addrs[i]->ai_protocol);
+        fds[i].events = POLLOUT;
+        fds[i].revents = 0;
+        if (fds[i].fd < 0) {
+            snprintf(error, error_size, "socket: %s", strerror(errno));
+            continue;
+        }
+        if (connect(fds[i].fd, addrs[i]->ai_addr, addrs[i]->ai_addrlen) == 0) {
+            winner = i;
+            break;
+        }
+        if (errno != EINPROGRESS) {
+            snprintf(error, error_size, "connect: %s", strerror(errno));
+            close(fds[i].fd);
+            fds[i].fd = -1;
+            continue;
+        }
+        pending++;
+    }
+
+    while (winner < 0 && pending > 0) {
+        int remaining = probe->timeout_ms - elapsed_ms(&probe->start);
+        if (remaining <= 0) {
+            snprintf(error, error_size, "timeout");
+            break;
+        }
+        int ready = poll(fds, count, remaining);
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) {
+            snprintf(error, error_size, "timeout");
+            break;
+        }
+        if (ready < 0) {
+            snprintf(error, error_size, "poll: %s", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < count && winner < 0; i++) {
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+            if (so_error == 0) {
+                winner = i;
+            } else {
+                snprintf(error, error_size, "connect: %s", strerror(so_error));
+                close(fds[i].fd);
+                fds[i].fd = -1;   // poll忽略负的fd
+                pending--;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (fds[i].fd >= 0) close(fds[i].fd);
+    }
+    return winner;
+}
+
+static void* probe_thread(void* data) {
+    net_probe_t* probe = (net_probe_t*)data;
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    struct addrinfo* list = NULL;
+    int rc = getaddrinfo(probe->host, probe->port, &hints, &list);
+    if (rc != 0) {
+        finish(probe, NET_PROBE_FAILED, NULL, rc == EAI_SYSTEM ? strerror(errno) : gai_strerror(rc));
+        return NULL;
+    }
+
+    // 每种地址族的第一个地址排在最前面，地址太多时IPv4和IPv6都能尝试到
+    struct addrinfo* addrs[NET_PROBE_MAX_ADDRESSES];
+    int count = 0;
+    for (int pass = 0; pass < 2 && count < NET_PROBE_MAX_ADDRESSES; pass++) {
+        int taken[2] = {0, 0};
+        for (struct addrinfo* ai = list; ai && count < NET_PROBE_MAX_ADDRESSES; ai = ai->ai_next) {
+            int v6 = ai->ai_family == AF_INET6;
+            if (ai->ai_family != AF_INET && !v6) continue;
+            // 第一遍每种地址族只取一个，第二遍取剩下的
+            int index = taken[v6]++;
+            if ((pass == 0) != (index == 0)) continue;
+            addrs[count++] = ai;
+        }
+    }
+
+    pthread_mutex_lock(&probe->lock);
+    probe->result.attempts = count;
+    pthread_mutex_unlock(&probe->lock);
+    set_state(probe, NET_PROBE_CONNECTING);
+
+    char error[128];
+    int winner = count > 0 ? connect_any(probe, addrs, count, error, sizeof(error)) : -1;
+    if (count == 0) snprintf(error, sizeof(error), "no usable address");
+
+    if (winner >= 0) {
+        char address[64];
+        if (getnameinfo(addrs[winner]->ai_addr, addrs[winner]->ai_addrlen, address, sizeof(address),
+                        NULL, 0, NI_NUMERICHOST) != 0) {
+            snprintf(address, sizeof(address), "?");
+        }
+        finish(probe, NET_PROBE_OK, address, NULL);
+    } else {
+        finish(probe, NET_PROBE_FAILED, NULL, error);
+    }
+    freeaddrinfo(list);
+    return NULL;
+}
+
+int net_probe_parse_target(const char* target, char* host, size_t host_size, char* port, size_t port_size) {
+    const char* host_start = target;
+    const char* host_end;
+    const char* colon;
+
+    if (target[0] == '[') {
+        host_start = target + 1;
+        host_end = strchr(host_start, ']');
+        if (!host_end || host_end[1] != ':') return -1;
+        colon = host_end + 1;
+    } else {
+        colon = strrchr(target, ':');
+        if (!colon || strchr(target, ':') != colon) return -1;   // 不带括号的IPv6有歧义
+        host_end = colon;
+    }
+
+    size_t host_len = host_end - host_start;
+    size_t port_len = strlen(colon + 1);
+    if (host_len == 0 || host_len >= host_size || port_len == 0 || port_len >= port_size) return -1;
+    memcpy(host, host_start, host_len);
+    host[host_len] = '\0';
+    memcpy(port, colon + 1, port_len + 1);
+    return 0;
+}
+
+int net_probe_start(net_probe_t* probe, const char* target, int timeout_ms) {
+    memset(probe, 0, sizeof(*probe));
+    if (net_probe_parse_target(target, probe->host, sizeof(probe->host), probe->port, sizeof(probe->port)) < 0) {
+        probe->result.state = NET_PROBE_FAILED;
+        snprintf(probe->result.message, sizeof(probe->result.message),
+                 "invalid target (expected host:port or [IPv6]:port)");
+        return -1;
+    }
+    probe->timeout_ms = timeout_ms > 0 ? timeout_ms : NET_PROBE_DEFAULT_TIMEOUT;
+    clock_gettime(CLOCK_MONOTONIC, &probe->start);
+    pthread_mutex_init(&probe->lock, NULL);
+    probe->result.state = NET_PROBE_RESOLVING;
+
+    // 分离线程: 解析无法取消，卡住时不影响退出
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, probe_thread, probe);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        probe->result.state = NET_PROBE_FAILED;
+        snprintf(probe->result.message, sizeof(probe->result.message), "pthread_create: %s", strerror(rc));
+        return -1;
+    }
+    return 0;
+}
+
+void net_probe_get(net_probe_t* probe, net_probe_result_t* result) {
+    pthread_mutex_lock(&probe->lock);
+    *result = probe->result;
+    pthread_mutex_unlock(&probe->lock);
+
+    if (result->state == NET_PROBE_RESOLVING || result->state == NET_PROBE_CONNECTING) {
+        result->elapsed_ms = elapsed_ms(&probe->start);
+        if (result->elapsed_ms >= probe->timeout_ms) {
+            // 后台线程仍在解析或连接，对调用方来说已经超时
+            result->state = NET_PROBE_FAILED;
+            snprintf(result->message, sizeof(result->message), "timeout");
+        }
+    }
+}
+
+const char* net_probe_state_name(net_probe_state_t state) {
+    switch (state) {
+        case NET_PROBE_IDLE:       return "idle";
+        case NET_PROBE_RESOLVING:  return "resolving";
+        case NET_PROBE_CONNECTING: return "connecting";
+        case NET_PROBE_OK:         return "ok";
+        default:                   return "failed";
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef NET_PROBE_H
+#define NET_PROBE_H
+
+#include <pthread.h>
+#include <time.h>
+
+// 异步网络检测: 在后台线程中解析目标地址 (getaddrinfo)，然后对解析出的所有地址
+// (IPv4和IPv6) 同时发起非阻塞connect，用poll等待，先连上的为准。
+// 调用方随时用 net_probe_get 取当前状态，不会被解析或连接阻塞；超过期限仍未完成时
+// 报告超时 (即使解析还卡在后台线程里)。
+
+#define NET_PROBE_DEFAULT_TARGET  "www.baidu.com:80"
+#define NET_PROBE_DEFAULT_TIMEOUT 5000
+#define NET_PROBE_MAX_ADDRESSES   8
+
+typedef enum {
+    NET_PROBE_IDLE,
+    NET_PROBE_RESOLVING,
+    NET_PROBE_CONNECTING,
+    NET_PROBE_OK,
+    NET_PROBE_FAILED,
+} net_probe_state_t;
+
+typedef struct {
+    net_probe_state_t state;
+    int elapsed_ms;              // 从开始到得出结果 (或到现在) 的耗时
+    int attempts;                // 同时尝试连接的地址数
+    char address[64];            // 连上的地址 (数字形式)
+    char message[128];           // 失败原因
+} net_probe_result_t;
+
+typedef struct {
+    char host[128];
+    char port[16];
+    int timeout_ms;
+    struct timespec start;
+    pthread_mutex_t lock;
+    net_probe_result_t result;
+} net_probe_t;
+
+// 拆分 "主机:端口" 或 "[IPv6]:端口"，失败返回-1
+int net_probe_parse_target(const char* target, char* host, size_t host_size, char* port, size_t port_size);
+
+// 开始检测 (立即返回)，失败返回-1，原因 (目标格式不对或无法创建线程) 写入 probe->result.message。
+// 后台线程会访问probe，probe必须一直有效直到得出结果或进程退出
+int net_probe_start(net_probe_t* probe, const char* target, int timeout_ms);
+
+// 当前状态的副本 (任意线程)
+void net_probe_get(net_probe_t* probe, net_probe_result_t* result);
+
+const char* net_probe_state_name(net_probe_state_t state);
+
+#endif
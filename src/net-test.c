@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "net-probe.h"
+
+// 网络检测工具: 与主程序相同的异步检测，打印每次状态变化的时间。
+// 可以对本机监听端口测试，例如:
+//   nc -l 127.0.0.1 8080 &   然后   ./net-test 127.0.0.1:8080
+// 成功返回0，失败或超时返回1。
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-t 超时毫秒] [主机:端口|[IPv6]:端口]\n"
+            "  默认目标 %s，超时 %dms\n",
+            prog, NET_PROBE_DEFAULT_TARGET, NET_PROBE_DEFAULT_TIMEOUT);
+}
+
+int main(int argc, char* argv[]) {
+    int timeout_ms = NET_PROBE_DEFAULT_TIMEOUT;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:h")) != -1) {
+        switch (opt) {
+            case 't': timeout_ms = atoi(optarg); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc - 1 || timeout_ms <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* target = optind < argc ? argv[optind] : NET_PROBE_DEFAULT_TARGET;
+
+    static net_probe_t probe;
+    if (net_probe_start(&probe, target, timeout_ms) < 0) {
+        fprintf(stderr, "错误: 无法开始检测 %s - %s\n", target, probe.result.message);
+        return 1;
+    }
+
+    // 调用方只轮询状态，从不阻塞在解析或连接上
+    net_probe_result_t result;
+    net_probe_state_t last = NET_PROBE_IDLE;
+    int polls = 0;
+    for (;;) {
+        net_probe_get(&probe, &result);
+        polls++;
+        if (result.state != last) {
+            printf("%6dms  %s", result.elapsed_ms, net_probe_state_name(result.state));
+            if (result.state == NET_PROBE_CONNECTING) printf(" (%d个地址)", result.attempts);
+            if (result.state == NET_PROBE_OK) printf(" %s", result.address);
+            if (result.state == NET_PROBE_FAILED) printf(" %s", result.message);
+            printf("\n");
+            last = result.state;
+        }
+        if (result.state == NET_PROBE_OK || result.state == NET_PROBE_FAILED) break;
+        struct timespec tick = {0, 1000000};
+        nanosleep(&tick, NULL);
+    }
+
+    printf("%s: %s | %dms | 轮询%d次\n", target, result.state == NET_PROBE_OK ? "连接成功" : "失败",
+           result.elapsed_ms, polls);
+    return result.state == NET_PROBE_OK ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "perf-trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    const char* name;
+    double start_ms;
+    double end_ms;       // 小于0表示未结束，等于start_ms为瞬时事件
+    int main_thread;
+} perf_phase_t;
+
+static perf_phase_t phases[PERF_TRACE_MAX_PHASES];
+static atomic_int phase_count;
+static double base_ms;           // 单调时钟上的进程启动时刻
+static double pre_main_ms;       // 进程启动到perf_trace_init的时间
+static pthread_t main_thread;
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// 进程已运行的时间，读取失败返回0
+static double process_age_ms(void) {
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/stat", "r");
+    if (!f) return 0;
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    // 进程名可能含空格，从最后一个')'之后开始数字段，starttime是第22个字段
+    char* p = strrchr(buf, ')');
+    if (!p) return 0;
+    int field = 2;
+    unsigned long long start_ticks = 0;
+    for (char* tok = strtok(p + 1, " "); tok; tok = strtok(NULL, " ")) {
+        if (++field == 22) {
+            start_ticks = strtoull(tok, NULL, 10);
+            break;
+        }
+    }
+
+    struct timespec boot;
+    long hz = sysconf(_SC_CLK_TCK);
+    if (start_ticks == 0 || hz <= 0 || clock_gettime(CLOCK_BOOTTIME, &boot) < 0) {
+        return 0;
+    }
+    double age = boot.tv_sec * 1000.0 + boot.tv_nsec / 1000000.0 - start_ticks * 1000.0 / hz;
+    return age > 0 ? age : 0;
+#else
+    return 0;
+#endif
+}
+
+void perf_trace_init(void) {
+    main_thread = pthread_self();
+    pre_main_ms = process_age_ms();
+    base_ms = monotonic_ms() - pre_main_ms;
+    atomic_store(&phase_count, 0);
+}
+
+double perf_trace_now_ms(void) {
+    return monotonic_ms() - base_ms;
+}
+
+int perf_trace_begin(const char* name) {
+    int id = atomic_fetch_add(&phase_count, 1);
+    if (id >= PERF_TRACE_MAX_PHASES) {
+        return -1;
+    }
+    perf_phase_t* phase = &phases[id];
+    phase->name = name;
+    phase->main_thread = pthread_equal(pthread_self(), main_thread);
+    phase->end_ms = -1;
+    phase->start_ms = perf_trace_now_ms();
+    return id;
+}
+
+void perf_trace_end(int id) {
+    if (id >= 0 && id < PERF_TRACE_MAX_PHASES) {
+        phases[id].end_ms = perf_trace_now_ms();
+    }
+}
+
+void perf_trace_mark(const char* name) {
+    int id = perf_trace_begin(name);
+    if (id >= 0) {
+        phases[id].end_ms = phases[id].start_ms;
+    }
+}
+
+void perf_trace_log(void (*log)(const char* message)) {
+    int count = atomic_load(&phase_count);
+    if (count > PERF_TRACE_MAX_PHASES) count = PERF_TRACE_MAX_PHASES;
+
+    // 按开始时间排序输出 (阶段数很少，插入排序即可)
+    int order[PERF_TRACE_MAX_PHASES];
+    for (int i = 0; i < count; i++) {
+        int j = i;
+        while (j > 0 && phases[order[j - 1]].start_ms > phases[i].start_ms) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "Startup trace (ms since process start, pre-main %.1f ms):", pre_main_ms);
+    log(msg);
+    for (int i = 0; i < count; i++) {
+        const perf_phase_t* p = &phases[order[i]];
+        if (p->end_ms == p->start_ms) {
+            snprintf(msg, sizeof(msg), "  %8.1f           %-7s * %s",
+                     p->start_ms, p->main_thread ? "main" : "worker", p->name);
+        } else if (p->end_ms < 0) {
+            snprintf(msg, sizeof(msg), "  %8.1f - ...     %-7s %s (unfinished)",
+                     p->start_ms, p->main_thread ? "main" : "worker", p->name);
+        } else {
+            snprintf(msg, sizeof(msg), "  %8.1f - %8.1f %-7s %s (%.1f ms)",
+                     p->start_ms, p->end_ms, p->main_thread ? "main" : "worker",
+                     p->name, p->end_ms - p->start_ms);
+        }
+        log(msg);
+    }
+}
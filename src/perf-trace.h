@@ -0,0 +1,28 @@
+#ifndef PERF_TRACE_H
+#define PERF_TRACE_H
+
+// 启动阶段跟踪: 记录从进程启动到第一帧呈现之间各阶段的起止时间。
+// 时间以进程启动为零点 (Linux上从/proc/self/stat得到进程启动时刻)，
+// 可在多个线程中同时记录。
+
+#define PERF_TRACE_MAX_PHASES 48
+
+// 记录时间零点，应在main开头调用
+void perf_trace_init(void);
+
+// 自进程启动以来的毫秒数
+double perf_trace_now_ms(void);
+
+// 开始一个阶段，返回阶段编号 (记录已满时返回-1)
+int perf_trace_begin(const char* name);
+
+// 结束阶段
+void perf_trace_end(int id);
+
+// 记录一个瞬时事件 (例如第一帧呈现)
+void perf_trace_mark(const char* name);
+
+// 按开始时间顺序输出所有阶段
+void perf_trace_log(void (*log)(const char* message));
+
+#endif
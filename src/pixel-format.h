@@ -0,0 +1,78 @@
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <stdint.h>
+#include <string.h>
+
+// 面板像素格式与转换 (仅头文件)
+// 颜色在绘制前用 pixel_map 转换一次为面板的原生像素值，之后的填充、混合和复制
+// 都直接在原生格式上进行；资源在加载时用 pixel_convert_row 转换一次。
+// 16bpp面板上每帧的内存流量只有32bpp的一半。
+
+typedef enum {
+    PIXEL_FORMAT_RGB565,
+    PIXEL_FORMAT_BGR565,
+    PIXEL_FORMAT_XRGB8888,
+    PIXEL_FORMAT_XBGR8888,
+} pixel_format_t;
+
+// 根据帧缓冲的色深和红色分量位置选择格式
+static inline pixel_format_t pixel_format_from_fb(int bits_per_pixel, int red_offset) {
+    if (bits_per_pixel == 16) {
+        return red_offset == 11 ? PIXEL_FORMAT_RGB565 : PIXEL_FORMAT_BGR565;
+    }
+    return red_offset == 16 ? PIXEL_FORMAT_XRGB8888 : PIXEL_FORMAT_XBGR8888;
+}
+
+static inline int pixel_format_bytes(pixel_format_t format) {
+    return (format == PIXEL_FORMAT_RGB565 || format == PIXEL_FORMAT_BGR565) ? 2 : 4;
+}
+
+// 0xRRGGBB 转为原生像素值
+static inline uint32_t pixel_map(pixel_format_t format, uint32_t rgb) {
+    uint32_t r = (rgb >> 16) & 0xFF;
+    uint32_t g = (rgb >> 8) & 0xFF;
+    uint32_t b = rgb & 0xFF;
+
+    switch (format) {
+        case PIXEL_FORMAT_RGB565:   return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        case PIXEL_FORMAT_BGR565:   return ((b >> 3) << 11) | ((g >> 2) << 5) | (r >> 3);
+        case PIXEL_FORMAT_XBGR8888: return (b << 16) | (g << 8) | r;
+        default:                    return rgb & 0xFFFFFF;
+    }
+}
+
+// 用原生像素值填充一行
+static inline void pixel_fill_row(pixel_format_t format, void* dst, uint32_t pixel, int count) {
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        uint16_t v = (uint16_t)pixel;
+        for (int i = 0; i < count; i++) {
+            p[i] = v;
+        }
+    } else {
+        uint32_t* p = (uint32_t*)dst;
+        for (int i = 0; i < count; i++) {
+            p[i] = pixel;
+        }
+    }
+}
+
+// 0xAARRGGBB 像素行转为原生格式 (资源加载时调用一次)
+static inline void pixel_convert_row(pixel_format_t format, void* dst, const uint32_t* src, int count) {
+    if (pixel_format_bytes(format) == 2) {
+        uint16_t* p = (uint16_t*)dst;
+        for (int i = 0; i < count; i++) {
+            p[i] = (uint16_t)pixel_map(format, src[i]);
+        }
+    } else if (format == PIXEL_FORMAT_XRGB8888) {
+        memcpy(dst, src, (size_t)count * 4);
+    } else {
+        uint32_t* p = (uint32_t*)dst;
+        for (int i = 0; i < count; i++) {
+            p[i] = pixel_map(format, src[i]);
+        }
+    }
+}
+
+#endif
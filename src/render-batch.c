@@ -0,0 +1,314 @@
+#include "render-batch.h"
+
+#include <string.h>
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define RENDER_BATCH_GEOMETRY 1
+#endif
+
+typedef struct {
+    render_cmd_type_t type;
+    SDL_Texture* texture;
+    SDL_Color color;
+    SDL_Rect bounds;             // 组内所有命令区域的外接矩形
+    int count;
+    int first;                   // 在排序后命令序列中的起始位置
+} render_group_t;
+
+// 提交时的临时数组 (只在渲染线程使用)
+static render_group_t groups[RENDER_BATCH_MAX_COMMANDS];
+static int order[RENDER_BATCH_MAX_COMMANDS];
+#ifdef RENDER_BATCH_GEOMETRY
+static SDL_Vertex vertices[RENDER_BATCH_MAX_COMMANDS * 4];
+static int indices[RENDER_BATCH_MAX_COMMANDS * 6];
+#endif
+
+static int same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static int is_white(SDL_Color c) {
+    return c.r == 255 && c.g == 255 && c.b == 255 && c.a == 255;
+}
+
+static int rects_overlap(const SDL_Rect* a, const SDL_Rect* b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w &&
+           a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static void union_rect(SDL_Rect* a, const SDL_Rect* b) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    a->x = x0;
+    a->y = y0;
+    a->w = x1 - x0;
+    a->h = y1 - y0;
+}
+
+// 命令能否加入组 (同类型同状态)
+static int can_merge(const render_group_t* group, const render_cmd_t* cmd) {
+    if (cmd->type == RENDER_CMD_CUSTOM || group->type != cmd->type) {
+        return 0;
+    }
+#ifdef RENDER_BATCH_GEOMETRY
+    // 几何提交用顶点颜色，颜色不同也能合并
+    if (cmd->type == RENDER_CMD_FILL) {
+        return 1;
+    }
+    return group->texture == cmd->texture;
+#else
+    return group->texture == cmd->texture && same_color(group->color, cmd->color);
+#endif
+}
+
+void render_batch_init(render_batch_t* batch, SDL_Renderer* renderer) {
+    memset(batch, 0, sizeof(*batch));
+    batch->renderer = renderer;
+    frame_arena_init(&batch->arena, batch->arena_buffer, sizeof(batch->arena_buffer));
+}
+
+void render_batch_begin(render_batch_t* batch) {
+    batch->last = batch->stats;
+    memset(&batch->stats, 0, sizeof(batch->stats));
+}
+
+static render_cmd_t* push_command(render_batch_t* batch, render_cmd_type_t type, const SDL_Rect* dst) {
+    if (batch->count == RENDER_BATCH_MAX_COMMANDS) {
+        render_batch_flush(batch);
+    }
+    render_cmd_t* cmd = &batch->commands[batch->count++];
+    memset(cmd, 0, sizeof(*cmd));
+    cmd->type = type;
+    cmd->dst = *dst;
+    batch->stats.commands++;
+    return cmd;
+}
+
+void render_batch_clear(render_batch_t* batch, SDL_Color color) {
+    // 清屏总在最前面执行，之前已记录的命令先提交
+    if (batch->count > 0) {
+        render_batch_flush(batch);
+    }
+    batch->clear = 1;
+    batch->clear_color = color;
+}
+
+void render_batch_fill(render_batch_t* batch, const SDL_Rect* rect, SDL_Color color) {
+    if (rect->w <= 0 || rect->h <= 0) return;
+    render_cmd_t* cmd = push_command(batch, RENDER_CMD_FILL, rect);
+    cmd->color = color;
+}
+
+void render_batch_copy(render_batch_t* batch, SDL_Texture* texture, const SDL_Rect* src,
+                       const SDL_Rect* dst, SDL_Color color, int owns_texture) {
+    render_cmd_t* cmd = push_command(batch, RENDER_CMD_COPY, dst);
+    cmd->texture = texture;
+    cmd->owns_texture = owns_texture;
+    cmd->color = color;
+    if (src) {
+        cmd->src = *src;
+    } else {
+        SDL_QueryTexture(texture, NULL, NULL, &cmd->src.w, &cmd->src.h);
+    }
+}
+
+void* render_batch_custom(render_batch_t* batch, const SDL_Rect* rect, render_batch_custom_fn fn,
+                          void* context, size_t size) {
+    if (batch->count == RENDER_BATCH_MAX_COMMANDS) {
+        render_batch_flush(batch);
+    }
+    void* data = frame_arena_alloc(&batch->arena, size);
+    if (!data) {
+        // 参数区已满: 先提交已记录的命令再重试
+        render_batch_flush(batch);
+        data = frame_arena_alloc(&batch->arena, size);
+        if (!data) return NULL;
+    }
+
+    render_cmd_t* cmd = push_command(batch, RENDER_CMD_CUSTOM, rect);
+    cmd->fn = fn;
+    cmd->context = context;
+    cmd->data = data;
+    return data;
+}
+
+// 分组: 每个命令尽量并入前面最近的同状态组，途中遇到区域重叠的组就停止
+static int build_groups(render_batch_t* batch) {
+    int group_count = 0;
+    for (int i = 0; i < batch->count; i++) {
+        render_cmd_t* cmd = &batch->commands[i];
+        int target = -1;
+        for (int g = group_count - 1; g >= 0; g--) {
+            if (can_merge(&groups[g], cmd)) {
+                target = g;
+                break;
+            }
+            if (rects_overlap(&groups[g].bounds, &cmd->dst)) {
+                break;
+            }
+        }
+        if (target < 0) {
+            target = group_count++;
+            groups[target].type = cmd->type;
+            groups[target].texture = cmd->texture;
+            groups[target].color = cmd->color;
+            groups[target].bounds = cmd->dst;
+            groups[target].count = 0;
+        } else {
+            union_rect(&groups[target].bounds, &cmd->dst);
+        }
+        groups[target].count++;
+        cmd->group = target;
+    }
+
+    // 按组排列命令，组内保持原来的顺序
+    int offset = 0;
+    for (int g = 0; g < group_count; g++) {
+        groups[g].first = offset;
+        offset += groups[g].count;
+        groups[g].count = 0;
+    }
+    for (int i = 0; i < batch->count; i++) {
+        render_group_t* group = &groups[batch->commands[i].group];
+        order[group->first + group->count++] = i;
+    }
+    return group_count;
+}
+
+#ifdef RENDER_BATCH_GEOMETRY
+// 一个矩形的四个顶点和两个三角形
+static void add_quad(int quad, const SDL_Rect* dst, SDL_Color color,
+                     float u0, float v0, float u1, float v1) {
+    SDL_Vertex* v = &vertices[quad * 4];
+    float x0 = dst->x, y0 = dst->y;
+    float x1 = dst->x + dst->w, y1 = dst->y + dst->h;
+    v[0].position.x = x0; v[0].position.y = y0; v[0].tex_coord.x = u0; v[0].tex_coord.y = v0;
+    v[1].position.x = x1; v[1].position.y = y0; v[1].tex_coord.x = u1; v[1].tex_coord.y = v0;
+    v[2].position.x = x1; v[2].position.y = y1; v[2].tex_coord.x = u1; v[2].tex_coord.y = v1;
+    v[3].position.x = x0; v[3].position.y = y1; v[3].tex_coord.x = u0; v[3].tex_coord.y = v1;
+    for (int i = 0; i < 4; i++) {
+        v[i].color = color;
+    }
+    int* idx = &indices[quad * 6];
+    int base = quad * 4;
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+}
+#endif
+
+static void submit_fills(render_batch_t* batch, const render_group_t* group,
+                         SDL_Color* draw_color, int* have_color) {
+    SDL_Renderer* renderer = batch->renderer;
+#ifdef RENDER_BATCH_GEOMETRY
+    if (group->count > 1) {
+        for (int i = 0; i < group->count; i++) {
+            const render_cmd_t* cmd = &batch->commands[order[group->first + i]];
+            add_quad(i, &cmd->dst, cmd->color, 0, 0, 0, 0);
+        }
+        SDL_RenderGeometry(renderer, NULL, vertices, group->count * 4, indices, group->count * 6);
+        batch->stats.draw_calls++;
+        return;
+    }
+#endif
+    // 单个矩形或同色矩形: 设置一次颜色后一次提交
+    SDL_Rect rects[RENDER_BATCH_MAX_COMMANDS];
+    for (int i = 0; i < group->count; i++) {
+        rects[i] = batch->commands[order[group->first + i]].dst;
+    }
+    if (!*have_color || !same_color(*draw_color, group->color)) {
+        SDL_SetRenderDrawColor(renderer, group->color.r, group->color.g, group->color.b, group->color.a);
+        *draw_color = group->color;
+        *have_color = 1;
+        batch->stats.state_changes++;
+    }
+    SDL_RenderFillRects(renderer, rects, group->count);
+    batch->stats.draw_calls++;
+}
+
+static void submit_copies(render_batch_t* batch, const render_group_t* group) {
+    SDL_Renderer* renderer = batch->renderer;
+#ifdef RENDER_BATCH_GEOMETRY
+    if (group->count > 1) {
+        int w, h;
+        SDL_QueryTexture(group->texture, NULL, NULL, &w, &h);
+        for (int i = 0; i < group->count; i++) {
+            const render_cmd_t* cmd = &batch->commands[order[group->first + i]];
+            add_quad(i, &cmd->dst, cmd->color,
+                     (float)cmd->src.x / w, (float)cmd->src.y / h,
+                     (float)(cmd->src.x + cmd->src.w) / w, (float)(cmd->src.y + cmd->src.h) / h);
+        }
+        SDL_RenderGeometry(renderer, group->texture, vertices, group->count * 4, indices, group->count * 6);
+        batch->stats.draw_calls++;
+        return;
+    }
+#endif
+    for (int i = 0; i < group->count; i++) {
+        const render_cmd_t* cmd = &batch->commands[order[group->first + i]];
+        if (!is_white(cmd->color)) {
+            SDL_SetTextureColorMod(cmd->texture, cmd->color.r, cmd->color.g, cmd->color.b);
+            SDL_SetTextureAlphaMod(cmd->texture, cmd->color.a);
+            batch->stats.state_changes++;
+        }
+        SDL_RenderCopy(renderer, cmd->texture, &cmd->src, &cmd->dst);
+        batch->stats.draw_calls++;
+        if (!is_white(cmd->color)) {
+            SDL_SetTextureColorMod(cmd->texture, 255, 255, 255);
+            SDL_SetTextureAlphaMod(cmd->texture, 255);
+        }
+    }
+}
+
+void render_batch_flush(render_batch_t* batch) {
+    SDL_Renderer* renderer = batch->renderer;
+    SDL_Color draw_color = {0, 0, 0, 0};
+    int have_color = 0;
+
+    if (batch->clear) {
+        SDL_Color c = batch->clear_color;
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderClear(renderer);
+        draw_color = c;
+        have_color = 1;
+        batch->clear = 0;
+        batch->stats.state_changes++;
+        batch->stats.draw_calls++;
+    }
+
+    int group_count = build_groups(batch);
+    SDL_Texture* last_texture = NULL;
+
+    for (int g = 0; g < group_count; g++) {
+        const render_group_t* group = &groups[g];
+        switch (group->type) {
+            case RENDER_CMD_FILL:
+                submit_fills(batch, group, &draw_color, &have_color);
+                break;
+            case RENDER_CMD_COPY:
+                if (group->texture != last_texture) {
+                    last_texture = group->texture;
+                    batch->stats.state_changes++;
+                }
+                submit_copies(batch, group);
+                break;
+            case RENDER_CMD_CUSTOM: {
+                // 自定义绘制前先让渲染器完成排队的绘制
+                const render_cmd_t* cmd = &batch->commands[order[group->first]];
+                SDL_RenderFlush(renderer);
+                cmd->fn(cmd->context, cmd->data);
+                batch->stats.state_changes++;
+                batch->stats.draw_calls++;
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < batch->count; i++) {
+        if (batch->commands[i].owns_texture) {
+            SDL_DestroyTexture(batch->commands[i].texture);
+        }
+    }
+    batch->count = 0;
+    frame_arena_reset(&batch->arena);
+}
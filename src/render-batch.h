@@ -0,0 +1,83 @@
+#ifndef RENDER_BATCH_H
+#define RENDER_BATCH_H
+
+#include <SDL2/SDL.h>
+#include <stdint.h>
+#include "frame-arena.h"
+
+// 每帧的绘制命令缓冲: 先记录纯色填充、纹理四边形和自定义绘制，
+// 帧末按纹理和状态分组合并后提交，尽量减少渲染器调用和状态切换。
+//
+// 合并规则: 命令只有在不与中间其它组的区域重叠时才会提前到前面的同状态组，
+// 因此重叠部分的绘制顺序保持不变。
+// SDL 2.0.18 起用 SDL_RenderGeometry 一次提交多色填充或同纹理的多个四边形，
+// 更早的版本退回 SDL_RenderFillRects (同色) 和逐个 SDL_RenderCopy。
+
+#define RENDER_BATCH_MAX_COMMANDS 128
+#define RENDER_BATCH_ARENA_SIZE   8192
+
+// 自定义绘制 (例如直接写入软件渲染的表面)，执行前渲染器已完成之前的绘制
+typedef void (*render_batch_custom_fn)(void* context, const void* data);
+
+typedef enum {
+    RENDER_CMD_FILL,
+    RENDER_CMD_COPY,
+    RENDER_CMD_CUSTOM,
+} render_cmd_type_t;
+
+typedef struct {
+    render_cmd_type_t type;
+    SDL_Rect dst;
+    SDL_Rect src;                // 纹理四边形的源区域
+    SDL_Color color;             // 填充颜色或纹理颜色调制
+    SDL_Texture* texture;
+    int owns_texture;            // 提交后销毁纹理
+    render_batch_custom_fn fn;
+    void* context;
+    const void* data;            // 自定义命令的参数 (在命令缓冲的arena中)
+    int group;
+} render_cmd_t;
+
+// 最近一次提交的统计，显示在性能HUD上
+typedef struct {
+    int commands;                // 记录的命令数
+    int draw_calls;              // 实际的渲染器绘制调用
+    int state_changes;           // 颜色、混合模式、纹理切换和刷新次数
+} render_batch_stats_t;
+
+typedef struct {
+    SDL_Renderer* renderer;
+    render_cmd_t commands[RENDER_BATCH_MAX_COMMANDS];
+    int count;
+    int clear;                   // 提交前先清屏
+    SDL_Color clear_color;
+
+    // 自定义命令的参数，提交后重置
+    uint64_t arena_buffer[RENDER_BATCH_ARENA_SIZE / 8];
+    frame_arena_t arena;
+
+    render_batch_stats_t stats;  // 本帧累计 (中途因缓冲满而提交也计入)
+    render_batch_stats_t last;   // 上一帧
+} render_batch_t;
+
+void render_batch_init(render_batch_t* batch, SDL_Renderer* renderer);
+
+// 开始新的一帧，保存上一帧的统计
+void render_batch_begin(render_batch_t* batch);
+
+void render_batch_clear(render_batch_t* batch, SDL_Color color);
+void render_batch_fill(render_batch_t* batch, const SDL_Rect* rect, SDL_Color color);
+
+// 纹理四边形，src为NULL时使用整个纹理；owns_texture为真时提交后销毁纹理
+void render_batch_copy(render_batch_t* batch, SDL_Texture* texture, const SDL_Rect* src,
+                       const SDL_Rect* dst, SDL_Color color, int owns_texture);
+
+// 自定义绘制，rect为影响的区域。返回size字节的参数内存由调用方填写 (提交时传给fn)，
+// 空间不足时返回NULL且不记录命令
+void* render_batch_custom(render_batch_t* batch, const SDL_Rect* rect, render_batch_custom_fn fn,
+                          void* context, size_t size);
+
+// 合并并提交所有命令
+void render_batch_flush(render_batch_t* batch);
+
+#endif
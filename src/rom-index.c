@@ -0,0 +1,686 @@
+#include "rom-index.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+
+// getdents64返回的目录项 (glibc 2.30之前没有包装函数)
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+#ifdef __APPLE__
+#define st_mtim st_mtimespec
+#endif
+
+// 一次读取的目录项缓冲区
+#define DIRENT_BUFFER_SIZE 32768
+
+// 上次索引的查找表 (后台线程)
+typedef struct {
+    const char* path;
+    int dir;
+} dir_key_t;
+
+typedef struct {
+    dir_key_t* by_path;          // 按路径排序，二分查找
+    int* file_first;             // 第d个目录的文件: file_order[file_first[d] .. file_first[d + 1])
+    int* file_order;
+    int* child_first;            // 第d个目录的子目录
+    int* child_order;
+} old_lookup_t;
+
+typedef struct {
+    const char* path;
+    rom_index_entry_t entry;
+} sort_item_t;
+
+static int elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int)((now.tv_sec - start->tv_sec) * 1000 + (now.tv_nsec - start->tv_nsec) / 1000000);
+}
+
+static void fail(rom_index_t* index, const char* message) {
+    pthread_mutex_lock(&index->lock);
+    index->status.state = ROM_INDEX_FAILED;
+    index->status.elapsed_ms = elapsed_ms(&index->start);
+    snprintf(index->status.message, sizeof(index->status.message), "%s", message);
+    pthread_mutex_unlock(&index->lock);
+}
+
+// 容量按倍数增长，失败返回-1 (原来的内容不变)
+static int grow(void** data, size_t* capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    size_t grown = *capacity ? *capacity * 2 : 1024;
+    while (grown < needed) grown *= 2;
+    void* resized = realloc(*data, grown * item_size);
+    if (!resized) {
+        return -1;
+    }
+    *data = resized;
+    *capacity = grown;
+    return 0;
+}
+
+// ---------- 上次的索引 ----------
+
+static int validate(const rom_index_t* index, const uint8_t* data, size_t size) {
+    const rom_index_header_t* h = (const rom_index_header_t*)data;
+    if (size < sizeof(*h) || memcmp(h->magic, ROM_INDEX_MAGIC, 4) != 0 || h->version != ROM_INDEX_VERSION ||
+        h->file_size != size || h->entry_count > ROM_INDEX_MAX_ENTRIES || h->dir_count == 0) {
+        return -1;
+    }
+    if (h->entries_offset % 8 != 0 || h->dirs_offset % 8 != 0 ||
+        h->entries_offset + (uint64_t)h->entry_count * sizeof(rom_index_entry_t) > size ||
+        h->dirs_offset + (uint64_t)h->dir_count * sizeof(rom_index_dir_t) > size ||
+        h->names_size == 0 || h->names_offset + (uint64_t)h->names_size > size) {
+        return -1;
+    }
+
+    // 所有偏移都在范围内，防止损坏的文件导致越界访问
+    const char* names = (const char*)data + h->names_offset;
+    const rom_index_entry_t* entries = (const rom_index_entry_t*)(data + h->entries_offset);
+    const rom_index_dir_t* dirs = (const rom_index_dir_t*)(data + h->dirs_offset);
+    if (names[h->names_size - 1] != '\0' || h->root >= h->names_size || strcmp(names + h->root, index->root) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < h->entry_count; i++) {
+        if (entries[i].path >= h->names_size || entries[i].dir >= h->dir_count) return -1;
+    }
+    for (uint32_t i = 0; i < h->dir_count; i++) {
+        if (dirs[i].path >= h->names_size || dirs[i].parent >= h->dir_count) return -1;
+    }
+    return 0;
+}
+
+static int load_index(rom_index_t* index) {
+    int fd = open(index->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(rom_index_header_t)) {
+        close(fd);
+        return -1;
+    }
+
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    if (validate(index, data, st.st_size) < 0) {
+        munmap(data, st.st_size);
+        return -1;
+    }
+
+    const rom_index_header_t* h = (const rom_index_header_t*)data;
+    index->map = data;
+    index->map_size = st.st_size;
+    index->old_entries = (const rom_index_entry_t*)(index->map + h->entries_offset);
+    index->old_dirs = (const rom_index_dir_t*)(index->map + h->dirs_offset);
+    index->old_names = (const char*)index->map + h->names_offset;
+    index->old_count = (int)h->entry_count;
+    index->old_dir_count = (int)h->dir_count;
+    return 0;
+}
+
+static void unmap_index(rom_index_t* index) {
+    if (index->map) {
+        munmap((void*)index->map, index->map_size);
+    }
+    index->map = NULL;
+    index->old_entries = NULL;
+    index->old_dirs = NULL;
+    index->old_names = NULL;
+    index->old_count = index->old_dir_count = 0;
+}
+
+static int compare_dir_keys(const void* a, const void* b) {
+    return strcmp(((const dir_key_t*)a)->path, ((const dir_key_t*)b)->path);
+}
+
+// 按key分组 (key为负的不属于任何组): 第k组为 order[first[k] .. first[k + 1])
+static void group(const int* keys, int count, int groups, int* first, int* order) {
+    memset(first, 0, (groups + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        if (keys[i] >= 0) first[keys[i] + 1]++;
+    }
+    for (int k = 0; k < groups; k++) {
+        first[k + 1] += first[k];
+    }
+    for (int i = 0; i < count; i++) {
+        if (keys[i] >= 0) order[first[keys[i]]++] = i;
+    }
+    // 填完后first[k]是第k组的结尾，右移一位变回开头
+    for (int k = groups; k > 0; k--) {
+        first[k] = first[k - 1];
+    }
+    first[0] = 0;
+}
+
+static void free_lookup(old_lookup_t* old) {
+    free(old->by_path);
+    free(old->file_first);
+    free(old->file_order);
+    free(old->child_first);
+    free(old->child_order);
+    memset(old, 0, sizeof(*old));
+}
+
+static int prepare_lookup(const rom_index_t* index, old_lookup_t* old) {
+    int dirs = index->old_dir_count;
+    int files = index->old_count;
+    int key_count = files > dirs ? files : dirs;
+    int* keys = calloc(key_count > 0 ? key_count : 1, sizeof(int));
+    old->by_path = malloc(dirs * sizeof(dir_key_t));
+    old->file_first = malloc((dirs + 1) * sizeof(int));
+    old->file_order = malloc((files > 0 ? files : 1) * sizeof(int));
+    old->child_first = malloc((dirs + 1) * sizeof(int));
+    old->child_order = malloc(dirs * sizeof(int));
+    if (!keys || !old->by_path || !old->file_first || !old->file_order || !old->child_first || !old->child_order) {
+        free(keys);
+        free_lookup(old);
+        return -1;
+    }
+
+    for (int i = 0; i < dirs; i++) {
+        old->by_path[i].path = index->old_names + index->old_dirs[i].path;
+        old->by_path[i].dir = i;
+    }
+    qsort(old->by_path, dirs, sizeof(dir_key_t), compare_dir_keys);
+
+    for (int i = 0; i < files; i++) {
+        keys[i] = (int)index->old_entries[i].dir;
+    }
+    group(keys, files, dirs, old->file_first, old->file_order);
+
+    for (int i = 0; i < dirs; i++) {
+        keys[i] = i == 0 ? -1 : (int)index->old_dirs[i].parent;   // 根目录不是自己的子目录
+    }
+    group(keys, dirs, dirs, old->child_first, old->child_order);
+
+    free(keys);
+    return 0;
+}
+
+static int find_old_dir(const old_lookup_t* old, int count, const char* path) {
+    if (!old->by_path) {
+        return -1;
+    }
+    dir_key_t key = {path, -1};
+    const dir_key_t* found = bsearch(&key, old->by_path, count, sizeof(dir_key_t), compare_dir_keys);
+    return found ? found->dir : -1;
+}
+
+// ---------- 构建新的索引 (后台线程) ----------
+
+static int append_dir_name(rom_index_t* index, const char* path, size_t len, uint32_t* offset) {
+    if (grow((void**)&index->dir_names, &index->dir_names_capacity, index->dir_names_size + len + 1, 1) < 0) {
+        return -1;
+    }
+    *offset = (uint32_t)index->dir_names_size;
+    memcpy(index->dir_names + index->dir_names_size, path, len);
+    index->dir_names[index->dir_names_size + len] = '\0';
+    index->dir_names_size += len + 1;
+    return 0;
+}
+
+// 加入扫描队列
+static int push_dir(rom_index_t* index, const char* path, size_t len, int parent) {
+    size_t capacity = index->dir_capacity;
+    if (grow((void**)&index->dirs, &capacity, index->dir_count + 1, sizeof(rom_index_dir_t)) < 0) {
+        return -1;
+    }
+    index->dir_capacity = (int)capacity;
+
+    rom_index_dir_t* dir = &index->dirs[index->dir_count];
+    memset(dir, 0, sizeof(*dir));
+    if (append_dir_name(index, path, len, &dir->path) < 0) {
+        return -1;
+    }
+    dir->parent = (uint32_t)parent;
+    index->dir_count++;
+    return 0;
+}
+
+// 加入一个文件。扫描中的结果正在显示时绘制方会同时读，增长和追加都持有lock (没有竞争时只是几十纳秒)
+static int add_file(rom_index_t* index, const char* path, size_t len, int dir) {
+    if (index->file_count >= ROM_INDEX_MAX_ENTRIES) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&index->lock);
+    size_t capacity = index->file_capacity;
+    int rc = grow((void**)&index->files, &capacity, index->file_count + 1, sizeof(rom_index_entry_t));
+    index->file_capacity = (int)capacity;
+    if (rc == 0) {
+        rc = grow((void**)&index->file_names, &index->file_names_capacity, index->file_names_size + len + 1, 1);
+    }
+    if (rc == 0) {
+        rom_index_entry_t* entry = &index->files[index->file_count++];
+        entry->path = (uint32_t)index->file_names_size;
+        entry->dir = (uint32_t)dir;
+        memcpy(index->file_names + index->file_names_size, path, len);
+        index->file_names[index->file_names_size + len] = '\0';
+        index->file_names_size += len + 1;
+        if (index->streaming) {
+            index->entries = index->files;
+            index->names = index->file_names;
+            index->count = index->file_count;
+        }
+    }
+    pthread_mutex_unlock(&index->lock);
+    return rc;
+}
+
+// mtime没变: 文件和子目录都从上次的索引复制，不读目录内容
+static int reuse_dir(rom_index_t* index, const old_lookup_t* old, int dir, int old_dir) {
+    for (int i = old->file_first[old_dir]; i < old->file_first[old_dir + 1]; i++) {
+        const char* path = index->old_names + index->old_entries[old->file_order[i]].path;
+        if (add_file(index, path, strlen(path), dir) < 0) return -1;
+    }
+    for (int i = old->child_first[old_dir]; i < old->child_first[old_dir + 1]; i++) {
+        const char* path = index->old_names + index->old_dirs[old->child_order[i]].path;
+        if (push_dir(index, path, strlen(path), dir) < 0) return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    int fd;
+#ifdef __linux__
+    uint64_t buffer[DIRENT_BUFFER_SIZE / sizeof(uint64_t)];
+    int size;
+    int pos;
+#else
+    DIR* dir;
+#endif
+} dir_reader_t;
+
+static int reader_open(dir_reader_t* reader, int fd) {
+    reader->fd = fd;
+#ifdef __linux__
+    reader->size = reader->pos = 0;
+    return 0;
+#else
+    reader->dir = fdopendir(fd);
+    return reader->dir ? 0 : -1;
+#endif
+}
+
+static void reader_close(dir_reader_t* reader) {
+#ifdef __linux__
+    close(reader->fd);
+#else
+    closedir(reader->dir);
+#endif
+}
+
+// 下一个目录项的名字和类型 (DT_*)，读完或出错返回NULL。Linux上一次系统调用读一整批
+static const char* reader_next(dir_reader_t* reader, unsigned char* type) {
+#ifdef __linux__
+    if (reader->pos >= reader->size) {
+        long n = syscall(SYS_getdents64, reader->fd, reader->buffer, sizeof(reader->buffer));
+        if (n <= 0) {
+            return NULL;
+        }
+        reader->size = (int)n;
+        reader->pos = 0;
+    }
+    const struct linux_dirent64* entry = (const struct linux_dirent64*)((const char*)reader->buffer + reader->pos);
+    reader->pos += entry->d_reclen;
+    *type = entry->d_type;
+    return entry->d_name;
+#else
+    struct dirent* entry = readdir(reader->dir);
+    if (!entry) {
+        return NULL;
+    }
+    *type = entry->d_type;
+    return entry->d_name;
+#endif
+}
+
+// 文件系统没有给出类型或是符号链接时用fstatat确定。链接到目录的不进入 (避免循环)
+static unsigned char resolve_type(int dir_fd, const char* name, unsigned char type) {
+    struct stat st;
+    if (type == DT_UNKNOWN) {
+        if (fstatat(dir_fd, name, &st, AT_SYMLINK_NOFOLLOW) < 0) return DT_UNKNOWN;
+        if (S_ISDIR(st.st_mode)) return DT_DIR;
+        if (S_ISREG(st.st_mode)) return DT_REG;
+        if (!S_ISLNK(st.st_mode)) return DT_UNKNOWN;
+        type = DT_LNK;
+    }
+    if (type == DT_LNK) {
+        if (fstatat(dir_fd, name, &st, 0) < 0) return DT_UNKNOWN;
+        return S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+    }
+    return type;
+}
+
+// 读目录内容: 文件加入条目，子目录加入队列
+static int scan_dir(rom_index_t* index, int root_fd, int dir, const char* dir_path) {
+    int fd = openat(root_fd, dir_path[0] ? dir_path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;   // 没有权限或已经删除: 当作空目录
+    }
+    dir_reader_t reader;
+    if (reader_open(&reader, fd) < 0) {
+        close(fd);
+        return 0;
+    }
+
+    int rc = 0;
+    unsigned char type;
+    const char* name;
+    char path[ROM_INDEX_MAX_PATH];
+    while (rc == 0 && !atomic_load_explicit(&index->cancel, memory_order_relaxed) &&
+           (name = reader_next(&reader, &type)) != NULL) {
+        if (name[0] == '.') continue;   // 隐藏文件以及 "." 和 ".."
+        type = resolve_type(fd, name, type);
+        if (type != DT_DIR && type != DT_REG) continue;
+
+        int len = snprintf(path, sizeof(path), "%s%s%s", dir_path, dir_path[0] ? "/" : "", name);
+        if (len < 0 || len >= (int)sizeof(path)) continue;
+        rc = type == DT_DIR ? push_dir(index, path, len, dir) : add_file(index, path, len, dir);
+    }
+    reader_close(&reader);
+    return rc;
+}
+
+static int compare_items(const void* a, const void* b) {
+    const char* pa = ((const sort_item_t*)a)->path;
+    const char* pb = ((const sort_item_t*)b)->path;
+    int rc = strcasecmp(pa, pb);
+    return rc != 0 ? rc : strcmp(pa, pb);
+}
+
+// 扫描完成后排序 (在副本上排，扫描中的结果同时还在显示)
+static int sort_files(rom_index_t* index) {
+    int count = index->file_count;
+    sort_item_t* items = malloc((count > 0 ? count : 1) * sizeof(sort_item_t));
+    index->sorted = malloc((count > 0 ? count : 1) * sizeof(rom_index_entry_t));
+    if (!items || !index->sorted) {
+        free(items);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        items[i].path = index->file_names + index->files[i].path;
+        items[i].entry = index->files[i];
+    }
+    qsort(items, count, sizeof(sort_item_t), compare_items);
+    for (int i = 0; i < count; i++) {
+        index->sorted[i] = items[i].entry;
+    }
+    free(items);
+    return 0;
+}
+
+static int write_all(int fd, const void* data, size_t size) {
+    const char* p = data;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// 写入临时文件再改名，中途断电也不会留下写了一半的索引
+static int write_index(rom_index_t* index) {
+    rom_index_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ROM_INDEX_MAGIC, 4);
+    h.version = ROM_INDEX_VERSION;
+    h.entry_count = (uint32_t)index->file_count;
+    h.dir_count = (uint32_t)index->dir_count;
+    h.entries_offset = sizeof(h);
+    h.dirs_offset = h.entries_offset + h.entry_count * sizeof(rom_index_entry_t);
+    h.names_offset = h.dirs_offset + h.dir_count * sizeof(rom_index_dir_t);
+    uint64_t names_size = index->file_names_size + index->dir_names_size;
+    if (h.names_offset + names_size > UINT32_MAX) {
+        return -1;
+    }
+    h.names_size = (uint32_t)names_size;
+    h.root = (uint32_t)index->file_names_size;   // 目录路径在文件路径之后，根目录是其中第一个
+    h.file_size = h.names_offset + h.names_size;
+
+    // 目录的路径偏移改为合并后字符串区中的偏移
+    rom_index_dir_t* dirs = malloc(index->dir_count * sizeof(rom_index_dir_t));
+    if (!dirs) {
+        return -1;
+    }
+    for (int i = 0; i < index->dir_count; i++) {
+        dirs[i] = index->dirs[i];
+        dirs[i].path += (uint32_t)index->file_names_size;
+    }
+
+    char tmp[ROM_INDEX_MAX_PATH + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", index->path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    int rc = fd < 0 ? -1 : 0;
+    if (rc == 0) {
+        rc = write_all(fd, &h, sizeof(h));
+        if (rc == 0) rc = write_all(fd, index->sorted, h.entry_count * sizeof(rom_index_entry_t));
+        if (rc == 0) rc = write_all(fd, dirs, h.dir_count * sizeof(rom_index_dir_t));
+        if (rc == 0) rc = write_all(fd, index->file_names, index->file_names_size);
+        if (rc == 0) rc = write_all(fd, index->dir_names, index->dir_names_size);
+        if (rc == 0) rc = fsync(fd);
+        if (close(fd) < 0) rc = -1;
+        if (rc == 0) rc = rename(tmp, index->path);
+        if (rc < 0) unlink(tmp);
+    }
+    free(dirs);
+    return rc;
+}
+
+static void* scan_thread(void* data) {
+    rom_index_t* index = (rom_index_t*)data;
+    old_lookup_t old;
+    memset(&old, 0, sizeof(old));
+    char message[128] = "";
+
+    int root_fd = open(index->root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd < 0) {
+        snprintf(message, sizeof(message), "open: %s", strerror(errno));
+        fail(index, message);
+        return NULL;
+    }
+    uint32_t root_name;
+    if ((index->map && prepare_lookup(index, &old) < 0) ||
+        append_dir_name(index, index->root, strlen(index->root), &root_name) < 0 || push_dir(index, "", 0, 0) < 0) {
+        close(root_fd);
+        free_lookup(&old);
+        fail(index, "out of memory");
+        return NULL;
+    }
+
+    // 队列就是目录数组本身: 处理第d个目录时把它的子目录加在后面
+    int scanned = 0, reused = 0, rc = 0;
+    char path[ROM_INDEX_MAX_PATH];
+    for (int d = 0; d < index->dir_count && rc == 0; d++) {
+        if (atomic_load_explicit(&index->cancel, memory_order_relaxed)) break;
+
+        // 处理中会加入子目录，dir_names可能被重新分配，先复制路径
+        snprintf(path, sizeof(path), "%s", index->dir_names + index->dirs[d].path);
+        struct stat st;
+        if (fstatat(root_fd, path[0] ? path : ".", &st, 0) < 0) {
+            continue;   // 扫描过程中被删除，mtime留作0，下次会重新读
+        }
+        index->dirs[d].mtime_sec = st.st_mtim.tv_sec;
+        index->dirs[d].mtime_nsec = (uint32_t)st.st_mtim.tv_nsec;
+
+        int old_dir = find_old_dir(&old, index->old_dir_count, path);
+        if (old_dir >= 0 && index->old_dirs[old_dir].mtime_sec == index->dirs[d].mtime_sec &&
+            index->old_dirs[old_dir].mtime_nsec == index->dirs[d].mtime_nsec) {
+            rc = reuse_dir(index, &old, d, old_dir);
+            reused++;
+        } else {
+            rc = scan_dir(index, root_fd, d, path);
+            scanned++;
+        }
+
+        pthread_mutex_lock(&index->lock);
+        index->status.dirs = index->dir_count;
+        index->status.dirs_scanned = scanned;
+        index->status.dirs_reused = reused;
+        pthread_mutex_unlock(&index->lock);
+    }
+    close(root_fd);
+    free_lookup(&old);
+
+    if (rc < 0) {
+        fail(index, "out of memory");
+        return NULL;
+    }
+    if (atomic_load(&index->cancel)) {
+        return NULL;
+    }
+
+    // 所有目录都没变: 继续显示映射的索引，不重写
+    int saved = 0;
+    if (!index->map || scanned > 0) {
+        if (sort_files(index) < 0) {
+            fail(index, "out of memory");
+            return NULL;
+        }
+        pthread_mutex_lock(&index->lock);
+        index->entries = index->sorted;
+        index->names = index->file_names;
+        index->count = index->file_count;
+        index->streaming = 0;
+        index->status.generation++;
+        index->status.sorted = 1;
+        pthread_mutex_unlock(&index->lock);
+
+        // 换下来的映射和未排序的条目已经没有人在读
+        unmap_index(index);
+        free(index->files);
+        index->files = NULL;
+
+        saved = write_index(index) == 0;
+        if (!saved) {
+            snprintf(message, sizeof(message), "index not saved: %s", strerror(errno));
+        }
+    } else {
+        free(index->files);
+        free(index->file_names);
+        index->files = NULL;
+        index->file_names = NULL;
+    }
+
+    pthread_mutex_lock(&index->lock);
+    index->status.state = ROM_INDEX_DONE;
+    index->status.saved = saved;
+    index->status.elapsed_ms = elapsed_ms(&index->start);
+    if (!saved && (!index->status.loaded || scanned > 0)) {
+        snprintf(index->status.message, sizeof(index->status.message), "%s", message);
+    }
+    pthread_mutex_unlock(&index->lock);
+    return NULL;
+}
+
+// ---------- 接口 ----------
+
+int rom_index_start(rom_index_t* index, const char* root, const char* index_path) {
+    memset(index, 0, sizeof(*index));
+    pthread_mutex_init(&index->lock, NULL);
+    atomic_init(&index->cancel, 0);
+    clock_gettime(CLOCK_MONOTONIC, &index->start);
+    if (strlen(root) >= sizeof(index->root) || strlen(index_path) >= sizeof(index->path)) {
+        index->status.state = ROM_INDEX_FAILED;
+        snprintf(index->status.message, sizeof(index->status.message), "path too long");
+        return -1;
+    }
+    snprintf(index->root, sizeof(index->root), "%s", root);
+    snprintf(index->path, sizeof(index->path), "%s", index_path);
+    index->status.state = ROM_INDEX_SCANNING;
+
+    // 上次的索引立即可以显示，没有时显示扫描中的结果
+    if (load_index(index) == 0) {
+        index->entries = index->old_entries;
+        index->names = index->old_names;
+        index->count = index->old_count;
+        index->status.loaded = 1;
+        index->status.sorted = 1;
+    } else {
+        index->streaming = 1;
+    }
+
+    int rc = pthread_create(&index->thread, NULL, scan_thread, index);
+    if (rc != 0) {
+        index->status.state = ROM_INDEX_FAILED;
+        snprintf(index->status.message, sizeof(index->status.message), "pthread_create: %s", strerror(rc));
+        return -1;
+    }
+    index->thread_started = 1;
+    return 0;
+}
+
+void rom_index_stop(rom_index_t* index) {
+    atomic_store(&index->cancel, 1);
+    if (index->thread_started) {
+        pthread_join(index->thread, NULL);
+    }
+    unmap_index(index);
+    free(index->files);
+    free(index->file_names);
+    free(index->sorted);
+    free(index->dirs);
+    free(index->dir_names);
+    pthread_mutex_destroy(&index->lock);
+    memset(index, 0, sizeof(*index));
+}
+
+void rom_index_get_status(rom_index_t* index, rom_index_status_t* status) {
+    pthread_mutex_lock(&index->lock);
+    *status = index->status;
+    status->count = index->count;
+    pthread_mutex_unlock(&index->lock);
+
+    if (status->state == ROM_INDEX_SCANNING) {
+        status->elapsed_ms = elapsed_ms(&index->start);
+    }
+}
+
+int rom_index_text(rom_index_t* index, int i, char* text, size_t size) {
+    pthread_mutex_lock(&index->lock);
+    int rc = -1;
+    if (i >= 0 && i < index->count) {
+        snprintf(text, size, "%s", index->names + index->entries[i].path);
+        rc = 0;
+    }
+    pthread_mutex_unlock(&index->lock);
+    return rc;
+}
+
+const char* rom_index_state_name(rom_index_state_t state) {
+    switch (state) {
+        case ROM_INDEX_IDLE:     return "idle";
+        case ROM_INDEX_SCANNING: return "scanning";
+        case ROM_INDEX_DONE:     return "done";
+        default:                 return "failed";
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef ROM_INDEX_H
+#define ROM_INDEX_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// ROM目录索引: 在后台线程中递归扫描ROM目录 (getdents64一次读一批目录项，只对类型未知的项和目录调用fstatat)，
+// 扫描中的结果随时可以显示，扫描完成后按路径 (不分大小写) 排序并写入紧凑的索引文件。
+//
+// 下次启动时直接mmap上次的索引，立即显示，同时在后台逐个目录比较mtime:
+// 没变的目录沿用索引中的条目和子目录，不读目录内容；变了的 (有文件增删改名) 才重新读。
+// 都没变时不重写索引。只索引名字，文件内容变化 (目录mtime不变) 不影响索引。
+//
+// 索引文件布局 (本机字节序，所有偏移相对文件开头):
+//   rom_index_header_t
+//   rom_index_entry_t[entry_count]   文件条目，按路径排序
+//   rom_index_dir_t[dir_count]       目录，0为根目录
+//   字符串区                          以'\0'结尾的相对路径 (和根目录的绝对路径)
+
+#define ROM_INDEX_MAGIC       "RGIX"
+#define ROM_INDEX_VERSION     1
+#define ROM_INDEX_MAX_PATH    1024
+#define ROM_INDEX_MAX_ENTRIES (1 << 22)
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t dir_count;
+    uint32_t entries_offset;
+    uint32_t dirs_offset;
+    uint32_t names_offset;
+    uint32_t names_size;
+    uint32_t root;           // 扫描的根目录 (字符串区中的偏移)，不同时整个重新扫描
+    uint32_t file_size;
+    uint32_t reserved[2];
+} rom_index_header_t;
+
+typedef struct {
+    uint32_t path;           // 相对根目录的路径 (字符串区中的偏移)
+    uint32_t dir;            // 所在的目录
+} rom_index_entry_t;
+
+typedef struct {
+    uint32_t path;           // 根目录为 ""
+    uint32_t parent;         // 根目录为0 (自己)
+    int64_t mtime_sec;
+    uint32_t mtime_nsec;
+    uint32_t reserved;
+} rom_index_dir_t;
+
+typedef enum {
+    ROM_INDEX_IDLE,
+    ROM_INDEX_SCANNING,
+    ROM_INDEX_DONE,
+    ROM_INDEX_FAILED,
+} rom_index_state_t;
+
+typedef struct {
+    rom_index_state_t state;
+    int count;               // 当前可以显示的条目数
+    unsigned generation;     // 条目整体替换 (排序完成或换成新的扫描结果) 时加一，调用方据此作废缓存的文字
+    int sorted;              // 条目已按路径排序 (来自索引文件或扫描完成)
+    int loaded;              // 启动时读到了上次的索引
+    int dirs;                // 目录数
+    int dirs_scanned;        // 读了目录内容的目录
+    int dirs_reused;         // mtime没变，沿用索引的目录
+    int saved;               // 新的索引已写入
+    int elapsed_ms;          // 从开始到扫描完成 (或到现在)
+    char message[128];       // 失败原因
+} rom_index_status_t;
+
+typedef struct {
+    char root[ROM_INDEX_MAX_PATH];
+    char path[ROM_INDEX_MAX_PATH];   // 索引文件
+    struct timespec start;
+    pthread_t thread;
+    int thread_started;
+    atomic_int cancel;
+    pthread_mutex_t lock;
+
+    // 上次保存的索引 (只读映射)
+    const uint8_t* map;
+    size_t map_size;
+    const rom_index_entry_t* old_entries;
+    const rom_index_dir_t* old_dirs;
+    const char* old_names;
+    int old_count;
+    int old_dir_count;
+
+    // 显示的条目 (lock保护): 指向映射的索引、扫描中的结果或排好序的结果
+    const rom_index_entry_t* entries;
+    const char* names;
+    int count;
+    int streaming;           // 显示的是扫描中的结果 (没有上次的索引)
+
+    // 后台线程构建的新索引。文件条目和路径在扫描中会被显示，增长 (realloc) 时持有lock
+    rom_index_entry_t* files;
+    int file_count, file_capacity;
+    char* file_names;
+    size_t file_names_size, file_names_capacity;
+    rom_index_entry_t* sorted;
+    rom_index_dir_t* dirs;   // 同时是扫描队列 (广度优先)
+    int dir_count, dir_capacity;
+    char* dir_names;         // 目录路径和根目录，只有后台线程访问
+    size_t dir_names_size, dir_names_capacity;
+
+    rom_index_status_t status;
+} rom_index_t;
+
+// 映射上次的索引 (有效时立即可以显示) 并启动后台扫描，失败返回-1。index在 rom_index_stop 之前必须一直有效
+int rom_index_start(rom_index_t* index, const char* root, const char* index_path);
+
+// 取消扫描 (在读下一批目录项之前停下)、等待后台线程并释放所有资源
+void rom_index_stop(rom_index_t* index);
+
+// 当前状态的副本 (任意线程)
+void rom_index_get_status(rom_index_t* index, rom_index_status_t* status);
+
+// 第i个条目的相对路径写入text，超出范围返回-1 (任意线程)
+int rom_index_text(rom_index_t* index, int i, char* text, size_t size);
+
+const char* rom_index_state_name(rom_index_state_t state);
+
+#endif
@@ -0,0 +1,175 @@
+#include "rt-tune.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+void rt_tune_defaults(rt_tune_options_t* options) {
+    options->cpu = -1;
+    options->policy = RT_TUNE_OTHER;
+    options->priority = RT_TUNE_DEFAULT_PRIORITY;
+    options->nice = 0;
+}
+
+int rt_tune_requested(const rt_tune_options_t* options) {
+    return options->cpu >= 0 || options->policy != RT_TUNE_OTHER || options->nice != 0;
+}
+
+int rt_tune_parse_policy(const char* name, rt_tune_policy_t* policy) {
+    if (strcmp(name, "fifo") == 0) *policy = RT_TUNE_FIFO;
+    else if (strcmp(name, "rr") == 0) *policy = RT_TUNE_RR;
+    else if (strcmp(name, "other") == 0) *policy = RT_TUNE_OTHER;
+    else return -1;
+    return 0;
+}
+
+const char* rt_tune_policy_name(rt_tune_policy_t policy) {
+    switch (policy) {
+        case RT_TUNE_FIFO: return "SCHED_FIFO";
+        case RT_TUNE_RR: return "SCHED_RR";
+        case RT_TUNE_OTHER: return "SCHED_OTHER";
+    }
+    return "?";
+}
+
+static size_t page_size(void) {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+size_t rt_tune_prefault(void* data, size_t size, int flags) {
+    if (!data || size == 0) {
+        return 0;
+    }
+    size_t page = page_size();
+    volatile uint8_t* bytes = data;
+    uint8_t sum = 0;
+    size_t pages = 0;
+    // 从所在页的开头起每页一个字节，最后一页也要触碰到
+    size_t offset = 0;
+    while (offset < size) {
+        if (flags & RT_TUNE_PREFAULT_WRITE) {
+            bytes[offset] = bytes[offset];
+        } else {
+            sum += bytes[offset];
+        }
+        pages++;
+        size_t next = (((uintptr_t)(bytes + offset) / page) + 1) * page - (uintptr_t)bytes;
+        offset = next;
+    }
+    (void)sum;
+#ifdef __linux__
+    if (flags & RT_TUNE_PREFAULT_LOCK) {
+        mlock(data, size);
+    }
+#endif
+    return pages;
+}
+
+#ifdef __linux__
+
+// 追加 "名字: 结果" 到结果文字
+static void append(rt_tune_result_t* result, const char* item, int status) {
+    size_t len = strlen(result->text);
+    if (len >= sizeof(result->text) - 1) return;
+    snprintf(result->text + len, sizeof(result->text) - len, "%s%s: %s", len ? " | " : "", item,
+             status > 0 ? "granted" : strerror(-status));
+}
+
+int rt_tune_apply(const rt_tune_options_t* options, rt_tune_result_t* result) {
+    memset(result, 0, sizeof(*result));
+    int denied = 0;
+    char item[48];
+
+    if (options->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options->cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        result->affinity = rc == 0 ? 1 : -rc;
+        snprintf(item, sizeof(item), "cpu %d", options->cpu);
+        append(result, item, result->affinity);
+        denied += rc != 0;
+    }
+
+    if (options->policy != RT_TUNE_OTHER) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = options->priority;
+        int policy = options->policy == RT_TUNE_FIFO ? SCHED_FIFO : SCHED_RR;
+        int rc = pthread_setschedparam(pthread_self(), policy, &param);
+        result->sched = rc == 0 ? 1 : -rc;
+        snprintf(item, sizeof(item), "%s %d", rt_tune_policy_name(options->policy), options->priority);
+        append(result, item, result->sched);
+        denied += rc != 0;
+    }
+
+    // 实时调度下nice没有作用，只在普通调度 (或实时调度被拒绝) 时设置。Linux上nice是每个线程的
+    if (options->nice != 0 && result->sched <= 0) {
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        int rc = setpriority(PRIO_PROCESS, (id_t)tid, options->nice) == 0 ? 0 : errno;
+        result->nice = rc == 0 ? 1 : -rc;
+        snprintf(item, sizeof(item), "nice %d", options->nice);
+        append(result, item, result->nice);
+        denied += rc != 0;
+    }
+
+    if (!result->text[0]) {
+        snprintf(result->text, sizeof(result->text), "default");
+    }
+    return denied;
+}
+
+int rt_tune_lock_memory(char* text, size_t size) {
+    struct rlimit limit;
+    int unlimited = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY;
+    int future = geteuid() == 0 || unlimited;
+    if (mlockall(future ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT) == 0) {
+        if (future) {
+            snprintf(text, size, "mlockall: current and future mappings locked");
+            return RT_TUNE_LOCK_CURRENT | RT_TUNE_LOCK_FUTURE;
+        }
+        snprintf(text, size, "mlockall: current mappings locked (RLIMIT_MEMLOCK %llu KB, future mappings not locked)",
+                 (unsigned long long)limit.rlim_cur / 1024);
+        return RT_TUNE_LOCK_CURRENT;
+    }
+    snprintf(text, size, "mlockall: %s (RLIMIT_MEMLOCK %llu KB)", strerror(errno),
+             (unsigned long long)limit.rlim_cur / 1024);
+    return 0;
+}
+
+void rt_tune_unlock_memory(void) {
+    munlockall();
+}
+
+#else
+
+int rt_tune_apply(const rt_tune_options_t* options, rt_tune_result_t* result) {
+    memset(result, 0, sizeof(*result));
+    if (!rt_tune_requested(options)) {
+        snprintf(result->text, sizeof(result->text), "default");
+        return 0;
+    }
+    snprintf(result->text, sizeof(result->text), "not supported on this platform");
+    return (options->cpu >= 0) + (options->policy != RT_TUNE_OTHER) + (options->nice != 0);
+}
+
+int rt_tune_lock_memory(char* text, size_t size) {
+    snprintf(text, size, "mlockall: not supported on this platform");
+    return 0;
+}
+
+void rt_tune_unlock_memory(void) {
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef RT_TUNE_H
+#define RT_TUNE_H
+
+#include <stddef.h>
+
+// 帧循环的实时选项: 把线程绑定到指定的核，请求SCHED_FIFO/SCHED_RR (没有权限时退回nice值)，
+// 锁定内存并预先触碰缓冲区，让后台服务的抢占和缺页不落在帧里。
+//
+// 每一项单独申请，被拒绝时不影响其他项，结果 (批准、拒绝的原因) 写成一行文字供日志使用。
+// 绑核、调度策略和nice都只作用于调用的线程。非Linux平台上只有预先触碰有效。
+
+#define RT_TUNE_DEFAULT_PRIORITY 50
+
+typedef enum {
+    RT_TUNE_OTHER,               // 普通调度 (只使用nice)
+    RT_TUNE_FIFO,
+    RT_TUNE_RR,
+} rt_tune_policy_t;
+
+typedef struct {
+    int cpu;                     // 绑定的核，-1为不绑定
+    rt_tune_policy_t policy;
+    int priority;                // SCHED_FIFO/SCHED_RR 的优先级 (1..99)
+    int nice;                    // 普通调度或实时调度被拒绝时的nice值，0为不改
+} rt_tune_options_t;
+
+typedef struct {
+    int affinity;                // 1为批准，0为没有申请，负数为被拒绝 (-errno)
+    int sched;
+    int nice;
+    char text[192];
+} rt_tune_result_t;
+
+// 锁定内存的结果
+#define RT_TUNE_LOCK_CURRENT 1       // 已有的映射
+#define RT_TUNE_LOCK_FUTURE  2       // 之后的映射 (分配时就调入并锁定)
+
+// 预先触碰的方式
+#define RT_TUNE_PREFAULT_WRITE 1     // 写回原值 (可写的私有内存)，否则只读
+#define RT_TUNE_PREFAULT_LOCK  2     // 同时锁定这段内存 (只锁定了已有映射时使用)
+
+void rt_tune_defaults(rt_tune_options_t* options);
+
+// 是否申请了任何一项
+int rt_tune_requested(const rt_tune_options_t* options);
+
+// "fifo"、"rr" 或 "other"，无法识别时返回-1
+int rt_tune_parse_policy(const char* name, rt_tune_policy_t* policy);
+const char* rt_tune_policy_name(rt_tune_policy_t policy);
+
+// 对调用的线程申请各项，返回被拒绝的项数
+int rt_tune_apply(const rt_tune_options_t* options, rt_tune_result_t* result);
+
+// 锁定进程的内存: 有权限 (root或RLIMIT_MEMLOCK不限) 时同时锁定之后的映射，否则只锁定已有的映射，
+// 避免之后的分配因超过限额而失败。返回批准的 RT_TUNE_LOCK_* 组合，结果写入text
+int rt_tune_lock_memory(char* text, size_t size);
+void rt_tune_unlock_memory(void);
+
+// 逐页触碰 (flags为 RT_TUNE_PREFAULT_* 组合)，返回触碰的页数
+size_t rt_tune_prefault(void* data, size_t size, int flags);
+
+#endif
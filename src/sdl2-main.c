@@ -1,10 +1,34 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include "font-cache.h"
+#include "glyph-pack.h"
+#include "utf8.h"
+#include "perf-trace.h"
+#include "fb-present.h"
+#include "pixel-format.h"
+#include "render-batch.h"
+#include "text-pool.h"
+#include "alloc-guard.h"
+#include "sprites.h"
+#include "blend.h"
+#include "image-asset.h"
+#include "triple-buffer.h"
+#include "ui-tree.h"
+#include "text-layout.h"
+#include "list-view.h"
+#include "rom-index.h"
+#include "thumb-cache.h"
+#include "audio-mixer.h"
+#include "gamepad.h"
+#include "metrics.h"
+#include "sensors.h"
+#include "rt-tune.h"
 
 #ifndef __CROSS_COMPILE__
 #include <sys/utsname.h>
@@ -13,11 +37,69 @@
 #include <sys/ioctl.h>
 #endif
 #include <locale.h>
+#include <sys/resource.h>
 
 // 屏幕尺寸
 #define SCREEN_WIDTH  720
 #define SCREEN_HEIGHT 480
 
+// 字号 (相同字号共享同一个字体)
+#define FONT_SIZE_MAIN    18
+#define FONT_SIZE_SMALL   14
+#define FONT_SIZE_CHINESE 18
+
+// 调试版本在第一个完整界面帧之后经过这么多帧开始检查堆分配
+#define ALLOC_WARMUP_FRAMES 120
+
+// 逻辑线程的固定步长 (60Hz)
+#define LOGIC_TICK_MS 16
+
+// 界面树的节点池 (目前用到35个) 和自定义节点
+#define UI_MAX_NODES  48
+#define UI_ID_LOGO    1
+#define UI_ID_SPRITES 2
+#define UI_ID_LIST    3
+#define UI_ID_PREVIEW 4
+
+// ROM浏览界面的列表: 固定行高和可见行数，上下各多准备几行
+#define LIST_ROW_HEIGHT   30
+#define LIST_VISIBLE_ROWS 13
+#define LIST_OVERSCAN     4
+#define ROMS_DIR          "/mnt/mmc/Roms"
+// ROM索引放在ROM目录外面，写索引不会改变被扫描目录的mtime
+#define ROM_INDEX_PATH    "/mnt/mmc/.rg34xx-rom-index"
+
+// 选中条目的封面预览: ROM "SYS/名字.zip" 的封面为 封面目录/SYS/名字.bmp，
+// 缩小后的结果缓存在内存 (按字节预算) 和磁盘缓存目录中，上下各预取几项
+#define ART_DIR           "/mnt/mmc/Imgs"
+#define THUMB_DIR         "/mnt/mmc/.rg34xx-thumbs"
+#define THUMB_WIDTH       192
+#define THUMB_HEIGHT      144
+#define THUMB_BUDGET      (4 << 20)
+#define THUMB_ENTRIES     64
+#define THUMB_WORKERS     2
+#define THUMB_PREFETCH    2
+#define PREVIEW_PADDING   10
+#define PREVIEW_BACKGROUND 0x181818
+
+// 音频: 小的回调缓冲 (256帧约5ms) 让按键音几乎没有延迟；界面音效启动时合成，背景音乐 (--music) 预先读入
+#define AUDIO_RATE          48000
+#define AUDIO_BUFFER_FRAMES 256
+#define AUDIO_VOICES        16
+#define AUDIO_MUSIC_VOLUME  96
+#define AUDIO_MOVE_GAP_MS   50       // 快速滚动时移动音的最小间隔
+
+// 手柄映射文件 (程序目录，其次SD卡的APPS目录)
+#define GAMEPAD_DB_LOCAL    "./gamecontrollerdb.txt"
+#define GAMEPAD_DB_SDCARD   "/mnt/mmc/Roms/APPS/gamecontrollerdb.txt"
+
+// 传感器: 后台按间隔采样CPU频率、温度、占用和电量；渲染一帧超过FRAME_SPIKE_US时连同当时的采样写入日志
+#define FRAME_SPIKE_US      33000    // 60Hz下连续两帧的时间
+#define SPIKE_LOG_GAP_MS    1000     // 连续掉帧时日志的最小间隔
+
+// 标签排版缓存: 常驻的标签加上每帧变化的几行文字
+#define TEXT_LAYOUT_CACHE_SIZE 64
+
 // 颜色定义
 #define COLOR_BLACK   0x000000
 #define COLOR_WHITE   0xFFFFFF
@@ -26,18 +108,168 @@
 #define COLOR_BLUE    0x0000FF
 #define COLOR_YELLOW  0xFFFF00
 
+// 格式化文字的缓存: 参与格式化的值不变时不重新格式化
+typedef struct {
+    int key[6];
+    int valid;
+    char text[160];
+} cached_text_t;
+
+// 界面状态快照中的一个精灵 (已取整为像素)
+typedef struct {
+    int x, y, w, h;
+    Uint32 color;
+} ui_sprite_t;
+
+// 逻辑线程发布的界面状态快照，发布后不再修改；render_ui只读取快照和渲染线程自己的数据
+typedef struct {
+    int tick;
+    int run_time;
+    char input_info[256];
+    char last_key_info[256];
+    int box_x, box_y;            // 演示方块的位置和速度 (显示用)
+    float box_vx, box_vy;
+    int browsing;                // 显示ROM浏览界面
+    int list_count;
+    int list_selected;
+    int list_scroll;
+    unsigned list_generation;    // 条目整体替换 (扫描完成排序) 时变化
+    int list_scanning;           // 后台还在扫描ROM目录
+    int sprite_count;
+    ui_sprite_t sprites[];
+} ui_state_t;
+
 // 应用上下文
 typedef struct {
     SDL_Window* window;
     SDL_Renderer* renderer;
-    TTF_Font* font;
-    TTF_Font* font_small;
-    TTF_Font* font_chinese;  // 中文字体
-    
-    // 帧缓冲模式 (Linux嵌入式)
+    render_batch_t batch;    // 每帧的绘制命令，帧末合并提交
+    font_cache_t fonts;      // 字体文件只映射一次，按字号懒加载
+    glyph_pack_t glyphs;     // 预光栅化的UI字形包 (可选)
+    text_pool_t text_pool;   // 复用的文字纹理，字符串不变时不重新渲染
+    text_layout_cache_t layout;  // 标签的折行结果，文字不变时不重新测量
+    
+    // 标题栏图标: 预转换的图片资源 (可选)，帧缓冲模式直接复制映射的像素，窗口模式启动时上传一次纹理
+    const char* image_path;      // --image 指定的文件
+    image_asset_t logo;
+    SDL_Texture* logo_texture;
+    
+    // 字体在后台线程加载，期间先显示启动画面
+    SDL_Thread* font_thread;
+    SDL_atomic_t fonts_ready;    // 后台线程完成后置1
+    int font_status;             // 后台线程结果 (0成功)
+    int fonts_loaded;            // 主线程已回收后台线程
+    int first_ui_frame;          // 第一个完整界面帧的帧号
+    
+    // 帧缓冲模式 (Linux嵌入式): SDL软件渲染到面板格式的影子表面，每帧复制到显存后翻页
     int framebuffer_mode;
-    void* fb_memory;
-    int fb_fd;
+    const char* fb_device;       // --fbdev 指定的设备，NULL为普通SDL窗口
+    fb_present_t fb;
+    pixel_format_t fb_format;    // 面板原生格式，影子表面和文字合成都使用它
+    SDL_Surface* fb_surface;
+    int fb_synced;               // 上一帧已等待垂直同步，不需要再延时
+    
+    // 基准测试 (--bench N): 不限帧率运行N个完整界面帧，统计FPS和CPU占用
+    int bench_frames;
+    Uint64 bench_start;
+    struct rusage bench_usage;
+    double present_ms;           // 累计的呈现耗时
+    
+    // 性能HUD
+    Uint32 fps_tick;
+    int fps_frames;
+    float fps;
+    
+    // 指标 (共享内存，metrics-tool在另一个进程中读取): 启动时登记，更新都是一次原子操作
+    const char* metrics_name;    // --metrics 指定的共享内存名
+    metrics_t metrics;
+    metrics_entry_t* m_frames;
+    metrics_entry_t* m_frame_us;         // 渲染一帧的耗时
+    metrics_entry_t* m_present_us;
+    metrics_entry_t* m_flip_bytes;       // 复制到显存的字节数
+    metrics_entry_t* m_logic_steps;
+    metrics_entry_t* m_events;
+    metrics_entry_t* m_audio_callbacks;
+    metrics_entry_t* m_fps;              // 以下每秒更新一次
+    metrics_entry_t* m_dropped_states;
+    metrics_entry_t* m_thumb_requests;
+    metrics_entry_t* m_thumb_ram_hits;
+    metrics_entry_t* m_thumb_disk_hits;
+    metrics_entry_t* m_thumb_decodes;
+    metrics_entry_t* m_audio_underruns;
+    metrics_entry_t* m_frame_spikes;
+    metrics_entry_t* m_cpu_khz;
+    metrics_entry_t* m_cpu_max_khz;
+    metrics_entry_t* m_temp_mc;
+    metrics_entry_t* m_load;
+    metrics_entry_t* m_battery;
+    
+    // 系统传感器 (--sensors 毫秒，0为关闭): 渲染线程每帧取最新的采样
+    int sensor_interval;
+    int sensors_started;
+    sensors_t sensors;
+    const sensors_sample_t* sensor;
+    Uint32 last_spike_log;
+    int spikes_unlogged;         // 间隔内没有写入日志的掉帧
+    
+    // 实时选项 (--render-cpu、--input-cpu、--rt、--rt-priority、--nice、--mlock)，默认都不申请
+    rt_tune_options_t render_tune;
+    rt_tune_options_t input_tune;    // 逻辑线程 (主线程，处理输入)
+    int lock_memory;
+    int memory_locked;           // 批准的 RT_TUNE_LOCK_*
+    
+    // 每帧变化的文字
+    cached_text_t time_text;
+    cached_text_t box_text;
+    cached_text_t hud_text;
+    cached_text_t sensor_text;
+    
+    // 界面树: 启动时建好，之后只由渲染线程修改。帧缓冲模式下影子表面保留上一帧，只重画变化的区域
+    ui_tree_t ui;
+    ui_node_t* input_label;
+    ui_node_t* last_key_label;
+    ui_node_t* time_label;
+    ui_node_t* box_label;
+    ui_node_t* hud_label;
+    ui_node_t* sensor_label;
+    ui_node_t* screen_panel;     // 测试界面和精灵层，浏览时隐藏
+    ui_node_t* sprites_node;
+    ui_node_t* browser_panel;
+    ui_node_t* browser_label;
+    ui_node_t* list_node;
+    ui_node_t* preview_node;
+    int shown_browsing;
+    int drawn_selected, drawn_scroll, drawn_list_count;
+    unsigned drawn_generation;
+    cached_text_t browser_text;
+    list_rows_t list_rows;       // 可见行的文字，滚动时循环使用
+    
+    // 封面预览 (渲染线程): 缩略图在后台解码，窗口模式下复制到启动时创建的流式纹理
+    const char* art_dir;
+    const char* thumb_dir;
+    thumb_cache_t thumbs;
+    int thumbs_ready;
+    SDL_Texture* preview_texture;
+    const image_asset_t* preview_image;  // 预览区显示的缩略图，本帧有效
+    int preview_selected;
+    unsigned preview_generation;
+    char thumb_path[THUMB_CACHE_MAX_PATH];
+    
+    // 音频: 回调在SDL的音频线程中混音，逻辑线程是命令的唯一发送者。打不开设备时没有声音
+    SDL_AudioDeviceID audio_device;
+    int audio_buffer;            // --audio-buffer 指定的回调帧数
+    const char* music_path;      // --music 指定的WAV
+    audio_mixer_t mixer;
+    audio_sound_t sound_move;
+    audio_sound_t sound_page;
+    audio_sound_t sound_open;
+    audio_sound_t sound_close;
+    audio_sound_t sound_key;
+    audio_sound_t music;
+    Uint32 last_move_sound;
+    const ui_state_t* paint_state;   // 正在绘制的快照 (精灵层使用)
+    ui_sprite_t* drawn_sprites;      // 上一帧画出的精灵位置，移动后新旧位置都要重画
+    int drawn_count;
     
     // 系统信息
     char system_info[512];
@@ -47,17 +279,42 @@ typedef struct {
     char input_info[256];
     char last_key_info[256];
     
-    // 运行状态
-    int running;
-    int frame_count;
+    // ROM浏览: 后台扫描ROM目录，有上次的索引时立即显示 (--list N 改用N个生成的条目)
+    const char* roms_dir;
+    const char* index_path;
+    rom_index_t roms;
+    int roms_started;
+    rom_index_state_t roms_state;
+    unsigned list_generation;
+    int synthetic_count;
+    
+    // 列表的滚动状态 (逻辑线程)
+    int browsing;
+    list_view_t list;
+    int list_hold;               // 本步按住的方向: -1上，1下 (键盘或手柄)
+    int key_hold;                // 键盘按住的方向键
+    int list_pages;              // 本步要翻的页数
+    
+    // 手柄: 按实例编号管理打开的设备，逻辑线程每步读一次每个玩家的状态快照
+    gamepad_manager_t pads;
+    
+    // 运行状态 (逻辑线程和渲染线程都可能结束程序)
+    SDL_atomic_t running;
+    int frame_count;             // 渲染的帧数
     time_t start_time;
     time_t last_input_time;  // 最后一次输入时间
     
-    // 动画相关
-    float box_x, box_y;
-    float box_vx, box_vy;
-    int box_size;
-    unsigned int box_color;
+    // 动画相关: 精灵0是演示方块，--sprites N 再加入N个小方块做压力测试
+    sprite_store_t sprites;
+    int extra_sprites;
+    
+    // 逻辑与渲染分离: 逻辑线程 (主线程) 处理输入和动画，每个tick发布一份界面状态快照，
+    // 渲染只读取最新的快照。帧缓冲模式下渲染在单独的线程中运行，互不等待
+    triple_buffer_t states;
+    int threaded;
+    int logic_tick;
+    SDL_Thread* render_thread;
+    SDL_sem* state_ready;        // 发布新快照时通知渲染线程
     
 } app_context_t;
 
@@ -68,7 +325,8 @@ FILE* log_file = NULL;
 void log_message(const char* message) {
     if (log_file) {
         time_t now = time(NULL);
-        char* time_str = ctime(&now);
+        char time_str[32];
+        ctime_r(&now, time_str);   // 逻辑线程和渲染线程都会写日志，不用ctime的静态缓冲区
         time_str[strlen(time_str) - 1] = '\0'; // 移除换行符
         fprintf(log_file, "[%s] %s\n", time_str, message);
         fflush(log_file);
@@ -115,53 +373,135 @@ void get_system_info(app_context_t* app) {
 }
 
 // 初始化动画
-void init_animation(app_context_t* app) {
-    app->box_x = SCREEN_WIDTH / 2.0f;
-    app->box_y = SCREEN_HEIGHT / 2.0f;
-    app->box_vx = 2.0f;  // 水平速度
-    app->box_vy = 1.5f;  // 垂直速度
-    app->box_size = 40;
-    app->box_color = COLOR_RED;
+int init_animation(app_context_t* app) {
+    if (app->extra_sprites < 0) {
+        app->extra_sprites = 0;
+    }
+    if (sprites_init(&app->sprites, 1 + app->extra_sprites) < 0) {
+        return -1;
+    }
+    
+    // 演示方块: 水平速度2，垂直速度1.5
+    sprites_add(&app->sprites, SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f, 40, 40, 2.0f, 1.5f, COLOR_RED);
+    
+    // 压力测试的小方块 (固定种子，每次运行相同)
+    srand(1);
+    for (int i = 0; i < app->extra_sprites; i++) {
+        float size = 4 + rand() % 8;
+        sprites_add(&app->sprites,
+                    rand() % (int)(SCREEN_WIDTH - size), rand() % (int)(SCREEN_HEIGHT - size),
+                    size, size, (rand() % 600 - 300) / 100.0f, (rand() % 600 - 300) / 100.0f,
+                    (Uint32)rand() & 0xFFFFFF);
+    }
+    return 0;
 }
 
-// 更新动画
+// 更新动画: 所有精灵一次移动并在屏幕边界反弹
 void update_animation(app_context_t* app) {
-    // 更新位置
-    app->box_x += app->box_vx;
-    app->box_y += app->box_vy;
-    
-    // 边界碰撞检测
-    if (app->box_x <= 0 || app->box_x + app->box_size >= SCREEN_WIDTH) {
-        app->box_vx = -app->box_vx;
-        app->box_x = (app->box_x <= 0) ? 0 : SCREEN_WIDTH - app->box_size;
-        
-        // 碰撞时改变颜色
-        app->box_color = (app->box_color == COLOR_RED) ? COLOR_BLUE : COLOR_RED;
+    sprite_store_t* sprites = &app->sprites;
+    sprites_update(sprites, 1.0f, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    
+    // 演示方块碰撞时改变颜色
+    if (sprites->bounced[0] & SPRITE_BOUNCE_X) {
+        sprites->color[0] = (sprites->color[0] == COLOR_RED) ? COLOR_BLUE : COLOR_RED;
+    }
+    if (sprites->bounced[0] & SPRITE_BOUNCE_Y) {
+        sprites->color[0] = (sprites->color[0] == COLOR_RED) ? COLOR_GREEN : COLOR_RED;
     }
+}
+
+// 面板原生格式对应的SDL格式
+static Uint32 sdl_pixel_format(pixel_format_t format) {
+    switch (format) {
+        case PIXEL_FORMAT_RGB565:   return SDL_PIXELFORMAT_RGB565;
+        case PIXEL_FORMAT_BGR565:   return SDL_PIXELFORMAT_BGR565;
+        case PIXEL_FORMAT_XBGR8888: return SDL_PIXELFORMAT_BGR888;
+        default:                    return SDL_PIXELFORMAT_RGB888;
+    }
+}
+
+// 打开帧缓冲并创建同格式的影子表面和软件渲染器。
+// 不直接在显存上绘制: 混合需要读回像素，而显存读取很慢，整帧顺序复制最快
+int init_framebuffer(app_context_t* app) {
+    if (fb_present_open(&app->fb, app->fb_device) < 0) {
+        char error_msg[320];
+        sprintf(error_msg, "Cannot open framebuffer %s", app->fb_device);
+        log_message(error_msg);
+        return -1;
+    }
+    app->framebuffer_mode = 1;
     
-    if (app->box_y <= 0 || app->box_y + app->box_size >= SCREEN_HEIGHT) {
-        app->box_vy = -app->box_vy;
-        app->box_y = (app->box_y <= 0) ? 0 : SCREEN_HEIGHT - app->box_size;
-        
-        // 碰撞时改变颜色
-        app->box_color = (app->box_color == COLOR_RED) ? COLOR_GREEN : COLOR_RED;
+    app->fb_format = pixel_format_from_fb(app->fb.bits_per_pixel, app->fb.red_offset);
+    Uint32 format = sdl_pixel_format(app->fb_format);
+    app->fb_surface = SDL_CreateRGBSurfaceWithFormat(0, app->fb.width, app->fb.height,
+                                                     app->fb.bits_per_pixel, format);
+    if (!app->fb_surface) {
+        char error_msg[128];
+        sprintf(error_msg, "Framebuffer surface creation failed: %s", SDL_GetError());
+        log_message(error_msg);
+        return -1;
+    }
+    
+    app->renderer = SDL_CreateSoftwareRenderer(app->fb_surface);
+    if (!app->renderer) {
+        char error_msg[128];
+        sprintf(error_msg, "Software renderer creation failed: %s", SDL_GetError());
+        log_message(error_msg);
+        return -1;
     }
+    
+    char fb_msg[320];
+    sprintf(fb_msg, "Framebuffer mode: %s %dx%d %dbpp %s, %d page(s)",
+            app->fb_device, app->fb.width, app->fb.height, app->fb.bits_per_pixel,
+            SDL_GetPixelFormatName(format), app->fb.pages);
+    log_message(fb_msg);
+    return 0;
+}
+
+// 打开一个手柄 (启动时和插入时)
+static void open_gamepad(app_context_t* app, int device_index) {
+    char pad_msg[192];
+    int slot = gamepad_manager_add(&app->pads, device_index);
+    if (slot < 0) {
+        snprintf(pad_msg, sizeof(pad_msg), "Failed to open gamepad %d: %s", device_index, SDL_GetError());
+        log_message(pad_msg);
+        return;
+    }
+    const gamepad_device_t* device = &app->pads.devices[slot];
+    snprintf(pad_msg, sizeof(pad_msg), "Opened gamepad %d: %s (instance %d, player %d, %s mapping)",
+             device_index, device->name, (int)device->instance, device->player + 1,
+             device->builtin ? "RG34XX" : "DB");
+    log_message(pad_msg);
 }
 
 // 初始化SDL2
 int init_sdl2(app_context_t* app) {
     log_message("=== Initializing SDL2 ===");
     
-    // 初始化SDL2 (包含视频和手柄子系统)
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK) < 0) {
+    // 初始化SDL2 (包含视频和手柄子系统)，帧缓冲模式不需要视频子系统
+    Uint32 init_flags = app->fb_device ? SDL_INIT_GAMECONTROLLER | SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_GAMECONTROLLER;
+    int phase = perf_trace_begin(app->fb_device ? "SDL_Init(GAMECONTROLLER|EVENTS)" : "SDL_Init(VIDEO|GAMECONTROLLER)");
+    if (SDL_Init(init_flags) < 0) {
         char error_msg[128];
         sprintf(error_msg, "SDL2 initialization failed: %s", SDL_GetError());
         log_message(error_msg);
         return -1;
     }
-    
-    // 初始化手柄子系统
-    SDL_JoystickEventState(SDL_ENABLE);
+    perf_trace_end(phase);
+    
+    // 读入手柄映射，打开所有手柄 (之后插入的在设备事件中打开)
+    phase = perf_trace_begin("gamepad enumeration");
+    static const char* const mapping_paths[] = { GAMEPAD_DB_LOCAL, GAMEPAD_DB_SDCARD, NULL };
+    gamepad_manager_init(&app->pads, mapping_paths);
+    char mapping_info[256];
+    if (app->pads.mappings_path) {
+        snprintf(mapping_info, sizeof(mapping_info), "Gamepad mappings: %d from %s",
+                 app->pads.mappings, app->pads.mappings_path);
+    } else {
+        snprintf(mapping_info, sizeof(mapping_info), "Gamepad mappings: no %s, using SDL built-in",
+                 GAMEPAD_DB_LOCAL);
+    }
+    log_message(mapping_info);
     
     // 检测手柄数量
     int num_joysticks = SDL_NumJoysticks();
@@ -169,47 +509,41 @@ int init_sdl2(app_context_t* app) {
     sprintf(joystick_info, "Detected %d joystick(s)", num_joysticks);
     log_message(joystick_info);
     
-    // 打开所有手柄
     for (int i = 0; i < num_joysticks; i++) {
-        SDL_Joystick* joystick = SDL_JoystickOpen(i);
-        if (joystick) {
-            char joy_name[128];
-            sprintf(joy_name, "Opened joystick %d: %s", i, SDL_JoystickName(joystick));
-            log_message(joy_name);
-        }
+        open_gamepad(app, i);
     }
+    perf_trace_end(phase);
     
-    // 初始化TTF
-    if (TTF_Init() < 0) {
-        char error_msg[128];
-        sprintf(error_msg, "TTF initialization failed: %s", TTF_GetError());
-        log_message(error_msg);
-        return -1;
+    // 帧缓冲模式: 不创建窗口，直接写显存
+    if (app->fb_device) {
+        phase = perf_trace_begin("framebuffer setup");
+        if (init_framebuffer(app) < 0) {
+            return -1;
+        }
+        perf_trace_end(phase);
+        
+        log_message("SDL2 initialization successful");
+        return 0;
     }
     
+    phase = perf_trace_begin("window creation");
     // 创建窗口
     #ifdef __linux__
     #ifndef __CROSS_COMPILE__
-        // 检查是否为帧缓冲模式
+        // 有帧缓冲设备时窗口大小与屏幕一致
         if (access("/dev/fb0", F_OK) == 0) {
-            log_message("Framebuffer device detected, using framebuffer mode");
-            app->framebuffer_mode = 1;
-            
-            // 尝试从帧缓冲创建窗口
             int fb_fd = open("/dev/fb0", O_RDWR);
             if (fb_fd >= 0) {
                 struct fb_var_screeninfo vinfo;
                 if (ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo) >= 0) {
-                    log_message("Creating SDL2 window from framebuffer");
-                    app->fb_fd = fb_fd;
+                    log_message("Framebuffer device detected, creating SDL2 window at framebuffer size");
                     app->window = SDL_CreateWindow("RG34XX Test", 
                                               SDL_WINDOWPOS_UNDEFINED, 
                                               SDL_WINDOWPOS_UNDEFINED, 
                                               vinfo.xres, vinfo.yres, 
                                               SDL_WINDOW_SHOWN);
-                } else {
-                    close(fb_fd);
                 }
+                close(fb_fd);
             }
         }
     #endif
@@ -218,7 +552,6 @@ int init_sdl2(app_context_t* app) {
     // 如果不是帧缓冲模式，创建普通窗口
     if (!app->window) {
         log_message("Creating normal SDL2 window");
-        app->framebuffer_mode = 0;
         app->window = SDL_CreateWindow("RG34XX Test", 
                                       SDL_WINDOWPOS_CENTERED, 
                                       SDL_WINDOWPOS_CENTERED, 
@@ -232,8 +565,10 @@ int init_sdl2(app_context_t* app) {
         log_message(error_msg);
         return -1;
     }
+    perf_trace_end(phase);
     
     // 创建渲染器
+    phase = perf_trace_begin("renderer creation");
     app->renderer = SDL_CreateRenderer(app->window, -1, SDL_RENDERER_ACCELERATED);
     if (!app->renderer) {
         char error_msg[128];
@@ -241,10 +576,34 @@ int init_sdl2(app_context_t* app) {
         log_message(error_msg);
         return -1;
     }
+    perf_trace_end(phase);
+    
+    log_message("SDL2 initialization successful");
+    return 0;
+}
+
+// 需要预热的UI文字 (字形包未覆盖时在后台线程打开对应字号并加载字形)
+static const struct {
+    int ptsize;
+    const char* text;
+} prewarm_texts[] = {
+    { FONT_SIZE_MAIN, " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~" },
+    { FONT_SIZE_SMALL, " !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~" },
+    { FONT_SIZE_CHINESE, "中文测试：方块动画演示" },
+    { FONT_SIZE_CHINESE, "繁體中文：方塊動畫演示" },
+    { FONT_SIZE_CHINESE, "日本語：ブロックアニメーション" },
+    { FONT_SIZE_CHINESE, "한국어：블록 애니메이션" },
+    { FONT_SIZE_CHINESE, "按任意键测试输入 | ESC退出程序" },
+    { FONT_SIZE_SMALL, "RG34XX SDL2 Multi-Input Test v1.0 | 中文支持" },
+};
+
+// 后台线程: 解析字体路径、映射字体和字形包、预热字形
+// 只使用TTF和文件接口，结果由主线程在等待加载完成后统一写入日志
+static int font_loader_thread(void* data) {
+    app_context_t* app = (app_context_t*)data;
     
-    // 加载字体 (使用Noto Sans CJK字体)
     // 优先使用Noto Sans CJK字体，专门支持中日韩等东亚语言
-    const char* font_paths[] = {
+    static const char* const font_paths[] = {
         "./NotoSansCJK-Regular.ttc",     // 当前目录的字体
         "/mnt/mmc/Roms/APPS/NotoSansCJK-Regular.ttc",  // 掌机应用目录
         "NotoSansCJK-Regular.ttc",       // 相对路径
@@ -263,195 +622,1138 @@ int init_sdl2(app_context_t* app) {
         NULL
     };
     
-    // 加载主字体
-    for (int i = 0; font_paths[i]; i++) {
-        app->font = TTF_OpenFont(font_paths[i], 18);
-        if (app->font) {
-            char font_msg[128];
-            sprintf(font_msg, "Font loaded successfully: %s", font_paths[i]);
-            log_message(font_msg);
+    // 只解析路径并映射一次，各字号在第一次用到时才打开
+    int phase = perf_trace_begin("font resolve + mmap");
+    app->font_status = font_cache_init(&app->fonts, font_paths);
+    perf_trace_end(phase);
+    
+    // 字形包覆盖UI用到的字符时，完全不需要打开字体
+    static const char* const pack_paths[] = {
+        "./ui-glyphs.pack",
+        "/mnt/mmc/Roms/APPS/ui-glyphs.pack",
+        NULL
+    };
+    phase = perf_trace_begin("glyph pack mmap");
+    for (int i = 0; pack_paths[i]; i++) {
+        if (glyph_pack_open(&app->glyphs, pack_paths[i]) == 0) {
             break;
         }
     }
+    perf_trace_end(phase);
+    
+    // --mlock: 字体数据在这个线程里整个读入，之后打开字号和渲染文字都不会缺页
+    if (app->lock_memory) {
+        int flags = app->memory_locked & RT_TUNE_LOCK_FUTURE ? 0 : RT_TUNE_PREFAULT_LOCK;
+        phase = perf_trace_begin("font prefault");
+        rt_tune_prefault((void*)app->fonts.data, app->fonts.size, flags);
+        rt_tune_prefault((void*)app->glyphs.data, app->glyphs.size, flags);
+        perf_trace_end(phase);
+    }
     
-    if (!app->font) {
-        log_message("Error: Cannot load any font for main text");
+    // 预热: 字形包缺字的文字提前打开字号并加载字形到SDL_ttf的字形缓存
+    phase = perf_trace_begin("font parse + glyph prewarm");
+    int count = (int)(sizeof(prewarm_texts) / sizeof(prewarm_texts[0]));
+    for (int i = 0; i < count && app->font_status == 0; i++) {
+        const glyph_pack_size_t* size = glyph_pack_find_size(&app->glyphs, prewarm_texts[i].ptsize);
+        if (size && glyph_pack_measure(&app->glyphs, size, prewarm_texts[i].text) >= 0) {
+            continue;
+        }
+        TTF_Font* font = font_cache_get(&app->fonts, prewarm_texts[i].ptsize);
+        int w, h;
+        if (font) {
+            TTF_SizeUTF8(font, prewarm_texts[i].text, &w, &h);
+        }
+    }
+    perf_trace_end(phase);
+    
+    SDL_AtomicSet(&app->fonts_ready, 1);
+    return 0;
+}
+
+// 初始化TTF并启动字体加载线程，与SDL视频和手柄初始化并行
+int start_font_loader(app_context_t* app) {
+    int phase = perf_trace_begin("TTF_Init");
+    if (TTF_Init() < 0) {
+        char error_msg[128];
+        sprintf(error_msg, "TTF initialization failed: %s", TTF_GetError());
+        log_message(error_msg);
         return -1;
     }
+    perf_trace_end(phase);
     
-    // 小字体
-    for (int i = 0; font_paths[i]; i++) {
-        app->font_small = TTF_OpenFont(font_paths[i], 14);
-        if (app->font_small) {
-            break;
-        }
+    app->font_thread = SDL_CreateThread(font_loader_thread, "font-loader", app);
+    if (!app->font_thread) {
+        // 无法创建线程时同步加载
+        log_message("Warning: Cannot create font loader thread, loading fonts synchronously");
+        font_loader_thread(app);
     }
-    if (!app->font_small) {
-        app->font_small = app->font; // 备用
+    return 0;
+}
+
+// 回收字体加载线程并输出结果，字体不可用时返回-1
+int finish_font_loader(app_context_t* app) {
+    if (app->font_thread) {
+        SDL_WaitThread(app->font_thread, NULL);
+        app->font_thread = NULL;
     }
+    app->fonts_loaded = 1;
+    perf_trace_mark("fonts ready");
     
-    // 中文字体优先使用CJK字体
-    for (int i = 0; font_paths[i]; i++) {
-        app->font_chinese = TTF_OpenFont(font_paths[i], 18);
-        if (app->font_chinese) {
-            break;
+    if (app->font_status < 0) {
+        log_message("Error: Cannot find any font file");
+        return -1;
+    }
+    
+    char font_msg[320];
+    sprintf(font_msg, "Font file resolved: %s", app->fonts.path);
+    log_message(font_msg);
+    if (app->glyphs.data) {
+        sprintf(font_msg, "Glyph pack loaded: %u glyphs, %zu bytes",
+                app->glyphs.header->glyph_count, app->glyphs.size);
+        log_message(font_msg);
+    }
+    return 0;
+}
+
+// 帧缓冲模式的文字命令参数 (分配在命令缓冲的arena中，text按实际长度分配)
+typedef struct {
+    const glyph_pack_size_t* size;
+    SDL_Rect rect;
+    SDL_Rect clip;               // 只绘制这个区域 (在rect内)
+    SDL_Color color;
+    char text[];
+} native_text_t;
+
+// 帧缓冲模式的表面命令参数
+typedef struct {
+    SDL_Surface* surface;
+    SDL_Rect src;
+    SDL_Rect dst;
+    int owned;                   // 提交后释放 (文字池放不下时的临时表面)
+} native_surface_t;
+
+// 帧缓冲模式: 字形覆盖率直接混合到原生格式的影子表面，不经过32位中间表面和纹理
+static void draw_text_native(void* context, const void* data) {
+    app_context_t* app = (app_context_t*)context;
+    const native_text_t* cmd = (const native_text_t*)data;
+    const glyph_pack_size_t* size = cmd->size;
+    SDL_Surface* target = app->fb_surface;
+    int bytes = target->format->BytesPerPixel;
+    
+    // 与纹理路径相同，只绘制在测量出的文字区域 (再裁剪到重画区域) 内
+    int clip_x0 = cmd->clip.x < 0 ? 0 : cmd->clip.x;
+    int clip_y0 = cmd->clip.y < 0 ? 0 : cmd->clip.y;
+    int clip_x1 = cmd->clip.x + cmd->clip.w > target->w ? target->w : cmd->clip.x + cmd->clip.w;
+    int clip_y1 = cmd->clip.y + cmd->clip.h > target->h ? target->h : cmd->clip.y + cmd->clip.h;
+    
+    SDL_Color color = cmd->color;
+    uint32_t pixel = pixel_map(app->fb_format, ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b);
+    const char* text = cmd->text;
+    int pen = cmd->rect.x;
+    uint32_t cp;
+    while ((cp = utf8_next(&text)) != 0) {
+        const glyph_pack_glyph_t* g = glyph_pack_find_glyph(&app->glyphs, size, cp);
+        if (!g) break;
+        const uint8_t* bitmap = glyph_pack_bitmap(&app->glyphs, g);
+        int gx = pen + g->left;
+        int x0 = gx < clip_x0 ? clip_x0 : gx;
+        int x1 = gx + g->width > clip_x1 ? clip_x1 : gx + g->width;
+        for (int row = 0; row < g->height && x0 < x1; row++) {
+            int dy = cmd->rect.y + size->ascent - g->top + row;
+            if (dy < clip_y0 || dy >= clip_y1) continue;
+            Uint8* dst = (Uint8*)target->pixels + dy * target->pitch + x0 * bytes;
+            blend_mask_row(app->fb_format, dst, pixel, bitmap + row * g->width + (x0 - gx), x1 - x0, color.a);
         }
+        pen += g->advance;
+    }
+}
+
+// 把目标区域裁剪到clip内，源区域跟着移动 (不缩放)。完全在clip外时返回0
+static int clip_blit(SDL_Rect* src, SDL_Rect* dst, const ui_rect_t* clip) {
+    ui_rect_t area = {dst->x, dst->y, dst->w, dst->h};
+    ui_rect_t visible;
+    if (!ui_rect_intersect(&area, clip, &visible)) {
+        return 0;
     }
-    if (!app->font_chinese) {
-        log_message("Warning: Cannot load Chinese font, using main font");
-        app->font_chinese = app->font; // 备用
+    src->x += visible.x - dst->x;
+    src->y += visible.y - dst->y;
+    src->w = visible.w;
+    src->h = visible.h;
+    dst->x = visible.x;
+    dst->y = visible.y;
+    dst->w = visible.w;
+    dst->h = visible.h;
+    return 1;
+}
+
+static SDL_Color rgb_color(uint32_t rgb) {
+    SDL_Color color = {(rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, 255};
+    return color;
+}
+
+// 帧缓冲模式的回退字体文字: 混合到影子表面，转换到面板格式只做一次
+static void draw_surface_native(void* context, const void* data) {
+    app_context_t* app = (app_context_t*)context;
+    const native_surface_t* cmd = (const native_surface_t*)data;
+    SDL_Rect src_rect = cmd->src;
+    SDL_Rect dst_rect = cmd->dst;
+    SDL_BlitSurface(cmd->surface, &src_rect, app->fb_surface, &dst_rect);
+    if (cmd->owned) {
+        SDL_FreeSurface(cmd->surface);
+    }
+}
+
+static void draw_surface(app_context_t* app, SDL_Surface* surface, const SDL_Rect* src,
+                         const SDL_Rect* dst, int owned) {
+    native_surface_t* cmd = render_batch_custom(&app->batch, dst, draw_surface_native, app, sizeof(*cmd));
+    if (!cmd) {
+        if (owned) SDL_FreeSurface(surface);
+        return;
+    }
+    cmd->surface = surface;
+    cmd->src = *src;
+    cmd->dst = *dst;
+    cmd->owned = owned;
+}
+
+// 帧缓冲模式的图片命令参数
+typedef struct {
+    const image_asset_t* image;  // 标题栏图标或本帧的缩略图
+    SDL_Rect rect;
+    ui_rect_t clip;
+} native_image_t;
+
+// 帧缓冲模式: 图片资源的像素已是面板格式，逐行复制或按透明度平面混合到影子表面。
+// 从重画区域的左上角开始、以它的大小作为目标，图片只写入重画区域
+static void draw_image_native(void* context, const void* data) {
+    app_context_t* app = (app_context_t*)context;
+    const native_image_t* cmd = (const native_image_t*)data;
+    SDL_Surface* target = app->fb_surface;
+    ui_rect_t bounds = {0, 0, target->w, target->h};
+    ui_rect_t clip;
+    if (!ui_rect_intersect(&cmd->clip, &bounds, &clip)) return;
+    Uint8* origin = (Uint8*)target->pixels + clip.y * target->pitch + clip.x * target->format->BytesPerPixel;
+    image_asset_blit(cmd->image, app->fb_format, origin, target->pitch, clip.w, clip.h,
+                     cmd->rect.x - clip.x, cmd->rect.y - clip.y, 255);
+}
+
+// 窗口模式: 不透明图片直接以原生格式上传，有透明度平面时转换为ARGB8888并填入alpha (只在启动时做一次)
+static SDL_Texture* create_image_texture(SDL_Renderer* renderer, const image_asset_t* image) {
+    Uint32 format = sdl_pixel_format(image->format);
+    if (!image->alpha) {
+        SDL_Texture* texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_STATIC,
+                                                 image->width, image->height);
+        if (texture && SDL_UpdateTexture(texture, NULL, image->pixels, image->header->pitch) < 0) {
+            SDL_DestroyTexture(texture);
+            texture = NULL;
+        }
+        return texture;
     }
     
-    log_message("SDL2 initialization successful");
-    return 0;
+    int pitch = image->width * 4;
+    Uint8* argb = malloc((size_t)pitch * image->height);
+    if (!argb) return NULL;
+    SDL_Texture* texture = NULL;
+    if (SDL_ConvertPixels(image->width, image->height, format, image->pixels, image->header->pitch,
+                          SDL_PIXELFORMAT_ARGB8888, argb, pitch) == 0) {
+        for (int y = 0; y < image->height; y++) {
+            Uint32* row = (Uint32*)(argb + (size_t)y * pitch);
+            const uint8_t* alpha = image_asset_alpha_row(image, y);
+            for (int x = 0; x < image->width; x++) {
+                row[x] = (row[x] & 0x00FFFFFF) | ((Uint32)alpha[x] << 24);
+            }
+        }
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                    image->width, image->height);
+        if (texture) {
+            SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+            if (SDL_UpdateTexture(texture, NULL, argb, pitch) < 0) {
+                SDL_DestroyTexture(texture);
+                texture = NULL;
+            }
+        }
+    }
+    free(argb);
+    return texture;
 }
 
-// 渲染文字
-void render_text(app_context_t* app, const char* text, int x, int y, SDL_Color color) {
-    if (!app->font || !text) return;
+// 映射标题栏图标，没有图片资源时不显示。帧缓冲模式要求资源格式与面板相同
+void load_images(app_context_t* app) {
+    static const char* const image_paths[] = {
+        "./ui-logo.rgi",
+        "/mnt/mmc/Roms/APPS/ui-logo.rgi",
+        NULL
+    };
+    int phase = perf_trace_begin("image mmap");
+    const char* path = NULL;
+    if (app->image_path) {
+        if (image_asset_open(&app->logo, app->image_path) == 0) path = app->image_path;
+    } else {
+        for (int i = 0; image_paths[i] && !path; i++) {
+            if (image_asset_open(&app->logo, image_paths[i]) == 0) path = image_paths[i];
+        }
+    }
+    perf_trace_end(phase);
+    if (!path) {
+        if (app->image_path) {
+            char error_msg[320];
+            sprintf(error_msg, "Cannot load image asset %s", app->image_path);
+            log_message(error_msg);
+        }
+        return;
+    }
     
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(app->font, text, color);
-    if (!surface) return;
+    if (app->framebuffer_mode && app->logo.format != app->fb_format) {
+        char error_msg[320];
+        sprintf(error_msg, "Image asset %s does not match the panel pixel format, convert it with image-asset-tool -f", path);
+        log_message(error_msg);
+        image_asset_close(&app->logo);
+        return;
+    }
+    if (!app->framebuffer_mode) {
+        app->logo_texture = create_image_texture(app->renderer, &app->logo);
+        if (!app->logo_texture) {
+            char error_msg[320];
+            sprintf(error_msg, "Image texture creation failed: %s", SDL_GetError());
+            log_message(error_msg);
+            image_asset_close(&app->logo);
+            return;
+        }
+    }
     
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(app->renderer, surface);
-    if (!texture) {
-        SDL_FreeSurface(surface);
+    char image_msg[320];
+    sprintf(image_msg, "Image asset: %s %dx%d%s", path, app->logo.width, app->logo.height,
+            app->logo.alpha ? " + alpha" : "");
+    log_message(image_msg);
+}
+
+// 登记指标 (共享内存打不开时改用私有内存，更新照常进行)
+void init_metrics(app_context_t* app) {
+    metrics_t* m = &app->metrics;
+    metrics_create(m, app->metrics_name);
+    app->m_frames = metrics_register(m, "frames", METRICS_COUNTER, "");
+    app->m_frame_us = metrics_register(m, "frame_time", METRICS_HISTOGRAM, "us");
+    app->m_present_us = metrics_register(m, "present_time", METRICS_HISTOGRAM, "us");
+    app->m_flip_bytes = metrics_register(m, "flip_bytes", METRICS_COUNTER, "B");
+    app->m_logic_steps = metrics_register(m, "logic_steps", METRICS_COUNTER, "");
+    app->m_events = metrics_register(m, "events", METRICS_COUNTER, "");
+    app->m_audio_callbacks = metrics_register(m, "audio_callbacks", METRICS_COUNTER, "");
+    app->m_fps = metrics_register(m, "fps", METRICS_GAUGE, "");
+    app->m_dropped_states = metrics_register(m, "dropped_states", METRICS_COUNTER, "");
+    app->m_thumb_requests = metrics_register(m, "thumb_requests", METRICS_COUNTER, "");
+    app->m_thumb_ram_hits = metrics_register(m, "thumb_ram_hits", METRICS_COUNTER, "");
+    app->m_thumb_disk_hits = metrics_register(m, "thumb_disk_hits", METRICS_COUNTER, "");
+    app->m_thumb_decodes = metrics_register(m, "thumb_decodes", METRICS_COUNTER, "");
+    app->m_audio_underruns = metrics_register(m, "audio_underruns", METRICS_COUNTER, "");
+    app->m_frame_spikes = metrics_register(m, "frame_spikes", METRICS_COUNTER, "");
+    app->m_cpu_khz = metrics_register(m, "cpu_freq", METRICS_GAUGE, "kHz");
+    app->m_cpu_max_khz = metrics_register(m, "cpu_max_freq", METRICS_GAUGE, "kHz");
+    app->m_temp_mc = metrics_register(m, "temperature", METRICS_GAUGE, "mC");
+    app->m_load = metrics_register(m, "cpu_load", METRICS_GAUGE, "permil");
+    app->m_battery = metrics_register(m, "battery", METRICS_GAUGE, "%");
+    
+    char metrics_msg[160];
+    snprintf(metrics_msg, sizeof(metrics_msg), "Metrics: %u entries in %s%s", metrics_count(m), m->name,
+             m->shared ? "" : " (shm unavailable, private memory)");
+    log_message(metrics_msg);
+}
+
+// 启动传感器采样 (找不到的节点显示为 "--")
+void init_sensors(app_context_t* app) {
+    if (app->sensor_interval <= 0) {
+        log_message("Sensors: disabled");
         return;
     }
+    if (sensors_start(&app->sensors, app->sensor_interval) < 0) {
+        log_message("Sensors: sampler thread creation failed");
+        return;
+    }
+    app->sensors_started = 1;
+    char nodes[192];
+    sensors_describe(&app->sensors, nodes, sizeof(nodes));
+    char sensor_msg[256];
+    snprintf(sensor_msg, sizeof(sensor_msg), "Sensors: every %d ms, %s", app->sensor_interval, nodes);
+    log_message(sensor_msg);
+}
+
+// 传感器采样格式化为一行 (HUD和掉帧日志共用)，未知的值显示为 "--"
+static void format_sensors(const sensors_sample_t* sample, char* text, size_t size) {
+    char freq[32] = "--", temp[16] = "--", load[16] = "--", battery[16] = "--";
+    if (sample && sample->cpu_khz != SENSORS_UNKNOWN) {
+        if (sample->cpu_max_khz != SENSORS_UNKNOWN) {
+            snprintf(freq, sizeof(freq), "%d/%d MHz", sample->cpu_khz / 1000, sample->cpu_max_khz / 1000);
+        } else {
+            snprintf(freq, sizeof(freq), "%d MHz", sample->cpu_khz / 1000);
+        }
+    }
+    if (sample && sample->temp_mc != SENSORS_NO_TEMP) {
+        snprintf(temp, sizeof(temp), "%.1f°C", sample->temp_mc / 1000.0);
+    }
+    if (sample && sample->load_permille != SENSORS_UNKNOWN) {
+        snprintf(load, sizeof(load), "%d%%", (sample->load_permille + 5) / 10);
+    }
+    if (sample && sample->battery_pct != SENSORS_UNKNOWN) {
+        snprintf(battery, sizeof(battery), "%d%%%s", sample->battery_pct, sample->charging ? "+" : "");
+    }
+    snprintf(text, size, "CPU: %s | Temp: %s | Load: %s | Battery: %s", freq, temp, load, battery);
+}
+
+// 封面缩略图缓存: 帧缓冲模式直接生成面板格式，窗口模式生成XRGB8888并准备一个预览区大小的流式纹理。
+// 失败时只是不显示封面
+void init_thumbs(app_context_t* app) {
+    thumb_cache_config_t config = {
+        .width = THUMB_WIDTH,
+        .height = THUMB_HEIGHT,
+        .format = app->framebuffer_mode ? app->fb_format : PIXEL_FORMAT_XRGB8888,
+        .background = PREVIEW_BACKGROUND,
+        .budget = THUMB_BUDGET,
+        .entries = THUMB_ENTRIES,
+        .workers = THUMB_WORKERS,
+        .disk_dir = app->thumb_dir,
+    };
+    if (!app->framebuffer_mode) {
+        app->preview_texture = SDL_CreateTexture(app->renderer, sdl_pixel_format(config.format),
+                                                 SDL_TEXTUREACCESS_STREAMING, THUMB_WIDTH, THUMB_HEIGHT);
+        if (!app->preview_texture) {
+            char error_msg[256];
+            sprintf(error_msg, "Preview texture creation failed: %s", SDL_GetError());
+            log_message(error_msg);
+            return;
+        }
+    }
+    if (thumb_cache_init(&app->thumbs, &config) < 0) {
+        log_message("Thumbnail cache creation failed");
+        return;
+    }
+    app->thumbs_ready = 1;
     
-    SDL_Rect dst_rect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(app->renderer, texture, NULL, &dst_rect);
+    char thumb_msg[THUMB_CACHE_MAX_PATH + 64];
+    snprintf(thumb_msg, sizeof(thumb_msg), "Thumbnails: %s -> %s (%dx%d, %d workers)", app->art_dir,
+             app->thumb_dir, THUMB_WIDTH, THUMB_HEIGHT, THUMB_WORKERS);
+    log_message(thumb_msg);
+}
+
+// 音频回调 (SDL的音频线程): 只混音，不加锁、不分配
+static void audio_callback(void* userdata, Uint8* stream, int len) {
+    app_context_t* app = (app_context_t*)userdata;
+    audio_mixer_render(&app->mixer, (int16_t*)stream, len / 4);
+    metrics_add(app->m_audio_callbacks, 1);
+}
+
+// 打开音频设备 (16位立体声，采样率和缓冲帧数可以由设备调整)，按实际的采样率合成界面音效。
+// 主机上可以用 SDL_AUDIODRIVER=dummy 或 disk 测试。失败时只是没有声音
+void init_audio(app_context_t* app) {
+    int phase = perf_trace_begin("audio open");
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        char error_msg[256];
+        sprintf(error_msg, "Audio initialization failed: %s", SDL_GetError());
+        log_message(error_msg);
+        perf_trace_end(phase);
+        return;
+    }
+    SDL_AudioSpec want, have;
+    memset(&want, 0, sizeof(want));
+    want.freq = AUDIO_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 2;
+    want.samples = app->audio_buffer;
+    want.callback = audio_callback;
+    want.userdata = app;
+    int allowed = SDL_AUDIO_ALLOW_FREQUENCY_CHANGE;
+#ifdef SDL_AUDIO_ALLOW_SAMPLES_CHANGE
+    allowed |= SDL_AUDIO_ALLOW_SAMPLES_CHANGE;   // SDL 2.0.9以上
+#endif
+    SDL_AudioDeviceID device = SDL_OpenAudioDevice(NULL, 0, &want, &have, allowed);
+    perf_trace_end(phase);
+    if (device == 0) {
+        char error_msg[256];
+        sprintf(error_msg, "Audio device open failed: %s", SDL_GetError());
+        log_message(error_msg);
+        return;
+    }
     
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    if (audio_mixer_init(&app->mixer, have.freq, AUDIO_VOICES, have.samples) < 0 ||
+        audio_sound_tone(&app->sound_move, have.freq, 1800, 1800, 15, 96) < 0 ||
+        audio_sound_tone(&app->sound_page, have.freq, 1200, 1600, 30, 112) < 0 ||
+        audio_sound_tone(&app->sound_open, have.freq, 660, 990, 70, 128) < 0 ||
+        audio_sound_tone(&app->sound_close, have.freq, 990, 660, 70, 128) < 0 ||
+        audio_sound_tone(&app->sound_key, have.freq, 1000, 1000, 25, 96) < 0) {
+        log_message("Audio mixer allocation failed");
+        SDL_CloseAudioDevice(device);
+        audio_mixer_destroy(&app->mixer);   // 没有设备时cleanup不会销毁混音器 (已经生成的音效由cleanup释放)
+        return;
+    }
+    if (app->music_path && audio_sound_load_wav(&app->music, app->music_path, have.freq) < 0) {
+        char error_msg[320];
+        sprintf(error_msg, "Cannot load music %s (16/8-bit PCM WAV only)", app->music_path);
+        log_message(error_msg);
+    }
+    app->audio_device = device;
+    if (app->music.frames > 0) {
+        audio_mixer_play(&app->mixer, &app->music, AUDIO_MUSIC_VOLUME, 0, 1);
+    }
+    SDL_PauseAudioDevice(device, 0);
+    
+    char audio_msg[256];
+    sprintf(audio_msg, "Audio: %s, %d Hz, %d frames (%.1f ms)%s", SDL_GetCurrentAudioDriver(), have.freq,
+            have.samples, have.samples * 1000.0 / have.freq, app->music.frames > 0 ? ", music" : "");
+    log_message(audio_msg);
+}
+
+// 界面音效 (逻辑线程)
+static void play_sound(app_context_t* app, const audio_sound_t* sound) {
+    if (app->audio_device) {
+        audio_mixer_play(&app->mixer, sound, AUDIO_VOLUME_MAX, 0, 0);
+    }
+}
+
+// 标题栏右侧的图标 (界面树中的自定义节点)
+static void render_logo(app_context_t* app, const ui_rect_t* area, const ui_rect_t* clip) {
+    if (!app->logo.data) return;
+    SDL_Rect rect = {area->x, area->y, app->logo.width, app->logo.height};
+    if (app->framebuffer_mode) {
+        SDL_Rect dst = {clip->x, clip->y, clip->w, clip->h};
+        native_image_t* cmd = render_batch_custom(&app->batch, &dst, draw_image_native, app, sizeof(*cmd));
+        if (cmd) {
+            cmd->image = &app->logo;
+            cmd->rect = rect;
+            cmd->clip = *clip;
+        }
+    } else {
+        SDL_Color white = {255, 255, 255, 255};
+        SDL_Rect src = {0, 0, app->logo.width, app->logo.height};
+        if (clip_blit(&src, &rect, clip)) {
+            render_batch_copy(&app->batch, app->logo_texture, &src, &rect, white, 0);
+        }
+    }
+}
+
+// ROM浏览界面右侧的封面预览: 缩略图居中，没有封面或还没准备好时只画背景
+static void render_preview(app_context_t* app, const ui_rect_t* area, const ui_rect_t* clip) {
+    SDL_Rect background = {clip->x, clip->y, clip->w, clip->h};
+    render_batch_fill(&app->batch, &background, rgb_color(PREVIEW_BACKGROUND));
+    const image_asset_t* image = app->preview_image;
+    if (!image) return;
+    SDL_Rect rect = {area->x + (area->w - image->width) / 2, area->y + PREVIEW_PADDING + (THUMB_HEIGHT - image->height) / 2,
+                     image->width, image->height};
+    if (app->framebuffer_mode) {
+        SDL_Rect src = {0, 0, image->width, image->height};
+        SDL_Rect dst = rect;
+        if (!clip_blit(&src, &dst, clip)) return;
+        native_image_t* cmd = render_batch_custom(&app->batch, &dst, draw_image_native, app, sizeof(*cmd));
+        if (cmd) {
+            ui_rect_t visible = {dst.x, dst.y, dst.w, dst.h};
+            cmd->image = image;
+            cmd->rect = rect;
+            cmd->clip = visible;
+        }
+    } else {
+        SDL_Color white = {255, 255, 255, 255};
+        SDL_Rect src = {0, 0, image->width, image->height};
+        if (clip_blit(&src, &rect, clip)) {
+            render_batch_copy(&app->batch, app->preview_texture, &src, &rect, white, 0);
+        }
+    }
 }
 
-// 渲染小文字
-void render_text_small(app_context_t* app, const char* text, int x, int y, SDL_Color color) {
-    if (!app->font_small || !text) return;
+// 帧缓冲模式用字形包直接绘制文字，字号或任一字符不在包中时返回-1
+static int render_text_native(app_context_t* app, int ptsize, const char* text, int x, int y, SDL_Color color,
+                              const ui_rect_t* clip) {
+    const glyph_pack_size_t* size = glyph_pack_find_size(&app->glyphs, ptsize);
+    if (!size) return -1;
+    
+    int width = glyph_pack_measure(&app->glyphs, size, text);
+    int height = size->ascent - size->descent;
+    if (width <= 0 || height <= 0) return -1;
+    
+    ui_rect_t area = {x, y, width, height};
+    ui_rect_t visible;
+    if (!ui_rect_intersect(&area, clip, &visible)) return 0;
+    
+    size_t len = strlen(text);
+    SDL_Rect rect = {x, y, width, height};
+    SDL_Rect dirty = {visible.x, visible.y, visible.w, visible.h};
+    native_text_t* cmd = render_batch_custom(&app->batch, &dirty, draw_text_native, app,
+                                             offsetof(native_text_t, text) + len + 1);
+    if (!cmd) return 0;
+    cmd->size = size;
+    cmd->rect = rect;
+    cmd->clip = dirty;
+    cmd->color = color;
+    memcpy(cmd->text, text, len + 1);
+    return 0;
+}
+
+// 用指定字号渲染文字，只画在clip内 (优先使用字形包，缺字时回退到完整字体)
+static void render_text_font(app_context_t* app, int ptsize, const char* text, int x, int y, SDL_Color color,
+                             const ui_rect_t* clip) {
+    if (!text) return;
+    if (app->framebuffer_mode && render_text_native(app, ptsize, text, x, y, color, clip) == 0) return;
     
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(app->font_small, text, color);
+    // 文字池中的纹理 (帧缓冲模式为回退字体的表面) 在字符串不变时直接复用
+    SDL_Color white = {255, 255, 255, 255};
+    const text_slot_t* slot = text_pool_get(&app->text_pool, ptsize, text, color);
+    if (slot) {
+        SDL_Rect src_rect = {0, slot->y, slot->w, slot->h};
+        SDL_Rect dst_rect = {x, y, slot->w, slot->h};
+        if (!clip_blit(&src_rect, &dst_rect, clip)) return;
+        if (app->framebuffer_mode) {
+            draw_surface(app, app->text_pool.surface, &src_rect, &dst_rect, 0);
+        } else {
+            render_batch_copy(&app->batch, app->text_pool.texture, &src_rect, &dst_rect, white, 0);
+        }
+        return;
+    }
+    
+    // 文字池放不下 (字符串过长或本帧槽位已用完): 临时渲染，提交后释放
+    TTF_Font* font = font_cache_get(&app->fonts, ptsize);
+    if (!font) return;
+    
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text, color);
     if (!surface) return;
     
+    SDL_Rect src_rect = {0, 0, surface->w, surface->h};
+    SDL_Rect dst_rect = {x, y, surface->w, surface->h};
+    if (!clip_blit(&src_rect, &dst_rect, clip)) {
+        SDL_FreeSurface(surface);
+        return;
+    }
+    
+    if (app->framebuffer_mode) {
+        draw_surface(app, surface, &src_rect, &dst_rect, 1);
+        return;
+    }
+    
     SDL_Texture* texture = SDL_CreateTextureFromSurface(app->renderer, surface);
     if (!texture) {
         SDL_FreeSurface(surface);
         return;
     }
     
-    SDL_Rect dst_rect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(app->renderer, texture, NULL, &dst_rect);
-    
+    render_batch_copy(&app->batch, texture, &src_rect, &dst_rect, white, 1);
     SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
 }
 
-// 渲染中文文字
-void render_chinese_text(app_context_t* app, const char* text, int x, int y, SDL_Color color) {
-    TTF_Font* font = app->font_chinese ? app->font_chinese : app->font;
-    if (!font || !text) return;
+// 每秒一次: 各模块自己统计的总数复制到指标表 (读它们的统计可能加锁，不放在每帧)
+static void publish_metrics(app_context_t* app) {
+    metrics_set(app->m_fps, (int64_t)(app->fps + 0.5f));
+    if (app->sensor) {
+        metrics_set(app->m_cpu_khz, app->sensor->cpu_khz);
+        metrics_set(app->m_cpu_max_khz, app->sensor->cpu_max_khz);
+        metrics_set(app->m_temp_mc, app->sensor->temp_mc);
+        metrics_set(app->m_load, app->sensor->load_permille);
+        metrics_set(app->m_battery, app->sensor->battery_pct);
+    }
+    triple_buffer_stats_t handoff;
+    triple_buffer_get_stats(&app->states, &handoff);
+    metrics_set(app->m_dropped_states, (int64_t)handoff.dropped);
+    if (app->thumbs_ready) {
+        thumb_cache_stats_t thumb_stats;
+        thumb_cache_get_stats(&app->thumbs, &thumb_stats);
+        metrics_set(app->m_thumb_requests, thumb_stats.requests);
+        metrics_set(app->m_thumb_ram_hits, thumb_stats.ram_hits);
+        metrics_set(app->m_thumb_disk_hits, thumb_stats.disk_hits);
+        metrics_set(app->m_thumb_decodes, thumb_stats.decodes);
+    }
+    if (app->audio_device) {
+        audio_mixer_stats_t audio_stats;
+        audio_mixer_get_stats(&app->mixer, &audio_stats);
+        metrics_set(app->m_audio_underruns, (int64_t)audio_stats.underruns);
+    }
+}
+
+// 呈现一帧: 帧缓冲模式下把影子表面复制到显存并翻页，dirty不为NULL时只复制变化的行
+void present_frame(app_context_t* app, const ui_rect_t* dirty) {
+    Uint64 start = SDL_GetPerformanceCounter();
     
-    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text, color);
-    if (!surface) return;
+    SDL_RenderPresent(app->renderer);
+    if (app->framebuffer_mode) {
+        // 基准测试不等待垂直同步
+        int y0 = dirty ? dirty->y : 0;
+        int y1 = dirty ? dirty->y + dirty->h : app->fb.height;   // 影子表面与帧缓冲同样大小
+        int result = fb_present_frame_rows(&app->fb, app->fb_surface->pixels, app->fb_surface->pitch,
+                                           y0, y1, !app->bench_frames);
+        app->fb_synced = (result == 1);
+        metrics_add(app->m_flip_bytes, app->fb.copied_bytes);
+    }
     
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(app->renderer, surface);
-    if (!texture) {
-        SDL_FreeSurface(surface);
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+    app->present_ms += elapsed * 1000.0 / SDL_GetPerformanceFrequency();
+    metrics_observe(app->m_present_us, elapsed * 1000000 / SDL_GetPerformanceFrequency());
+    
+    // 每秒更新一次HUD上的帧率
+    Uint32 now = SDL_GetTicks();
+    app->fps_frames++;
+    if (now - app->fps_tick >= 1000) {
+        app->fps = app->fps_frames * 1000.0f / (now - app->fps_tick);
+        app->fps_frames = 0;
+        app->fps_tick = now;
+        publish_metrics(app);
+    }
+}
+
+// 启动画面: 字体就绪前只绘制不需要文字的图形
+void render_splash(app_context_t* app) {
+    render_batch_begin(&app->batch);
+    
+    SDL_Color black = {0, 0, 0, 255};
+    render_batch_clear(&app->batch, black);
+    
+    SDL_Color navy = {0, 0, 128, 255};
+    SDL_Rect title_bar = {0, 0, SCREEN_WIDTH, 40};
+    render_batch_fill(&app->batch, &title_bar, navy);
+    
+    // 来回移动的加载条
+    int track_w = SCREEN_WIDTH / 2;
+    int bar_w = track_w / 4;
+    int travel = track_w - bar_w;
+    int pos = (app->frame_count * 8) % (travel * 2);
+    if (pos > travel) pos = travel * 2 - pos;
+    
+    SDL_Color gray = {32, 32, 32, 255};
+    SDL_Rect track = {(SCREEN_WIDTH - track_w) / 2, SCREEN_HEIGHT / 2 - 4, track_w, 8};
+    render_batch_fill(&app->batch, &track, gray);
+    SDL_Color orange = {255, 165, 0, 255};
+    SDL_Rect bar = {track.x + pos, track.y, bar_w, 8};
+    render_batch_fill(&app->batch, &bar, orange);
+    
+    render_batch_flush(&app->batch);
+    present_frame(app, NULL);
+}
+
+// 参与格式化的值与上次相同时返回0，否则记下新值并返回1
+static int text_changed(cached_text_t* cache, const int* key, int count) {
+    if (cache->valid && memcmp(cache->key, key, count * sizeof(int)) == 0) {
+        return 0;
+    }
+    memcpy(cache->key, key, count * sizeof(int));
+    cache->valid = 1;
+    return 1;
+}
+
+// 按显示精度 (一位小数) 取整，避免显示不变时重新格式化
+static int round_tenths(float value) {
+    return (int)(value * 10.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+// 排版的字符宽度: 字形包有这个字时用包里的步进，否则用完整字体
+static int text_advance(void* context, int font, uint32_t cp) {
+    app_context_t* app = (app_context_t*)context;
+    const glyph_pack_size_t* size = glyph_pack_find_size(&app->glyphs, font);
+    const glyph_pack_glyph_t* glyph = size ? glyph_pack_find_glyph(&app->glyphs, size, cp) : NULL;
+    if (glyph) {
+        return glyph->advance;
+    }
+    return font_cache_advance(&app->fonts, font, cp);
+}
+
+static int text_line_height(void* context, int font) {
+    app_context_t* app = (app_context_t*)context;
+    const glyph_pack_size_t* size = glyph_pack_find_size(&app->glyphs, font);
+    if (size) {
+        return size->ascent - size->descent;
+    }
+    TTF_Font* ttf = font_cache_get(&app->fonts, font);
+    return ttf ? TTF_FontHeight(ttf) : font;
+}
+
+// 标签的排版: 测量和绘制使用同一份缓存的结果
+static const text_layout_t* label_layout(app_context_t* app, const ui_node_t* node, int max_width) {
+    return text_layout_get(&app->layout, node->text, node->font, max_width, max_width > 0 ? node->max_lines : 0);
+}
+
+// 界面树的测量回调: 按字符步进折行，文字和宽度不变时命中排版缓存
+static void measure_text(void* context, const ui_node_t* node, int max_width, int* w, int* h) {
+    const text_layout_t* layout = label_layout((app_context_t*)context, node, max_width);
+    *w = layout->width;
+    *h = layout->height;
+}
+
+// 精灵层: 画出与重画区域相交的精灵
+static void paint_sprites(app_context_t* app, const ui_rect_t* clip) {
+    const ui_state_t* state = app->paint_state;
+    for (int i = 0; i < state->sprite_count; i++) {
+        const ui_sprite_t* sprite = &state->sprites[i];
+        ui_rect_t area = {sprite->x, sprite->y, sprite->w, sprite->h};
+        ui_rect_t visible;
+        if (ui_rect_intersect(&area, clip, &visible)) {
+            SDL_Rect rect = {visible.x, visible.y, visible.w, visible.h};
+            render_batch_fill(&app->batch, &rect, rgb_color(sprite->color));
+        }
+    }
+}
+
+// 列表的文字来源 (渲染线程调用，扫描中的条目由索引加锁保护)
+static int rom_text(void* context, int index, char* text, int size) {
+    app_context_t* app = (app_context_t*)context;
+    if (app->synthetic_count > 0) {
+        static const char* const titles[] = {
+            "Super Mario World", "塞尔达传说 众神的三角力量", "ファイナルファンタジーVI",
+            "Street Fighter II' Turbo", "슈퍼 메트로이드", "Chrono Trigger",
+        };
+        snprintf(text, size, "%06d  %s (Rev %d).zip", index + 1, titles[index % 6], index % 3);
+        return 0;
+    }
+    return rom_index_text(&app->roms, index, text, size);
+}
+
+// 快照中的滚动位置对应的可见范围
+static void list_visible_rows(const ui_state_t* state, int* first, int* last) {
+    list_view_t view;
+    list_view_init(&view, state->list_count, LIST_ROW_HEIGHT, LIST_ROW_HEIGHT * LIST_VISIBLE_ROWS);
+    view.scroll = state->list_scroll;
+    list_view_visible(&view, first, last);
+}
+
+// 列表: 只画与重画区域相交的可见行，文字来自行缓存，超出宽度时截短
+static void paint_list(app_context_t* app, const ui_node_t* node, const ui_rect_t* clip) {
+    const ui_state_t* state = app->paint_state;
+    SDL_Rect background = {clip->x, clip->y, clip->w, clip->h};
+    render_batch_fill(&app->batch, &background, rgb_color(0x101010));
+    
+    int first, last;
+    list_visible_rows(state, &first, &last);
+    for (int i = first; i <= last; i++) {
+        ui_rect_t row = {node->rect.x, node->rect.y + i * LIST_ROW_HEIGHT - state->list_scroll,
+                         node->rect.w, LIST_ROW_HEIGHT};
+        ui_rect_t visible;
+        if (!ui_rect_intersect(&row, clip, &visible)) continue;
+        
+        int selected = i == state->list_selected;
+        if (selected || (i & 1)) {
+            SDL_Rect rect = {visible.x, visible.y, visible.w, visible.h};
+            render_batch_fill(&app->batch, &rect, rgb_color(selected ? 0x3060C0 : 0x181818));
+        }
+        const char* text = list_rows_text(&app->list_rows, i);
+        if (!text || !text[0]) continue;
+        const text_layout_t* layout = text_layout_get(&app->layout, text, FONT_SIZE_MAIN, row.w - 20, 1);
+        if (layout->line_count == 0) continue;
+        render_text_font(app, FONT_SIZE_MAIN, layout->lines[0].text, row.x + 10,
+                         row.y + (LIST_ROW_HEIGHT - layout->line_height) / 2,
+                         rgb_color(selected ? COLOR_WHITE : 0xC0C0C0), &visible);
+    }
+}
+
+// 界面树的绘制回调: 记录为命令，由命令缓冲合并提交
+static void paint_ui_node(void* context, const ui_node_t* node, const ui_rect_t* clip) {
+    app_context_t* app = (app_context_t*)context;
+    switch (node->type) {
+        case UI_NODE_PANEL:
+            if (node->has_background) {
+                SDL_Rect rect = {clip->x, clip->y, clip->w, clip->h};
+                render_batch_fill(&app->batch, &rect, rgb_color(node->background));
+            }
+            break;
+        case UI_NODE_LABEL: {
+            const text_layout_t* layout = label_layout(app, node, node->max_lines > 0 ? node->wrap_width : 0);
+            int x = node->rect.x + node->padding_x;
+            int y = node->rect.y + node->padding_y;
+            for (int i = 0; i < layout->line_count; i++, y += layout->line_height) {
+                render_text_font(app, node->font, layout->lines[i].text, x, y, rgb_color(node->color), clip);
+            }
+            break;
+        }
+        case UI_NODE_CUSTOM:
+            if (node->id == UI_ID_LOGO) {
+                render_logo(app, &node->rect, clip);
+            } else if (node->id == UI_ID_SPRITES) {
+                paint_sprites(app, clip);
+            } else if (node->id == UI_ID_LIST) {
+                paint_list(app, node, clip);
+            } else if (node->id == UI_ID_PREVIEW) {
+                render_preview(app, &node->rect, clip);
+            }
+            break;
+    }
+}
+
+static ui_node_t* add_section(app_context_t* app, ui_node_t* parent, int height, uint32_t background) {
+    ui_node_t* panel = ui_tree_add_panel(&app->ui, parent, UI_VERTICAL, UI_SIZE_FILL, height);
+    ui_node_set_background(panel, background);
+    panel->padding_x = 10;
+    panel->padding_y = 6;
+    panel->spacing = 2;
+    return panel;
+}
+
+// 建立界面树: 从上到下依次为标题栏、输入信息、按键状态、动画演示和底栏，精灵层盖在最上面；
+// ROM浏览界面与它们叠放，默认隐藏
+int build_ui(app_context_t* app) {
+    text_metrics_t metrics = {text_advance, text_line_height, app};
+    if (text_layout_init(&app->layout, TEXT_LAYOUT_CACHE_SIZE, &metrics) < 0) {
+        return -1;
+    }
+    if (ui_tree_init(&app->ui, UI_MAX_NODES, SCREEN_WIDTH, SCREEN_HEIGHT, measure_text, app) < 0) {
+        return -1;
+    }
+    ui_tree_t* ui = &app->ui;
+    ui_node_t* root = ui->root;
+    root->direction = UI_OVERLAY;
+    ui_node_set_background(root, COLOR_BLACK);
+    
+    ui_node_t* screen = ui_tree_add_panel(ui, root, UI_VERTICAL, UI_SIZE_FILL, UI_SIZE_FILL);
+    screen->spacing = 10;
+    app->screen_panel = screen;
+    
+    // 标题栏: 系统信息在左，图标在右
+    ui_node_t* title = ui_tree_add_panel(ui, screen, UI_HORIZONTAL, UI_SIZE_FILL, 40);
+    ui_node_set_background(title, 0x000080);
+    title->padding_x = 10;
+    title->padding_y = 3;
+    ui_node_t* info = ui_tree_add_panel(ui, title, UI_VERTICAL, UI_SIZE_FILL, UI_SIZE_FILL);
+    // 系统信息可能比标题栏长，超出时截短加省略号
+    ui_node_t* system = ui_tree_add_label(ui, info, FONT_SIZE_SMALL, COLOR_WHITE, app->system_info);
+    ui_label_set_max_lines(system, 1);
+    ui_node_t* device = ui_tree_add_label(ui, info, FONT_SIZE_SMALL, COLOR_WHITE, app->device_info);
+    ui_label_set_max_lines(device, 1);
+    ui_tree_add_custom(ui, title, UI_ID_LOGO, app->logo.width, app->logo.height);
+    
+    ui_node_t* input = add_section(app, screen, 80, 0x004040);
+    ui_tree_add_label(ui, input, FONT_SIZE_MAIN, COLOR_YELLOW, "=== Input Monitoring ===");
+    app->input_label = ui_tree_add_label(ui, input, FONT_SIZE_SMALL, COLOR_WHITE, app->input_info);
+    ui_label_set_max_lines(app->input_label, 1);
+    app->last_key_label = ui_tree_add_label(ui, input, FONT_SIZE_SMALL, COLOR_WHITE, app->last_key_info);
+    ui_label_set_max_lines(app->last_key_label, 1);
+    
+    ui_node_t* status = add_section(app, screen, 60, 0x008000);
+    ui_tree_add_label(ui, status, FONT_SIZE_MAIN, COLOR_GREEN, "=== Key Status ===");
+    app->time_label = ui_tree_add_label(ui, status, FONT_SIZE_SMALL, COLOR_WHITE, "");
+    
+    // 动画演示占满中间剩余的高度
+    ui_node_t* animation = add_section(app, screen, UI_SIZE_FILL, 0x202020);
+    ui_tree_add_label(ui, animation, FONT_SIZE_MAIN, 0xFF00FF, "=== Animation Demo ===");
+    app->box_label = ui_tree_add_label(ui, animation, FONT_SIZE_SMALL, COLOR_WHITE, "");
+    ui_tree_add_label(ui, animation, FONT_SIZE_CHINESE, 0xFFA500, "中文测试：方块动画演示");
+    ui_tree_add_label(ui, animation, FONT_SIZE_CHINESE, 0xFFA500, "繁體中文：方塊動畫演示");
+    ui_tree_add_label(ui, animation, FONT_SIZE_CHINESE, 0xFFA500, "日本語：ブロックアニメーション");
+    ui_tree_add_label(ui, animation, FONT_SIZE_CHINESE, 0xFFA500, "한국어：블록 애니메이션");
+    ui_tree_add_label(ui, animation, FONT_SIZE_CHINESE, 0xFFA500, "按任意键测试输入 | ESC退出程序");
+    ui_tree_add_label(ui, animation, FONT_SIZE_SMALL, 0x00FFFF,
+                      "Press any key to test | ESC to exit | F1 to switch input");
+    app->hud_label = ui_tree_add_label(ui, animation, FONT_SIZE_SMALL, 0xA0A0A0, "");
+    app->sensor_label = ui_tree_add_label(ui, animation, FONT_SIZE_SMALL, 0xA0A0A0, "");
+    
+    ui_node_t* bottom = add_section(app, screen, 40, 0x800080);
+    bottom->padding_y = 10;
+    ui_tree_add_label(ui, bottom, FONT_SIZE_SMALL, COLOR_WHITE, "RG34XX SDL2 Multi-Input Test v1.0 | 中文支持");
+    
+    app->sprites_node = ui_tree_add_custom(ui, root, UI_ID_SPRITES, UI_SIZE_FILL, UI_SIZE_FILL);
+    
+    // ROM浏览: 标题 (目录、位置和帧率)、列表和右侧的封面预览、按键提示
+    ui_node_t* browser = ui_tree_add_panel(ui, root, UI_VERTICAL, UI_SIZE_FILL, UI_SIZE_FILL);
+    ui_node_set_hidden(browser, 1);
+    app->browser_panel = browser;
+    ui_node_t* header = add_section(app, browser, 40, 0x000080);
+    header->padding_y = 10;
+    app->browser_label = ui_tree_add_label(ui, header, FONT_SIZE_SMALL, COLOR_WHITE, "");
+    ui_label_set_max_lines(app->browser_label, 1);
+    ui_node_t* content = ui_tree_add_panel(ui, browser, UI_HORIZONTAL, UI_SIZE_FILL, LIST_ROW_HEIGHT * LIST_VISIBLE_ROWS);
+    app->list_node = ui_tree_add_custom(ui, content, UI_ID_LIST, UI_SIZE_FILL, UI_SIZE_FILL);
+    app->preview_node = ui_tree_add_custom(ui, content, UI_ID_PREVIEW, THUMB_WIDTH + PREVIEW_PADDING * 2, UI_SIZE_FILL);
+    ui_node_t* footer = add_section(app, browser, UI_SIZE_FILL, 0x800080);
+    ui_node_t* hint = ui_tree_add_label(ui, footer, FONT_SIZE_SMALL, COLOR_WHITE,
+                                        "UP/DOWN: Scroll (hold to speed up) | L1/R1 LEFT/RIGHT: Page | SELECT/TAB: Back");
+    ui_label_set_max_lines(hint, 1);
+    if (list_rows_init(&app->list_rows, LIST_VISIBLE_ROWS, LIST_OVERSCAN, rom_text, app) < 0) {
+        return -1;
+    }
+    
+    app->drawn_sprites = calloc(app->sprites.count, sizeof(ui_sprite_t));
+    return app->drawn_sprites ? 0 : -1;
+}
+
+// 精灵移动后新旧位置都要重画。精灵多时散落在整个屏幕上，直接重画它们的外接矩形
+static void damage_sprites(app_context_t* app, const ui_state_t* state) {
+    int count = state->sprite_count;
+    int merge = count > UI_MAX_DAMAGE / 2;
+    ui_rect_t all = {0, 0, 0, 0};
+    for (int i = 0; i < count; i++) {
+        const ui_sprite_t* now = &state->sprites[i];
+        ui_sprite_t* drawn = &app->drawn_sprites[i];
+        if (i < app->drawn_count && memcmp(now, drawn, sizeof(*now)) == 0) continue;
+        
+        ui_rect_t area = {now->x, now->y, now->w, now->h};
+        if (i < app->drawn_count) {
+            int x0 = drawn->x < now->x ? drawn->x : now->x;
+            int y0 = drawn->y < now->y ? drawn->y : now->y;
+            int x1 = drawn->x + drawn->w > now->x + now->w ? drawn->x + drawn->w : now->x + now->w;
+            int y1 = drawn->y + drawn->h > now->y + now->h ? drawn->y + drawn->h : now->y + now->h;
+            area.x = x0;
+            area.y = y0;
+            area.w = x1 - x0;
+            area.h = y1 - y0;
+        }
+        *drawn = *now;
+        if (!merge) {
+            ui_tree_damage(&app->ui, &area);
+        } else if (all.w == 0) {
+            all = area;
+        } else {
+            int x1 = all.x + all.w > area.x + area.w ? all.x + all.w : area.x + area.w;
+            int y1 = all.y + all.h > area.y + area.h ? all.y + all.h : area.y + area.h;
+            all.x = all.x < area.x ? all.x : area.x;
+            all.y = all.y < area.y ? all.y : area.y;
+            all.w = x1 - all.x;
+            all.h = y1 - all.y;
+        }
+    }
+    if (merge && all.w > 0) {
+        ui_tree_damage(&app->ui, &all);
+    }
+    app->drawn_count = count;
+}
+
+// 第index行的封面缩略图: 把 "SYS/名字.zip" 换成 封面目录/SYS/名字.bmp 后请求 (只有行缓存中的行有文字)。
+// fetch为0时只预取
+static const image_asset_t* request_thumb(app_context_t* app, int index, int fetch) {
+    const char* text = list_rows_text(&app->list_rows, index);
+    if (!text || !text[0]) return NULL;
+    const char* dot = strrchr(text, '.');
+    const char* slash = strrchr(text, '/');
+    int stem = dot && (!slash || dot > slash) ? (int)(dot - text) : (int)strlen(text);
+    int len = snprintf(app->thumb_path, sizeof(app->thumb_path), "%s/%.*s.bmp", app->art_dir, stem, text);
+    if (len < 0 || len >= (int)sizeof(app->thumb_path)) return NULL;
+    if (!fetch) {
+        thumb_cache_prefetch(&app->thumbs, app->thumb_path);
+        return NULL;
+    }
+    return thumb_cache_get(&app->thumbs, app->thumb_path);
+}
+
+// 预览区: 选中条目和它的缩略图都没变时不重画。附近的条目先预取，选中的最后请求，在队列中最先处理。
+// 窗口模式下缩略图变化时复制到流式纹理 (纹理启动时已创建，这里不分配)
+static void update_preview(app_context_t* app, const ui_state_t* state) {
+    const image_asset_t* image = NULL;
+    if (app->thumbs_ready && app->synthetic_count <= 0 && state->list_count > 0) {
+        for (int d = THUMB_PREFETCH; d >= 1; d--) {
+            if (state->list_selected + d < state->list_count) request_thumb(app, state->list_selected + d, 0);
+            if (state->list_selected - d >= 0) request_thumb(app, state->list_selected - d, 0);
+        }
+        image = request_thumb(app, state->list_selected, 1);
+    }
+    if (image == app->preview_image && state->list_selected == app->preview_selected &&
+        state->list_generation == app->preview_generation) {
         return;
     }
+    app->preview_image = image;
+    app->preview_selected = state->list_selected;
+    app->preview_generation = state->list_generation;
+    if (image && app->preview_texture) {
+        SDL_Rect rect = {0, 0, image->width, image->height};
+        if (SDL_UpdateTexture(app->preview_texture, &rect, image->pixels, image->header->pitch) < 0) {
+            app->preview_image = NULL;
+        }
+    }
+    ui_node_invalidate(app->preview_node, UI_DIRTY_PAINT);
+}
+
+// ROM浏览界面: 标题在选中行、条目数、扫描状态或帧率变化时更新，列表在滚动、选中行或条目变化时重画
+static void update_browser(app_context_t* app, const ui_state_t* state) {
+    int browser_key[4] = {state->list_selected, state->list_count, state->list_scanning, round_tenths(app->fps)};
+    if (text_changed(&app->browser_text, browser_key, 4)) {
+        snprintf(app->browser_text.text, sizeof(app->browser_text.text), "%s%s | %d / %d | FPS: %.1f",
+                 app->synthetic_count > 0 ? "Generated list" : app->roms_dir, state->list_scanning ? " (scanning)" : "",
+                 state->list_count > 0 ? state->list_selected + 1 : 0, state->list_count, browser_key[3] / 10.0);
+        ui_label_set_text(app->browser_label, app->browser_text.text);
+    }
     
-    SDL_Rect dst_rect = {x, y, surface->w, surface->h};
-    SDL_RenderCopy(app->renderer, texture, NULL, &dst_rect);
+    // 扫描完成后条目重新排序，缓存的行文字全部作废
+    if (state->list_generation != app->drawn_generation) {
+        list_rows_invalidate(&app->list_rows);
+        app->drawn_generation = state->list_generation;
+    }
     
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    // 只准备可见行和上下几行的文字，开销与条目总数无关
+    int first, last;
+    list_visible_rows(state, &first, &last);
+    int fetched = list_rows_update(&app->list_rows, first, last, state->list_count);
+    if (fetched > 0 || state->list_selected != app->drawn_selected || state->list_scroll != app->drawn_scroll ||
+        state->list_count != app->drawn_list_count) {
+        ui_node_invalidate(app->list_node, UI_DIRTY_PAINT);
+        app->drawn_selected = state->list_selected;
+        app->drawn_scroll = state->list_scroll;
+        app->drawn_list_count = state->list_count;
+    }
+    update_preview(app, state);
 }
 
-// 渲染界面
-void render_ui(app_context_t* app) {
-    // 清屏
-    SDL_SetRenderDrawColor(app->renderer, 0, 0, 0, 255);
-    SDL_RenderClear(app->renderer);
+// 渲染界面: 把快照中变化的内容更新到界面树，只重画变化的区域
+void render_ui(app_context_t* app, const ui_state_t* state) {
+    render_batch_begin(&app->batch);
+    text_pool_begin_frame(&app->text_pool);
+    if (app->thumbs_ready) {
+        thumb_cache_begin_frame(&app->thumbs);   // 上一帧的缩略图可以被替换了，preview_image在本帧重新请求
+    }
     
-    // 绘制标题栏
-    SDL_SetRenderDrawColor(app->renderer, 0, 0, 128, 255);
-    SDL_Rect title_bar = {0, 0, SCREEN_WIDTH, 40};
-    SDL_RenderFillRect(app->renderer, &title_bar);
+    // 切换界面: 隐藏的子树保留原来的状态，再显示时整块重画
+    if (state->browsing != app->shown_browsing) {
+        app->shown_browsing = state->browsing;
+        ui_node_set_hidden(app->screen_panel, state->browsing);
+        ui_node_set_hidden(app->sprites_node, state->browsing);
+        ui_node_set_hidden(app->browser_panel, !state->browsing);
+    }
+    if (state->browsing) {
+        update_browser(app, state);
+    }
     
-    // 绘制系统信息
-    SDL_Color white = {255, 255, 255, 255};
-    render_text_small(app, app->system_info, 10, 10, white);
-    render_text_small(app, app->device_info, 10, 25, white);
-    
-    // 绘制输入信息区域
-    SDL_SetRenderDrawColor(app->renderer, 0, 64, 64, 255);
-    SDL_Rect input_area = {0, 50, SCREEN_WIDTH, 80};
-    SDL_RenderFillRect(app->renderer, &input_area);
-    
-    SDL_Color yellow = {255, 255, 0, 255};
-    render_text(app, "=== Input Monitoring ===", 10, 60, yellow);
-    render_text_small(app, app->input_info, 10, 80, white);
-    render_text_small(app, app->last_key_info, 10, 100, white);
-    
-    // 绘制按键状态区域
-    SDL_SetRenderDrawColor(app->renderer, 0, 128, 0, 255);
-    SDL_Rect status_area = {0, 140, SCREEN_WIDTH, 60};
-    SDL_RenderFillRect(app->renderer, &status_area);
-    
-    SDL_Color green = {0, 255, 0, 255};
-    render_text(app, "=== Key Status ===", 10, 150, green);
-    
-    // 绘制运行时间
-    time_t current_time = time(NULL);
-    int run_time = current_time - app->start_time;
-    char time_info[64];
-    sprintf(time_info, "Runtime: %d seconds | Frames: %d", run_time, app->frame_count);
-    render_text_small(app, time_info, 10, 175, white);
-    
-    // 绘制动画区域 (缩小高度，为底部信息留空间)
-    SDL_SetRenderDrawColor(app->renderer, 32, 32, 32, 255);
-    SDL_Rect animation_area = {0, 210, SCREEN_WIDTH, 120};
-    SDL_RenderFillRect(app->renderer, &animation_area);
-    
-    // 绘制动画标题
-    SDL_Color magenta = {255, 0, 255, 255};
-    render_text(app, "=== Animation Demo ===", 10, 220, magenta);
-    
-    // 绘制移动的方块
-    SDL_SetRenderDrawColor(app->renderer, 
-                         (app->box_color >> 16) & 0xFF,
-                         (app->box_color >> 8) & 0xFF,
-                         app->box_color & 0xFF, 255);
-    SDL_Rect box_rect = {(int)app->box_x, (int)app->box_y, app->box_size, app->box_size};
-    SDL_RenderFillRect(app->renderer, &box_rect);
-    
-    // 绘制方块信息
-    char box_info[128];
-    sprintf(box_info, "Box: (%.0f, %.0f) | Speed: (%.1f, %.1f) | Color: 0x%06X", 
-            app->box_x, app->box_y, app->box_vx, app->box_vy, app->box_color);
-    render_text_small(app, box_info, 10, 260, white);
-    
-    // 绘制中文测试
-    SDL_Color orange = {255, 165, 0, 255};
-    render_chinese_text(app, "中文测试：方块动画演示", 10, 280, orange);
-    render_chinese_text(app, "繁體中文：方塊動畫演示", 10, 300, orange);
-    render_chinese_text(app, "日本語：ブロックアニメーション", 10, 320, orange);
-    render_chinese_text(app, "한국어：블록 애니메이션", 10, 340, orange);
-    render_chinese_text(app, "按任意键测试输入 | ESC退出程序", 10, 360, orange);
+    // 文字与上一帧相同时界面树不会标记失效
+    ui_label_set_text(app->input_label, state->input_info);
+    ui_label_set_text(app->last_key_label, state->last_key_info);
+    
+    // 运行时间
+    int run_time = state->run_time;
+    int time_key[2] = {run_time, app->frame_count};
+    if (text_changed(&app->time_text, time_key, 2)) {
+        sprintf(app->time_text.text, "Runtime: %d seconds | Frames: %d", run_time, app->frame_count);
+        ui_label_set_text(app->time_label, app->time_text.text);
+    }
     
-    // 绘制操作提示
-    SDL_Color cyan = {0, 255, 255, 255};
-    render_text_small(app, "Press any key to test | ESC to exit | F1 to switch input", 10, 380, cyan);
+    // 方块信息
+    int box_key[5] = {state->box_x, state->box_y, round_tenths(state->box_vx), round_tenths(state->box_vy),
+                      (int)state->sprites[0].color};
+    if (text_changed(&app->box_text, box_key, 5)) {
+        sprintf(app->box_text.text, "Box: (%d, %d) | Speed: (%.1f, %.1f) | Color: 0x%06X",
+                box_key[0], box_key[1], box_key[2] / 10.0, box_key[3] / 10.0, state->sprites[0].color);
+        ui_label_set_text(app->box_label, app->box_text.text);
+    }
     
-    // 绘制底部信息
-    SDL_SetRenderDrawColor(app->renderer, 128, 0, 128, 255);
-    SDL_Rect bottom_bar = {0, SCREEN_HEIGHT - 40, SCREEN_WIDTH, 40};
-    SDL_RenderFillRect(app->renderer, &bottom_bar);
+    // 性能HUD (上一帧的命令数、绘制调用、状态切换和重画面积)
+    int repaint = app->ui.last.damage_area * 100 / (SCREEN_WIDTH * SCREEN_HEIGHT);
+    int hud_key[5] = {round_tenths(app->fps), app->batch.last.commands,
+                      app->batch.last.draw_calls, app->batch.last.state_changes, repaint};
+    if (text_changed(&app->hud_text, hud_key, 5)) {
+        sprintf(app->hud_text.text, "FPS: %.1f | Commands: %d | Draw calls: %d | State changes: %d | Repaint: %d%%",
+                hud_key[0] / 10.0, hud_key[1], hud_key[2], hud_key[3], hud_key[4]);
+        ui_label_set_text(app->hud_label, app->hud_text.text);
+    }
     
-    render_text_small(app, "RG34XX SDL2 Multi-Input Test v1.0 | 中文支持", 10, SCREEN_HEIGHT - 30, white);
+    // 传感器 (频率、温度、占用和电量按显示精度比较)
+    const sensors_sample_t* sensor = app->sensor;
+    int sensor_key[6] = {sensor ? sensor->cpu_khz / 1000 : 0, sensor ? sensor->cpu_max_khz / 1000 : 0,
+                         sensor ? sensor->temp_mc / 100 : 0, sensor ? (sensor->load_permille + 5) / 10 : 0,
+                         sensor ? sensor->battery_pct : 0, sensor ? sensor->charging : 0};
+    if (text_changed(&app->sensor_text, sensor_key, 6)) {
+        format_sensors(sensor, app->sensor_text.text, sizeof(app->sensor_text.text));
+        ui_label_set_text(app->sensor_label, app->sensor_text.text);
+    }
     
-    // 呈现
-    SDL_RenderPresent(app->renderer);
+    if (!state->browsing) {
+        damage_sprites(app, state);
+    }
+    
+    // 窗口模式的后台缓冲在呈现后内容不确定，每帧整个重画 (布局仍然只在变化时计算)
+    if (!app->framebuffer_mode) {
+        ui_tree_damage_all(&app->ui);
+    }
+    
+    ui_rect_t dirty;
+    app->paint_state = state;
+    ui_tree_paint(&app->ui, paint_ui_node, app, &dirty);
+    app->paint_state = NULL;
+    
+    // 合并提交后呈现
+    render_batch_flush(&app->batch);
+    present_frame(app, &dirty);
 }
 
 // 处理键盘输入
@@ -488,36 +1790,57 @@ void handle_mouse_event(app_context_t* app, SDL_MouseButtonEvent* event) {
     sprintf(app->input_info, "Input: Mouse | Button: %s | Position: (%d, %d)", button_name, event->x, event->y);
 }
 
-// 处理手柄输入
-void handle_joystick_event(app_context_t* app, SDL_JoyButtonEvent* event) {
-    char button_name[16];  // 增加缓冲区大小
-    switch (event->button) {
-        case 0: strcpy(button_name, "A"); break;
-        case 1: strcpy(button_name, "B"); break;
-        case 2: strcpy(button_name, "Y"); break;     // X和Y交换
-        case 3: strcpy(button_name, "X"); break;     // X和Y交换
-        case 4: strcpy(button_name, "L1"); break;
-        case 5: strcpy(button_name, "R1"); break;
-        case 6: strcpy(button_name, "SELECT"); break;  // L2显示为SELECT
-        case 7: strcpy(button_name, "START"); break;     // R2显示为L3
-        case 8: strcpy(button_name, "M"); break;     // START显示为R2
-        case 9: strcpy(button_name, "L2"); break;     // L3显示为L2
-        case 10: strcpy(button_name, "R2"); break;    // 修正R3
-        case 13: strcpy(button_name, "VOL-"); break; // 音量增加显示为Btn14
-        case 14: strcpy(button_name, "VOL+"); break; // 音量增加显示为Btn14
-        default: 
-            sprintf(button_name, "Btn%d", (int)event->button);  // 修复格式警告
-            break;
+// 在测试界面和ROM浏览界面之间切换
+static void toggle_browser(app_context_t* app) {
+    app->browsing = !app->browsing;
+    app->key_hold = 0;
+    app->list_pages = 0;
+    play_sound(app, app->browsing ? &app->sound_open : &app->sound_close);
+    log_message(app->browsing ? "ROM browser opened" : "ROM browser closed");
+}
+
+// 处理手柄输入: 每个逻辑步读一次所有玩家的快照 (不处理手柄的按键事件)
+static void handle_gamepad_input(app_context_t* app) {
+    gamepad_manager_update(&app->pads);
+    
+    // 测试界面显示每个玩家的按键变化
+    for (int p = 0; p < GAMEPAD_MAX_PLAYERS; p++) {
+        const gamepad_state_t* pad = gamepad_player(&app->pads, p);
+        uint32_t changed = pad->pressed | pad->released;
+        for (int b = 0; changed && b < GAMEPAD_BUTTON_COUNT; b++) {
+            if (!(changed & GAMEPAD_BIT(b))) continue;
+            changed &= ~GAMEPAD_BIT(b);
+            const char* button_name = gamepad_button_name((gamepad_button_t)b);
+            const char* state = (pad->pressed & GAMEPAD_BIT(b)) ? "Pressed" : "Released";
+            
+            char gamepad_msg[256];
+            sprintf(gamepad_msg, "Gamepad P%d: %s %s", p + 1, button_name, state);
+            log_message(gamepad_msg);
+            
+            sprintf(app->last_key_info, "Gamepad P%d: %s %s", p + 1, button_name, state);
+            sprintf(app->input_info, "Input: Gamepad P%d | Button: %s | State: %s", p + 1, button_name, state);
+        }
     }
     
-    const char* state = (event->state == SDL_PRESSED) ? "Pressed" : "Released";
-    
-    char joystick_msg[256];
-    sprintf(joystick_msg, "Joystick%d: %s %s", event->which, button_name, state);
-    log_message(joystick_msg);
-    
-    sprintf(app->last_key_info, "Joystick%d: %s %s", event->which, button_name, state);
-    sprintf(app->input_info, "Input: Joystick%d | Button: %s | State: %s", event->which, button_name, state);
+    // 菜单接受任意玩家的输入
+    const gamepad_state_t* any = &app->pads.any;
+    if (any->buttons || any->released) {
+        app->last_input_time = time(NULL);  // 更新最后输入时间
+    }
+    if (any->pressed & GAMEPAD_BIT(GAMEPAD_SELECT)) {
+        toggle_browser(app);
+    } else if (any->pressed && !app->browsing) {
+        play_sound(app, &app->sound_key);
+    }
+    if (any->pressed & (GAMEPAD_BIT(GAMEPAD_L1) | GAMEPAD_BIT(GAMEPAD_LEFT))) app->list_pages--;
+    if (any->pressed & (GAMEPAD_BIT(GAMEPAD_R1) | GAMEPAD_BIT(GAMEPAD_RIGHT))) app->list_pages++;
+    
+    // 上下按住滚动列表 (键盘优先)
+    app->list_hold = app->key_hold;
+    if (!app->list_hold) {
+        if (any->buttons & GAMEPAD_BIT(GAMEPAD_UP)) app->list_hold = -1;
+        else if (any->buttons & GAMEPAD_BIT(GAMEPAD_DOWN)) app->list_hold = 1;
+    }
 }
 
 // 处理事件
@@ -525,6 +1848,7 @@ void handle_events(app_context_t* app) {
     SDL_Event event;
     
     while (SDL_PollEvent(&event)) {
+        metrics_add(app->m_events, 1);
         // 调试模式：显示所有事件类型
         #ifdef DEBUG
         char debug_msg[128];
@@ -535,7 +1859,7 @@ void handle_events(app_context_t* app) {
         switch (event.type) {
             case SDL_QUIT:
                 log_message("Quit event received");
-                app->running = 0;
+                SDL_AtomicSet(&app->running, 0);
                 break;
                 
             case SDL_KEYDOWN:
@@ -544,18 +1868,40 @@ void handle_events(app_context_t* app) {
                 app->last_input_time = time(NULL);  // 更新最后输入时间
                 handle_keyboard_event(app, &event.key);
                 
-                // 特殊按键处理
+                // 特殊按键处理 (测试界面上每次按下都有按键音)
                 if (event.type == SDL_KEYDOWN) {
+                    if (!app->browsing && !event.key.repeat && event.key.keysym.sym != SDLK_TAB) {
+                        play_sound(app, &app->sound_key);
+                    }
                     switch (event.key.keysym.sym) {
                         case SDLK_ESCAPE:
                             log_message("ESC key pressed - Exiting application");
-                            app->running = 0;
+                            SDL_AtomicSet(&app->running, 0);
                             break;
                         case SDLK_F1:
                             log_message("F1 key pressed - Switching input source");
                             sprintf(app->input_info, "Input source switched: Keyboard -> Mouse -> Joystick");
                             break;
+                        case SDLK_TAB:
+                            if (!event.key.repeat) toggle_browser(app);
+                            break;
+                        case SDLK_UP:
+                        case SDLK_DOWN:
+                            // 自动重复由列表自己处理
+                            if (!event.key.repeat) app->key_hold = event.key.keysym.sym == SDLK_UP ? -1 : 1;
+                            break;
+                        case SDLK_LEFT:
+                        case SDLK_PAGEUP:
+                            app->list_pages--;
+                            break;
+                        case SDLK_RIGHT:
+                        case SDLK_PAGEDOWN:
+                            app->list_pages++;
+                            break;
                     }
+                } else if ((event.key.keysym.sym == SDLK_UP && app->key_hold < 0) ||
+                           (event.key.keysym.sym == SDLK_DOWN && app->key_hold > 0)) {
+                    app->key_hold = 0;
                 }
                 break;
                 
@@ -566,100 +1912,26 @@ void handle_events(app_context_t* app) {
                 handle_mouse_event(app, &event.button);
                 break;
                 
-            case SDL_JOYBUTTONDOWN:
-            case SDL_JOYBUTTONUP:
-                log_message("Joystick button event detected");
-                app->last_input_time = time(NULL);  // 更新最后输入时间
-                handle_joystick_event(app, &event.jbutton);
-                break;
-                
-            case SDL_JOYAXISMOTION:
-                log_message("Joystick axis motion detected");
-                app->last_input_time = time(NULL);  // 更新最后输入时间
-                // 处理方向键 - 降低阈值提高敏感度
-                char axis_info[128];
-                sprintf(axis_info, "Axis%d: %d", event.jaxis.axis, event.jaxis.value);
-                log_message(axis_info);
-                
-                if (event.jaxis.axis == 0) {  // X轴
-                    if (event.jaxis.value < -8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Direction: LEFT", event.jaxis.which);
-                        log_message("Direction: LEFT");
-                    } else if (event.jaxis.value > 8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Direction: RIGHT", event.jaxis.which);
-                        log_message("Direction: RIGHT");
-                    }
-                } else if (event.jaxis.axis == 1) {  // Y轴
-                    if (event.jaxis.value < -8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Direction: UP", event.jaxis.which);
-                        log_message("Direction: UP");
-                    } else if (event.jaxis.value > 8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Direction: DOWN", event.jaxis.which);
-                        log_message("Direction: DOWN");
-                    }
-                } else if (event.jaxis.axis == 2) {  // 可能是第二个摇杆X轴
-                    if (event.jaxis.value < -8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Axis2: LEFT", event.jaxis.which);
-                        log_message("Axis2: LEFT");
-                    } else if (event.jaxis.value > 8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Axis2: RIGHT", event.jaxis.which);
-                        log_message("Axis2: RIGHT");
-                    }
-                } else if (event.jaxis.axis == 3) {  // 可能是第二个摇杆Y轴
-                    if (event.jaxis.value < -8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Axis2: UP", event.jaxis.which);
-                        log_message("Axis2: UP");
-                    } else if (event.jaxis.value > 8000) {
-                        sprintf(app->input_info, "Input: Joystick%d | Axis2: DOWN", event.jaxis.which);
-                        log_message("Axis2: DOWN");
-                    }
-                }
-                break;
-                
-            case SDL_JOYHATMOTION:
-                log_message("Joystick hat motion detected");
-                app->last_input_time = time(NULL);  // 更新最后输入时间
-                // 处理帽子运动（十字键）
-                switch (event.jhat.value) {
-                    case SDL_HAT_UP:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: UP", event.jhat.which);
-                        log_message("Hat: UP");
-                        break;
-                    case SDL_HAT_DOWN:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: DOWN", event.jhat.which);
-                        log_message("Hat: DOWN");
-                        break;
-                    case SDL_HAT_LEFT:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: LEFT", event.jhat.which);
-                        log_message("Hat: LEFT");
-                        break;
-                    case SDL_HAT_RIGHT:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: RIGHT", event.jhat.which);
-                        log_message("Hat: RIGHT");
-                        break;
-                    case SDL_HAT_CENTERED:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: CENTERED", event.jhat.which);
-                        log_message("Hat: CENTERED");
-                        break;
-                    default:
-                        sprintf(app->input_info, "Input: Joystick%d | Hat: %d", event.jhat.which, event.jhat.value);
-                        log_message("Hat: OTHER");
-                        break;
-                }
-                break;
-                
             case SDL_JOYDEVICEADDED:
                 {
+                    // which为设备序号
                     char device_msg[128];
                     sprintf(device_msg, "Joystick device added: %d", event.jdevice.which);
                     log_message(device_msg);
+                    open_gamepad(app, event.jdevice.which);
                 }
                 break;
                 
             case SDL_JOYDEVICEREMOVED:
                 {
+                    // which为实例编号
                     char device_msg[128];
-                    sprintf(device_msg, "Joystick device removed: %d", event.jdevice.which);
+                    int player = gamepad_manager_remove(&app->pads, event.jdevice.which);
+                    if (player >= 0) {
+                        sprintf(device_msg, "Joystick device removed: %d (player %d)", event.jdevice.which, player + 1);
+                    } else {
+                        sprintf(device_msg, "Joystick device removed: %d", event.jdevice.which);
+                    }
                     log_message(device_msg);
                 }
                 break;
@@ -680,34 +1952,348 @@ void handle_events(app_context_t* app) {
 void cleanup(app_context_t* app) {
     log_message("=== Cleaning up resources ===");
     
-    if (app->font) {
-        TTF_CloseFont(app->font);
+    if (app->font_thread) {
+        SDL_WaitThread(app->font_thread, NULL);
+        app->font_thread = NULL;
+    }
+    text_pool_destroy(&app->text_pool);
+    ui_tree_destroy(&app->ui);
+    text_layout_destroy(&app->layout);
+    list_rows_destroy(&app->list_rows);
+    if (app->roms_started) {
+        rom_index_stop(&app->roms);
+        app->roms_started = 0;
+    }
+    free(app->drawn_sprites);
+    if (app->sensors_started) {
+        sensors_stop(&app->sensors);
+        app->sensors_started = 0;
+    }
+    // 先关闭设备 (等回调结束)，再释放混音缓冲和音效
+    if (app->audio_device) {
+        SDL_CloseAudioDevice(app->audio_device);
+        app->audio_device = 0;
+        audio_mixer_destroy(&app->mixer);
+    }
+    audio_sound_free(&app->sound_move);
+    audio_sound_free(&app->sound_page);
+    audio_sound_free(&app->sound_open);
+    audio_sound_free(&app->sound_close);
+    audio_sound_free(&app->sound_key);
+    audio_sound_free(&app->music);
+    if (app->thumbs_ready) {
+        thumb_cache_destroy(&app->thumbs);
+        app->thumbs_ready = 0;
+    }
+    if (app->preview_texture) {
+        SDL_DestroyTexture(app->preview_texture);
     }
-    if (app->font_small) {
-        TTF_CloseFont(app->font_small);
+    if (app->logo_texture) {
+        SDL_DestroyTexture(app->logo_texture);
     }
-    if (app->font_chinese) {
-        TTF_CloseFont(app->font_chinese);
+    image_asset_close(&app->logo);
+    sprites_destroy(&app->sprites);
+    triple_buffer_destroy(&app->states);
+    if (app->state_ready) {
+        SDL_DestroySemaphore(app->state_ready);
     }
+    font_cache_destroy(&app->fonts);
+    glyph_pack_close(&app->glyphs);
     if (app->renderer) {
         SDL_DestroyRenderer(app->renderer);
     }
     if (app->window) {
         SDL_DestroyWindow(app->window);
     }
-    if (app->fb_fd >= 0) {
-        close(app->fb_fd);
+    if (app->fb_surface) {
+        SDL_FreeSurface(app->fb_surface);
+    }
+    if (app->framebuffer_mode) {
+        fb_present_close(&app->fb);
     }
     
-    // 关闭所有手柄 - SDL2会自动清理，无需手动关闭
-    // SDL_Quit()会自动关闭所有打开的手柄
+    // 关闭所有手柄
+    gamepad_manager_destroy(&app->pads);
     
     TTF_Quit();
     SDL_Quit();
     
+    // 最后解除映射 (所有线程和音频回调都已结束)，同时删除共享内存名字
+    metrics_close(&app->metrics);
+    
     log_message("Resource cleanup completed");
 }
 
+// 基准测试从第一个完整界面帧开始计时
+void start_benchmark(app_context_t* app) {
+    app->bench_start = SDL_GetPerformanceCounter();
+    app->present_ms = 0;
+    getrusage(RUSAGE_SELF, &app->bench_usage);
+}
+
+// 输出基准测试结果: FPS、CPU占用 (用户态+内核态时间 / 墙钟时间) 和平均呈现耗时
+void finish_benchmark(app_context_t* app) {
+    double wall_ms = (SDL_GetPerformanceCounter() - app->bench_start) * 1000.0 / SDL_GetPerformanceFrequency();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    
+    double user_ms = (usage.ru_utime.tv_sec - app->bench_usage.ru_utime.tv_sec) * 1000.0 +
+                     (usage.ru_utime.tv_usec - app->bench_usage.ru_utime.tv_usec) / 1000.0;
+    double sys_ms = (usage.ru_stime.tv_sec - app->bench_usage.ru_stime.tv_sec) * 1000.0 +
+                    (usage.ru_stime.tv_usec - app->bench_usage.ru_stime.tv_usec) / 1000.0;
+    int frames = app->bench_frames;
+    
+    char bench_msg[320];
+    sprintf(bench_msg, "Benchmark (%s): %d frames in %.1f ms, %.1f FPS, CPU %.1f%% (user %.1f ms, sys %.1f ms), present %.3f ms/frame",
+            app->framebuffer_mode ? "framebuffer" : "window", frames, wall_ms,
+            wall_ms > 0 ? frames * 1000.0 / wall_ms : 0,
+            wall_ms > 0 ? (user_ms + sys_ms) * 100.0 / wall_ms : 0,
+            user_ms, sys_ms, app->present_ms / frames);
+    log_message(bench_msg);
+}
+
+// 逻辑线程: 把当前的输入信息和动画状态写入快照并发布，不等待渲染
+void publish_state(app_context_t* app) {
+    ui_state_t* state = triple_buffer_write_slot(&app->states);
+    const sprite_store_t* sprites = &app->sprites;
+    
+    state->tick = app->logic_tick;
+    state->run_time = (int)(time(NULL) - app->start_time);
+    strcpy(state->input_info, app->input_info);
+    strcpy(state->last_key_info, app->last_key_info);
+    state->box_x = (int)(sprites->x[0] + 0.5f);
+    state->box_y = (int)(sprites->y[0] + 0.5f);
+    state->box_vx = sprites->vx[0];
+    state->box_vy = sprites->vy[0];
+    state->browsing = app->browsing;
+    state->list_count = app->list.count;
+    state->list_selected = app->list.selected;
+    state->list_scroll = app->list.scroll;
+    state->list_generation = app->list_generation;
+    state->list_scanning = app->roms_state == ROM_INDEX_SCANNING;
+    state->sprite_count = sprites->count;
+    for (int i = 0; i < sprites->count; i++) {
+        ui_sprite_t* sprite = &state->sprites[i];
+        sprite->x = (int)sprites->x[i];
+        sprite->y = (int)sprites->y[i];
+        sprite->w = (int)sprites->w[i];
+        sprite->h = (int)sprites->h[i];
+        sprite->color = sprites->color[i];
+    }
+    triple_buffer_publish(&app->states);
+}
+
+// ROM索引在后台扫描: 条目数增长时列表跟着变长，扫描结束时记录结果
+static void update_rom_index(app_context_t* app) {
+    rom_index_status_t status;
+    rom_index_get_status(&app->roms, &status);
+    if (status.count != app->list.count) {
+        list_view_set_count(&app->list, status.count);
+    }
+    app->list_generation = status.generation;
+    
+    if (status.state != app->roms_state) {
+        app->roms_state = status.state;
+        if (status.state == ROM_INDEX_DONE || status.state == ROM_INDEX_FAILED) {
+            char index_msg[320];
+            snprintf(index_msg, sizeof(index_msg), "ROM index %s: %d entries, %d dirs (%d read, %d reused), %d ms%s%s%s",
+                     rom_index_state_name(status.state), status.count, status.dirs, status.dirs_scanned,
+                     status.dirs_reused, status.elapsed_ms, status.saved ? ", index saved" : "",
+                     status.message[0] ? " - " : "", status.message);
+            log_message(index_msg);
+        }
+    }
+}
+
+// 逻辑一步: 处理输入、推进动画、发布快照、检查无输入自动退出
+void logic_step(app_context_t* app) {
+    handle_events(app);
+    handle_gamepad_input(app);
+    update_animation(app);
+    if (app->roms_started) {
+        update_rom_index(app);
+    }
+    if (app->browsing) {
+        int selected = app->list.selected;
+        if (app->list_pages) {
+            list_view_page(&app->list, app->list_pages);
+        }
+        list_view_step(&app->list, app->list_hold, LOGIC_TICK_MS);
+        // 选中行变化时的提示音，按住快速滚动时限制间隔
+        if (app->list.selected != selected) {
+            Uint32 now = SDL_GetTicks();
+            if (app->list_pages) {
+                play_sound(app, &app->sound_page);
+            } else if (now - app->last_move_sound >= AUDIO_MOVE_GAP_MS) {
+                play_sound(app, &app->sound_move);
+                app->last_move_sound = now;
+            }
+        }
+        // 一直按住方向键也算有输入
+        if (app->list_hold) {
+            app->last_input_time = time(NULL);
+        }
+    }
+    app->list_pages = 0;
+    app->logic_tick++;
+    metrics_add(app->m_logic_steps, 1);
+    publish_state(app);
+    
+    // 15秒无输入自动退出 (仅Linux环境)，基准测试不自动退出
+    #ifdef __linux__
+        if (app->bench_frames == 0 && time(NULL) - app->last_input_time >= 15) {
+            log_message("15 seconds without input - Auto exit for handheld device");
+            SDL_AtomicSet(&app->running, 0);
+        }
+    #endif
+}
+
+// 渲染一帧太慢: 计数，并把当时的传感器采样写入日志，用来区分降频、过热和程序本身的问题
+static void log_frame_spike(app_context_t* app, Uint64 frame_us) {
+    metrics_add(app->m_frame_spikes, 1);
+    Uint32 now = SDL_GetTicks();
+    if (app->last_spike_log && now - app->last_spike_log < SPIKE_LOG_GAP_MS) {
+        app->spikes_unlogged++;
+        return;
+    }
+    app->last_spike_log = now;
+    char sensors_text[160];
+    format_sensors(app->sensor, sensors_text, sizeof(sensors_text));
+    char spike_msg[256];
+    snprintf(spike_msg, sizeof(spike_msg), "Frame spike: %.1f ms at frame %d (+%d since last log) | %s",
+             frame_us / 1000.0, app->frame_count, app->spikes_unlogged, sensors_text);
+    log_message(spike_msg);
+    app->spikes_unlogged = 0;
+}
+
+// 渲染一帧: 使用最新的快照 (逻辑没有发布新快照时重复使用上一个)
+void render_step(app_context_t* app) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    const ui_state_t* state = triple_buffer_read(&app->states, NULL);
+    if (app->sensors_started) {
+        app->sensor = sensors_latest(&app->sensors);
+    }
+    
+    // 字体就绪前显示启动画面
+    if (!app->fonts_loaded && SDL_AtomicGet(&app->fonts_ready)) {
+        if (finish_font_loader(app) < 0) {
+            SDL_AtomicSet(&app->running, 0);
+            return;
+        }
+    }
+    if (app->fonts_loaded) {
+        render_ui(app, state);
+    } else {
+        render_splash(app);
+    }
+    
+    app->frame_count++;
+    Uint64 frame_us = (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+    metrics_add(app->m_frames, 1);
+    metrics_observe(app->m_frame_us, frame_us);
+    if (app->first_ui_frame && app->frame_count > app->first_ui_frame && frame_us >= FRAME_SPIKE_US) {
+        log_frame_spike(app, frame_us);
+    }
+    
+    if (app->frame_count == 1) {
+        perf_trace_mark("first frame presented");
+    }
+    
+    // 第一个完整界面帧后所有用到的字号都已打开，输出启动跟踪和字体加载耗时
+    if (app->fonts_loaded && !app->first_ui_frame) {
+        app->first_ui_frame = app->frame_count;
+        perf_trace_mark("first UI frame presented");
+        perf_trace_log(log_message);
+        font_cache_log_stats(&app->fonts, log_message);
+        
+        if (app->bench_frames > 0) {
+            start_benchmark(app);
+        }
+    }
+    
+    // 调试版本: 预热后的渲染循环不允许堆分配 (检查只作用于调用alloc_guard_arm的线程)
+    if (alloc_guard_enabled() && app->first_ui_frame) {
+        if (app->frame_count - app->first_ui_frame == ALLOC_WARMUP_FRAMES) {
+            alloc_guard_arm();
+            log_message("Allocation guard armed");
+        } else if (alloc_guard_count() > 0) {
+            alloc_guard_disarm();
+            char alloc_msg[160];
+            sprintf(alloc_msg, "Heap allocation in steady-state frame %d: %lu allocation(s), first %zu bytes",
+                    app->frame_count, alloc_guard_count(), alloc_guard_first_size());
+            log_message(alloc_msg);
+            close_log_file();
+            abort();
+        }
+    }
+    
+    // 基准测试: 渲染够帧数后结束
+    if (app->bench_frames > 0 && app->first_ui_frame &&
+        app->frame_count - app->first_ui_frame >= app->bench_frames) {
+        finish_benchmark(app);
+        SDL_AtomicSet(&app->running, 0);
+    }
+}
+
+// 对调用的线程申请实时选项，记录批准和被拒绝的项
+static void tune_thread(const char* name, const rt_tune_options_t* options) {
+    if (!rt_tune_requested(options)) {
+        return;
+    }
+    rt_tune_result_t result;
+    rt_tune_apply(options, &result);
+    char tune_msg[256];
+    snprintf(tune_msg, sizeof(tune_msg), "%s thread tuning: %s", name, result.text);
+    log_message(tune_msg);
+}
+
+// --mlock: 进入主循环前触碰每帧都会用到的缓冲区，前几帧不再缺页 (只锁定了已有映射时同时锁定它们)
+static void prefault_buffers(app_context_t* app) {
+    int lock = app->memory_locked & RT_TUNE_LOCK_FUTURE ? 0 : RT_TUNE_PREFAULT_LOCK;
+    size_t pages = 0;
+    if (app->fb_surface) {
+        pages += rt_tune_prefault(app->fb_surface->pixels, (size_t)app->fb_surface->pitch * app->fb_surface->h,
+                                  RT_TUNE_PREFAULT_WRITE | lock);
+    }
+    if (app->text_pool.surface) {
+        SDL_Surface* atlas = app->text_pool.surface;
+        pages += rt_tune_prefault(atlas->pixels, (size_t)atlas->pitch * atlas->h, RT_TUNE_PREFAULT_WRITE | lock);
+    }
+    pages += rt_tune_prefault(app->states.block, app->states.slot_size * 3, RT_TUNE_PREFAULT_WRITE | lock);
+    pages += rt_tune_prefault((void*)app->logo.data, app->logo.size, lock);
+    
+    char prefault_msg[128];
+    snprintf(prefault_msg, sizeof(prefault_msg), "Prefaulted %zu pages (back buffer, text atlas, state buffers, images)",
+             pages);
+    log_message(prefault_msg);
+}
+
+// 渲染线程: 有新快照时渲染；基准测试不限帧率、等待垂直同步时按刷新率渲染 (可能重复快照)
+static int render_thread_main(void* data) {
+    app_context_t* app = (app_context_t*)data;
+    tune_thread("Render", &app->render_tune);
+    while (SDL_AtomicGet(&app->running)) {
+        if (app->bench_frames == 0 && !app->fb_synced && !triple_buffer_pending(&app->states)) {
+            SDL_SemWaitTimeout(app->state_ready, 100);
+            continue;
+        }
+        render_step(app);
+    }
+    alloc_guard_disarm();
+    return 0;
+}
+
+// 快照交接统计: 逻辑发布、渲染取到、没被渲染就被覆盖 (丢帧)、重复渲染同一快照 (重复帧)
+void log_frame_handoff(app_context_t* app) {
+    triple_buffer_stats_t stats;
+    triple_buffer_get_stats(&app->states, &stats);
+    char handoff_msg[256];
+    sprintf(handoff_msg, "Frame handoff (%s): %lu published, %lu rendered, %lu dropped, %lu duplicated",
+            app->threaded ? "render thread" : "single thread",
+            stats.published, stats.consumed, stats.dropped, stats.duplicated);
+    log_message(handoff_msg);
+}
+
 // 主函数
 int main(int argc, char* argv[]) {
     printf("=== RG34XX SDL2 Multi-Input Test Application ===\n");
@@ -715,60 +2301,270 @@ int main(int argc, char* argv[]) {
     // 设置UTF-8编码
     setlocale(LC_ALL, "en_US.UTF-8");
     
+    perf_trace_init();
+    
     app_context_t app = {0};
-    app.running = 1;
+    SDL_AtomicSet(&app.running, 1);
     app.frame_count = 0;
     app.start_time = time(NULL);
-    app.fb_fd = -1;
+    
+    // 命令行参数: --fbdev[=设备] 直接输出到帧缓冲，--bench N 基准测试，--sprites N 额外的动画方块，
+    // --image 文件 标题栏图标，--single-thread 帧缓冲模式下也不使用渲染线程，
+    // --roms 目录 浏览的ROM目录，--index 文件 ROM索引，--list N 浏览N个生成的条目 (测试大列表)，
+    // --art 目录 封面图片，--thumbs 目录 缩略图的磁盘缓存，--audio-buffer N 音频回调帧数，--music 文件 背景音乐 (WAV)，
+    // --metrics 名字 指标表的共享内存名，--sensors N 传感器采样间隔 (毫秒，0为关闭)，
+    // --render-cpu N / --input-cpu N 渲染线程和逻辑线程绑定的核，--rt fifo|rr 实时调度 (--rt-priority N)，
+    // --nice N 没有实时调度时的nice值，--mlock 锁定内存并预先触碰缓冲区
+    int single_thread = 0;
+    app.roms_dir = ROMS_DIR;
+    app.index_path = ROM_INDEX_PATH;
+    app.art_dir = ART_DIR;
+    app.thumb_dir = THUMB_DIR;
+    app.audio_buffer = AUDIO_BUFFER_FRAMES;
+    app.metrics_name = METRICS_DEFAULT_NAME;
+    app.sensor_interval = SENSORS_DEFAULT_INTERVAL_MS;
+    rt_tune_defaults(&app.render_tune);
+    rt_tune_defaults(&app.input_tune);
+    int bad_arg = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fbdev") == 0) {
+            app.fb_device = "/dev/fb0";
+        } else if (strncmp(argv[i], "--fbdev=", 8) == 0) {
+            app.fb_device = argv[i] + 8;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            app.bench_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sprites") == 0 && i + 1 < argc) {
+            app.extra_sprites = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            app.image_path = argv[++i];
+        } else if (strcmp(argv[i], "--single-thread") == 0) {
+            single_thread = 1;
+        } else if (strcmp(argv[i], "--roms") == 0 && i + 1 < argc) {
+            app.roms_dir = argv[++i];
+        } else if (strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            app.index_path = argv[++i];
+        } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            app.synthetic_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--art") == 0 && i + 1 < argc) {
+            app.art_dir = argv[++i];
+        } else if (strcmp(argv[i], "--thumbs") == 0 && i + 1 < argc) {
+            app.thumb_dir = argv[++i];
+        } else if (strcmp(argv[i], "--audio-buffer") == 0 && i + 1 < argc) {
+            app.audio_buffer = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--music") == 0 && i + 1 < argc) {
+            app.music_path = argv[++i];
+        } else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) {
+            app.metrics_name = argv[++i];
+        } else if (strcmp(argv[i], "--sensors") == 0 && i + 1 < argc) {
+            app.sensor_interval = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--render-cpu") == 0 && i + 1 < argc) {
+            app.render_tune.cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--input-cpu") == 0 && i + 1 < argc) {
+            app.input_tune.cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rt") == 0 && i + 1 < argc) {
+            bad_arg = rt_tune_parse_policy(argv[++i], &app.render_tune.policy) < 0;
+            app.input_tune.policy = app.render_tune.policy;
+        } else if (strcmp(argv[i], "--rt-priority") == 0 && i + 1 < argc) {
+            app.render_tune.priority = app.input_tune.priority = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--nice") == 0 && i + 1 < argc) {
+            app.render_tune.nice = app.input_tune.nice = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mlock") == 0) {
+            app.lock_memory = 1;
+        } else {
+            bad_arg = 1;
+        }
+        if (bad_arg) {
+            printf("用法: %s [--fbdev[=/dev/fb0]] [--bench 帧数] [--sprites 数量] [--image 图标.rgi] [--single-thread]\n"
+                   "       [--roms 目录] [--index 索引文件] [--list 条目数] [--art 封面目录] [--thumbs 缓存目录]\n"
+                   "       [--audio-buffer 帧数] [--music 音乐.wav] [--metrics 共享内存名]\n"
+                   "       [--sensors 采样间隔毫秒] [--render-cpu 核] [--input-cpu 核] [--rt fifo|rr]\n"
+                   "       [--rt-priority 优先级] [--nice 值] [--mlock]\n", argv[0]);
+            return 1;
+        }
+    }
     
     // 打开日志文件
+    int phase = perf_trace_begin("open_log_file");
     open_log_file();
+    perf_trace_end(phase);
     
     // 获取系统信息
+    phase = perf_trace_begin("get_system_info");
     get_system_info(&app);
     log_message(app.system_info);
     log_message(app.device_info);
+    perf_trace_end(phase);
     
-    // 初始化SDL2
-    if (init_sdl2(&app) < 0) {
+    // 指标最先登记，之后任何线程都可以直接更新
+    init_metrics(&app);
+    
+    // 锁定内存在启动其他线程之前，批准锁定之后的映射时字体和缓冲区分配时就调入
+    if (app.lock_memory) {
+        char lock_msg[192];
+        app.memory_locked = rt_tune_lock_memory(lock_msg, sizeof(lock_msg));
+        log_message(lock_msg);
+    }
+    
+    // ROM目录在后台扫描 (有上次的索引时先映射)，与字体加载和SDL初始化同时进行
+    if (app.synthetic_count <= 0) {
+        rom_index_start(&app.roms, app.roms_dir, app.index_path);   // 失败时状态为FAILED，由逻辑线程记录原因
+        app.roms_started = 1;
+        app.roms_state = ROM_INDEX_SCANNING;
+    }
+    
+    // 字体在后台加载，同时初始化SDL视频和手柄
+    if (start_font_loader(&app) < 0 || init_sdl2(&app) < 0) {
         log_message("SDL2 initialization failed");
+        cleanup(&app);
+        close_log_file();
+        return 1;
+    }
+    
+    render_batch_init(&app.batch, app.renderer);
+    app.fps_tick = SDL_GetTicks();
+    
+    // 文字池的图集一次创建: 每个槽位能放下一整行的主字号文字
+    if (text_pool_init(&app.text_pool, app.renderer, &app.glyphs, &app.fonts, app.framebuffer_mode,
+                       SCREEN_WIDTH, FONT_SIZE_MAIN * 2) < 0) {
+        char error_msg[256];
+        sprintf(error_msg, "Text pool creation failed: %s", SDL_GetError());
+        log_message(error_msg);
+        cleanup(&app);
         close_log_file();
         return 1;
     }
     
+    // 图片资源只映射，不解码
+    load_images(&app);
+    init_thumbs(&app);
+    init_audio(&app);
+    init_sensors(&app);
+    app.threaded = app.framebuffer_mode && !single_thread;
+    
     // 初始化动画
-    init_animation(&app);
+    if (init_animation(&app) < 0) {
+        log_message("Sprite storage allocation failed");
+        cleanup(&app);
+        close_log_file();
+        return 1;
+    }
     
     // 初始化输入信息
     strcpy(app.input_info, "Waiting for input...");
     strcpy(app.last_key_info, "No key input");
     app.last_input_time = time(NULL);  // 初始化最后输入时间
     
-    log_message("=== Starting main loop ===");
+    // ROM列表: 按SELECT (键盘Tab) 打开浏览界面，条目数随扫描增长
+    list_view_init(&app.list, app.synthetic_count > 0 ? app.synthetic_count : 0,
+                   LIST_ROW_HEIGHT, LIST_ROW_HEIGHT * LIST_VISIBLE_ROWS);
+    if (app.roms_started) {
+        update_rom_index(&app);
+    }
     
-    // 主循环
-    while (app.running) {
-        handle_events(&app);
-        update_animation(&app);  // 更新动画
-        render_ui(&app);
-        
-        app.frame_count++;
+    // 界面树 (测量在第一个完整界面帧布局时进行，那时字体已经加载)
+    if (build_ui(&app) < 0) {
+        log_message("UI tree creation failed");
+        cleanup(&app);
+        close_log_file();
+        return 1;
+    }
+    
+    // 每个快照都带着全部精灵，槽位按精灵数一次分配
+    size_t state_size = offsetof(ui_state_t, sprites) + (size_t)app.sprites.count * sizeof(ui_sprite_t);
+    app.state_ready = SDL_CreateSemaphore(0);
+    if (triple_buffer_init(&app.states, state_size) < 0 || !app.state_ready) {
+        log_message("State buffer allocation failed");
+        cleanup(&app);
+        close_log_file();
+        return 1;
+    }
+    publish_state(&app);
+    
+    // 预先触碰在渲染线程启动之前，写回原值时没有其他线程访问
+    if (app.lock_memory) {
+        prefault_buffers(&app);
+    }
+    
+    // 窗口模式的渲染器只能在创建它的线程上使用，逻辑和渲染在主线程上交替进行
+    if (app.threaded) {
+        app.render_thread = SDL_CreateThread(render_thread_main, "render", &app);
+        if (!app.render_thread) {
+            char error_msg[128];
+            sprintf(error_msg, "Render thread creation failed, running single-threaded: %s", SDL_GetError());
+            log_message(error_msg);
+            app.threaded = 0;
+        }
+    }
+    
+    // 单线程时主线程也负责渲染，使用渲染线程的选项
+    tune_thread(app.threaded ? "Input" : "Main", app.threaded ? &app.input_tune : &app.render_tune);
+    
+    log_message(app.threaded ? "=== Starting logic loop (render thread) ===" : "=== Starting main loop ===");
+    
+    // 主循环: 逻辑以固定步长运行，不等待渲染
+    Uint32 next_tick = SDL_GetTicks();
+    while (SDL_AtomicGet(&app.running)) {
+        logic_step(&app);
         
-        // 15秒无输入自动退出 (仅Linux环境)
-        time_t current_time = time(NULL);
-        int idle_time = current_time - app.last_input_time;
-        #ifdef __linux__
-            if (idle_time >= 15) {
-                log_message("15 seconds without input - Auto exit for handheld device");
-                app.running = 0;
+        if (!app.threaded) {
+            render_step(&app);
+            
+            // 基准测试不限帧率；已等待垂直同步时不再延时
+            if (app.bench_frames == 0 && !app.fb_synced) {
+                SDL_Delay(LOGIC_TICK_MS);
             }
-        #endif
+            continue;
+        }
         
-        // 控制帧率 (60FPS)
-        SDL_Delay(16);
+        SDL_SemPost(app.state_ready);
+        next_tick += LOGIC_TICK_MS;
+        Uint32 now = SDL_GetTicks();
+        if ((Sint32)(next_tick - now) > 0) {
+            SDL_Delay(next_tick - now);
+        } else if (now - next_tick > 100) {
+            next_tick = now;  // 落后太多 (例如被挂起) 时不追赶
+        }
+    }
+    
+    if (app.render_thread) {
+        SDL_SemPost(app.state_ready);
+        SDL_WaitThread(app.render_thread, NULL);
+        app.render_thread = NULL;
+    }
+    log_frame_handoff(&app);
+    
+    const text_layout_stats_t* layout_stats = &app.layout.stats;
+    char layout_msg[256];
+    sprintf(layout_msg, "Text layout: %d requests, %d cache hits, %d glyph advances measured",
+            layout_stats->layouts, layout_stats->layout_hits, layout_stats->advance_misses);
+    log_message(layout_msg);
+    
+    if (app.thumbs_ready) {
+        thumb_cache_stats_t thumb_stats;
+        thumb_cache_get_stats(&app.thumbs, &thumb_stats);
+        char thumb_msg[256];
+        sprintf(thumb_msg, "Thumbnails: %d requests, %d RAM hits, %d disk hits, %d decoded (avg %.1f ms, max %.1f ms), "
+                "%d failed, %d evicted, %d dropped",
+                thumb_stats.requests, thumb_stats.ram_hits, thumb_stats.disk_hits, thumb_stats.decodes,
+                thumb_stats.decodes > 0 ? thumb_stats.decode_ms / thumb_stats.decodes : 0.0, thumb_stats.decode_max_ms,
+                thumb_stats.failures, thumb_stats.evictions, thumb_stats.dropped);
+        log_message(thumb_msg);
+    }
+    
+    if (app.audio_device) {
+        audio_mixer_stats_t audio_stats;
+        audio_mixer_get_stats(&app.mixer, &audio_stats);
+        char audio_msg[256];
+        sprintf(audio_msg, "Audio: %lu callbacks, mix avg %.1f us max %lu us, %lu underruns, %lu late, "
+                "%lu commands (%lu dropped), %lu voices stolen, peak %d voices, %lu samples clipped",
+                audio_stats.callbacks, audio_stats.callbacks ? (double)audio_stats.mix_us / audio_stats.callbacks : 0.0,
+                audio_stats.max_mix_us, audio_stats.underruns, audio_stats.late, audio_stats.commands,
+                audio_stats.dropped, audio_stats.stolen, audio_stats.peak, audio_stats.clipped);
+        log_message(audio_msg);
     }
     
     // 清理
+    alloc_guard_disarm();
     cleanup(&app);
     close_log_file();
     
@@ -0,0 +1,254 @@
+#include "sensors.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CPUFREQ_DIR "/sys/devices/system/cpu/cpu0/cpufreq"
+#define THERMAL_DIR "/sys/class/thermal"
+#define POWER_DIR   "/sys/class/power_supply"
+
+static long long elapsed_us(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000LL + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+// 从偏移0读整个节点 (sysfs和procfs每次pread都重新生成内容)，返回长度，失败返回-1
+static int read_node(int fd, char* buffer, size_t size) {
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = pread(fd, buffer, size - 1, 0);
+    if (n <= 0) {
+        return -1;
+    }
+    buffer[n] = '\0';
+    return (int)n;
+}
+
+static int read_int(int fd, long long* value) {
+    char buffer[32];
+    if (read_node(fd, buffer, sizeof(buffer)) < 0) {
+        return -1;
+    }
+    char* end;
+    errno = 0;
+    *value = strtoll(buffer, &end, 10);
+    return end == buffer || errno ? -1 : 0;
+}
+
+// 读一次就够的小文件 (去掉换行)
+static int read_text(const char* path, char* text, size_t size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    int n = read_node(fd, text, size);
+    if (fd >= 0) close(fd);
+    if (n < 0) {
+        text[0] = '\0';
+        return -1;
+    }
+    text[strcspn(text, "\n")] = '\0';
+    return 0;
+}
+
+static void open_battery(sensors_t* sensors) {
+    DIR* dir = opendir(POWER_DIR);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL && sensors->battery_fd < 0) {
+        if (entry->d_name[0] == '.') continue;
+        char path[320];
+        char type[32];
+        snprintf(path, sizeof(path), POWER_DIR "/%s/type", entry->d_name);
+        if (read_text(path, type, sizeof(type)) < 0 || strcmp(type, "Battery") != 0) continue;
+        snprintf(path, sizeof(path), POWER_DIR "/%s/capacity", entry->d_name);
+        sensors->battery_fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (sensors->battery_fd < 0) continue;
+        snprintf(path, sizeof(path), POWER_DIR "/%s/status", entry->d_name);
+        sensors->battery_status_fd = open(path, O_RDONLY | O_CLOEXEC);
+        snprintf(sensors->battery_name, sizeof(sensors->battery_name), "%.31s", entry->d_name);
+    }
+    closedir(dir);
+}
+
+static void open_nodes(sensors_t* sensors) {
+    sensors->freq_fd = open(CPUFREQ_DIR "/scaling_cur_freq", O_RDONLY | O_CLOEXEC);
+    sensors->max_freq_fd = open(CPUFREQ_DIR "/scaling_max_freq", O_RDONLY | O_CLOEXEC);
+    read_text(CPUFREQ_DIR "/scaling_governor", sensors->governor, sizeof(sensors->governor));
+
+    for (int i = 0; i < SENSORS_MAX_ZONES; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), THERMAL_DIR "/thermal_zone%d/temp", i);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            sensors->zone_fds[sensors->zone_count++] = fd;
+        }
+    }
+
+    sensors->stat_fd = open("/proc/stat", O_RDONLY | O_CLOEXEC);
+    sensors->battery_fd = -1;
+    sensors->battery_status_fd = -1;
+    open_battery(sensors);
+}
+
+static void close_fd(int* fd) {
+    if (*fd >= 0) close(*fd);
+    *fd = -1;
+}
+
+static void close_nodes(sensors_t* sensors) {
+    close_fd(&sensors->freq_fd);
+    close_fd(&sensors->max_freq_fd);
+    for (int i = 0; i < sensors->zone_count; i++) {
+        close_fd(&sensors->zone_fds[i]);
+    }
+    sensors->zone_count = 0;
+    close_fd(&sensors->stat_fd);
+    close_fd(&sensors->battery_fd);
+    close_fd(&sensors->battery_status_fd);
+}
+
+// /proc/stat第一行: cpu user nice system idle iowait irq softirq steal ...
+static int read_load(sensors_t* sensors) {
+    char buffer[512];
+    if (read_node(sensors->stat_fd, buffer, sizeof(buffer)) < 0 || strncmp(buffer, "cpu ", 4) != 0) {
+        return SENSORS_UNKNOWN;
+    }
+    unsigned long long values[8] = {0};
+    char* p = buffer + 4;
+    for (int i = 0; i < 8; i++) {
+        char* end;
+        values[i] = strtoull(p, &end, 10);
+        if (end == p) break;
+        p = end;
+    }
+    unsigned long long total = 0;
+    for (int i = 0; i < 8; i++) {
+        total += values[i];
+    }
+    unsigned long long busy = total - values[3] - values[4];
+
+    int load = SENSORS_UNKNOWN;
+    if (sensors->last_total && total > sensors->last_total) {
+        load = (int)((busy - sensors->last_busy) * 1000 / (total - sensors->last_total));
+    }
+    sensors->last_busy = busy;
+    sensors->last_total = total;
+    return load;
+}
+
+static void take_sample(sensors_t* sensors, sensors_sample_t* sample) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long long value;
+
+    sample->sequence = ++sensors->sequence;
+    sample->cpu_khz = read_int(sensors->freq_fd, &value) == 0 ? (int)value : SENSORS_UNKNOWN;
+    sample->cpu_max_khz = read_int(sensors->max_freq_fd, &value) == 0 ? (int)value : SENSORS_UNKNOWN;
+
+    // 有的驱动以摄氏度为单位，小于1000的读数按摄氏度换算
+    sample->temp_mc = SENSORS_NO_TEMP;
+    for (int i = 0; i < sensors->zone_count; i++) {
+        if (read_int(sensors->zone_fds[i], &value) < 0) continue;
+        if (value > -1000 && value < 1000) value *= 1000;
+        if (value > sample->temp_mc) sample->temp_mc = (int)value;
+    }
+
+    sample->load_permille = read_load(sensors);
+    sample->battery_pct = read_int(sensors->battery_fd, &value) == 0 ? (int)value : SENSORS_UNKNOWN;
+    char status[32];
+    sample->charging = read_node(sensors->battery_status_fd, status, sizeof(status)) > 0 &&
+                       (strncmp(status, "Charging", 8) == 0 || strncmp(status, "Full", 4) == 0);
+    sample->sample_us = (int)elapsed_us(&start);
+}
+
+static void publish_sample(sensors_t* sensors) {
+    sensors_sample_t* sample = triple_buffer_write_slot(&sensors->samples);
+    take_sample(sensors, sample);
+    triple_buffer_publish(&sensors->samples);
+}
+
+static void* sampler_main(void* arg) {
+    sensors_t* sensors = arg;
+    pthread_mutex_lock(&sensors->lock);
+    while (!sensors->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += sensors->interval_ms / 1000;
+        deadline.tv_nsec += (long)(sensors->interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        // 停止时立即醒来
+        while (!sensors->stop && pthread_cond_timedwait(&sensors->wake, &sensors->lock, &deadline) != ETIMEDOUT) {
+        }
+        if (sensors->stop) break;
+        pthread_mutex_unlock(&sensors->lock);
+        publish_sample(sensors);
+        pthread_mutex_lock(&sensors->lock);
+    }
+    pthread_mutex_unlock(&sensors->lock);
+    return NULL;
+}
+
+int sensors_start(sensors_t* sensors, int interval_ms) {
+    memset(sensors, 0, sizeof(*sensors));
+    sensors->interval_ms = interval_ms > 0 ? interval_ms : SENSORS_DEFAULT_INTERVAL_MS;
+    if (triple_buffer_init(&sensors->samples, sizeof(sensors_sample_t)) < 0) {
+        return -1;
+    }
+    open_nodes(sensors);
+    pthread_mutex_init(&sensors->lock, NULL);
+    pthread_cond_init(&sensors->wake, NULL);
+
+    // 第一次采样同步进行，读者启动后立即有值 (CPU占用要等第二次采样)
+    publish_sample(sensors);
+
+    if (pthread_create(&sensors->thread, NULL, sampler_main, sensors) != 0) {
+        sensors_stop(sensors);
+        return -1;
+    }
+    sensors->thread_started = 1;
+    return 0;
+}
+
+void sensors_stop(sensors_t* sensors) {
+    if (sensors->thread_started) {
+        pthread_mutex_lock(&sensors->lock);
+        sensors->stop = 1;
+        pthread_cond_signal(&sensors->wake);
+        pthread_mutex_unlock(&sensors->lock);
+        pthread_join(sensors->thread, NULL);
+    }
+    if (sensors->samples.block) {
+        close_nodes(sensors);
+        pthread_cond_destroy(&sensors->wake);
+        pthread_mutex_destroy(&sensors->lock);
+        triple_buffer_destroy(&sensors->samples);
+    }
+    memset(sensors, 0, sizeof(*sensors));
+}
+
+const sensors_sample_t* sensors_latest(sensors_t* sensors) {
+    if (!sensors->samples.block) {
+        return NULL;
+    }
+    return triple_buffer_read(&sensors->samples, NULL);
+}
+
+void sensors_describe(const sensors_t* sensors, char* text, size_t size) {
+    snprintf(text, size, "cpufreq %s%s%s, %d thermal zone(s), load %s, battery %s",
+             sensors->freq_fd >= 0 ? "yes" : "no",
+             sensors->governor[0] ? " " : "", sensors->governor,
+             sensors->zone_count,
+             sensors->stat_fd >= 0 ? "yes" : "no",
+             sensors->battery_fd >= 0 ? sensors->battery_name : "no");
+}
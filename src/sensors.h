@@ -0,0 +1,67 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "triple-buffer.h"
+
+// 系统传感器采样: 掌机上的掉帧常常来自温度降频或调速器，而不是程序本身。
+//
+// 启动时打开所有能找到的节点 (cpu0的 scaling_cur_freq/scaling_max_freq、各 thermal_zone*/temp、
+// /proc/stat、power_supply中电池的 capacity/status)，后台线程按间隔用 pread 从偏移0重新读取，
+// 不再打开文件或分配内存。每次采样通过三缓冲发布给一个读者 (渲染线程)。
+// 找不到的节点对应的值为未知，什么都没有时照常运行，可以在任何Linux主机上使用。
+
+#define SENSORS_MAX_ZONES 8
+#define SENSORS_DEFAULT_INTERVAL_MS 500
+#define SENSORS_UNKNOWN (-1)
+#define SENSORS_NO_TEMP INT32_MIN
+
+typedef struct {
+    unsigned sequence;           // 第几次采样 (从1开始)
+    int cpu_khz;                 // cpu0当前频率
+    int cpu_max_khz;             // 调速器当前允许的最高频率 (降频时变小)
+    int temp_mc;                 // 最热的温区 (毫摄氏度)，SENSORS_NO_TEMP为未知
+    int load_permille;           // 与上次采样之间的CPU占用 (所有核，千分比)
+    int battery_pct;
+    int charging;                // 电池状态为 Charging 或 Full
+    int sample_us;               // 这次采样的耗时
+} sensors_sample_t;
+
+typedef struct {
+    int interval_ms;
+    int freq_fd;                 // 以下不存在时为-1
+    int max_freq_fd;
+    int zone_fds[SENSORS_MAX_ZONES];
+    int zone_count;
+    int stat_fd;
+    int battery_fd;
+    int battery_status_fd;
+    char governor[32];
+    char battery_name[32];
+
+    // 只由采样线程访问
+    unsigned sequence;
+    unsigned long long last_busy;
+    unsigned long long last_total;
+
+    triple_buffer_t samples;
+    pthread_t thread;
+    int thread_started;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int stop;
+} sensors_t;
+
+// 打开节点，同步采样一次后启动采样线程。线程或缓冲创建失败返回-1
+int sensors_start(sensors_t* sensors, int interval_ms);
+void sensors_stop(sensors_t* sensors);
+
+// 读者 (只有一个线程): 最新的采样，还没有时返回NULL
+const sensors_sample_t* sensors_latest(sensors_t* sensors);
+
+// 找到的节点 (写入日志)
+void sensors_describe(const sensors_t* sensors, char* text, size_t size);
+
+#endif
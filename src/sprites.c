@@ -0,0 +1,261 @@
+#include "sprites.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPRITES_HAVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SPRITES_HAVE_SSE2 1
+#endif
+
+#define SPRITES_ALIGN 16
+
+int sprites_init(sprite_store_t* store, int capacity) {
+    memset(store, 0, sizeof(*store));
+    if (capacity <= 0) return -1;
+
+    // 容量按4对齐，向量循环不需要处理尾部
+    int padded = (capacity + 3) & ~3;
+    size_t floats = (size_t)padded * sizeof(float);
+    size_t total = floats * 6 + (size_t)padded * sizeof(uint32_t) + (size_t)padded;
+    uint8_t* block = aligned_alloc(SPRITES_ALIGN, (total + SPRITES_ALIGN - 1) & ~(size_t)(SPRITES_ALIGN - 1));
+    if (!block) return -1;
+    memset(block, 0, total);
+
+    store->block = block;
+    store->capacity = capacity;
+    store->x = (float*)block;
+    store->y = (float*)(block + floats);
+    store->vx = (float*)(block + floats * 2);
+    store->vy = (float*)(block + floats * 3);
+    store->w = (float*)(block + floats * 4);
+    store->h = (float*)(block + floats * 5);
+    store->color = (uint32_t*)(block + floats * 6);
+    store->bounced = block + floats * 6 + (size_t)padded * sizeof(uint32_t);
+    return 0;
+}
+
+void sprites_destroy(sprite_store_t* store) {
+    free(store->block);
+    memset(store, 0, sizeof(*store));
+}
+
+int sprites_add(sprite_store_t* store, float x, float y, float w, float h,
+                float vx, float vy, uint32_t color) {
+    if (store->count >= store->capacity) return -1;
+    int i = store->count++;
+    store->x[i] = x;
+    store->y[i] = y;
+    store->vx[i] = vx;
+    store->vy[i] = vy;
+    store->w[i] = w;
+    store->h[i] = h;
+    store->color[i] = color;
+    store->bounced[i] = 0;
+    return i;
+}
+
+// 一个轴的移动和反弹 (标量版本，也用条件选择而不是分支)
+static inline uint8_t step_axis(float* pos, float* vel, float size, float dt, float lo, float max) {
+    float hi = max - size;
+    float p = *pos + *vel * dt;
+    int out = (p <= lo) | (p >= hi);
+    *vel = out ? -*vel : *vel;
+    p = p < lo ? lo : p;
+    p = p > hi ? hi : p;
+    *pos = p;
+    return (uint8_t)out;
+}
+
+void sprites_update(sprite_store_t* store, float dt, float min_x, float min_y, float max_x, float max_y) {
+    float* x = store->x;
+    float* y = store->y;
+    float* vx = store->vx;
+    float* vy = store->vy;
+    const float* w = store->w;
+    const float* h = store->h;
+    uint8_t* bounced = store->bounced;
+    int n = (store->count + 3) & ~3;
+    int i = 0;
+
+#if defined(SPRITES_HAVE_NEON)
+    float32x4_t vdt = vdupq_n_f32(dt);
+    float32x4_t lo_x = vdupq_n_f32(min_x), lo_y = vdupq_n_f32(min_y);
+    float32x4_t max_xv = vdupq_n_f32(max_x), max_yv = vdupq_n_f32(max_y);
+    uint32x4_t bit_x = vdupq_n_u32(SPRITE_BOUNCE_X), bit_y = vdupq_n_u32(SPRITE_BOUNCE_Y);
+    for (; i < n; i += 4) {
+        float32x4_t px = vaddq_f32(vld1q_f32(x + i), vmulq_f32(vld1q_f32(vx + i), vdt));
+        float32x4_t py = vaddq_f32(vld1q_f32(y + i), vmulq_f32(vld1q_f32(vy + i), vdt));
+        float32x4_t hi_x = vsubq_f32(max_xv, vld1q_f32(w + i));
+        float32x4_t hi_y = vsubq_f32(max_yv, vld1q_f32(h + i));
+        uint32x4_t out_x = vorrq_u32(vcleq_f32(px, lo_x), vcgeq_f32(px, hi_x));
+        uint32x4_t out_y = vorrq_u32(vcleq_f32(py, lo_y), vcgeq_f32(py, hi_y));
+
+        float32x4_t vel_x = vld1q_f32(vx + i);
+        float32x4_t vel_y = vld1q_f32(vy + i);
+        vst1q_f32(vx + i, vbslq_f32(out_x, vnegq_f32(vel_x), vel_x));
+        vst1q_f32(vy + i, vbslq_f32(out_y, vnegq_f32(vel_y), vel_y));
+        vst1q_f32(x + i, vminq_f32(vmaxq_f32(px, lo_x), hi_x));
+        vst1q_f32(y + i, vminq_f32(vmaxq_f32(py, lo_y), hi_y));
+
+        // 4个32位标志收窄为4个字节
+        uint32x4_t bits = vorrq_u32(vandq_u32(out_x, bit_x), vandq_u32(out_y, bit_y));
+        uint16x4_t bits16 = vmovn_u32(bits);
+        uint8x8_t bits8 = vmovn_u16(vcombine_u16(bits16, bits16));
+        vst1_lane_u32((uint32_t*)(bounced + i), vreinterpret_u32_u8(bits8), 0);
+    }
+#elif defined(SPRITES_HAVE_SSE2)
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 lo_x = _mm_set1_ps(min_x), lo_y = _mm_set1_ps(min_y);
+    __m128 max_xv = _mm_set1_ps(max_x), max_yv = _mm_set1_ps(max_y);
+    __m128 sign = _mm_set1_ps(-0.0f);
+    for (; i < n; i += 4) {
+        __m128 vel_x = _mm_load_ps(vx + i);
+        __m128 vel_y = _mm_load_ps(vy + i);
+        __m128 px = _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(vel_x, vdt));
+        __m128 py = _mm_add_ps(_mm_load_ps(y + i), _mm_mul_ps(vel_y, vdt));
+        __m128 hi_x = _mm_sub_ps(max_xv, _mm_load_ps(w + i));
+        __m128 hi_y = _mm_sub_ps(max_yv, _mm_load_ps(h + i));
+        __m128 out_x = _mm_or_ps(_mm_cmple_ps(px, lo_x), _mm_cmpge_ps(px, hi_x));
+        __m128 out_y = _mm_or_ps(_mm_cmple_ps(py, lo_y), _mm_cmpge_ps(py, hi_y));
+
+        // 越界的速度翻转符号位
+        _mm_store_ps(vx + i, _mm_xor_ps(vel_x, _mm_and_ps(out_x, sign)));
+        _mm_store_ps(vy + i, _mm_xor_ps(vel_y, _mm_and_ps(out_y, sign)));
+        _mm_store_ps(x + i, _mm_min_ps(_mm_max_ps(px, lo_x), hi_x));
+        _mm_store_ps(y + i, _mm_min_ps(_mm_max_ps(py, lo_y), hi_y));
+
+        int mask_x = _mm_movemask_ps(out_x);
+        int mask_y = _mm_movemask_ps(out_y);
+        for (int k = 0; k < 4; k++) {
+            bounced[i + k] = (uint8_t)(((mask_x >> k) & 1) * SPRITE_BOUNCE_X |
+                                       ((mask_y >> k) & 1) * SPRITE_BOUNCE_Y);
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        uint8_t bx = step_axis(&x[i], &vx[i], w[i], dt, min_x, max_x);
+        uint8_t by = step_axis(&y[i], &vy[i], h[i], dt, min_y, max_y);
+        bounced[i] = (uint8_t)(bx * SPRITE_BOUNCE_X | by * SPRITE_BOUNCE_Y);
+    }
+}
+
+int sprite_grid_init(sprite_grid_t* grid, float x, float y, float w, float h,
+                     float cell_size, int capacity) {
+    memset(grid, 0, sizeof(*grid));
+    if (cell_size <= 0 || w <= 0 || h <= 0 || capacity <= 0) return -1;
+
+    grid->origin_x = x;
+    grid->origin_y = y;
+    grid->cell_size = cell_size;
+    grid->cols = (int)(w / cell_size) + 1;
+    grid->rows = (int)(h / cell_size) + 1;
+    grid->capacity = capacity;
+    grid->cell_start = calloc((size_t)grid->cols * grid->rows + 1, sizeof(int));
+    grid->items = malloc((size_t)capacity * sizeof(int));
+    grid->cell_of = malloc((size_t)capacity * sizeof(int));
+    if (!grid->cell_start || !grid->items || !grid->cell_of) {
+        sprite_grid_destroy(grid);
+        return -1;
+    }
+    return 0;
+}
+
+void sprite_grid_destroy(sprite_grid_t* grid) {
+    free(grid->cell_start);
+    free(grid->items);
+    free(grid->cell_of);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static inline int clamp_cell(int v, int limit) {
+    return v < 0 ? 0 : (v >= limit ? limit - 1 : v);
+}
+
+void sprite_grid_build(sprite_grid_t* grid, const sprite_store_t* store) {
+    int cells = grid->cols * grid->rows;
+    int count = store->count < grid->capacity ? store->count : grid->capacity;
+    float inv = 1.0f / grid->cell_size;
+    int* start = grid->cell_start;
+
+    // 计数排序: 先统计每个格子的精灵数，再求前缀和得到起始位置
+    memset(start, 0, (size_t)(cells + 1) * sizeof(int));
+    for (int i = 0; i < count; i++) {
+        int cx = clamp_cell((int)((store->x[i] + store->w[i] * 0.5f - grid->origin_x) * inv), grid->cols);
+        int cy = clamp_cell((int)((store->y[i] + store->h[i] * 0.5f - grid->origin_y) * inv), grid->rows);
+        int cell = cy * grid->cols + cx;
+        grid->cell_of[i] = cell;
+        start[cell + 1]++;
+    }
+    for (int c = 0; c < cells; c++) {
+        start[c + 1] += start[c];
+    }
+    // 用cell_start[c]作为写入位置，写完后整体后移一格
+    for (int i = 0; i < count; i++) {
+        grid->items[start[grid->cell_of[i]]++] = i;
+    }
+    memmove(start + 1, start, (size_t)cells * sizeof(int));
+    start[0] = 0;
+}
+
+int sprite_grid_collide(const sprite_grid_t* grid, const sprite_store_t* store,
+                        sprite_pair_t* pairs, int max_pairs) {
+    const float* x = store->x;
+    const float* y = store->y;
+    const float* w = store->w;
+    const float* h = store->h;
+    int count = store->count < grid->capacity ? store->count : grid->capacity;
+    int found = 0;
+
+    for (int a = 0; a < count; a++) {
+        int cell = grid->cell_of[a];
+        int cx = cell % grid->cols;
+        int cy = cell / grid->cols;
+        int x0 = cx > 0 ? cx - 1 : 0, x1 = cx + 1 < grid->cols ? cx + 1 : cx;
+        int y0 = cy > 0 ? cy - 1 : 0, y1 = cy + 1 < grid->rows ? cy + 1 : cy;
+        float ax1 = x[a] + w[a], ay1 = y[a] + h[a];
+
+        for (int gy = y0; gy <= y1; gy++) {
+            const int* row = grid->cell_start + gy * grid->cols;
+            for (int k = row[x0]; k < row[x1 + 1]; k++) {
+                int b = grid->items[k];
+                // 每对只在下标较小的一方报告一次
+                if (b <= a) continue;
+                if (x[b] < ax1 && x[a] < x[b] + w[b] && y[b] < ay1 && y[a] < y[b] + h[b]) {
+                    if (found < max_pairs) {
+                        pairs[found].a = a;
+                        pairs[found].b = b;
+                    }
+                    found++;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+void sprites_draw(const sprite_store_t* store, pixel_format_t format, void* pixels, int pitch,
+                  int width, int height) {
+    int bytes = pixel_format_bytes(format);
+    for (int i = 0; i < store->count; i++) {
+        int x0 = (int)store->x[i];
+        int y0 = (int)store->y[i];
+        int x1 = x0 + (int)store->w[i];
+        int y1 = y0 + (int)store->h[i];
+        if (x0 < 0) x0 = 0;
+        if (y0 < 0) y0 = 0;
+        if (x1 > width) x1 = width;
+        if (y1 > height) y1 = height;
+        if (x0 >= x1 || y0 >= y1) continue;
+
+        uint32_t pixel = pixel_map(format, store->color[i]);
+        uint8_t* row = (uint8_t*)pixels + (size_t)y0 * pitch + (size_t)x0 * bytes;
+        for (int y = y0; y < y1; y++, row += pitch) {
+            pixel_fill_row(format, row, pixel, x1 - x0);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef SPRITES_H
+#define SPRITES_H
+
+#include <stdint.h>
+#include "pixel-format.h"
+
+// 精灵子系统 (不依赖SDL): 大量矩形精灵的移动、边界反弹、网格碰撞检测和批量绘制。
+//
+// 数据按字段分开存放 (SoA)，同一字段连续排列，移动和反弹对整个数组一次处理，
+// 有NEON/SSE2时每次处理4个精灵，没有分支。数组容量按4对齐，补齐部分不参与绘制和碰撞。
+// 所有内存在 sprites_init / sprite_grid_init 时一次分配，每帧不再分配。
+
+#define SPRITE_BOUNCE_X 1
+#define SPRITE_BOUNCE_Y 2
+
+typedef struct {
+    int count;
+    int capacity;
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* w;
+    float* h;
+    uint32_t* color;             // 0xRRGGBB
+    uint8_t* bounced;            // 最近一次更新的反弹标志 (SPRITE_BOUNCE_X/Y)
+    void* block;                 // 所有数组共用的一块内存
+} sprite_store_t;
+
+// 碰撞检测的结果: 两个精灵的下标 (a < b)
+typedef struct {
+    int a;
+    int b;
+} sprite_pair_t;
+
+// 均匀网格: 每个精灵按中心点放进一个格子，格子边长不小于最大的精灵，
+// 因此只需检查相邻的3x3个格子
+typedef struct {
+    float origin_x, origin_y;
+    float cell_size;
+    int cols, rows;
+    int* cell_start;             // cols*rows+1 个，格子i的精灵是 items[cell_start[i] .. cell_start[i+1])
+    int* items;                  // 按格子排列的精灵下标
+    int* cell_of;                // 每个精灵所在的格子
+    int capacity;
+} sprite_grid_t;
+
+// 分配最多capacity个精灵的存储，失败返回-1
+int sprites_init(sprite_store_t* store, int capacity);
+void sprites_destroy(sprite_store_t* store);
+
+// 添加一个精灵，返回下标，已满返回-1
+int sprites_add(sprite_store_t* store, float x, float y, float w, float h,
+                float vx, float vy, uint32_t color);
+
+// 按速度移动dt个时间单位；碰到 [min, max) 边界时速度取反、位置夹回边界内，并记录反弹标志
+void sprites_update(sprite_store_t* store, float dt, float min_x, float min_y, float max_x, float max_y);
+
+// 网格覆盖 (x, y, w, h) 的区域，区域外的精灵归到边缘的格子。失败返回-1
+int sprite_grid_init(sprite_grid_t* grid, float x, float y, float w, float h,
+                     float cell_size, int capacity);
+void sprite_grid_destroy(sprite_grid_t* grid);
+
+// 按当前位置重建网格 (计数排序，O(n))
+void sprite_grid_build(sprite_grid_t* grid, const sprite_store_t* store);
+
+// 找出所有重叠的精灵对，最多写入max_pairs个，返回重叠的总对数
+int sprite_grid_collide(const sprite_grid_t* grid, const sprite_store_t* store,
+                        sprite_pair_t* pairs, int max_pairs);
+
+// 把所有精灵按顺序填充到原生格式的像素缓冲区 (自动裁剪)
+void sprites_draw(const sprite_store_t* store, pixel_format_t format, void* pixels, int pitch,
+                  int width, int height);
+
+#endif
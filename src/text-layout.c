@@ -0,0 +1,361 @@
+#include "text-layout.h"
+#include "utf8.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ADVANCE_TABLE_SIZE 4096
+
+// 不能放在行首的字符 (行首禁则)，按码位排序
+static const uint16_t no_start_chars[] = {
+    '!', '%', ')', ',', '.', ':', ';', '?', ']', '}',
+    0x2019, 0x201D, 0x2025, 0x2026,
+    0x3001, 0x3002, 0x3005, 0x3009, 0x300B, 0x300D, 0x300F, 0x3011, 0x3015, 0x3017, 0x3019, 0x301B,
+    0x3041, 0x3043, 0x3045, 0x3047, 0x3049, 0x3063, 0x3083, 0x3085, 0x3087, 0x308E, 0x3095, 0x3096,
+    0x309D, 0x309E,
+    0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30C3, 0x30E3, 0x30E5, 0x30E7, 0x30EE, 0x30F5, 0x30F6,
+    0x30FB, 0x30FC, 0x30FD, 0x30FE,
+    0xFF01, 0xFF05, 0xFF09, 0xFF0C, 0xFF0E, 0xFF1A, 0xFF1B, 0xFF1F, 0xFF3D, 0xFF5D,
+    0xFF61, 0xFF63, 0xFF64,
+};
+
+// 不能放在行尾的字符 (行尾禁则)
+static const uint16_t no_end_chars[] = {
+    '(', '[', '{',
+    0x2018, 0x201C,
+    0x3008, 0x300A, 0x300C, 0x300E, 0x3010, 0x3014, 0x3016, 0x3018, 0x301A,
+    0xFF08, 0xFF3B, 0xFF5B, 0xFF62,
+};
+
+static int in_table(const uint16_t* table, int count, uint32_t cp) {
+    if (cp > 0xFFFF) return 0;
+    int lo = 0, hi = count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (table[mid] == cp) return 1;
+        if (table[mid] < cp) lo = mid + 1; else hi = mid - 1;
+    }
+    return 0;
+}
+
+static int no_start(uint32_t cp) {
+    return in_table(no_start_chars, sizeof(no_start_chars) / sizeof(no_start_chars[0]), cp);
+}
+
+static int no_end(uint32_t cp) {
+    return in_table(no_end_chars, sizeof(no_end_chars) / sizeof(no_end_chars[0]), cp);
+}
+
+static int is_space(uint32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == 0x3000;
+}
+
+// 中日韩文字和全角符号: 字符之间可以断行
+static int is_cjk(uint32_t cp) {
+    return (cp >= 0x1100 && cp <= 0x11FF) ||     // 韩文字母
+           (cp >= 0x2E80 && cp <= 0x2FFF) ||     // 部首
+           (cp >= 0x3000 && cp <= 0x33FF) ||     // 标点、假名、注音、带圈字符
+           (cp >= 0x3400 && cp <= 0x4DBF) ||
+           (cp >= 0x4E00 && cp <= 0x9FFF) ||
+           (cp >= 0xA960 && cp <= 0xA97F) ||
+           (cp >= 0xAC00 && cp <= 0xD7AF) ||     // 韩文音节
+           (cp >= 0xF900 && cp <= 0xFAFF) ||
+           (cp >= 0xFE30 && cp <= 0xFE4F) ||
+           (cp >= 0xFF00 && cp <= 0xFF64) ||     // 全角字母和标点、半角标点
+           (cp >= 0xFFE0 && cp <= 0xFFE6) ||
+           (cp >= 0x20000 && cp <= 0x3FFFF);
+}
+
+// prev和cp之间能否断行
+static int can_break(uint32_t prev, uint32_t cp) {
+    if (is_space(cp)) return 0;                  // 空格留在上一行末尾
+    if (no_start(cp) || no_end(prev)) return 0;
+    if (is_space(prev) || prev == '-') return 1;
+    return is_cjk(prev) || is_cjk(cp);
+}
+
+static uint32_t hash_key(const char* text, size_t len, int font, int max_width, int max_lines) {
+    uint32_t h = 2166136261u;                    // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    }
+    h = (h ^ (uint32_t)font) * 16777619u;
+    h = (h ^ (uint32_t)max_width) * 16777619u;
+    h = (h ^ (uint32_t)max_lines) * 16777619u;
+    return h;
+}
+
+int text_layout_init(text_layout_cache_t* cache, int capacity, const text_metrics_t* metrics) {
+    memset(cache, 0, sizeof(*cache));
+    if (capacity < 1) {
+        return -1;
+    }
+    // 桶数为不小于容量的2的幂，链表平均不超过一项
+    uint32_t buckets = 1;
+    while (buckets < (uint32_t)capacity) buckets <<= 1;
+    cache->entries = calloc(capacity, sizeof(text_layout_t));
+    cache->buckets = malloc(buckets * sizeof(int));
+    cache->advances = calloc(ADVANCE_TABLE_SIZE, sizeof(text_advance_t));
+    if (!cache->entries || !cache->buckets || !cache->advances) {
+        text_layout_destroy(cache);
+        return -1;
+    }
+    cache->capacity = capacity;
+    cache->bucket_mask = buckets - 1;
+    memset(cache->buckets, 0xFF, buckets * sizeof(int));
+    cache->advance_capacity = ADVANCE_TABLE_SIZE;
+    cache->metrics = *metrics;
+    return 0;
+}
+
+void text_layout_destroy(text_layout_cache_t* cache) {
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache->advances);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void text_layout_clear(text_layout_cache_t* cache) {
+    cache->count = 0;
+    memset(cache->buckets, 0xFF, (cache->bucket_mask + 1) * sizeof(int));
+    cache->advance_count = 0;
+    memset(cache->advances, 0, cache->advance_capacity * sizeof(text_advance_t));
+}
+
+int text_layout_advance(text_layout_cache_t* cache, int font, uint32_t cp) {
+    uint32_t key = ((uint32_t)font << 21) | (cp & 0x1FFFFF);
+    uint32_t mask = cache->advance_capacity - 1;
+    uint32_t i = (key * 2654435761u) & mask;
+    cache->stats.advance_lookups++;
+    while (cache->advances[i].key) {
+        if (cache->advances[i].key == key) {
+            return cache->advances[i].advance;
+        }
+        i = (i + 1) & mask;
+    }
+
+    int advance = cache->metrics.advance(cache->metrics.context, font, cp);
+    cache->stats.advance_misses++;
+    if (cache->advance_count >= cache->advance_capacity * 3 / 4) {
+        // 表太满时整个清空，常用的字很快会重新填进来
+        memset(cache->advances, 0, cache->advance_capacity * sizeof(text_advance_t));
+        cache->advance_count = 0;
+        i = (key * 2654435761u) & mask;
+    }
+    cache->advances[i].key = key;
+    cache->advances[i].advance = advance;
+    cache->advance_count++;
+    return advance;
+}
+
+// 排版用的宽度，缺字按0计
+static int char_width(text_layout_cache_t* cache, int font, uint32_t cp) {
+    int advance = text_layout_advance(cache, font, cp);
+    return advance > 0 ? advance : 0;
+}
+
+int text_layout_measure(text_layout_cache_t* cache, const char* text, int font) {
+    int width = 0;
+    const char* p = text;
+    uint32_t cp;
+    while ((cp = utf8_next(&p)) != 0) {
+        int advance = text_layout_advance(cache, font, cp);
+        if (advance < 0) return -1;
+        width += advance;
+    }
+    return width;
+}
+
+// 从line开始找一行的结尾: end为这一行 (含行尾空格) 的结尾，next为下一行的开头，width不含行尾空格。
+// 遇到'\n'时返回1
+static int find_break(text_layout_cache_t* cache, int font, const char* line, int max_width,
+                      const char** end, const char** next, int* width) {
+    const char* p = line;
+    const char* brk = NULL;
+    int brk_width = 0;
+    int total = 0, trimmed = 0;
+    uint32_t prev = 0;
+
+    for (;;) {
+        const char* q = p;
+        uint32_t cp = utf8_next(&q);
+        if (cp == 0 || cp == '\n') {
+            *end = p;
+            *next = cp ? q : p;
+            *width = trimmed;
+            return cp == '\n';
+        }
+        if (prev && can_break(prev, cp)) {
+            brk = p;
+            brk_width = trimmed;
+        }
+        int advance = char_width(cache, font, cp);
+        if (!is_space(cp) && total + advance > max_width && p > line) {
+            // 超宽: 退回最后一个断行点，没有时在这个字前面强制断开
+            *end = *next = brk ? brk : p;
+            *width = brk ? brk_width : trimmed;
+            return 0;
+        }
+        total += advance;
+        if (!is_space(cp)) trimmed = total;
+        prev = cp;
+        p = q;
+    }
+}
+
+static const char* skip_spaces(const char* p) {
+    for (;;) {
+        const char* q = p;
+        if (!is_space(utf8_next(&q))) return p;
+        p = q;
+    }
+}
+
+// 去掉行尾的空格 (ASCII空格、制表符和全角空格)
+static const char* trim_end(const char* line, const char* end) {
+    for (;;) {
+        if (end > line && (end[-1] == ' ' || end[-1] == '\t')) {
+            end--;
+        } else if (end - line >= 3 && memcmp(end - 3, "\xE3\x80\x80", 3) == 0) {
+            end -= 3;
+        } else {
+            return end;
+        }
+    }
+}
+
+static char* emit_line(text_layout_t* layout, char* out, const char* line, const char* end,
+                       int width, const char* suffix) {
+    size_t len = end - line;
+    memcpy(out, line, len);
+    size_t suffix_len = suffix ? strlen(suffix) : 0;
+    if (suffix_len) memcpy(out + len, suffix, suffix_len);
+    out[len + suffix_len] = '\0';
+
+    text_line_t* l = &layout->lines[layout->line_count++];
+    l->text = out;
+    l->width = width;
+    if (width > layout->width) layout->width = width;
+    return out + len + suffix_len + 1;
+}
+
+// 最后一行放不下剩余的文字: 按字符截短到能放下省略号为止
+static void emit_ellipsized(text_layout_cache_t* cache, text_layout_t* layout, char* out,
+                            const char* line, int max_width) {
+    const char* ellipsis = TEXT_LAYOUT_ELLIPSIS;
+    int ellipsis_width = text_layout_measure(cache, ellipsis, layout->font);
+    if (ellipsis_width < 0) {
+        ellipsis = "...";
+        ellipsis_width = char_width(cache, layout->font, '.') * 3;
+    }
+
+    int limit = max_width - ellipsis_width;
+    const char* p = line;
+    const char* end = line;
+    int total = 0, width = 0;
+    for (;;) {
+        const char* q = p;
+        uint32_t cp = utf8_next(&q);
+        if (cp == 0 || cp == '\n') break;
+        int advance = char_width(cache, layout->font, cp);
+        if (total + advance > limit) break;
+        total += advance;
+        p = q;
+        if (!is_space(cp)) {
+            end = p;
+            width = total;
+        }
+    }
+    emit_line(layout, out, line, end, width + ellipsis_width, ellipsis);
+    layout->ellipsized = 1;
+}
+
+static void layout_text(text_layout_cache_t* cache, text_layout_t* layout) {
+    int max_width = layout->max_width > 0 ? layout->max_width : INT_MAX;
+    int max_lines = layout->max_lines > 0 && layout->max_lines < TEXT_LAYOUT_MAX_LINES
+                        ? layout->max_lines : TEXT_LAYOUT_MAX_LINES;
+    char* out = layout->buffer;
+    const char* line = layout->key;
+
+    layout->width = 0;
+    layout->line_count = 0;
+    layout->ellipsized = 0;
+    while (*line) {
+        const char* end;
+        const char* next;
+        int width;
+        int hard = find_break(cache, layout->font, line, max_width, &end, &next, &width);
+        // 软换行后的行首空格丢弃，'\n'后的保留 (缩进)
+        const char* rest = hard ? next : skip_spaces(next);
+
+        if (layout->line_count == max_lines - 1 && *rest) {
+            emit_ellipsized(cache, layout, out, line, max_width);
+            break;
+        }
+        out = emit_line(layout, out, line, trim_end(line, end), width, NULL);
+        line = rest;
+    }
+
+    layout->line_height = cache->metrics.line_height(cache->metrics.context, layout->font);
+    layout->height = layout->line_count * layout->line_height;
+}
+
+const text_layout_t* text_layout_get(text_layout_cache_t* cache, const char* text, int font,
+                                     int max_width, int max_lines) {
+    if (!text) text = "";
+    size_t len = strlen(text);
+    if (len >= TEXT_LAYOUT_MAX_TEXT) {
+        // 截断时不留下半个UTF-8字符
+        len = TEXT_LAYOUT_MAX_TEXT - 1;
+        while (len > 0 && ((unsigned char)text[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    if (max_width < 0) max_width = 0;
+    if (max_lines < 0) max_lines = 0;
+    uint32_t hash = hash_key(text, len, font, max_width, max_lines);
+    cache->stats.layouts++;
+    cache->clock++;
+
+    int* bucket = &cache->buckets[hash & cache->bucket_mask];
+    for (int i = *bucket; i >= 0; i = cache->entries[i].chain) {
+        text_layout_t* layout = &cache->entries[i];
+        if (layout->hash == hash && layout->font == font && layout->max_width == max_width &&
+            layout->max_lines == max_lines && memcmp(layout->key, text, len) == 0 && layout->key[len] == '\0') {
+            layout->last_used = cache->clock;
+            cache->stats.layout_hits++;
+            return layout;
+        }
+    }
+
+    // 未命中: 有空位用空位，否则替换最久没用的 (先从它的桶里摘下来)
+    text_layout_t* layout;
+    if (cache->count < cache->capacity) {
+        layout = &cache->entries[cache->count++];
+    } else {
+        layout = &cache->entries[0];
+        for (int i = 1; i < cache->count; i++) {
+            if (cache->entries[i].last_used < layout->last_used) {
+                layout = &cache->entries[i];
+            }
+        }
+        int index = (int)(layout - cache->entries);
+        int* link = &cache->buckets[layout->hash & cache->bucket_mask];
+        while (*link != index) {
+            link = &cache->entries[*link].chain;
+        }
+        *link = layout->chain;
+    }
+    layout->chain = *bucket;
+    *bucket = (int)(layout - cache->entries);
+    layout->hash = hash;
+    layout->font = font;
+    layout->max_width = max_width;
+    layout->max_lines = max_lines;
+    memcpy(layout->key, text, len);
+    layout->key[len] = '\0';
+    layout->last_used = cache->clock;
+    layout_text(cache, layout);
+    return layout;
+}
@@ -0,0 +1,97 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include <stdint.h>
+
+// 文字排版 (不依赖SDL): UTF-8解码后按字符的步进宽度折行，结果按 (字符串, 字号, 宽度, 行数) 缓存。
+//
+// 折行规则: 拉丁文字只在空格后 (和连字符后) 断开，中日韩文字每个字符之间都可以断开；
+// 避头尾 (禁则): 逗号句号、右括号、小假名等不放在行首，左括号不放在行尾，必要时把前一个字一起移到下一行。
+// 一个词比整行还宽时在字符之间强制断开。行尾的空格不计入宽度，软换行后的行首空格丢弃，'\n'强制换行。
+// 行数超过限制时最后一行截短并加省略号 "…" (字体没有这个字时用 "...")。
+//
+// 字符宽度通过回调取得 (字形包或完整字体)，按 (字号, 字符) 缓存在哈希表里，每个字只查一次。
+// 同一个标签每帧请求相同的排版时只是一次哈希比较，内容不变的标签不会重新测量。
+
+#define TEXT_LAYOUT_MAX_TEXT  512
+#define TEXT_LAYOUT_MAX_LINES 16
+#define TEXT_LAYOUT_ELLIPSIS  "\xE2\x80\xA6"    // U+2026
+
+// 字体度量回调。advance返回字符的步进宽度，字体没有这个字时返回-1
+typedef struct {
+    int (*advance)(void* context, int font, uint32_t cp);
+    int (*line_height)(void* context, int font);
+    void* context;
+} text_metrics_t;
+
+typedef struct {
+    const char* text;            // 这一行的文字 (以'\0'结尾，截短时已带省略号)
+    int width;
+} text_line_t;
+
+// 一次排版的结果，指针在下一次 text_layout_get 之前有效
+typedef struct {
+    uint32_t hash;
+    int font;
+    int max_width;
+    int max_lines;
+    char key[TEXT_LAYOUT_MAX_TEXT];
+    unsigned last_used;
+    int chain;                   // 同一个哈希桶的下一项，-1为结尾
+
+    int width;                   // 最宽一行的宽度
+    int height;                  // 行数 x 行高
+    int line_height;
+    int line_count;
+    int ellipsized;              // 行数超出限制，最后一行被截短
+    text_line_t lines[TEXT_LAYOUT_MAX_LINES];
+    char buffer[TEXT_LAYOUT_MAX_TEXT + TEXT_LAYOUT_MAX_LINES + 8];
+} text_layout_t;
+
+typedef struct {
+    uint32_t key;                // (字号 << 21) | 字符，0为空槽
+    int advance;
+} text_advance_t;
+
+typedef struct {
+    int layouts;                 // text_layout_get 的调用次数
+    int layout_hits;
+    int advance_lookups;
+    int advance_misses;          // 调用了度量回调的次数
+} text_layout_stats_t;
+
+typedef struct {
+    text_metrics_t metrics;
+    text_layout_t* entries;
+    int capacity;
+    int count;
+    int* buckets;                // 按哈希值索引的链表头 (entries的下标)，-1为空
+    uint32_t bucket_mask;
+    unsigned clock;
+
+    text_advance_t* advances;    // 开放寻址哈希表
+    int advance_capacity;        // 2的幂
+    int advance_count;
+
+    text_layout_stats_t stats;
+} text_layout_cache_t;
+
+// 分配capacity个排版结果的缓存，失败返回-1
+int text_layout_init(text_layout_cache_t* cache, int capacity, const text_metrics_t* metrics);
+void text_layout_destroy(text_layout_cache_t* cache);
+
+// 清空所有缓存 (字体或字形包变了时调用)
+void text_layout_clear(text_layout_cache_t* cache);
+
+// 排版text。max_width<=0时不自动折行 (只在'\n'处换行)，max_lines<=0时不限行数 (最多TEXT_LAYOUT_MAX_LINES)。
+// 相同参数命中缓存时不重新计算，缓存满时替换最久没用的一项
+const text_layout_t* text_layout_get(text_layout_cache_t* cache, const char* text, int font,
+                                     int max_width, int max_lines);
+
+// 单行文字的宽度 (不折行、不缓存排版结果)，有字符缺字时返回-1
+int text_layout_measure(text_layout_cache_t* cache, const char* text, int font);
+
+// 一个字符的步进宽度 (缓存)，缺字时返回-1
+int text_layout_advance(text_layout_cache_t* cache, int font, uint32_t cp);
+
+#endif
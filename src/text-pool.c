@@ -0,0 +1,184 @@
+#include "text-pool.h"
+
+#include <string.h>
+#include <SDL2/SDL_ttf.h>
+#include "utf8.h"
+
+static uint32_t hash_text(const char* text) {
+    uint32_t h = 2166136261u;
+    while (*text) {
+        h = (h ^ (uint8_t)*text++) * 16777619u;
+    }
+    return h;
+}
+
+int text_pool_init(text_pool_t* pool, SDL_Renderer* renderer, const glyph_pack_t* glyphs,
+                   font_cache_t* fonts, int use_surface, int slot_w, int slot_h) {
+    memset(pool, 0, sizeof(*pool));
+    pool->renderer = renderer;
+    pool->glyphs = glyphs;
+    pool->fonts = fonts;
+    pool->slot_w = slot_w;
+    pool->slot_h = slot_h;
+
+    int atlas_h = slot_h * TEXT_POOL_SLOTS;
+    if (use_surface) {
+        pool->surface = SDL_CreateRGBSurfaceWithFormat(0, slot_w, atlas_h, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!pool->surface) return -1;
+        SDL_SetSurfaceBlendMode(pool->surface, SDL_BLENDMODE_BLEND);
+    } else {
+        pool->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                          slot_w, atlas_h);
+        if (!pool->texture) return -1;
+        SDL_SetTextureBlendMode(pool->texture, SDL_BLENDMODE_BLEND);
+    }
+
+    for (int i = 0; i < TEXT_POOL_SLOTS; i++) {
+        pool->slots[i].y = i * slot_h;
+    }
+    return 0;
+}
+
+void text_pool_begin_frame(text_pool_t* pool) {
+    pool->frame++;
+}
+
+// A8字形按颜色着色，alpha取重叠处的最大值
+static void compose_pack(const glyph_pack_t* glyphs, const glyph_pack_size_t* size, const char* text,
+                         SDL_Color color, Uint8* pixels, int pitch, int width, int height) {
+    Uint32 rgb = ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | color.b;
+    int pen = 0;
+    uint32_t cp;
+    while ((cp = utf8_next(&text)) != 0) {
+        const glyph_pack_glyph_t* g = glyph_pack_find_glyph(glyphs, size, cp);
+        const uint8_t* bitmap = glyph_pack_bitmap(glyphs, g);
+        for (int row = 0; row < g->height; row++) {
+            int dy = size->ascent - g->top + row;
+            if (dy < 0 || dy >= height) continue;
+            Uint32* dst = (Uint32*)(pixels + dy * pitch);
+            for (int col = 0; col < g->width; col++) {
+                int dx = pen + g->left + col;
+                if (dx < 0 || dx >= width) continue;
+                Uint32 a = bitmap[row * g->width + col] * color.a / 255;
+                if (a > (dst[dx] >> 24)) {
+                    dst[dx] = (a << 24) | rgb;
+                }
+            }
+        }
+        pen += g->advance;
+    }
+}
+
+// 把文字合成到槽位，失败 (过大或无法渲染) 返回-1
+static int compose_slot(text_pool_t* pool, text_slot_t* slot, int ptsize, const char* text, SDL_Color color) {
+    const glyph_pack_size_t* size = pool->glyphs ? glyph_pack_find_size(pool->glyphs, ptsize) : NULL;
+    int width = size ? glyph_pack_measure(pool->glyphs, size, text) : -1;
+    SDL_Surface* rendered = NULL;
+    int height;
+
+    if (width > 0) {
+        height = size->ascent - size->descent;
+    } else {
+        // 字形包缺字时回退到完整字体 (只在字符串变化时渲染一次)
+        TTF_Font* font = font_cache_get(pool->fonts, ptsize);
+        if (!font) return -1;
+        rendered = TTF_RenderUTF8_Blended(font, text, color);
+        if (!rendered) return -1;
+        width = rendered->w;
+        height = rendered->h;
+    }
+    if (width <= 0 || width > pool->slot_w || height <= 0 || height > pool->slot_h) {
+        if (rendered) SDL_FreeSurface(rendered);
+        return -1;
+    }
+
+    Uint8* pixels;
+    int pitch;
+    SDL_Rect area = {0, slot->y, width, height};
+    if (pool->surface) {
+        pitch = pool->surface->pitch;
+        pixels = (Uint8*)pool->surface->pixels + slot->y * pitch;
+    } else if (SDL_LockTexture(pool->texture, &area, (void**)&pixels, &pitch) < 0) {
+        if (rendered) SDL_FreeSurface(rendered);
+        return -1;
+    }
+
+    for (int row = 0; row < height; row++) {
+        Uint8* dst = pixels + row * pitch;
+        if (rendered) {
+            memcpy(dst, (Uint8*)rendered->pixels + row * rendered->pitch, (size_t)width * 4);
+        } else {
+            memset(dst, 0, (size_t)width * 4);
+        }
+    }
+    if (!rendered) {
+        compose_pack(pool->glyphs, size, text, color, pixels, pitch, width, height);
+    }
+
+    if (pool->texture) {
+        SDL_UnlockTexture(pool->texture);
+    }
+    if (rendered) {
+        SDL_FreeSurface(rendered);
+    }
+    slot->w = width;
+    slot->h = height;
+    return 0;
+}
+
+const text_slot_t* text_pool_get(text_pool_t* pool, int ptsize, const char* text, SDL_Color color) {
+    size_t len = strlen(text);
+    if (len >= TEXT_POOL_MAX_TEXT) {
+        pool->rejects++;
+        return NULL;
+    }
+    uint32_t hash = hash_text(text);
+
+    // 查找相同的字符串，同时记下最久未用的槽位
+    text_slot_t* victim = NULL;
+    for (int i = 0; i < TEXT_POOL_SLOTS; i++) {
+        text_slot_t* slot = &pool->slots[i];
+        if (slot->valid && slot->hash == hash && slot->ptsize == ptsize &&
+            slot->color.r == color.r && slot->color.g == color.g &&
+            slot->color.b == color.b && slot->color.a == color.a &&
+            strcmp(slot->text, text) == 0) {
+            slot->last_used = pool->frame;
+            pool->hits++;
+            return slot;
+        }
+        if (slot->valid && slot->last_used == pool->frame) continue;
+        // 优先使用空槽位
+        if (!victim || (!slot->valid && victim->valid) ||
+            (slot->valid == victim->valid && slot->last_used < victim->last_used)) {
+            victim = slot;
+        }
+    }
+    if (!victim) {
+        pool->rejects++;
+        return NULL;
+    }
+
+    pool->misses++;
+    victim->valid = 0;
+    if (compose_slot(pool, victim, ptsize, text, color) < 0) {
+        pool->rejects++;
+        return NULL;
+    }
+    victim->ptsize = ptsize;
+    victim->color = color;
+    victim->hash = hash;
+    memcpy(victim->text, text, len + 1);
+    victim->valid = 1;
+    victim->last_used = pool->frame;
+    return victim;
+}
+
+void text_pool_destroy(text_pool_t* pool) {
+    if (pool->texture) {
+        SDL_DestroyTexture(pool->texture);
+    }
+    if (pool->surface) {
+        SDL_FreeSurface(pool->surface);
+    }
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,55 @@
+#ifndef TEXT_POOL_H
+#define TEXT_POOL_H
+
+#include <stdint.h>
+#include <SDL2/SDL.h>
+#include "font-cache.h"
+#include "glyph-pack.h"
+
+// 文字纹理池: 所有槽位在初始化时一次分配 (一张按最长字符串尺寸划分的图集)，
+// 字符串不变时直接复用上次的结果，变化时在原槽位上重新合成，主循环中不创建也不销毁纹理。
+//
+// 窗口模式使用流式纹理，帧缓冲模式使用表面 (只用于字形包缺字时的回退字体)。
+// 同一帧内用过的槽位不会被替换，因此命令缓冲中尚未提交的引用始终有效。
+
+#define TEXT_POOL_SLOTS    32
+#define TEXT_POOL_MAX_TEXT 512
+
+typedef struct {
+    int ptsize;
+    SDL_Color color;
+    uint32_t hash;
+    char text[TEXT_POOL_MAX_TEXT];
+    int valid;
+    int w, h;                    // 文字的实际尺寸
+    int y;                       // 在图集中的位置
+    unsigned int last_used;      // 最近一次使用的帧号
+} text_slot_t;
+
+typedef struct {
+    SDL_Renderer* renderer;
+    const glyph_pack_t* glyphs;
+    font_cache_t* fonts;
+    SDL_Texture* texture;        // 窗口模式的图集
+    SDL_Surface* surface;        // 帧缓冲模式的图集
+    int slot_w, slot_h;
+    unsigned int frame;
+    text_slot_t slots[TEXT_POOL_SLOTS];
+    int hits;
+    int misses;
+    int rejects;                 // 过大或本帧槽位已用完
+} text_pool_t;
+
+// 创建图集，每个槽位slot_w x slot_h；use_surface为真时使用表面而不是纹理。失败返回-1
+int text_pool_init(text_pool_t* pool, SDL_Renderer* renderer, const glyph_pack_t* glyphs,
+                   font_cache_t* fonts, int use_surface, int slot_w, int slot_h);
+
+// 每帧开始时调用
+void text_pool_begin_frame(text_pool_t* pool);
+
+// 获取文字对应的槽位，需要时重新合成。放不下或没有可替换的槽位时返回NULL
+const text_slot_t* text_pool_get(text_pool_t* pool, int ptsize, const char* text, SDL_Color color);
+
+void text_pool_destroy(text_pool_t* pool);
+
+#endif
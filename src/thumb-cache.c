@@ -0,0 +1,612 @@
+#include "thumb-cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#define st_mtim st_mtimespec
+#endif
+
+// 排队后超过这么多帧没有再被请求的，处理到时丢弃
+#define THUMB_STALE_FRAMES 2
+
+// 源图片的大小上限
+#define THUMB_MAX_SOURCE_BYTES (64 << 20)
+#define THUMB_MAX_SOURCE_SIZE  4096
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* p = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static uint64_t path_key(const char* path) {
+    return fnv1a(0xCBF29CE484222325ULL, path, strlen(path));
+}
+
+// ---------- BMP解码 (后台线程) ----------
+
+static uint32_t read_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 按位掩码取出分量并扩展到8位
+static uint32_t mask_channel(uint32_t value, uint32_t mask) {
+    if (!mask) return 255;
+    int shift = __builtin_ctz(mask);
+    int bits = __builtin_popcount(mask);
+    uint32_t v = (value & mask) >> shift;
+    return bits >= 8 ? v >> (bits - 8) : v * 255 / ((1u << bits) - 1);
+}
+
+static uint8_t* read_file(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size <= 0 || st.st_size > THUMB_MAX_SOURCE_BYTES) {
+        close(fd);
+        return NULL;
+    }
+    uint8_t* data = malloc(st.st_size);
+    size_t done = 0;
+    while (data && done < (size_t)st.st_size) {
+        ssize_t n = read(fd, data + done, st.st_size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            free(data);
+            data = NULL;
+            break;
+        }
+        done += n;
+    }
+    close(fd);
+    *size = done;
+    return data;
+}
+
+// 解码为0xAARRGGBB像素: 24/32位 (BI_RGB或BI_BITFIELDS) 和8位调色板，由下往上或由上往下的行
+static uint32_t* decode_bmp(const char* path, int* width, int* height) {
+    size_t size = 0;
+    uint8_t* file = read_file(path, &size);
+    if (!file) {
+        return NULL;
+    }
+    uint32_t* argb = NULL;
+    if (size < 54 || file[0] != 'B' || file[1] != 'M') {
+        goto done;
+    }
+
+    uint32_t data_offset = read_u32(file + 10);
+    uint32_t info_size = read_u32(file + 14);
+    int32_t w = (int32_t)read_u32(file + 18);
+    int32_t h = (int32_t)read_u32(file + 22);
+    uint32_t bpp = read_u16(file + 28);
+    uint32_t compression = read_u32(file + 30);
+    int top_down = h < 0;
+    if (top_down) h = -h;
+    if (info_size < 40 || w <= 0 || h <= 0 || w > THUMB_MAX_SOURCE_SIZE || h > THUMB_MAX_SOURCE_SIZE) {
+        goto done;
+    }
+
+    uint32_t masks[4] = {0x00FF0000, 0x0000FF00, 0x000000FF, 0};
+    if (compression == 3 && (bpp == 32 || bpp == 16)) {
+        // 掩码紧跟在40字节的信息头之后 (V3以上的信息头里也在同一位置)
+        if (size < 66) goto done;
+        masks[0] = read_u32(file + 54);
+        masks[1] = read_u32(file + 58);
+        masks[2] = read_u32(file + 62);
+        masks[3] = info_size >= 56 && size >= 70 ? read_u32(file + 66) : 0;
+    } else if (compression != 0 || (bpp != 24 && bpp != 32 && bpp != 8)) {
+        goto done;
+    }
+
+    uint32_t palette[256];
+    if (bpp == 8) {
+        uint32_t colors = read_u32(file + 46);
+        if (colors == 0 || colors > 256) colors = 256;
+        uint32_t palette_offset = 14 + info_size;
+        if (palette_offset + colors * 4 > size) goto done;
+        memset(palette, 0, sizeof(palette));
+        for (uint32_t i = 0; i < colors; i++) {
+            palette[i] = 0xFF000000 | (read_u32(file + palette_offset + i * 4) & 0xFFFFFF);
+        }
+    }
+
+    size_t stride = ((size_t)bpp * w + 31) / 32 * 4;
+    if (data_offset > size || stride * h > size - data_offset) {
+        goto done;
+    }
+    argb = malloc((size_t)w * h * sizeof(uint32_t));
+    if (!argb) {
+        goto done;
+    }
+    for (int y = 0; y < h; y++) {
+        const uint8_t* src = file + data_offset + stride * (top_down ? y : h - 1 - y);
+        uint32_t* dst = argb + (size_t)y * w;
+        for (int x = 0; x < w; x++) {
+            if (bpp == 8) {
+                dst[x] = palette[src[x]];
+            } else if (bpp == 24) {
+                const uint8_t* p = src + x * 3;
+                dst[x] = 0xFF000000 | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+            } else {
+                uint32_t v = bpp == 32 ? read_u32(src + x * 4) : read_u16(src + x * 2);
+                // BI_RGB的32位没有透明度 (第四个字节通常是0)
+                uint32_t a = compression == 3 && masks[3] ? mask_channel(v, masks[3]) : 255;
+                dst[x] = (a << 24) | (mask_channel(v, masks[0]) << 16) | (mask_channel(v, masks[1]) << 8) |
+                         mask_channel(v, masks[2]);
+            }
+        }
+    }
+    *width = w;
+    *height = h;
+
+done:
+    free(file);
+    return argb;
+}
+
+// ---------- 缩放和合成 (后台线程) ----------
+
+static inline uint32_t div255(uint32_t v) {
+    return (v + 1 + (v >> 8)) >> 8;
+}
+
+// 按比例缩小到能放进 max_w x max_h (不放大)，区域平均 (每个目标像素取覆盖的所有源像素的平均)。
+// 半透明像素先与背景合成，结果不透明
+static uint32_t* scale_to_fit(const uint32_t* src, int sw, int sh, int max_w, int max_h, uint32_t background,
+                              int* out_w, int* out_h) {
+    int dw = sw, dh = sh;
+    if (sw > max_w || sh > max_h) {
+        if ((int64_t)sw * max_h >= (int64_t)sh * max_w) {
+            dw = max_w;
+            dh = (int)((int64_t)sh * max_w / sw);
+        } else {
+            dh = max_h;
+            dw = (int)((int64_t)sw * max_h / sh);
+        }
+        if (dw < 1) dw = 1;
+        if (dh < 1) dh = 1;
+    }
+
+    uint32_t* dst = malloc((size_t)dw * dh * sizeof(uint32_t));
+    int* columns = malloc(sw * sizeof(int));
+    uint32_t* sums = malloc((size_t)dw * 4 * sizeof(uint32_t));
+    if (!dst || !columns || !sums) {
+        free(dst);
+        free(columns);
+        free(sums);
+        return NULL;
+    }
+    for (int x = 0; x < sw; x++) {
+        columns[x] = (int)((int64_t)x * dw / sw);   // 源像素所在的目标列
+    }
+
+    uint32_t bg_r = (background >> 16) & 0xFF, bg_g = (background >> 8) & 0xFF, bg_b = background & 0xFF;
+    for (int dy = 0; dy < dh; dy++) {
+        int y0 = (int)((int64_t)dy * sh / dh);
+        int y1 = (int)((int64_t)(dy + 1) * sh / dh);
+        if (y1 <= y0) y1 = y0 + 1;
+        memset(sums, 0, (size_t)dw * 4 * sizeof(uint32_t));
+        for (int y = y0; y < y1; y++) {
+            const uint32_t* row = src + (size_t)y * sw;
+            for (int x = 0; x < sw; x++) {
+                uint32_t p = row[x];
+                uint32_t a = p >> 24;
+                uint32_t r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+                if (a != 255) {
+                    r = div255(r * a + bg_r * (255 - a));
+                    g = div255(g * a + bg_g * (255 - a));
+                    b = div255(b * a + bg_b * (255 - a));
+                }
+                uint32_t* sum = sums + columns[x] * 4;
+                sum[0] += r;
+                sum[1] += g;
+                sum[2] += b;
+                sum[3]++;
+            }
+        }
+        uint32_t* out = dst + (size_t)dy * dw;
+        for (int dx = 0; dx < dw; dx++) {
+            const uint32_t* sum = sums + dx * 4;
+            uint32_t n = sum[3], half = n / 2;
+            out[dx] = 0xFF000000 | (((sum[0] + half) / n) << 16) | (((sum[1] + half) / n) << 8) | ((sum[2] + half) / n);
+        }
+    }
+    free(columns);
+    free(sums);
+    *out_w = dw;
+    *out_h = dh;
+    return dst;
+}
+
+// ---------- 加载一张缩略图 (后台线程) ----------
+
+static int write_file(const char* path, const void* data, size_t size) {
+    char tmp[THUMB_CACHE_MAX_PATH + 64];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    const uint8_t* p = data;
+    int rc = 0;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            rc = -1;
+            break;
+        }
+        p += n;
+        size -= n;
+    }
+    if (close(fd) < 0) rc = -1;
+    if (rc == 0) rc = rename(tmp, path);
+    if (rc < 0) unlink(tmp);
+    return rc;
+}
+
+typedef struct {
+    image_asset_t image;
+    void* memory;
+    size_t bytes;
+    int from_disk;
+    double ms;
+} thumb_result_t;
+
+static int load_thumb(const thumb_cache_t* cache, const char* path, thumb_result_t* result) {
+    const thumb_cache_config_t* config = &cache->config;
+    double start = now_ms();
+    memset(result, 0, sizeof(*result));
+
+    struct stat st;
+    if (stat(path, &st) < 0 || !S_ISREG(st.st_mode)) {
+        return -1;
+    }
+
+    // 磁盘缓存的文件名: 路径、源文件的mtime和大小以及输出参数的哈希
+    char disk_path[THUMB_CACHE_MAX_PATH + 32];
+    if (cache->disk_dir[0]) {
+        struct {
+            int64_t mtime_sec;
+            int64_t mtime_nsec;
+            int64_t size;
+            int32_t width, height, format;
+            uint32_t background;
+        } source;
+        memset(&source, 0, sizeof(source));
+        source.mtime_sec = st.st_mtim.tv_sec;
+        source.mtime_nsec = st.st_mtim.tv_nsec;
+        source.size = st.st_size;
+        source.width = config->width;
+        source.height = config->height;
+        source.format = config->format;
+        source.background = config->background;
+        uint64_t key = fnv1a(path_key(path), &source, sizeof(source));
+        snprintf(disk_path, sizeof(disk_path), "%s/%016llx.rgi", cache->disk_dir, (unsigned long long)key);
+
+        if (image_asset_open(&result->image, disk_path) == 0) {
+            if (result->image.format == config->format && result->image.width <= config->width &&
+                result->image.height <= config->height && !result->image.alpha) {
+                result->bytes = result->image.size;
+                result->from_disk = 1;
+                result->ms = now_ms() - start;
+                return 0;
+            }
+            image_asset_close(&result->image);
+        }
+    }
+
+    int sw, sh, dw, dh;
+    uint32_t* source = decode_bmp(path, &sw, &sh);
+    if (!source) {
+        return -1;
+    }
+    uint32_t* scaled = scale_to_fit(source, sw, sh, config->width, config->height, config->background, &dw, &dh);
+    free(source);
+    if (!scaled) {
+        return -1;
+    }
+    size_t size = 0;
+    uint8_t* file = image_asset_build(config->format, dw, dh, scaled, 0, &size);
+    free(scaled);
+    if (!file || image_asset_view(&result->image, file, size) < 0) {
+        free(file);
+        return -1;
+    }
+    if (cache->disk_dir[0]) {
+        write_file(disk_path, file, size);   // 写不进去 (只读或空间不足) 时下次重新解码
+    }
+    result->memory = file;
+    result->bytes = size;
+    result->ms = now_ms() - start;
+    return 0;
+}
+
+// ---------- 条目管理 (持有lock) ----------
+
+static void lru_unlink(thumb_cache_t* cache, thumb_entry_t* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else cache->lru_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else cache->lru_tail = entry->prev;
+    entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(thumb_cache_t* cache, thumb_entry_t* entry) {
+    entry->prev = NULL;
+    entry->next = cache->lru_head;
+    if (cache->lru_head) cache->lru_head->prev = entry;
+    cache->lru_head = entry;
+    if (!cache->lru_tail) cache->lru_tail = entry;
+}
+
+static thumb_entry_t* find(thumb_cache_t* cache, uint64_t key, const char* path) {
+    for (thumb_entry_t* e = cache->buckets[key & cache->bucket_mask]; e; e = e->chain) {
+        if (e->key == key && strcmp(e->path, path) == 0) return e;
+    }
+    return NULL;
+}
+
+// 从哈希表和LRU链表中移除，释放缩略图，放回空闲链表
+static void release(thumb_cache_t* cache, thumb_entry_t* entry) {
+    thumb_entry_t** link = &cache->buckets[entry->key & cache->bucket_mask];
+    while (*link != entry) link = &(*link)->chain;
+    *link = entry->chain;
+    lru_unlink(cache, entry);
+
+    if (entry->state == THUMB_READY) {
+        if (entry->memory) {
+            free(entry->memory);
+        } else {
+            image_asset_close(&entry->image);
+        }
+        cache->stats.bytes -= entry->bytes;
+        cache->stats.ready--;
+    }
+    memset(&entry->image, 0, sizeof(entry->image));
+    entry->memory = NULL;
+    entry->bytes = 0;
+    entry->state = THUMB_FREE;
+    entry->next = cache->free_list;
+    cache->free_list = entry;
+}
+
+// 从最久没用的开始替换已经完成的条目 (本帧用过的、排队和解码中的不动)
+static thumb_entry_t* evict_one(thumb_cache_t* cache) {
+    for (thumb_entry_t* e = cache->lru_tail; e; e = e->prev) {
+        if ((e->state == THUMB_READY || e->state == THUMB_FAILED) && e->last_used != cache->frame) {
+            release(cache, e);
+            cache->stats.evictions++;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static thumb_entry_t* request(thumb_cache_t* cache, const char* path, int fetch) {
+    size_t len = strlen(path);
+    if (len >= THUMB_CACHE_MAX_PATH) {
+        return NULL;
+    }
+    uint64_t key = path_key(path);
+    thumb_entry_t* entry = find(cache, key, path);
+    if (entry) {
+        entry->last_used = cache->frame;
+        lru_unlink(cache, entry);
+        lru_push_front(cache, entry);
+        if (fetch && entry->state == THUMB_READY) {
+            cache->stats.ram_hits++;
+        }
+        // 还在排队的移到栈顶，最新的请求先处理
+        if (entry->state == THUMB_QUEUED) {
+            for (int i = 0; i < cache->queue_count - 1; i++) {
+                if (cache->queue[i] == entry) {
+                    memmove(&cache->queue[i], &cache->queue[i + 1], (cache->queue_count - 1 - i) * sizeof(entry));
+                    cache->queue[cache->queue_count - 1] = entry;
+                    break;
+                }
+            }
+        }
+        return entry;
+    }
+
+    entry = cache->free_list;
+    if (entry) {
+        cache->free_list = entry->next;
+    } else if (!evict_one(cache)) {
+        cache->stats.rejected++;
+        return NULL;
+    } else {
+        entry = cache->free_list;
+        cache->free_list = entry->next;
+    }
+
+    entry->key = key;
+    memcpy(entry->path, path, len + 1);
+    entry->state = THUMB_QUEUED;
+    entry->last_used = cache->frame;
+    entry->chain = cache->buckets[key & cache->bucket_mask];
+    cache->buckets[key & cache->bucket_mask] = entry;
+    lru_push_front(cache, entry);
+    cache->queue[cache->queue_count++] = entry;
+    cache->stats.queued = cache->queue_count;
+    pthread_cond_signal(&cache->wake);
+    return entry;
+}
+
+// ---------- 后台线程 ----------
+
+static void* worker_main(void* data) {
+    thumb_cache_t* cache = (thumb_cache_t*)data;
+    char path[THUMB_CACHE_MAX_PATH];
+
+    pthread_mutex_lock(&cache->lock);
+    while (!cache->quit) {
+        if (cache->queue_count == 0) {
+            pthread_cond_wait(&cache->wake, &cache->lock);
+            continue;
+        }
+        thumb_entry_t* entry = cache->queue[--cache->queue_count];
+        cache->stats.queued = cache->queue_count;
+        if (entry->last_used + THUMB_STALE_FRAMES < cache->frame) {
+            release(cache, entry);
+            cache->stats.dropped++;
+            continue;
+        }
+        entry->state = THUMB_LOADING;
+        memcpy(path, entry->path, sizeof(path));
+        pthread_mutex_unlock(&cache->lock);
+
+        thumb_result_t result;
+        int rc = load_thumb(cache, path, &result);
+
+        pthread_mutex_lock(&cache->lock);
+        if (rc < 0) {
+            entry->state = THUMB_FAILED;
+            cache->stats.failures++;
+            continue;
+        }
+        entry->image = result.image;
+        entry->memory = result.memory;
+        entry->bytes = result.bytes;
+        entry->state = THUMB_READY;
+        cache->stats.bytes += result.bytes;
+        cache->stats.ready++;
+        if (result.from_disk) {
+            cache->stats.disk_hits++;
+            cache->stats.disk_ms += result.ms;
+        } else {
+            cache->stats.decodes++;
+            cache->stats.decode_ms += result.ms;
+            if (result.ms > cache->stats.decode_max_ms) cache->stats.decode_max_ms = result.ms;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return NULL;
+}
+
+// ---------- 接口 ----------
+
+int thumb_cache_init(thumb_cache_t* cache, const thumb_cache_config_t* config) {
+    memset(cache, 0, sizeof(*cache));
+    if (config->width <= 0 || config->height <= 0 || config->entries <= 0) {
+        return -1;
+    }
+    cache->config = *config;
+    if (config->disk_dir) {
+        snprintf(cache->disk_dir, sizeof(cache->disk_dir), "%s", config->disk_dir);
+        mkdir(cache->disk_dir, 0755);   // 已经存在或无法创建 (只读) 时写入失败，只用内存缓存
+    }
+    cache->config.disk_dir = cache->disk_dir[0] ? cache->disk_dir : NULL;
+
+    uint32_t buckets = 1;
+    while (buckets < (uint32_t)config->entries * 2) buckets <<= 1;
+    cache->bucket_mask = buckets - 1;
+    cache->entries = calloc(config->entries, sizeof(thumb_entry_t));
+    cache->buckets = calloc(buckets, sizeof(thumb_entry_t*));
+    cache->queue = calloc(config->entries, sizeof(thumb_entry_t*));
+    if (!cache->entries || !cache->buckets || !cache->queue) {
+        thumb_cache_destroy(cache);
+        return -1;
+    }
+    for (int i = config->entries - 1; i >= 0; i--) {
+        cache->entries[i].next = cache->free_list;
+        cache->free_list = &cache->entries[i];
+    }
+
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->wake, NULL);
+    int workers = config->workers < 1 ? 1 : (config->workers > THUMB_CACHE_MAX_WORKERS ? THUMB_CACHE_MAX_WORKERS
+                                                                                       : config->workers);
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&cache->threads[i], NULL, worker_main, cache) != 0) break;
+        cache->thread_count++;
+    }
+    if (cache->thread_count == 0) {
+        thumb_cache_destroy(cache);
+        return -1;
+    }
+    return 0;
+}
+
+void thumb_cache_destroy(thumb_cache_t* cache) {
+    if (cache->thread_count > 0) {
+        pthread_mutex_lock(&cache->lock);
+        cache->quit = 1;
+        pthread_cond_broadcast(&cache->wake);
+        pthread_mutex_unlock(&cache->lock);
+        for (int i = 0; i < cache->thread_count; i++) {
+            pthread_join(cache->threads[i], NULL);
+        }
+        pthread_cond_destroy(&cache->wake);
+        pthread_mutex_destroy(&cache->lock);
+    }
+    while (cache->lru_head) {
+        release(cache, cache->lru_head);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache->queue);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void thumb_cache_begin_frame(thumb_cache_t* cache) {
+    pthread_mutex_lock(&cache->lock);
+    cache->frame++;
+    // 后台线程完成的缩略图可能让总量超出预算
+    while (cache->stats.bytes > cache->config.budget && evict_one(cache)) {
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+const image_asset_t* thumb_cache_get(thumb_cache_t* cache, const char* path) {
+    pthread_mutex_lock(&cache->lock);
+    cache->stats.requests++;
+    thumb_entry_t* entry = request(cache, path, 1);
+    const image_asset_t* image = entry && entry->state == THUMB_READY ? &entry->image : NULL;
+    pthread_mutex_unlock(&cache->lock);
+    return image;
+}
+
+void thumb_cache_prefetch(thumb_cache_t* cache, const char* path) {
+    pthread_mutex_lock(&cache->lock);
+    request(cache, path, 0);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+thumb_state_t thumb_cache_state(thumb_cache_t* cache, const char* path) {
+    pthread_mutex_lock(&cache->lock);
+    thumb_entry_t* entry = find(cache, path_key(path), path);
+    thumb_state_t state = entry ? entry->state : THUMB_FREE;
+    pthread_mutex_unlock(&cache->lock);
+    return state;
+}
+
+void thumb_cache_get_stats(thumb_cache_t* cache, thumb_cache_stats_t* stats) {
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
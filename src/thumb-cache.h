@@ -0,0 +1,119 @@
+#ifndef THUMB_CACHE_H
+#define THUMB_CACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "image-asset.h"
+
+// 缩略图缓存 (不依赖SDL): 封面和截图在后台线程中解码，缩小到显示尺寸 (保持比例，不放大)，
+// 半透明部分先与背景色合成，再转换为面板的像素格式，结果就是绘制时逐行复制的像素。
+//
+// 内存中按字节预算保留最近用过的缩略图 (LRU)；转换好的结果同时以图片资源格式写入磁盘缓存目录，
+// 以后 (包括下次启动) 只需一次mmap。磁盘缓存的文件名包含源文件的mtime和大小，源图片换了自动失效。
+//
+// thumb_cache_get 不会阻塞: 没有准备好时加入请求队列并返回NULL。队列后进先出 (最新的选择先处理)，
+// 处理到时已经几帧没人要的请求直接丢弃，快速滚动时不会在看不到的图片上浪费时间。
+// 本帧请求过的缩略图不会被替换，返回的图片在下一次 thumb_cache_begin_frame 之前有效。
+// 所有条目在初始化时一次分配，调用方的线程上不分配内存 (解码和缓冲区分配都在后台线程)。
+//
+// 源图片目前支持BMP (24/32位非压缩和8位调色板)。
+
+#define THUMB_CACHE_MAX_PATH 1024
+#define THUMB_CACHE_MAX_WORKERS 4
+
+typedef enum {
+    THUMB_FREE,
+    THUMB_QUEUED,
+    THUMB_LOADING,
+    THUMB_READY,
+    THUMB_FAILED,                // 源图片不存在或无法解码 (也缓存，避免反复尝试)
+} thumb_state_t;
+
+typedef struct thumb_entry thumb_entry_t;
+
+struct thumb_entry {
+    uint64_t key;                // 路径的哈希
+    char path[THUMB_CACHE_MAX_PATH];
+    thumb_state_t state;
+    image_asset_t image;         // THUMB_READY时有效
+    void* memory;                // 刚解码的文件内容 (image指向它)，为NULL时image是映射的磁盘缓存
+    size_t bytes;
+    unsigned last_used;          // 最近一次请求的帧号
+    thumb_entry_t* prev;         // LRU链表 (最近用的在前)
+    thumb_entry_t* next;
+    thumb_entry_t* chain;        // 同一个哈希桶的下一项
+};
+
+typedef struct {
+    int width, height;           // 显示尺寸
+    pixel_format_t format;
+    uint32_t background;         // 0xRRGGBB，半透明像素与它合成
+    size_t budget;               // 内存中缩略图的字节预算
+    int entries;                 // 条目数 (包括排队和解码中的)
+    int workers;                 // 后台线程数
+    const char* disk_dir;        // 磁盘缓存目录，NULL时只缓存在内存中
+} thumb_cache_config_t;
+
+typedef struct {
+    int requests;                // thumb_cache_get 的调用次数
+    int ram_hits;                // 已经在内存中
+    int disk_hits;               // 从磁盘缓存映射
+    int decodes;                 // 解码、缩放并转换的图片
+    int failures;
+    int evictions;
+    int dropped;                 // 处理到时已经不需要的请求
+    int rejected;                // 条目都在使用中，没有加入队列的请求
+    int queued;                  // 当前排队数
+    int ready;                   // 当前内存中的缩略图数
+    size_t bytes;                // 当前内存中缩略图的总字节数
+    double decode_ms;            // 解码累计耗时 (读文件、解码、缩放、转换、写磁盘缓存)
+    double decode_max_ms;
+    double disk_ms;              // 从磁盘缓存加载的累计耗时
+} thumb_cache_stats_t;
+
+typedef struct {
+    thumb_cache_config_t config;
+    char disk_dir[THUMB_CACHE_MAX_PATH];
+    thumb_entry_t* entries;
+    thumb_entry_t** buckets;
+    uint32_t bucket_mask;
+    thumb_entry_t* lru_head;
+    thumb_entry_t* lru_tail;
+    thumb_entry_t* free_list;    // 通过next链接
+    thumb_entry_t** queue;       // 待处理的请求 (栈)
+    int queue_count;
+    unsigned frame;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t threads[THUMB_CACHE_MAX_WORKERS];
+    int thread_count;
+    int quit;
+
+    thumb_cache_stats_t stats;
+} thumb_cache_t;
+
+// 分配所有条目并启动后台线程，失败返回-1
+int thumb_cache_init(thumb_cache_t* cache, const thumb_cache_config_t* config);
+
+// 停止后台线程 (等待正在解码的图片) 并释放所有缩略图
+void thumb_cache_destroy(thumb_cache_t* cache);
+
+// 每帧开始时调用: 上一帧返回的图片不再受保护
+void thumb_cache_begin_frame(thumb_cache_t* cache);
+
+// path的缩略图，准备好时返回 (格式为config.format，尺寸不超过显示尺寸)，否则加入请求队列并返回NULL。
+// 失败过的图片也返回NULL，不再排队
+const image_asset_t* thumb_cache_get(thumb_cache_t* cache, const char* path);
+
+// 只请求不取结果 (预取附近的条目)
+void thumb_cache_prefetch(thumb_cache_t* cache, const char* path);
+
+// path的状态 (没有请求过时为THUMB_FREE)
+thumb_state_t thumb_cache_state(thumb_cache_t* cache, const char* path);
+
+// 统计的副本 (任意线程)
+void thumb_cache_get_stats(thumb_cache_t* cache, thumb_cache_stats_t* stats);
+
+#endif
@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "thumb-cache.h"
+
+// 缩略图缓存测试工具: 在目录中生成BMP图片 (24位横图、带透明度的32位竖图、8位调色板图)，然后依次测试:
+//   1. 冷启动: 全部在后台解码、缩放、转换并写入磁盘缓存，检查缩略图的尺寸和颜色
+//   2. 内存命中: 同一帧里全部立即返回
+//   3. 重新启动: 全部从磁盘缓存映射，不再解码
+//   4. 字节预算: 预算只够几张时逐个浏览，旧的被替换，总量不超过预算
+//   5. 快速滚动: 每帧换一张，来不及处理的旧请求被丢弃
+// 例如:  ./thumb-test -n 200 /dev/shm/thumbs
+// 所有检查通过返回0。
+
+static const struct {
+    const char* name;
+    pixel_format_t format;
+} formats[] = {
+    { "rgb565", PIXEL_FORMAT_RGB565 },
+    { "bgr565", PIXEL_FORMAT_BGR565 },
+    { "xrgb8888", PIXEL_FORMAT_XRGB8888 },
+    { "xbgr8888", PIXEL_FORMAT_XBGR8888 },
+};
+
+#define BACKGROUND 0x202020
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec tick = {0, ms * 1000000L};
+    nanosleep(&tick, NULL);
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-n 图片数] [-s 宽x高] [-w 线程数] [-f rgb565|bgr565|xrgb8888|xbgr8888] 目录\n"
+            "  默认 200 张，显示尺寸 192x144，2 个后台线程，rgb565；目录不能已经存在\n",
+            prog);
+}
+
+static void put_u16(uint8_t* p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    put_u16(p, v & 0xFFFF);
+    put_u16(p + 2, v >> 16);
+}
+
+// 第i张图片左半边的颜色 (检查缩略图用)，右半边为渐变
+static uint32_t image_color(int i) {
+    return ((i * 37) & 0xFF) << 16 | ((i * 91) & 0xFF) << 8 | ((i * 53) & 0xFF);
+}
+
+// 写BMP: 每3张中一张是带透明度的32位竖图 (BI_BITFIELDS)，一张是8位调色板图，其余为24位横图
+static int write_bmp(const char* path, int i) {
+    int kind = i % 3;
+    int w = kind == 1 ? 300 : 640;
+    int h = kind == 1 ? 500 : 480;
+    int bpp = kind == 1 ? 32 : (kind == 2 ? 8 : 24);
+    uint32_t info_size = kind == 1 ? 108 : 40;
+    uint32_t palette_size = kind == 2 ? 256 * 4 : 0;
+    uint32_t offset = 14 + info_size + palette_size;
+    size_t stride = ((size_t)bpp * w + 31) / 32 * 4;
+    size_t size = offset + stride * h;
+
+    uint8_t* file = calloc(1, size);
+    if (!file) return -1;
+    file[0] = 'B';
+    file[1] = 'M';
+    put_u32(file + 2, (uint32_t)size);
+    put_u32(file + 10, offset);
+    put_u32(file + 14, info_size);
+    put_u32(file + 18, w);
+    put_u32(file + 22, kind == 1 ? (uint32_t)-h : (uint32_t)h);   // 竖图由上往下存放
+    put_u16(file + 26, 1);
+    put_u16(file + 28, bpp);
+    if (kind == 1) {
+        put_u32(file + 30, 3);
+        put_u32(file + 54, 0x00FF0000);
+        put_u32(file + 58, 0x0000FF00);
+        put_u32(file + 62, 0x000000FF);
+        put_u32(file + 66, 0xFF000000);
+    }
+    uint32_t color = image_color(i);
+    if (kind == 2) {
+        // 调色板: 0为左半边的颜色，其余为灰度渐变
+        put_u32(file + 54, color);
+        for (int c = 1; c < 256; c++) put_u32(file + 54 + c * 4, c * 0x010101);
+    }
+
+    for (int y = 0; y < h; y++) {
+        uint8_t* row = file + offset + stride * y;
+        for (int x = 0; x < w; x++) {
+            uint32_t rgb = x < w / 2 ? color : (uint32_t)((x * 255 / w) << 16 | (y * 255 / h) << 8 | 0x80);
+            if (kind == 2) {
+                row[x] = x < w / 2 ? 0 : 1 + (x * 254 / w);
+            } else if (kind == 1) {
+                // 右下角半透明，与背景合成
+                uint32_t a = x >= w / 2 && y >= h / 2 ? 0x80 : 0xFF;
+                put_u32(row + x * 4, a << 24 | rgb);
+            } else {
+                row[x * 3] = rgb & 0xFF;
+                row[x * 3 + 1] = (rgb >> 8) & 0xFF;
+                row[x * 3 + 2] = (rgb >> 16) & 0xFF;
+            }
+        }
+    }
+
+    FILE* out = fopen(path, "wb");
+    size_t written = out ? fwrite(file, 1, size, out) : 0;
+    if (out) fclose(out);
+    free(file);
+    return written == size ? 0 : -1;
+}
+
+// 请求 paths[first .. first + count) 直到全部完成 (或超时)，返回准备好的张数
+static int wait_all(thumb_cache_t* cache, char (*paths)[256], int first, int count, double* wall_ms) {
+    double start = now_ms();
+    int ready = 0;
+    while (now_ms() - start < 30000) {
+        thumb_cache_begin_frame(cache);
+        ready = 0;
+        int pending = 0;
+        for (int i = first; i < first + count; i++) {
+            if (thumb_cache_get(cache, paths[i])) ready++;
+            else if (thumb_cache_state(cache, paths[i]) != THUMB_FAILED) pending++;
+        }
+        if (pending == 0) break;
+        sleep_ms(1);
+    }
+    *wall_ms = now_ms() - start;
+    return ready;
+}
+
+static int check(int ok, const char* message) {
+    if (!ok) {
+        printf("  检查失败: %s\n", message);
+    }
+    return ok ? 0 : 1;
+}
+
+// 打印并返回统计 (后台线程还在运行，只读副本)
+static void print_stats(const char* label, thumb_cache_t* cache, double wall_ms, thumb_cache_stats_t* s) {
+    thumb_cache_get_stats(cache, s);
+    printf("%s: %.0fms | 请求%d 内存命中%d 磁盘命中%d 解码%d 失败%d 替换%d 丢弃%d | 内存中%d张 %zuKB",
+           label, wall_ms, s->requests, s->ram_hits, s->disk_hits, s->decodes, s->failures, s->evictions,
+           s->dropped, s->ready, s->bytes / 1024);
+    if (s->decodes > 0) printf(" | 解码平均%.2fms 最长%.2fms", s->decode_ms / s->decodes, s->decode_max_ms);
+    if (s->disk_hits > 0) printf(" | 磁盘缓存平均%.3fms", s->disk_ms / s->disk_hits);
+    printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    int count = 200;
+    thumb_cache_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.width = 192;
+    config.height = 144;
+    config.workers = 2;
+    config.format = PIXEL_FORMAT_RGB565;
+    config.background = BACKGROUND;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:w:f:h")) != -1) {
+        switch (opt) {
+            case 'n': count = atoi(optarg); break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &config.width, &config.height) != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'w': config.workers = atoi(optarg); break;
+            case 'f': {
+                size_t i;
+                for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+                    if (strcmp(optarg, formats[i].name) == 0) break;
+                }
+                if (i == sizeof(formats) / sizeof(formats[0])) {
+                    fprintf(stderr, "错误: 不支持的像素格式 %s\n", optarg);
+                    return 1;
+                }
+                config.format = formats[i].format;
+                break;
+            }
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || count < 8 || config.width < 8 || config.height < 8) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char* dir = argv[optind];
+
+    char cache_dir[1024];
+    snprintf(cache_dir, sizeof(cache_dir), "%s/cache", dir);
+    char (*paths)[256] = malloc((size_t)count * sizeof(*paths));
+    if (!paths || mkdir(dir, 0755) < 0) {
+        fprintf(stderr, "错误: 无法创建 %s (目录不能已经存在)\n", dir);
+        return 1;
+    }
+    double t = now_ms();
+    for (int i = 0; i < count; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%04d.bmp", dir, i);
+        if (write_bmp(paths[i], i) < 0) {
+            fprintf(stderr, "错误: 无法写入 %s\n", paths[i]);
+            return 1;
+        }
+    }
+    printf("生成 %d 张BMP: %.0fms\n", count, now_ms() - t);
+
+    int failures = 0;
+    double wall;
+    static thumb_cache_t cache;
+    thumb_cache_stats_t stats;
+
+    // 1. 冷启动
+    config.entries = count;
+    config.budget = (size_t)count * config.width * config.height * 4;
+    config.disk_dir = cache_dir;
+    if (thumb_cache_init(&cache, &config) < 0) {
+        fprintf(stderr, "错误: 缩略图缓存初始化失败\n");
+        return 1;
+    }
+    int ready = wait_all(&cache, paths, 0, count, &wall);
+    print_stats("1.冷启动", &cache, wall, &stats);
+    failures += check(ready == count && stats.decodes == count, "没有全部解码");
+    int wrong = 0;
+    thumb_cache_begin_frame(&cache);
+    for (int i = 0; i < count; i++) {
+        const image_asset_t* image = thumb_cache_get(&cache, paths[i]);
+        if (!image) {
+            wrong++;
+            continue;
+        }
+        // 横图缩到整个宽度，竖图缩到整个高度；左半边的颜色原样保留
+        int landscape = i % 3 != 1;
+        int expect_w = landscape ? config.width : 300 * config.height / 500;
+        int expect_h = landscape ? 480 * config.width / 640 : config.height;
+        if (expect_h > config.height) {
+            expect_h = config.height;
+            expect_w = 640 * config.height / 480;
+        }
+        const uint8_t* row = image_asset_row(image, image->height / 2);
+        int x = image->width / 4;
+        // 32位格式的最高字节不使用
+        uint32_t pixel = pixel_format_bytes(config.format) == 2 ? ((const uint16_t*)row)[x]
+                                                                  : ((const uint32_t*)row)[x] & 0xFFFFFF;
+        if (image->width != expect_w || image->height != expect_h || image->format != config.format ||
+            pixel != pixel_map(config.format, image_color(i))) {
+            if (wrong < 3) {
+                printf("  第%d张: %dx%d (应为%dx%d) 像素%08x (应为%08x)\n", i, image->width, image->height,
+                       expect_w, expect_h, pixel, pixel_map(config.format, image_color(i)));
+            }
+            wrong++;
+        }
+    }
+    failures += check(wrong == 0, "缩略图的尺寸或颜色不对");
+
+    // 2. 内存命中
+    thumb_cache_get_stats(&cache, &stats);
+    int before = stats.ram_hits;
+    thumb_cache_begin_frame(&cache);
+    t = now_ms();
+    ready = 0;
+    for (int i = 0; i < count; i++) {
+        if (thumb_cache_get(&cache, paths[i])) ready++;
+    }
+    printf("2.内存命中: %d张 %.3fms (每次%.2fus)\n", ready, now_ms() - t, (now_ms() - t) * 1000 / count);
+    thumb_cache_get_stats(&cache, &stats);
+    failures += check(ready == count && stats.ram_hits - before == count, "应该全部在内存中");
+    thumb_cache_destroy(&cache);
+
+    // 3. 重新启动: 磁盘缓存
+    if (thumb_cache_init(&cache, &config) < 0) return 1;
+    ready = wait_all(&cache, paths, 0, count, &wall);
+    print_stats("3.重新启动", &cache, wall, &stats);
+    failures += check(ready == count && stats.disk_hits == count && stats.decodes == 0,
+                      "应该全部从磁盘缓存加载");
+    size_t thumb_bytes = stats.bytes / count;
+    thumb_cache_destroy(&cache);
+
+    // 4. 字节预算只够8张，逐个浏览
+    config.entries = 16;
+    config.budget = thumb_bytes * 8;
+    if (thumb_cache_init(&cache, &config) < 0) return 1;
+    int over = 0;
+    t = now_ms();
+    for (int i = 0; i < count; i++) {
+        if (wait_all(&cache, paths, i, 1, &wall) != 1) over++;
+        thumb_cache_begin_frame(&cache);
+        thumb_cache_get_stats(&cache, &stats);
+        if (stats.bytes > config.budget) over++;
+    }
+    print_stats("4.字节预算", &cache, now_ms() - t, &stats);
+    failures += check(over == 0 && stats.evictions >= count - 16, "超出预算或没有替换");
+    thumb_cache_destroy(&cache);
+
+    // 5. 快速滚动: 每帧换一张 (不用磁盘缓存，都要解码)
+    config.entries = 32;
+    config.disk_dir = NULL;
+    if (thumb_cache_init(&cache, &config) < 0) return 1;
+    t = now_ms();
+    for (int i = 0; i < count; i++) {
+        thumb_cache_begin_frame(&cache);
+        thumb_cache_get(&cache, paths[i]);
+        sleep_ms(1);
+    }
+    ready = wait_all(&cache, paths, count - 1, 1, &wall);
+    print_stats("5.快速滚动", &cache, now_ms() - t, &stats);
+    failures += check(ready == 1 && stats.dropped > 0 && stats.decodes < count,
+                      "看不到的请求应该被丢弃，最后一张应该准备好");
+    thumb_cache_destroy(&cache);
+
+    free(paths);
+    printf("%s\n", failures ? "失败" : "全部通过");
+    return failures ? 1 : 0;
+}
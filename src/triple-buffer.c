@@ -0,0 +1,76 @@
+#include "triple-buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TRIPLE_BUFFER_FRESH 4u
+#define TRIPLE_BUFFER_INDEX 3u
+#define CACHE_LINE 64
+
+int triple_buffer_init(triple_buffer_t* tb, size_t slot_size) {
+    memset(tb, 0, sizeof(*tb));
+
+    // 槽位按缓存行对齐，写者和读者不会共享同一行
+    tb->slot_size = (slot_size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    if (tb->slot_size == 0) {
+        tb->slot_size = CACHE_LINE;
+    }
+    tb->block = aligned_alloc(CACHE_LINE, tb->slot_size * 3);
+    if (!tb->block) {
+        return -1;
+    }
+    memset(tb->block, 0, tb->slot_size * 3);
+
+    tb->back = 0;
+    atomic_init(&tb->middle, 1);
+    tb->front = 2;
+    return 0;
+}
+
+void triple_buffer_destroy(triple_buffer_t* tb) {
+    free(tb->block);
+    memset(tb, 0, sizeof(*tb));
+}
+
+void* triple_buffer_write_slot(triple_buffer_t* tb) {
+    return tb->block + tb->back * tb->slot_size;
+}
+
+void triple_buffer_publish(triple_buffer_t* tb) {
+    // release: 快照的内容在交换之前对读者可见
+    unsigned old = atomic_exchange_explicit(&tb->middle, tb->back | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+    tb->back = old & TRIPLE_BUFFER_INDEX;
+    if (old & TRIPLE_BUFFER_FRESH) {
+        atomic_fetch_add_explicit(&tb->dropped, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&tb->published, 1, memory_order_relaxed);
+}
+
+const void* triple_buffer_read(triple_buffer_t* tb, int* fresh) {
+    int is_fresh = 0;
+    if (atomic_load_explicit(&tb->middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH) {
+        // acquire: 看到写者在发布前写入的快照内容
+        unsigned old = atomic_exchange_explicit(&tb->middle, tb->front, memory_order_acq_rel);
+        tb->front = old & TRIPLE_BUFFER_INDEX;
+        tb->has_front = 1;
+        is_fresh = 1;
+        atomic_fetch_add_explicit(&tb->consumed, 1, memory_order_relaxed);
+    } else if (tb->has_front) {
+        atomic_fetch_add_explicit(&tb->duplicated, 1, memory_order_relaxed);
+    }
+    if (fresh) {
+        *fresh = is_fresh;
+    }
+    return tb->has_front ? tb->block + tb->front * tb->slot_size : NULL;
+}
+
+int triple_buffer_pending(triple_buffer_t* tb) {
+    return (atomic_load_explicit(&tb->middle, memory_order_acquire) & TRIPLE_BUFFER_FRESH) != 0;
+}
+
+void triple_buffer_get_stats(triple_buffer_t* tb, triple_buffer_stats_t* stats) {
+    stats->published = atomic_load_explicit(&tb->published, memory_order_relaxed);
+    stats->consumed = atomic_load_explicit(&tb->consumed, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&tb->dropped, memory_order_relaxed);
+    stats->duplicated = atomic_load_explicit(&tb->duplicated, memory_order_relaxed);
+}
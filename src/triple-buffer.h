@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+// 无锁三缓冲: 一个写者 (逻辑线程) 发布状态快照，一个读者 (渲染线程) 读取最新的快照。
+//
+// 三个槽位中写者和读者各占一个，第三个用于交换。写者写完自己的槽后用一次原子交换
+// 把它和交换槽对调；读者发现有新快照时同样用一次原子交换取走，双方都不会等待对方。
+// 读者还没取走时写者又发布了新快照，旧的那个被覆盖 (丢帧)；读者没有新快照时继续使用
+// 手上的快照 (重复帧)。快照发布后不再修改，读者可以在不加锁的情况下使用。
+
+typedef struct {
+    unsigned long published;     // 写者发布的快照数
+    unsigned long consumed;      // 读者取到的新快照数
+    unsigned long dropped;       // 没被读到就被覆盖的快照数
+    unsigned long duplicated;    // 读者重复使用旧快照的次数
+} triple_buffer_stats_t;
+
+typedef struct {
+    unsigned char* block;        // 三个槽位共用的一块内存
+    size_t slot_size;            // 按缓存行对齐后的槽位大小
+
+    // 交换槽的下标，低2位为槽位，TRIPLE_BUFFER_FRESH 位表示有读者未取走的新快照
+    atomic_uint middle;
+
+    // 只由写者访问
+    unsigned back;
+    atomic_ulong published;
+    atomic_ulong dropped;
+
+    // 只由读者访问
+    unsigned front;
+    int has_front;               // 已经取到过快照
+    atomic_ulong consumed;
+    atomic_ulong duplicated;
+} triple_buffer_t;
+
+// 分配三个slot_size字节的槽位 (清零)，失败返回-1
+int triple_buffer_init(triple_buffer_t* tb, size_t slot_size);
+void triple_buffer_destroy(triple_buffer_t* tb);
+
+// 写者: 当前可写的槽位 (内容是更早的快照，需要完整写入)，写完后发布
+void* triple_buffer_write_slot(triple_buffer_t* tb);
+void triple_buffer_publish(triple_buffer_t* tb);
+
+// 读者: 有新快照时取走并返回它，否则返回手上的旧快照 (记一次重复)。
+// 还没有任何快照时返回NULL。fresh不为NULL时写入是否为新快照
+const void* triple_buffer_read(triple_buffer_t* tb, int* fresh);
+
+// 是否有读者未取走的新快照 (任意线程)
+int triple_buffer_pending(triple_buffer_t* tb);
+
+// 统计 (任意线程，各计数分别读取)
+void triple_buffer_get_stats(triple_buffer_t* tb, triple_buffer_stats_t* stats);
+
+#endif
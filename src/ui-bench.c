@@ -0,0 +1,552 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "pixel-format.h"
+#include "sprites.h"
+#include "fixmath.h"
+#include "ui-tree.h"
+#include "text-layout.h"
+#include "list-view.h"
+
+// 界面子系统压力测试 (纯CPU，不需要帧缓冲或SDL)
+// 每种精灵数量分别测量移动、网格重建、碰撞检测、绘制和曲线动画 (libm与定点) 的耗时，
+// 以及同样数量的标签组成的界面树每帧全部重画与只重画变化部分的耗时、同样数量的中英日韩混排字符串的折行耗时、
+// 同样条目数的虚拟列表按住方向键滚动的耗时，
+// 结果以CSV输出到stdout (或 -o 指定文件)，提示信息输出到stderr。
+
+#define DEFAULT_WIDTH       720
+#define DEFAULT_HEIGHT      480
+#define DEFAULT_FRAMES      300
+#define DEFAULT_SPRITE_SIZE 8
+#define DEFAULT_COUNTS      "100,1000,10000"
+#define MAX_COUNTS          16
+
+typedef struct {
+    int width, height;
+    int frames;
+    int sprite_size;
+    int counts[MAX_COUNTS];
+    int count_num;
+    pixel_format_t format;
+    const char* output;
+    FILE* csv;
+} bench_config_t;
+
+// 对照组: 原来每个对象一个结构体、逐个分支判断的写法
+typedef struct {
+    float x, y;
+    float vx, vy;
+    int size;
+    unsigned int color;
+} aos_sprite_t;
+
+// 防止结果被优化掉
+static volatile int bench_sink;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// 可重复的伪随机数 (xorshift32)
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static float rng_range(float lo, float hi) {
+    return lo + (hi - lo) * (rng_next() & 0xFFFF) / 65535.0f;
+}
+
+// 输出一行CSV结果，result为测试相关的附加值 (例如平均重叠对数)
+static void report(bench_config_t* cfg, const char* test, int sprites, int frames,
+                   double total_ms, double result) {
+    double us_per_frame = frames > 0 ? total_ms * 1000.0 / frames : 0.0;
+    double ns_per_sprite = frames > 0 && sprites > 0 ? total_ms * 1000000.0 / frames / sprites : 0.0;
+    fprintf(cfg->csv, "%s,%d,%d,%.3f,%.1f,%.2f,%.1f\n",
+            test, sprites, frames, total_ms, us_per_frame, ns_per_sprite, result);
+    fflush(cfg->csv);
+}
+
+static void update_aos(aos_sprite_t* sprites, int count, int width, int height) {
+    for (int i = 0; i < count; i++) {
+        aos_sprite_t* s = &sprites[i];
+        s->x += s->vx;
+        s->y += s->vy;
+        if (s->x <= 0 || s->x + s->size >= width) {
+            s->vx = -s->vx;
+            s->x = (s->x <= 0) ? 0 : width - s->size;
+            s->color = (s->color == 0xFF0000) ? 0x0000FF : 0xFF0000;
+        }
+        if (s->y <= 0 || s->y + s->size >= height) {
+            s->vy = -s->vy;
+            s->y = (s->y <= 0) ? 0 : height - s->size;
+            s->color = (s->color == 0xFF0000) ? 0x00FF00 : 0xFF0000;
+        }
+    }
+}
+
+static void spawn(bench_config_t* cfg, sprite_store_t* store, aos_sprite_t* aos, int count) {
+    rng_state = 2463534242u;
+    store->count = 0;
+    float size = (float)cfg->sprite_size;
+    for (int i = 0; i < count; i++) {
+        float x = rng_range(0, cfg->width - size - 1);
+        float y = rng_range(0, cfg->height - size - 1);
+        float vx = rng_range(-3.0f, 3.0f);
+        float vy = rng_range(-3.0f, 3.0f);
+        uint32_t color = rng_next() & 0xFFFFFF;
+        sprites_add(store, x, y, size, size, vx, vy, color);
+        aos[i] = (aos_sprite_t){x, y, vx, vy, cfg->sprite_size, color};
+    }
+}
+
+static int run_count(bench_config_t* cfg, int count) {
+    int frames = cfg->frames;
+    int bytes = pixel_format_bytes(cfg->format);
+    int pitch = cfg->width * bytes;
+    int max_pairs = count * 8;
+
+    sprite_store_t store;
+    sprite_grid_t grid;
+    aos_sprite_t* aos = malloc((size_t)count * sizeof(aos_sprite_t));
+    sprite_pair_t* pairs = malloc((size_t)max_pairs * sizeof(sprite_pair_t));
+    uint8_t* pixels = malloc((size_t)pitch * cfg->height);
+    if (!aos || !pairs || !pixels || sprites_init(&store, count) < 0) {
+        fprintf(stderr, "错误: 无法分配 %d 个精灵\n", count);
+        free(aos);
+        free(pairs);
+        free(pixels);
+        return -1;
+    }
+    // 格子边长取精灵边长的两倍
+    if (sprite_grid_init(&grid, 0, 0, cfg->width, cfg->height, cfg->sprite_size * 2.0f, count) < 0) {
+        fprintf(stderr, "错误: 无法创建碰撞网格\n");
+        sprites_destroy(&store);
+        free(aos);
+        free(pairs);
+        free(pixels);
+        return -1;
+    }
+    fprintf(stderr, "🧩 %d 个精灵, %d 帧\n", count, frames);
+
+    spawn(cfg, &store, aos, count);
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        update_aos(aos, count, cfg->width, cfg->height);
+    }
+    report(cfg, "update_aos_branchy", count, frames, now_ms() - start, 0);
+
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        sprites_update(&store, 1.0f, 0, 0, cfg->width, cfg->height);
+    }
+    report(cfg, "update_soa", count, frames, now_ms() - start, 0);
+
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        sprite_grid_build(&grid, &store);
+    }
+    report(cfg, "grid_build", count, frames, now_ms() - start, 0);
+
+    long total_pairs = 0;
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        total_pairs += sprite_grid_collide(&grid, &store, pairs, max_pairs);
+    }
+    report(cfg, "grid_collide", count, frames, now_ms() - start, (double)total_pairs / frames);
+
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        sprites_draw(&store, cfg->format, pixels, pitch, cfg->width, cfg->height);
+    }
+    report(cfg, "draw_native", count, frames, now_ms() - start, 0);
+
+    // 沿曲线移动 (原来 draw_ui 的写法): libm的cos/sin与定点查表，result为两者的最大像素差
+    int cx = cfg->width / 2, cy = cfg->height / 2;
+    int sink = 0;
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < count; i++) {
+            double t = ((f * 67 + i * 13) & (FX_ANGLE_TURN - 1)) * (2 * M_PI / FX_ANGLE_TURN);
+            sink += (int)(cx + cos(t) * 100) + (int)(cy + sin(t * 2) * 60);
+        }
+    }
+    report(cfg, "path_libm", count, frames, now_ms() - start, 0);
+
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < count; i++) {
+            fx_angle_t t = (f * 67 + i * 13) & (FX_ANGLE_TURN - 1);
+            sink += cx + fx_to_int(fx_cos(t) * 100) + cy + fx_to_int(fx_sin(t * 2) * 60);
+        }
+    }
+    double fixed_ms = now_ms() - start;
+    bench_sink = sink;
+
+    int max_diff = 0;
+    for (int i = 0; i < count; i++) {
+        fx_angle_t a = (i * 13) & (FX_ANGLE_TURN - 1);
+        double t = a * (2 * M_PI / FX_ANGLE_TURN);
+        int dx = abs((int)floor(cx + cos(t) * 100) - (cx + fx_to_int(fx_cos(a) * 100)));
+        int dy = abs((int)floor(cy + sin(t * 2) * 60) - (cy + fx_to_int(fx_sin(a * 2) * 60)));
+        if (dx > max_diff) max_diff = dx;
+        if (dy > max_diff) max_diff = dy;
+    }
+    report(cfg, "path_fixed", count, frames, fixed_ms, max_diff);
+
+    // 完整一帧: 清屏、移动、碰撞、绘制
+    uint32_t black = pixel_map(cfg->format, 0x000000);
+    total_pairs = 0;
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        pixel_fill_row(cfg->format, pixels, black, cfg->width * cfg->height);
+        sprites_update(&store, 1.0f, 0, 0, cfg->width, cfg->height);
+        sprite_grid_build(&grid, &store);
+        total_pairs += sprite_grid_collide(&grid, &store, pairs, max_pairs);
+        sprites_draw(&store, cfg->format, pixels, pitch, cfg->width, cfg->height);
+    }
+    report(cfg, "frame", count, frames, now_ms() - start, (double)total_pairs / frames);
+
+    sprite_grid_destroy(&grid);
+    sprites_destroy(&store);
+    free(aos);
+    free(pairs);
+    free(pixels);
+    return 0;
+}
+
+// 界面树的测量和绘制回调: 文字按每字符6像素宽，绘制只填充裁剪区域 (开销与重画的面积成正比)
+typedef struct {
+    bench_config_t* cfg;
+    uint8_t* pixels;
+    int pitch;
+} tree_canvas_t;
+
+static void tree_measure(void* context, const ui_node_t* node, int max_width, int* w, int* h) {
+    (void)context;
+    (void)max_width;
+    *w = (int)strlen(node->text) * 6;
+    *h = 4;
+}
+
+static void tree_paint(void* context, const ui_node_t* node, const ui_rect_t* clip) {
+    tree_canvas_t* canvas = (tree_canvas_t*)context;
+    if (node->type == UI_NODE_PANEL && !node->has_background) return;
+    pixel_format_t format = canvas->cfg->format;
+    uint32_t pixel = pixel_map(format, node->type == UI_NODE_LABEL ? node->color : node->background);
+    int bytes = pixel_format_bytes(format);
+    for (int y = clip->y; y < clip->y + clip->h; y++) {
+        pixel_fill_row(format, canvas->pixels + (size_t)y * canvas->pitch + clip->x * bytes, pixel, clip->w);
+    }
+}
+
+// 界面树: count个标签排成网格 (每行一个横向面板)，每帧改变一个标签的文字 (宽度也会变)。
+// ui_tree_full 每帧整个界面重画 (原来 render_ui 的做法)，ui_tree_incremental 只重画变化的区域，
+// result为每帧绘制的节点数
+static int run_ui_tree(bench_config_t* cfg, int count) {
+    int rows = 1;
+    while (rows * rows < count) rows++;
+    int cols = (count + rows - 1) / rows;
+    int pitch = cfg->width * pixel_format_bytes(cfg->format);
+
+    ui_tree_t tree;
+    tree_canvas_t canvas = {cfg, malloc((size_t)pitch * cfg->height), pitch};
+    ui_node_t** labels = malloc((size_t)count * sizeof(ui_node_t*));
+    if (!canvas.pixels || !labels || ui_tree_init(&tree, count + rows + 1, cfg->width, cfg->height,
+                                                  tree_measure, &canvas) < 0) {
+        fprintf(stderr, "错误: 无法创建 %d 个节点的界面树\n", count);
+        free(canvas.pixels);
+        free(labels);
+        return -1;
+    }
+    ui_node_set_background(tree.root, 0x000000);
+    int added = 0;
+    for (int r = 0; r < rows && added < count; r++) {
+        ui_node_t* row = ui_tree_add_panel(&tree, tree.root, UI_HORIZONTAL, UI_SIZE_FILL, UI_SIZE_FILL);
+        ui_node_set_background(row, (r & 1) ? 0x202020 : 0x303030);
+        for (int c = 0; c < cols && added < count; c++) {
+            labels[added++] = ui_tree_add_label(&tree, row, 14, 0xFFFFFF, "0");
+        }
+    }
+    ui_tree_paint(&tree, tree_paint, &canvas, NULL);
+
+    char text[16];
+    long painted = 0;
+    double start = now_ms();
+    for (int f = 0; f < cfg->frames; f++) {
+        sprintf(text, "%d", f);
+        ui_label_set_text(labels[(f * 7919) % count], text);
+        ui_tree_damage_all(&tree);
+        painted += ui_tree_paint(&tree, tree_paint, &canvas, NULL);
+    }
+    report(cfg, "ui_tree_full", count, cfg->frames, now_ms() - start, (double)painted / cfg->frames);
+
+    painted = 0;
+    start = now_ms();
+    for (int f = 0; f < cfg->frames; f++) {
+        sprintf(text, "%d", f + cfg->frames);
+        ui_label_set_text(labels[(f * 7919) % count], text);
+        painted += ui_tree_paint(&tree, tree_paint, &canvas, NULL);
+    }
+    report(cfg, "ui_tree_incremental", count, cfg->frames, now_ms() - start, (double)painted / cfg->frames);
+
+    free(labels);
+    ui_tree_destroy(&tree);
+    free(canvas.pixels);
+    return 0;
+}
+
+// 排版的度量回调: 半角字符7像素 (空格4)，中日韩文字14像素，行高16
+static int bench_advance(void* context, int font, uint32_t cp) {
+    (void)context;
+    (void)font;
+    if (cp == ' ') return 4;
+    return cp < 0x1100 ? 7 : 14;
+}
+
+static int bench_line_height(void* context, int font) {
+    (void)context;
+    (void)font;
+    return 16;
+}
+
+#define BENCH_TEXT_MAX 160
+
+// 随机拼出混排字符串: 英文单词、中文、日文假名、韩文、数字和全角标点
+static void make_mixed_text(char* text, size_t size) {
+    static const char* const words[] = {
+        "Press", "any", "key", "to", "continue", "RG34XX", "handheld", "loading", "ROM", "v1.0",
+        "中文测试", "方块动画演示", "繁體中文", "设置", "游戏列表", "最近游玩",
+        "ブロック", "アニメーション", "ゲーム", "しゃっきり",
+        "한국어", "블록", "애니메이션",
+        "，", "。", "：", "（括弧）", "「引用」", "12:34", "100%",
+    };
+    int count = (int)(sizeof(words) / sizeof(words[0]));
+    size_t len = 0;
+    text[0] = '\0';
+    while (len < size / 2) {
+        const char* word = words[rng_next() % count];
+        const char* sep = (rng_next() & 1) ? " " : "";
+        int n = snprintf(text + len, size - len, "%s%s", word, sep);
+        if (n < 0 || (size_t)n >= size - len) break;
+        len += n;
+    }
+}
+
+// 文字排版: count个混排字符串折行到最多3行。
+// text_layout_cold 每帧换一个宽度 (全部未命中，完整地解码、查字宽和折行)，
+// text_layout_cached 宽度不变，缓存能放下全部字符串 (只有哈希和比较)。result为每秒排版的字符串数
+static int run_text_layout(bench_config_t* cfg, int count) {
+    char* texts = malloc((size_t)count * BENCH_TEXT_MAX);
+    text_metrics_t metrics = {bench_advance, bench_line_height, NULL};
+    text_layout_cache_t cold, cached;
+    int cold_ok = text_layout_init(&cold, 64, &metrics) == 0;
+    int cached_ok = text_layout_init(&cached, count, &metrics) == 0;
+    if (!texts || !cold_ok || !cached_ok) {
+        fprintf(stderr, "错误: 无法分配 %d 个字符串的排版缓存\n", count);
+        free(texts);
+        if (cold_ok) text_layout_destroy(&cold);
+        if (cached_ok) text_layout_destroy(&cached);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        make_mixed_text(texts + (size_t)i * BENCH_TEXT_MAX, BENCH_TEXT_MAX);
+    }
+
+    // 每帧排版全部字符串，帧数按字符串数缩减，使每项的总量与其他测试相当
+    int frames = cfg->frames * 100 / count;
+    if (frames < 1) frames = 1;
+    if (frames > cfg->frames) frames = cfg->frames;
+
+    int lines = 0;
+    double start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        int width = 160 + (f % 16) * 8;
+        for (int i = 0; i < count; i++) {
+            lines += text_layout_get(&cold, texts + (size_t)i * BENCH_TEXT_MAX, 16, width, 3)->line_count;
+        }
+    }
+    double elapsed = now_ms() - start;
+    report(cfg, "text_layout_cold", count, frames, elapsed, elapsed > 0 ? count * frames * 1000.0 / elapsed : 0);
+
+    for (int i = 0; i < count; i++) {
+        text_layout_get(&cached, texts + (size_t)i * BENCH_TEXT_MAX, 16, 240, 3);
+    }
+    start = now_ms();
+    for (int f = 0; f < frames; f++) {
+        for (int i = 0; i < count; i++) {
+            lines += text_layout_get(&cached, texts + (size_t)i * BENCH_TEXT_MAX, 16, 240, 3)->line_count;
+        }
+    }
+    elapsed = now_ms() - start;
+    report(cfg, "text_layout_cached", count, frames, elapsed, elapsed > 0 ? count * frames * 1000.0 / elapsed : 0);
+    bench_sink = lines;
+
+    text_layout_destroy(&cold);
+    text_layout_destroy(&cached);
+    free(texts);
+    return 0;
+}
+
+// 虚拟列表的文字来源
+static int bench_row_text(void* context, int index, char* text, int size) {
+    (void)context;
+    snprintf(text, size, "%06d  Game title %d (Rev %d).zip", index + 1, index % 97, index % 3);
+    return 0;
+}
+
+// 虚拟列表: count个条目，模拟一直按住方向键 (到头后反向)，每帧更新行缓存并填充可见行。
+// 耗时应与条目总数无关，result为每帧新取文字的行数
+static int run_list_view(bench_config_t* cfg, int count) {
+    const int row_height = 30, visible = 13;
+    int pitch = cfg->width * pixel_format_bytes(cfg->format);
+    uint8_t* pixels = malloc((size_t)pitch * cfg->height);
+    list_rows_t rows;
+    if (!pixels || list_rows_init(&rows, visible, 4, bench_row_text, NULL) < 0) {
+        fprintf(stderr, "错误: 无法创建 %d 个条目的列表\n", count);
+        free(pixels);
+        return -1;
+    }
+    list_view_t view;
+    list_view_init(&view, count, row_height, row_height * visible);
+    int height = row_height * visible < cfg->height ? row_height * visible : cfg->height;
+
+    int dir = 1;
+    long chars = 0;
+    double start = now_ms();
+    for (int f = 0; f < cfg->frames; f++) {
+        if (view.selected == count - 1) dir = -1;
+        else if (view.selected == 0) dir = 1;
+        list_view_step(&view, dir, 16);
+
+        int first, last;
+        list_view_visible(&view, &first, &last);
+        list_rows_update(&rows, first, last, count);
+        for (int i = first; i <= last; i++) {
+            int y0 = i * row_height - view.scroll;
+            int y1 = y0 + row_height;
+            if (y0 < 0) y0 = 0;
+            if (y1 > height) y1 = height;
+            uint32_t pixel = pixel_map(cfg->format, i == view.selected ? 0x3060C0 : 0x101010);
+            for (int y = y0; y < y1; y++) {
+                pixel_fill_row(cfg->format, pixels + (size_t)y * pitch, pixel, cfg->width);
+            }
+            const char* text = list_rows_text(&rows, i);
+            chars += text ? (long)strlen(text) : 0;
+        }
+    }
+    report(cfg, "list_scroll", count, cfg->frames, now_ms() - start, (double)rows.total_fetched / cfg->frames);
+    bench_sink = (int)chars;
+
+    list_rows_destroy(&rows);
+    free(pixels);
+    return 0;
+}
+
+static int parse_counts(bench_config_t* cfg, const char* list) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", list);
+    cfg->count_num = 0;
+    for (char* token = strtok(buffer, ","); token; token = strtok(NULL, ",")) {
+        int count = atoi(token);
+        if (count <= 0 || cfg->count_num == MAX_COUNTS) return -1;
+        cfg->counts[cfg->count_num++] = count;
+    }
+    return cfg->count_num > 0 ? 0 : -1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "用法: %s [-c 数量列表] [-n 帧数] [-s 边长] [-b 16|32] [-W 宽] [-H 高] [-o 输出.csv]\n"
+            "  -c  精灵数量，逗号分隔，默认 %s\n"
+            "  -n  每项帧数，默认 %d\n"
+            "  -s  精灵边长 (像素)，默认 %d\n"
+            "  -b  绘制的色深，默认16 (RGB565)\n"
+            "  -W/-H  场景尺寸，默认 %dx%d\n"
+            "  -o  CSV输出文件，默认stdout\n",
+            prog, DEFAULT_COUNTS, DEFAULT_FRAMES, DEFAULT_SPRITE_SIZE, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+}
+
+int main(int argc, char* argv[]) {
+    bench_config_t cfg = {
+        .width = DEFAULT_WIDTH,
+        .height = DEFAULT_HEIGHT,
+        .frames = DEFAULT_FRAMES,
+        .sprite_size = DEFAULT_SPRITE_SIZE,
+        .format = PIXEL_FORMAT_RGB565,
+        .csv = stdout,
+    };
+    parse_counts(&cfg, DEFAULT_COUNTS);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:n:s:b:W:H:o:h")) != -1) {
+        switch (opt) {
+            case 'c':
+                if (parse_counts(&cfg, optarg) < 0) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'n': cfg.frames = atoi(optarg); break;
+            case 's': cfg.sprite_size = atoi(optarg); break;
+            case 'b': cfg.format = atoi(optarg) == 32 ? PIXEL_FORMAT_XRGB8888 : PIXEL_FORMAT_RGB565; break;
+            case 'W': cfg.width = atoi(optarg); break;
+            case 'H': cfg.height = atoi(optarg); break;
+            case 'o': cfg.output = optarg; break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (cfg.frames <= 0 || cfg.sprite_size <= 0 || cfg.width <= cfg.sprite_size * 2 ||
+        cfg.height <= cfg.sprite_size * 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    fprintf(stderr, "=== 界面压力测试 ===\n");
+
+    if (cfg.output) {
+        cfg.csv = fopen(cfg.output, "w");
+        if (!cfg.csv) {
+            fprintf(stderr, "错误: 无法创建 %s - %s\n", cfg.output, strerror(errno));
+            return 1;
+        }
+    }
+
+    fprintf(cfg.csv, "test,sprites,frames,total_ms,us_per_frame,ns_per_sprite,result\n");
+    int status = 0;
+    for (int i = 0; i < cfg.count_num && status == 0; i++) {
+        status = run_count(&cfg, cfg.counts[i]);
+        if (status == 0) {
+            status = run_ui_tree(&cfg, cfg.counts[i]);
+        }
+        if (status == 0) {
+            status = run_text_layout(&cfg, cfg.counts[i]);
+        }
+        if (status == 0) {
+            status = run_list_view(&cfg, cfg.counts[i]);
+        }
+    }
+
+    if (cfg.csv != stdout) {
+        fclose(cfg.csv);
+    }
+    if (status == 0) {
+        fprintf(stderr, "✅ 界面压力测试完成\n");
+    }
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,520 @@
+#include "ui-tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int rect_equal(const ui_rect_t* a, const ui_rect_t* b) {
+    return a->x == b->x && a->y == b->y && a->w == b->w && a->h == b->h;
+}
+
+static int rect_area(const ui_rect_t* r) {
+    return r->w * r->h;
+}
+
+static void rect_union(const ui_rect_t* a, const ui_rect_t* b, ui_rect_t* out) {
+    int x0 = a->x < b->x ? a->x : b->x;
+    int y0 = a->y < b->y ? a->y : b->y;
+    int x1 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+}
+
+int ui_rect_intersect(const ui_rect_t* a, const ui_rect_t* b, ui_rect_t* out) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    int y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+    if (x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+    out->x = x0;
+    out->y = y0;
+    out->w = x1 - x0;
+    out->h = y1 - y0;
+    return 1;
+}
+
+int ui_tree_init(ui_tree_t* tree, int capacity, int width, int height, ui_measure_fn measure, void* context) {
+    memset(tree, 0, sizeof(*tree));
+    if (capacity < 1) {
+        return -1;
+    }
+    tree->nodes = calloc(capacity, sizeof(ui_node_t));
+    if (!tree->nodes) {
+        return -1;
+    }
+    tree->capacity = capacity;
+    tree->measure = measure;
+    tree->context = context;
+
+    tree->root = ui_tree_add_panel(tree, NULL, UI_VERTICAL, width, height);
+    tree->root->rect.w = width;
+    tree->root->rect.h = height;
+    ui_tree_damage_all(tree);
+    return 0;
+}
+
+void ui_tree_destroy(ui_tree_t* tree) {
+    free(tree->nodes);
+    memset(tree, 0, sizeof(*tree));
+}
+
+static ui_node_t* add_node(ui_tree_t* tree, ui_node_t* parent, ui_node_type_t type) {
+    if (tree->count == tree->capacity) {
+        return NULL;
+    }
+    ui_node_t* node = &tree->nodes[tree->count++];
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    node->parent = parent;
+    if (parent) {
+        if (parent->last_child) {
+            parent->last_child->next = node;
+        } else {
+            parent->first_child = node;
+        }
+        parent->last_child = node;
+    }
+    ui_node_invalidate(node, UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT | UI_DIRTY_PAINT);
+    return node;
+}
+
+ui_node_t* ui_tree_add_panel(ui_tree_t* tree, ui_node_t* parent, ui_direction_t direction, int width, int height) {
+    ui_node_t* node = add_node(tree, parent, UI_NODE_PANEL);
+    if (node) {
+        node->direction = direction;
+        node->width = width;
+        node->height = height;
+    }
+    return node;
+}
+
+ui_node_t* ui_tree_add_label(ui_tree_t* tree, ui_node_t* parent, int font, uint32_t color, const char* text) {
+    ui_node_t* node = add_node(tree, parent, UI_NODE_LABEL);
+    if (node) {
+        node->font = font;
+        node->color = color;
+        ui_label_set_text(node, text);
+    }
+    return node;
+}
+
+ui_node_t* ui_tree_add_custom(ui_tree_t* tree, ui_node_t* parent, int id, int width, int height) {
+    ui_node_t* node = add_node(tree, parent, UI_NODE_CUSTOM);
+    if (node) {
+        node->id = id;
+        node->width = width;
+        node->height = height;
+    }
+    return node;
+}
+
+void ui_node_invalidate(ui_node_t* node, unsigned flags) {
+    node->flags |= flags;
+    // 祖先已有标记时它上面的祖先也都有
+    for (ui_node_t* p = node->parent; p && !(p->flags & UI_DIRTY_SUBTREE); p = p->parent) {
+        p->flags |= UI_DIRTY_SUBTREE;
+    }
+}
+
+void ui_label_set_text(ui_node_t* node, const char* text) {
+    if (!text) text = "";
+    if (strcmp(node->text, text) == 0) {
+        return;
+    }
+    size_t len = strlen(text);
+    if (len >= UI_TEXT_MAX) {
+        // 截断时不留下半个UTF-8字符
+        len = UI_TEXT_MAX - 1;
+        while (len > 0 && ((unsigned char)text[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    memcpy(node->text, text, len);
+    node->text[len] = '\0';
+    ui_node_invalidate(node, UI_DIRTY_MEASURE | UI_DIRTY_PAINT);
+}
+
+void ui_label_set_color(ui_node_t* node, uint32_t color) {
+    if (node->color == color) {
+        return;
+    }
+    node->color = color;
+    ui_node_invalidate(node, UI_DIRTY_PAINT);
+}
+
+void ui_label_set_max_lines(ui_node_t* node, int max_lines) {
+    if (node->max_lines == max_lines) {
+        return;
+    }
+    node->max_lines = max_lines;
+    ui_node_invalidate(node, UI_DIRTY_MEASURE | UI_DIRTY_PAINT);
+}
+
+void ui_node_set_background(ui_node_t* node, uint32_t color) {
+    if (node->has_background && node->background == color) {
+        return;
+    }
+    node->has_background = 1;
+    node->background = color;
+    ui_node_invalidate(node, UI_DIRTY_PAINT);
+}
+
+void ui_node_set_size(ui_node_t* node, int width, int height) {
+    if (node->width == width && node->height == height) {
+        return;
+    }
+    node->width = width;
+    node->height = height;
+    ui_node_invalidate(node, UI_DIRTY_LAYOUT);
+    if (node->parent) {
+        ui_node_invalidate(node->parent, UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT);
+    }
+}
+
+void ui_node_set_hidden(ui_node_t* node, int hidden) {
+    hidden = hidden != 0;
+    if (node->hidden == hidden) {
+        return;
+    }
+    node->hidden = hidden;
+    // 隐藏期间子树的失效标志保留，重新显示时一起处理
+    if (!hidden) {
+        ui_node_invalidate(node, UI_DIRTY_LAYOUT | UI_DIRTY_PAINT);
+    }
+    if (node->parent) {
+        ui_node_invalidate(node->parent, UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT);
+    }
+}
+
+void ui_tree_damage(ui_tree_t* tree, const ui_rect_t* rect) {
+    ui_rect_t r;
+    if (!ui_rect_intersect(rect, &tree->root->rect, &r)) {
+        return;
+    }
+
+    // 与已有的脏矩形重叠时合并，避免同一区域画两次
+    for (int i = 0; i < tree->damage_count;) {
+        ui_rect_t overlap;
+        if (ui_rect_intersect(&tree->damage[i], &r, &overlap)) {
+            rect_union(&tree->damage[i], &r, &r);
+            tree->damage[i] = tree->damage[--tree->damage_count];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+
+    if (tree->damage_count == UI_MAX_DAMAGE) {
+        // 已满: 并入合并后面积增加最少的那个
+        int best = 0;
+        int best_growth = 0;
+        for (int i = 0; i < tree->damage_count; i++) {
+            ui_rect_t u;
+            rect_union(&tree->damage[i], &r, &u);
+            int growth = rect_area(&u) - rect_area(&tree->damage[i]);
+            if (i == 0 || growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        ui_rect_t merged;
+        rect_union(&tree->damage[best], &r, &merged);
+        tree->damage[best] = tree->damage[--tree->damage_count];
+        ui_tree_damage(tree, &merged);
+        return;
+    }
+    tree->damage[tree->damage_count++] = r;
+}
+
+void ui_tree_damage_all(ui_tree_t* tree) {
+    tree->damage_count = 0;
+    ui_tree_damage(tree, &tree->root->rect);
+}
+
+// 按内容的尺寸在某个方向上的请求值 (UI_SIZE_FILL不占用空间)
+static int preferred(int request, int measured) {
+    if (request > 0) return request;
+    return request == UI_SIZE_AUTO ? measured : 0;
+}
+
+// 按当前的折行宽度测量标签，写入含内边距的尺寸
+static void measure_label(ui_tree_t* tree, ui_node_t* node, int* w, int* h) {
+    *w = *h = 0;
+    if (node->text[0] && tree->measure) {
+        tree->measure(tree->context, node, node->max_lines > 0 ? node->wrap_width : 0, w, h);
+    }
+    *w += node->padding_x * 2;
+    *h += node->padding_y * 2;
+    tree->stats.measured++;
+}
+
+// 重新测量失效的节点，按内容的尺寸变了时返回1
+static int measure(ui_tree_t* tree, ui_node_t* node) {
+    if (!(node->flags & (UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT | UI_DIRTY_SUBTREE))) {
+        return 0;
+    }
+    int w = node->measured_w;
+    int h = node->measured_h;
+
+    if (node->type == UI_NODE_LABEL) {
+        if (node->flags & UI_DIRTY_MEASURE) {
+            measure_label(tree, node, &w, &h);
+        }
+    } else if (node->type == UI_NODE_PANEL) {
+        for (ui_node_t* child = node->first_child; child; child = child->next) {
+            if (!child->hidden && measure(tree, child)) {
+                node->flags |= UI_DIRTY_LAYOUT;
+            }
+        }
+        if (node->flags & (UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT)) {
+            int main = 0, cross = 0, count = 0;
+            for (ui_node_t* child = node->first_child; child; child = child->next) {
+                if (child->hidden) continue;
+                int cw = preferred(child->width, child->measured_w);
+                int ch = preferred(child->height, child->measured_h);
+                if (node->direction == UI_HORIZONTAL) {
+                    main += cw;
+                    if (ch > cross) cross = ch;
+                } else if (node->direction == UI_VERTICAL) {
+                    main += ch;
+                    if (cw > cross) cross = cw;
+                } else {
+                    if (ch > main) main = ch;
+                    if (cw > cross) cross = cw;
+                }
+                count++;
+            }
+            if (count > 1 && node->direction != UI_OVERLAY) {
+                main += node->spacing * (count - 1);
+            }
+            w = (node->direction == UI_HORIZONTAL ? main : cross) + node->padding_x * 2;
+            h = (node->direction == UI_HORIZONTAL ? cross : main) + node->padding_y * 2;
+        }
+    } else {
+        w = node->padding_x * 2;
+        h = node->padding_y * 2;
+    }
+
+    int changed = (w != node->measured_w || h != node->measured_h);
+    node->measured_w = w;
+    node->measured_h = h;
+    return changed;
+}
+
+// 交叉方向的尺寸，不超过可用空间
+static int cross_size(int request, int measured, int available) {
+    int size = request == UI_SIZE_FILL ? available : preferred(request, measured);
+    return size > available ? available : size;
+}
+
+static unsigned arrange(ui_tree_t* tree, ui_node_t* node, const ui_rect_t* rect, int covered);
+
+// 隐藏的节点区域清空 (原来的区域要重画)，子树保持原样
+static void hide(ui_tree_t* tree, ui_node_t* node, int covered) {
+    if (node->rect.w > 0 && node->rect.h > 0 && !covered) {
+        ui_tree_damage(tree, &node->rect);
+    }
+    node->rect.w = 0;
+    node->rect.h = 0;
+}
+
+// 子节点的arrange返回值合并为父节点下一遍布局的失效标志
+static unsigned reflow_flags(unsigned child) {
+    if (child & UI_DIRTY_MEASURE) return UI_DIRTY_MEASURE | UI_DIRTY_LAYOUT | UI_DIRTY_SUBTREE;
+    return child ? UI_DIRTY_SUBTREE : 0;
+}
+
+// 按方向排列子节点，子节点的区域限制在内容区内。返回子节点需要的下一遍布局 (见arrange)
+static unsigned arrange_children(ui_tree_t* tree, ui_node_t* node, int covered) {
+    ui_rect_t content = {
+        node->rect.x + node->padding_x,
+        node->rect.y + node->padding_y,
+        node->rect.w - node->padding_x * 2,
+        node->rect.h - node->padding_y * 2,
+    };
+    if (content.w < 0) content.w = 0;
+    if (content.h < 0) content.h = 0;
+    tree->stats.arranged++;
+    unsigned again = 0;
+
+    if (node->direction == UI_OVERLAY) {
+        for (ui_node_t* child = node->first_child; child; child = child->next) {
+            if (child->hidden) {
+                hide(tree, child, covered);
+                continue;
+            }
+            ui_rect_t r = {content.x, content.y,
+                           cross_size(child->width, child->measured_w, content.w),
+                           cross_size(child->height, child->measured_h, content.h)};
+            again |= reflow_flags(arrange(tree, child, &r, covered));
+        }
+        return again;
+    }
+
+    int horizontal = node->direction == UI_HORIZONTAL;
+    int available = horizontal ? content.w : content.h;
+    int used = 0, fills = 0, count = 0;
+    for (ui_node_t* child = node->first_child; child; child = child->next) {
+        if (child->hidden) continue;
+        int request = horizontal ? child->width : child->height;
+        if (request == UI_SIZE_FILL) {
+            fills++;
+        } else {
+            used += preferred(request, horizontal ? child->measured_w : child->measured_h);
+        }
+        count++;
+    }
+    if (count > 1) {
+        used += node->spacing * (count - 1);
+    }
+    int remaining = available - used;
+    if (remaining < 0) remaining = 0;
+
+    int cursor = 0;
+    int fill_index = 0;
+    for (ui_node_t* child = node->first_child; child; child = child->next) {
+        if (child->hidden) {
+            hide(tree, child, covered);
+            continue;
+        }
+        int request = horizontal ? child->width : child->height;
+        int main;
+        if (request == UI_SIZE_FILL) {
+            // 剩余空间平分，余数给最后一个
+            main = remaining / fills + (++fill_index == fills ? remaining % fills : 0);
+        } else {
+            main = preferred(request, horizontal ? child->measured_w : child->measured_h);
+        }
+        int start = cursor < available ? cursor : available;
+        if (main > available - start) main = available - start;
+
+        ui_rect_t r;
+        if (horizontal) {
+            r.x = content.x + start;
+            r.y = content.y;
+            r.w = main;
+            r.h = cross_size(child->height, child->measured_h, content.h);
+        } else {
+            r.x = content.x;
+            r.y = content.y + start;
+            r.w = cross_size(child->width, child->measured_w, content.w);
+            r.h = main;
+        }
+        again |= reflow_flags(arrange(tree, child, &r, covered));
+        cursor += main + node->spacing;
+    }
+    return again;
+}
+
+// 折行标签分到的宽度与测量时不同: 按新宽度重新测量，尺寸变了时返回1
+static int reflow_label(ui_tree_t* tree, ui_node_t* node) {
+    int width = node->rect.w - node->padding_x * 2;
+    if (width < 1) width = 1;
+    if (node->max_lines <= 0 || width == node->wrap_width) {
+        return 0;
+    }
+    node->wrap_width = width;
+    int w, h;
+    measure_label(tree, node, &w, &h);
+    int changed = (w != node->measured_w || h != node->measured_h);
+    node->measured_w = w;
+    node->measured_h = h;
+    return changed;
+}
+
+// covered: 祖先的新旧区域已经加入脏矩形，子孙节点不用再加。
+// 返回这个节点在下一遍布局中的失效标志: 折行标签的尺寸变了时为UI_DIRTY_MEASURE (父节点要重新测量和排列)，
+// 子孙中有这样的标签时为UI_DIRTY_SUBTREE，都没有时为0
+static unsigned arrange(ui_tree_t* tree, ui_node_t* node, const ui_rect_t* rect, int covered) {
+    if (!rect_equal(&node->rect, rect)) {
+        if (!covered) {
+            ui_tree_damage(tree, &node->rect);
+            ui_tree_damage(tree, rect);
+            covered = 1;
+        }
+        node->rect = *rect;
+        node->flags |= UI_DIRTY_LAYOUT;
+    } else if ((node->flags & UI_DIRTY_PAINT) && !covered) {
+        ui_tree_damage(tree, rect);
+        covered = 1;
+    }
+
+    unsigned again = 0;
+    if (node->type == UI_NODE_LABEL) {
+        if (reflow_label(tree, node)) {
+            again = UI_DIRTY_MEASURE;
+        }
+    } else if (node->flags & UI_DIRTY_LAYOUT) {
+        if (node->first_child) {
+            again = arrange_children(tree, node, covered);
+        }
+    } else if (node->flags & UI_DIRTY_SUBTREE) {
+        for (ui_node_t* child = node->first_child; child; child = child->next) {
+            if (child->flags && !child->hidden) {
+                again |= reflow_flags(arrange(tree, child, &child->rect, covered));
+            }
+        }
+    }
+    node->flags = 0;
+    if (node->type == UI_NODE_LABEL) {
+        return again;
+    }
+    node->flags = again;
+    return again ? UI_DIRTY_SUBTREE : 0;
+}
+
+void ui_tree_layout(ui_tree_t* tree) {
+    ui_node_t* root = tree->root;
+    // 折行标签的宽度取决于布局，高度又影响布局: 一般一遍就稳定，最多三遍
+    for (int pass = 0; pass < 3 && root->flags; pass++) {
+        measure(tree, root);
+        ui_rect_t rect = {0, 0, root->width, root->height};
+        arrange(tree, root, &rect, 0);
+    }
+}
+
+static void paint_node(ui_tree_t* tree, ui_node_t* node, const ui_rect_t* damage,
+                       ui_paint_fn paint, void* context) {
+    ui_rect_t clip;
+    if (!ui_rect_intersect(&node->rect, damage, &clip)) {
+        return;
+    }
+    paint(context, node, &clip);
+    tree->stats.painted++;
+    // 子节点在父节点的区域内，父节点不相交时不用再看子节点
+    for (ui_node_t* child = node->first_child; child; child = child->next) {
+        paint_node(tree, child, damage, paint, context);
+    }
+}
+
+int ui_tree_paint(ui_tree_t* tree, ui_paint_fn paint, void* context, ui_rect_t* bounds) {
+    ui_tree_layout(tree);
+
+    tree->stats.painted = 0;
+    tree->stats.damage_rects = tree->damage_count;
+    tree->stats.damage_area = 0;
+    ui_rect_t all = {0, 0, 0, 0};
+    for (int i = 0; i < tree->damage_count; i++) {
+        paint_node(tree, tree->root, &tree->damage[i], paint, context);
+        tree->stats.damage_area += rect_area(&tree->damage[i]);
+        if (i == 0) {
+            all = tree->damage[i];
+        } else {
+            rect_union(&all, &tree->damage[i], &all);
+        }
+    }
+    tree->damage_count = 0;
+    if (bounds) {
+        *bounds = all;
+    }
+    int painted = tree->stats.painted;
+
+    // 统计只保留到下一帧的绘制，布局计数从这里重新开始累计
+    tree->last = tree->stats;
+    memset(&tree->stats, 0, sizeof(tree->stats));
+    return painted;
+}
@@ -0,0 +1,144 @@
+#ifndef UI_TREE_H
+#define UI_TREE_H
+
+#include <stdint.h>
+
+// 保留模式的界面树 (不依赖SDL): 面板、文字标签和自定义节点组成一棵树，取代按固定坐标逐帧重画。
+//
+// 内容或尺寸变化的节点标记失效，并在祖先上标记"子树有失效"。布局只进入有标记的子树:
+// 标签只在文字变化时重新测量，面板只在子节点尺寸或自身区域变化时重新排列。
+// 区域变化或需要重画的节点把新旧区域加入脏矩形，绘制只重画脏矩形内的节点，
+// 其余部分保留上一帧的输出 (调用方的画面不清屏)，每帧的开销取决于变化了多少而不是界面大小。
+//
+// 节点只在自己的区域内绘制 (布局把子节点限制在父节点的内容区内)，父节点先于子节点，
+// 后面的兄弟节点盖住前面的。所有节点在初始化时一次分配，主循环中不分配内存。
+
+#define UI_TEXT_MAX   512
+#define UI_MAX_DAMAGE 16
+
+// 请求尺寸: 正数为固定像素
+#define UI_SIZE_AUTO  0          // 按内容
+#define UI_SIZE_FILL  -1         // 主方向上平分剩余空间，交叉方向上占满
+
+// 失效标志
+#define UI_DIRTY_MEASURE 1       // 内容变了，需要重新测量
+#define UI_DIRTY_LAYOUT  2       // 需要重新排列子节点
+#define UI_DIRTY_PAINT   4       // 需要重画
+#define UI_DIRTY_SUBTREE 8       // 子孙节点中有失效的
+
+typedef enum {
+    UI_NODE_PANEL,               // 容器，可选纯色背景
+    UI_NODE_LABEL,               // 文字 (默认单行，可以折行或截短)
+    UI_NODE_CUSTOM,              // 调用方自己绘制 (图片、动画等)
+} ui_node_type_t;
+
+// 面板排列子节点的方向
+typedef enum {
+    UI_VERTICAL,
+    UI_HORIZONTAL,
+    UI_OVERLAY,                  // 所有子节点叠放在内容区的左上角
+} ui_direction_t;
+
+typedef struct {
+    int x, y, w, h;
+} ui_rect_t;
+
+typedef struct ui_node ui_node_t;
+
+struct ui_node {
+    ui_node_type_t type;
+    ui_node_t* parent;
+    ui_node_t* first_child;
+    ui_node_t* last_child;
+    ui_node_t* next;
+    unsigned flags;
+
+    // 样式 (建树时直接设置，运行中修改用下面的函数)
+    int width, height;           // 请求尺寸 (UI_SIZE_AUTO / UI_SIZE_FILL / 像素)
+    int padding_x, padding_y;
+    int spacing;                 // 子节点之间的间距
+    ui_direction_t direction;
+    int has_background;
+    uint32_t background;         // 0xRRGGBB
+    uint32_t color;              // 文字颜色 0xRRGGBB
+    int font;                    // 字号，由测量和绘制回调解释
+    int max_lines;               // 标签: 0为单行不限宽，1为超出宽度时截短加省略号，N为折行最多N行
+    int id;                      // 调用方的标识 (自定义节点区分绘制内容)
+    int hidden;                  // 隐藏的节点不占空间也不绘制 (例如切换界面)
+    void* user;
+
+    char text[UI_TEXT_MAX];
+
+    // 布局结果
+    int measured_w, measured_h;  // 按内容的尺寸 (含内边距)，只在失效时重新计算
+    int wrap_width;              // 折行标签测量时使用的宽度 (布局分配的内容宽度)
+    ui_rect_t rect;              // 屏幕坐标
+};
+
+// 测量标签文字，写入宽高 (只在文字、字号或折行宽度变化时调用)。
+// max_width为0时按单行测量，否则按这个宽度和node->max_lines折行或截短
+typedef void (*ui_measure_fn)(void* context, const ui_node_t* node, int max_width, int* w, int* h);
+
+// 绘制一个节点，只能画在clip内 (节点区域与脏矩形的交集)
+typedef void (*ui_paint_fn)(void* context, const ui_node_t* node, const ui_rect_t* clip);
+
+// 最近一次布局和绘制的统计
+typedef struct {
+    int measured;                // 重新测量的标签数
+    int arranged;                // 重新排列的面板数
+    int painted;                 // 绘制的节点数 (一个节点跨多个脏矩形时计多次)
+    int damage_rects;
+    int damage_area;             // 脏矩形的总面积 (像素)
+} ui_tree_stats_t;
+
+typedef struct {
+    ui_node_t* nodes;
+    int capacity;
+    int count;
+    ui_node_t* root;             // 固定为界面尺寸的纵向面板
+    ui_measure_fn measure;
+    void* context;
+
+    ui_rect_t damage[UI_MAX_DAMAGE];
+    int damage_count;
+
+    ui_tree_stats_t stats;       // 本帧累计 (布局可能在绘制之前单独调用)
+    ui_tree_stats_t last;        // 上一次绘制完成时的统计
+} ui_tree_t;
+
+// 分配capacity个节点并创建width x height的根节点，失败返回-1。第一次绘制时整个界面为脏
+int ui_tree_init(ui_tree_t* tree, int capacity, int width, int height, ui_measure_fn measure, void* context);
+void ui_tree_destroy(ui_tree_t* tree);
+
+// 添加节点 (放在parent的最后)，节点池用完时返回NULL
+ui_node_t* ui_tree_add_panel(ui_tree_t* tree, ui_node_t* parent, ui_direction_t direction, int width, int height);
+ui_node_t* ui_tree_add_label(ui_tree_t* tree, ui_node_t* parent, int font, uint32_t color, const char* text);
+ui_node_t* ui_tree_add_custom(ui_tree_t* tree, ui_node_t* parent, int id, int width, int height);
+
+// 修改内容或样式，与当前值相同时不做任何事
+void ui_label_set_text(ui_node_t* node, const char* text);
+void ui_label_set_color(ui_node_t* node, uint32_t color);
+void ui_label_set_max_lines(ui_node_t* node, int max_lines);
+void ui_node_set_background(ui_node_t* node, uint32_t color);
+void ui_node_set_size(ui_node_t* node, int width, int height);
+void ui_node_set_hidden(ui_node_t* node, int hidden);
+
+// 标记节点失效 (UI_DIRTY_*)，例如自定义节点的内容变了时用 UI_DIRTY_PAINT
+void ui_node_invalidate(ui_node_t* node, unsigned flags);
+
+// 直接加入脏矩形 (例如移动的精灵的新旧位置)，超出界面的部分忽略
+void ui_tree_damage(ui_tree_t* tree, const ui_rect_t* rect);
+void ui_tree_damage_all(ui_tree_t* tree);
+
+// 重新计算失效子树的布局，区域变化的节点加入脏矩形。
+// 折行标签先按上次的宽度测量，分到的宽度不同时按新宽度重新测量，高度变了再布局一遍
+void ui_tree_layout(ui_tree_t* tree);
+
+// 按顺序绘制与脏矩形相交的节点，然后清空脏矩形。bounds不为NULL时写入脏矩形的外接矩形
+// (没有变化时宽高为0)。返回绘制的节点数
+int ui_tree_paint(ui_tree_t* tree, ui_paint_fn paint, void* context, ui_rect_t* bounds);
+
+// 两个矩形的交集，为空时返回0
+int ui_rect_intersect(const ui_rect_t* a, const ui_rect_t* b, ui_rect_t* out);
+
+#endif
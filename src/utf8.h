@@ -0,0 +1,51 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <stdint.h>
+
+// 非法序列返回的替换字符
+#define UTF8_REPLACEMENT 0xFFFD
+
+// 解码*p处的一个UTF-8字符并前移指针，字符串结束时返回0且不前移
+static inline uint32_t utf8_next(const char** p) {
+    const unsigned char* s = (const unsigned char*)*p;
+    uint32_t c = s[0];
+
+    if (c == 0) {
+        return 0;
+    }
+    if (c < 0x80) {
+        *p += 1;
+        return c;
+    }
+
+    int len;
+    uint32_t min;
+    if ((c & 0xE0) == 0xC0) {
+        len = 2; c &= 0x1F; min = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+        len = 3; c &= 0x0F; min = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+        len = 4; c &= 0x07; min = 0x10000;
+    } else {
+        *p += 1;
+        return UTF8_REPLACEMENT;
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            // 截断的序列: 只跳过首字节，让后续字节重新同步
+            *p += 1;
+            return UTF8_REPLACEMENT;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+
+    *p += len;
+    if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+        return UTF8_REPLACEMENT;
+    }
+    return c;
+}
+
+#endif